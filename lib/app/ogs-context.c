@@ -64,8 +64,6 @@ ogs_app_context_t *ogs_app(void)
 
 static void recalculate_pool_size(void)
 {
-    self.pool.packet = self.max.ue * OGS_MAX_NUM_OF_PACKET_BUFFER;
-
 #define MAX_NUM_OF_TUNNEL       3   /* Num of Tunnel per Bearer */
     self.pool.sess = self.max.ue * OGS_MAX_NUM_OF_SESS;
     self.pool.bearer = self.pool.sess * OGS_MAX_NUM_OF_BEARER;
@@ -266,6 +264,8 @@ int ogs_app_context_parse_config(void)
                 } else if (!strcmp(logger_key, "domain")) {
                     self.logger.domain =
                         ogs_yaml_iter_value(&logger_iter);
+                } else if (!strcmp(logger_key, "async")) {
+                    self.logger.async = ogs_yaml_iter_bool(&logger_iter);
                 }
             }
         } else if (!strcmp(root_key, "parameter")) {
@@ -350,10 +350,19 @@ int ogs_app_context_parse_config(void)
                 } else if (!strcmp(parameter_key, "no_pfcp_rr_select")) {
                     self.parameter.no_pfcp_rr_select =
                         ogs_yaml_iter_bool(&parameter_iter);
+                } else if (!strcmp(parameter_key, "timer_wheel")) {
+                    self.parameter.timer_wheel =
+                        ogs_yaml_iter_bool(&parameter_iter);
                 } else if (!strcmp(parameter_key,
                             "use_mongodb_change_stream")) {
                     self.use_mongodb_change_stream = 
                         ogs_yaml_iter_bool(&parameter_iter);
+                } else if (!strcmp(parameter_key, "subscriber_cache")) {
+                    const char *v = ogs_yaml_iter_value(&parameter_iter);
+                    if (v) self.subscriber_cache = atoi(v);
+                } else if (!strcmp(parameter_key, "sqn_reservation")) {
+                    const char *v = ogs_yaml_iter_value(&parameter_iter);
+                    if (v) self.sqn_reservation = atoi(v);
                 } else
                     ogs_warn("unknown key `%s`", parameter_key);
             }
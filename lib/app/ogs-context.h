@@ -42,11 +42,14 @@ typedef struct ogs_app_context_s {
 
     const char *db_uri;
     int use_mongodb_change_stream;
+    int subscriber_cache;
+    int sqn_reservation;
 
     struct {
         const char *file;
         const char *level;
         const char *domain;
+        int async;
     } logger;
 
     ogs_queue_t *queue;
@@ -85,6 +88,8 @@ typedef struct ogs_app_context_s {
         int no_ipv4v6_local_addr_in_packet_filter;
 
         int no_pfcp_rr_select;
+
+        int timer_wheel;
     } parameter;
 
     struct {
@@ -106,8 +111,6 @@ typedef struct ogs_app_context_s {
     struct {
         ogs_pkbuf_config_t defconfig;
 
-        uint64_t packet;
-
         uint64_t sess;
         uint64_t bearer;
         uint64_t tunnel;
@@ -110,6 +110,11 @@ int ogs_app_initialize(
             ogs_app()->logger.domain, ogs_app()->logger.level);
     if (rv != OGS_OK) return rv;
 
+    if (ogs_app()->logger.async) {
+        rv = ogs_log_async_start();
+        if (rv != OGS_OK) return rv;
+    }
+
     /**************************************************************************
      * Stage 5 : Setup Database Module
      */
@@ -141,7 +146,11 @@ int ogs_app_initialize(
      */
     ogs_app()->queue = ogs_queue_create(ogs_app()->pool.event);
     ogs_assert(ogs_app()->queue);
-    ogs_app()->timer_mgr = ogs_timer_mgr_create(ogs_app()->pool.timer);
+    if (ogs_app()->parameter.timer_wheel)
+        ogs_app()->timer_mgr =
+            ogs_timer_mgr_create_wheel(ogs_app()->pool.timer);
+    else
+        ogs_app()->timer_mgr = ogs_timer_mgr_create(ogs_app()->pool.timer);
     ogs_assert(ogs_app()->timer_mgr);
     ogs_app()->pollset = ogs_pollset_create(ogs_app()->pool.socket);
     ogs_assert(ogs_app()->pollset);
@@ -44,7 +44,7 @@ int get_asn1c_environment_version(void);	/* Run-time version */
 
 static ogs_inline void *ogs_asn_malloc(size_t size, const char *file_line)
 {
-    void *ptr = ogs_malloc(size);
+    void *ptr = ogs_arena_malloc(size);
     if (!ptr) {
         ogs_fatal("asn_malloc() failed in `%s`", file_line);
         ogs_assert_if_reached();
@@ -55,7 +55,7 @@ static ogs_inline void *ogs_asn_malloc(size_t size, const char *file_line)
 static ogs_inline void *ogs_asn_calloc(
         size_t nmemb, size_t size, const char *file_line)
 {
-    void *ptr = ogs_calloc(nmemb, size);
+    void *ptr = ogs_arena_calloc(nmemb, size);
     if (!ptr) {
         ogs_fatal("asn_calloc() failed in `%s`", file_line);
         ogs_assert_if_reached();
@@ -66,7 +66,7 @@ static ogs_inline void *ogs_asn_calloc(
 static ogs_inline void *ogs_asn_realloc(
         void *oldptr, size_t size, const char *file_line)
 {
-    void *ptr = ogs_realloc(oldptr, size);
+    void *ptr = ogs_arena_realloc(oldptr, size);
     if (!ptr) {
         ogs_fatal("asn_realloc() failed in `%s`", file_line);
         ogs_assert_if_reached();
@@ -78,7 +78,7 @@ static ogs_inline void *ogs_asn_realloc(
 #define CALLOC(nmemb, size) ogs_asn_calloc(nmemb, size, OGS_FILE_LINE)
 #define MALLOC(size) ogs_asn_malloc(size, OGS_FILE_LINE)
 #define REALLOC(oldptr, size) ogs_asn_realloc(oldptr, size, OGS_FILE_LINE)
-#define FREEMEM(ptr) ogs_free(ptr)
+#define FREEMEM(ptr) ogs_arena_free(ptr)
 
 #endif
 
@@ -21,30 +21,36 @@
 
 ogs_pkbuf_t *ogs_asn_encode(const asn_TYPE_descriptor_t *td, void *sptr)
 {
+    /*
+     * Encode into a per-thread scratch buffer and copy the result into
+     * a right-sized pkbuf. Most NGAP/S1AP PDUs are a few hundred bytes,
+     * so they come from the small pkbuf classes instead of a 32K cluster.
+     */
+    static OGS_THREAD_LOCAL uint8_t buffer[OGS_MAX_SDU_LEN];
+
     asn_enc_rval_t enc_ret = {0};
     ogs_pkbuf_t *pkbuf = NULL;
+    size_t size;
 
     ogs_assert(td);
     ogs_assert(sptr);
 
-    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
-    if (!pkbuf) {
-        ogs_error("ogs_pkbuf_alloc() failed");
-        return NULL;
-    }
-    ogs_pkbuf_put(pkbuf, OGS_MAX_SDU_LEN);
-
-    enc_ret = aper_encode_to_buffer(td, NULL,
-                    sptr, pkbuf->data, OGS_MAX_SDU_LEN);
+    enc_ret = aper_encode_to_buffer(td, NULL, sptr, buffer, sizeof(buffer));
     ogs_asn_free(td, sptr);
 
     if (enc_ret.encoded < 0) {
         ogs_error("Failed to encode ASN-PDU [%d]", (int)enc_ret.encoded);
-        ogs_pkbuf_free(pkbuf);
         return NULL;
     }
 
-    ogs_pkbuf_trim(pkbuf, ((enc_ret.encoded + 7) >> 3));
+    size = (enc_ret.encoded + 7) >> 3;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, size);
+    if (!pkbuf) {
+        ogs_error("ogs_pkbuf_alloc() failed");
+        return NULL;
+    }
+    ogs_pkbuf_put_data(pkbuf, buffer, size);
 
     return pkbuf;
 }
@@ -62,8 +68,12 @@ int ogs_asn_decode(const asn_TYPE_descriptor_t *td,
     ogs_assert(pkbuf->len);
 
     memset(struct_ptr, 0, struct_size);
+
+    /* The decoded IEs live until ogs_asn_free() in the same handler */
+    ogs_arena_enter();
     dec_ret = aper_decode(NULL, td, (void **)&struct_ptr,
             pkbuf->data, pkbuf->len, 0, 0);
+    ogs_arena_leave();
 
     if (dec_ret.code != RC_OK) {
         ogs_warn("Failed to decode ASN-PDU [code:%d,consumed:%d]",
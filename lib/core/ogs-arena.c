@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+
+#undef OGS_LOG_DOMAIN
+#define OGS_LOG_DOMAIN __ogs_mem_domain
+
+#define ARENA_ALIGN(__x) (((__x) + 15) & ~((size_t)15))
+
+/*
+ * The tag is kept right in front of each arena allocation.
+ * It is odd, so it never matches the aligned ogs_pkbuf_t pointer
+ * that ogs_malloc() keeps at the same place.
+ */
+#define ARENA_TAG ((uint64_t)0xa7e4a7e4a7e4a7e5ULL)
+
+typedef struct arena_chunk_s {
+    ogs_lnode_t lnode;
+
+    void *owner;                /* Arena of the allocating thread */
+    uint8_t *next;              /* Next free byte, used by the owner only */
+    uint8_t *end;               /* One past the last byte */
+
+    /*
+     * Allocations not yet freed, plus one held by the owner thread.
+     * Other threads may free into the chunk, so it is updated atomically.
+     */
+    unsigned int live;
+} arena_chunk_t;
+
+typedef struct arena_head_s {
+    arena_chunk_t *chunk;
+    size_t size;
+} arena_head_t;
+
+#define CHUNK_HEAD_SIZE ARENA_ALIGN(sizeof(arena_chunk_t))
+#define CHUNK_DATA(__cHUNK) ((uint8_t *)(__cHUNK) + CHUNK_HEAD_SIZE)
+#define HEAD_SIZE ARENA_ALIGN(sizeof(arena_head_t) + sizeof(uint64_t))
+#define HEAD_OF(__pTR) ((arena_head_t *)((uint8_t *)(__pTR) - HEAD_SIZE))
+#define TAG_OF(__pTR) ((uint64_t *)((uint8_t *)(__pTR) - sizeof(uint64_t)))
+
+/* The first chunk in the list is the one being filled */
+static OGS_THREAD_LOCAL struct {
+    ogs_list_t chunk_list;
+    int depth;
+} arena;
+
+static unsigned int chunk_live(arena_chunk_t *chunk)
+{
+    return __atomic_load_n(&chunk->live, __ATOMIC_ACQUIRE);
+}
+
+/* Chunks emptied by other threads are freed here */
+static void chunk_reclaim(void)
+{
+    arena_chunk_t *chunk = NULL, *next_chunk = NULL;
+
+    ogs_list_for_each_safe(&arena.chunk_list, next_chunk, chunk) {
+        if (chunk_live(chunk) == 1) {
+            ogs_list_remove(&arena.chunk_list, chunk);
+            ogs_free(chunk);
+        }
+    }
+}
+
+static arena_chunk_t *chunk_create(size_t need)
+{
+    arena_chunk_t *chunk = NULL;
+    size_t size = OGS_ARENA_CHUNK_SIZE;
+
+    chunk_reclaim();
+
+    if (size < CHUNK_HEAD_SIZE + need)
+        size = CHUNK_HEAD_SIZE + need;
+
+    chunk = ogs_malloc(size);
+    if (!chunk) {
+        ogs_error("ogs_malloc() failed");
+        return NULL;
+    }
+
+    chunk->owner = &arena;
+    chunk->next = CHUNK_DATA(chunk);
+    chunk->end = (uint8_t *)chunk + size;
+    chunk->live = 1;
+
+    ogs_list_prepend(&arena.chunk_list, chunk);
+
+    return chunk;
+}
+
+static void *arena_alloc(size_t size)
+{
+    arena_chunk_t *chunk = NULL;
+    arena_head_t *head = NULL;
+    size_t need = HEAD_SIZE + ARENA_ALIGN(size);
+    void *ptr = NULL;
+
+    chunk = ogs_list_first(&arena.chunk_list);
+
+    /* Everything was freed by other threads */
+    if (chunk && chunk_live(chunk) == 1)
+        chunk->next = CHUNK_DATA(chunk);
+
+    if (!chunk || (size_t)(chunk->end - chunk->next) < need) {
+        chunk = chunk_create(need);
+        if (!chunk)
+            return NULL;
+    }
+
+    head = (arena_head_t *)chunk->next;
+    head->chunk = chunk;
+    head->size = size;
+
+    ptr = (uint8_t *)head + HEAD_SIZE;
+    *TAG_OF(ptr) = ARENA_TAG;
+
+    chunk->next += need;
+    __atomic_add_fetch(&chunk->live, 1, __ATOMIC_RELAXED);
+
+    return ptr;
+}
+
+void ogs_arena_enter(void)
+{
+    arena.depth++;
+}
+
+void ogs_arena_leave(void)
+{
+    ogs_assert(arena.depth > 0);
+    arena.depth--;
+}
+
+bool ogs_arena_owns(const void *ptr)
+{
+    if (!ptr)
+        return false;
+
+    return *TAG_OF(ptr) == ARENA_TAG;
+}
+
+void *ogs_arena_malloc(size_t size)
+{
+    if (arena.depth)
+        return arena_alloc(size);
+
+    return ogs_malloc(size);
+}
+
+void *ogs_arena_calloc(size_t nmemb, size_t size)
+{
+    void *ptr = NULL;
+
+    if (!arena.depth)
+        return ogs_calloc(nmemb, size);
+
+    ptr = arena_alloc(nmemb * size);
+    if (ptr)
+        memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+void *ogs_arena_realloc(void *ptr, size_t size)
+{
+    arena_head_t *head = NULL;
+    arena_chunk_t *chunk = NULL;
+    void *new = NULL;
+
+    if (!ptr)
+        return ogs_arena_malloc(size);
+
+    if (!ogs_arena_owns(ptr))
+        return ogs_realloc(ptr, size);
+
+    head = HEAD_OF(ptr);
+    chunk = head->chunk;
+
+    /* Within the scope, the last allocation grows or shrinks in place */
+    if (arena.depth && chunk->owner == &arena &&
+        (uint8_t *)ptr + ARENA_ALIGN(head->size) == chunk->next &&
+        (size_t)(chunk->end - (uint8_t *)ptr) >= ARENA_ALIGN(size)) {
+        chunk->next = (uint8_t *)ptr + ARENA_ALIGN(size);
+        head->size = size;
+        return ptr;
+    }
+
+    if (size <= head->size) {
+        head->size = size;
+        return ptr;
+    }
+
+    new = ogs_arena_malloc(size);
+    if (!new)
+        return NULL;
+
+    memcpy(new, ptr, head->size);
+    ogs_arena_free(ptr);
+
+    return new;
+}
+
+void ogs_arena_free(void *ptr)
+{
+    arena_head_t *head = NULL;
+    arena_chunk_t *chunk = NULL;
+    unsigned int live;
+
+    if (!ptr)
+        return;
+
+    if (!ogs_arena_owns(ptr)) {
+        ogs_free(ptr);
+        return;
+    }
+
+    head = HEAD_OF(ptr);
+    chunk = head->chunk;
+    *TAG_OF(ptr) = 0;
+
+    if (__atomic_load_n(&chunk->owner, __ATOMIC_RELAXED) != &arena) {
+        /*
+         * Another thread's chunk. Its owner reclaims it once empty,
+         * or it is freed here if the owner thread has already exited.
+         */
+        live = __atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL);
+        ogs_assert(live != (unsigned int)-1);
+        if (live == 0)
+            ogs_free(chunk);
+        return;
+    }
+
+    /* Freeing in reverse order gives the space back right away */
+    if ((uint8_t *)ptr + ARENA_ALIGN(head->size) == chunk->next)
+        chunk->next = (uint8_t *)head;
+
+    live = __atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL);
+    ogs_assert(live);
+    if (live > 1)
+        return;
+
+    if (chunk == ogs_list_first(&arena.chunk_list)) {
+        chunk->next = CHUNK_DATA(chunk);
+    } else {
+        ogs_list_remove(&arena.chunk_list, chunk);
+        ogs_free(chunk);
+    }
+}
+
+void ogs_arena_release(void)
+{
+    arena_chunk_t *chunk = NULL, *next_chunk = NULL;
+    unsigned int live;
+
+    ogs_list_for_each_safe(&arena.chunk_list, next_chunk, chunk) {
+        ogs_list_remove(&arena.chunk_list, chunk);
+
+        /* Chunks still in use are freed by their last ogs_arena_free() */
+        __atomic_store_n(&chunk->owner, NULL, __ATOMIC_RELAXED);
+        live = __atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL);
+        if (live == 0)
+            ogs_free(chunk);
+        else
+            ogs_debug("%u arena allocations outlive the thread", live);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_CORE_INSIDE) && !defined(OGS_CORE_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_ARENA_H
+#define OGS_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-thread Arena for Transient Allocations
+ *
+ * A decoder runs between ogs_arena_enter() and ogs_arena_leave(). While
+ * the scope is open, ogs_arena_malloc() and ogs_arena_calloc() take memory
+ * from the arena of the calling thread with a pointer bump, without
+ * the global memory lock. Outside of the scope, they fall back to
+ * ogs_malloc() and ogs_calloc().
+ *
+ * ogs_arena_free() and ogs_arena_realloc() accept both kinds of pointer,
+ * so the decoded message is released as before (ogs_asn_free(),
+ * cJSON_Delete()). Each chunk counts its live allocations. When the
+ * last one is freed, which is normally the end of the event handler,
+ * the chunk is rewound or released.
+ *
+ * Each arena allocation is tagged in its header, so ogs_arena_owns()
+ * is O(1) and arena memory may be freed from any thread. A chunk emptied
+ * by another thread is reclaimed by its owner on a later allocation,
+ * and a chunk outliving its owner thread is freed by its last free.
+ */
+#define OGS_ARENA_CHUNK_SIZE        16384
+
+void ogs_arena_enter(void);
+void ogs_arena_leave(void);
+
+void *ogs_arena_malloc(size_t size);
+void *ogs_arena_calloc(size_t nmemb, size_t size);
+void *ogs_arena_realloc(void *ptr, size_t size);
+void ogs_arena_free(void *ptr);
+
+bool ogs_arena_owns(const void *ptr);
+
+/* Called at thread exit, and by ogs_core_terminate() */
+void ogs_arena_release(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_ARENA_H */
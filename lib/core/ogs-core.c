@@ -54,6 +54,7 @@ void ogs_core_initialize(void)
 
 void ogs_core_terminate(void)
 {
+    ogs_arena_release();
     ogs_tlv_final();
     ogs_socket_final();
     ogs_pkbuf_final();
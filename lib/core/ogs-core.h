@@ -38,6 +38,7 @@
 #include "core/ogs-log.h"
 #include "core/ogs-pkbuf.h"
 #include "core/ogs-memory.h"
+#include "core/ogs-arena.h"
 #include "core/ogs-rand.h"
 #include "core/ogs-uuid.h"
 #include "core/ogs-rbtree.h"
@@ -60,6 +61,8 @@
 #include "core/ogs-env.h"
 #include "core/ogs-fsm.h"
 #include "core/ogs-hash.h"
+#include "core/ogs-lpm.h"
+#include "core/ogs-hmap.h"
 #include "core/ogs-misc.h"
 #include "core/ogs-getopt.h"
 #include "core/ogs-file.h"
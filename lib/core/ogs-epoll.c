@@ -25,6 +25,10 @@
 
 #include <sys/epoll.h>
 
+#if HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#endif
+
 #include "ogs-core.h"
 #include "ogs-poll-private.h"
 
@@ -55,8 +59,17 @@ struct epoll_context_s {
 
     ogs_hash_t *map_hash;
     struct epoll_event *event_list;
+
+#if HAVE_SYS_TIMERFD_H
+    int timerfd;        /* Sub-millisecond timeout without epoll_pwait2() */
+    bool timer_armed;
+#endif
 };
 
+#if HAVE_EPOLL_PWAIT2
+static bool no_epoll_pwait2;    /* The kernel is older than 5.11 */
+#endif
+
 static void epoll_init(ogs_pollset_t *pollset)
 {
     struct epoll_context_s *context = NULL;
@@ -76,6 +89,28 @@ static void epoll_init(ogs_pollset_t *pollset)
     context->epfd = epoll_create(pollset->capacity);
     ogs_assert(context->epfd >= 0);
 
+#if HAVE_SYS_TIMERFD_H
+    context->timerfd = timerfd_create(
+            CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+    if (context->timerfd >= 0) {
+        struct epoll_event ee;
+
+        memset(&ee, 0, sizeof ee);
+        ee.events = EPOLLIN;
+        ee.data.fd = context->timerfd;
+        if (epoll_ctl(context->epfd,
+                    EPOLL_CTL_ADD, context->timerfd, &ee) != 0) {
+            ogs_log_message(OGS_LOG_WARN, ogs_socket_errno,
+                    "epoll_ctl() for timerfd failed");
+            close(context->timerfd);
+            context->timerfd = -1;
+        }
+    } else {
+        ogs_log_message(OGS_LOG_WARN, ogs_socket_errno,
+                "timerfd_create() failed");
+    }
+#endif
+
     ogs_notify_init(pollset);
 }
 
@@ -88,6 +123,10 @@ static void epoll_cleanup(ogs_pollset_t *pollset)
     ogs_assert(context);
 
     ogs_notify_final(pollset);
+#if HAVE_SYS_TIMERFD_H
+    if (context->timerfd >= 0)
+        close(context->timerfd);
+#endif
     close(context->epfd);
     ogs_free(context->event_list);
     ogs_hash_destroy(context->map_hash);
@@ -198,6 +237,62 @@ static int epoll_remove(ogs_poll_t *poll)
     return OGS_OK;
 }
 
+/*
+ * epoll_wait() only takes milliseconds, and the timeout is rounded up,
+ * so a PFCP/GTP retransmission timer could fire up to 1ms late.
+ * Use epoll_pwait2() when the kernel has it. Otherwise, a timeout with
+ * a sub-millisecond part is left to the timerfd in the epoll set.
+ */
+static int epoll_wait_timeout(struct epoll_context_s *context,
+        unsigned int capacity, ogs_time_t timeout)
+{
+    int msec;
+
+#if HAVE_EPOLL_PWAIT2
+    if (!no_epoll_pwait2) {
+        struct timespec ts, *tp = NULL;
+        int n;
+
+        if (timeout != OGS_INFINITE_TIME) {
+            ts.tv_sec = ogs_time_sec(timeout);
+            ts.tv_nsec = ogs_time_usec(timeout) * 1000;
+            tp = &ts;
+        }
+
+        n = epoll_pwait2(context->epfd,
+                context->event_list, capacity, tp, NULL);
+        if (n >= 0 || errno != ENOSYS)
+            return n;
+
+        no_epoll_pwait2 = true;
+    }
+#endif
+
+    msec = timeout == OGS_INFINITE_TIME ? -1 : ogs_time_to_msec(timeout);
+
+#if HAVE_SYS_TIMERFD_H
+    if (context->timerfd >= 0) {
+        struct itimerspec its;
+
+        memset(&its, 0, sizeof its);
+        if (timeout != OGS_INFINITE_TIME && ogs_time_usec(timeout) % 1000) {
+            its.it_value.tv_sec = ogs_time_sec(timeout);
+            its.it_value.tv_nsec = ogs_time_usec(timeout) * 1000;
+            if (timerfd_settime(context->timerfd, 0, &its, NULL) == 0) {
+                context->timer_armed = true;
+                msec = -1;
+            }
+        } else if (context->timer_armed) {
+            /* Disarm so that it does not wake up the next wait */
+            timerfd_settime(context->timerfd, 0, &its, NULL);
+            context->timer_armed = false;
+        }
+    }
+#endif
+
+    return epoll_wait(context->epfd, context->event_list, capacity, msec);
+}
+
 static int epoll_process(ogs_pollset_t *pollset, ogs_time_t timeout)
 {
     struct epoll_context_s *context = NULL;
@@ -208,10 +303,8 @@ static int epoll_process(ogs_pollset_t *pollset, ogs_time_t timeout)
     context = pollset->context;
     ogs_assert(context);
 
-    num_of_poll = epoll_wait(context->epfd, context->event_list,
-            pollset->capacity,
-            timeout == OGS_INFINITE_TIME ? OGS_INFINITE_TIME :
-                ogs_time_to_msec(timeout));
+    num_of_poll = epoll_wait_timeout(context, pollset->capacity, timeout);
+    ogs_loop_time_update();
     if (num_of_poll < 0) {
         ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno, "epoll failed");
         return OGS_ERROR;
@@ -225,6 +318,22 @@ static int epoll_process(ogs_pollset_t *pollset, ogs_time_t timeout)
         short when = 0;
         ogs_socket_t fd;
 
+#if HAVE_SYS_TIMERFD_H
+        if (context->event_list[i].data.fd == context->timerfd) {
+            uint64_t expirations;
+
+            if (read(context->timerfd,
+                        &expirations, sizeof(expirations)) < 0 &&
+                errno != EAGAIN)
+                ogs_log_message(OGS_LOG_ERROR, errno, "timerfd read failed");
+            context->timer_armed = false;
+
+            if (num_of_poll == 1)
+                return OGS_TIMEUP;
+            continue;
+        }
+#endif
+
         received = context->event_list[i].events;
         if (received & EPOLLERR) {
         /*
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+
+#define HMAP_INITIAL_SIZE       16
+#define HMAP_MIGRATE_STEP       8   /* Old slots moved per ogs_hmap_set() */
+
+typedef struct hmap_entry_s {
+    uint32_t hash;
+    uint16_t klen;
+    uint8_t deleted;            /* Tombstone, the probe goes on */
+    union {
+        uint8_t bytes[OGS_HMAP_INLINE_KEY_LEN];
+        const void *ptr;        /* klen > OGS_HMAP_INLINE_KEY_LEN */
+    } key;
+    void *value;                /* NULL : Empty or deleted */
+} hmap_entry_t;
+
+typedef struct hmap_table_s {
+    hmap_entry_t *entry;
+    unsigned int mask;
+    unsigned int used;          /* Entries and tombstones */
+} hmap_table_t;
+
+struct ogs_hmap_s {
+    hmap_table_t cur;
+    hmap_table_t old;           /* Being moved into 'cur' */
+    unsigned int migrate;       /* Next slot of 'old' to move */
+    unsigned int old_count;     /* Entries left in 'old' */
+
+    unsigned int count;
+    uint64_t seed;
+};
+
+static ogs_inline uint64_t hmap_mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= UINT64_C(0xff51afd7ed558ccd);
+    x ^= x >> 33;
+    x *= UINT64_C(0xc4ceb9fe1a85ec53);
+    x ^= x >> 33;
+
+    return x;
+}
+
+/* Word-at-a-time hash, with a single mix for 32/64-bit keys */
+static uint32_t hmap_hash(ogs_hmap_t *map, const void *key, int klen)
+{
+    const uint8_t *p = key;
+    uint64_t h = map->seed ^ (uint64_t)klen, w;
+    uint32_t w32;
+
+    if (klen == 4) {
+        memcpy(&w32, p, sizeof(w32));
+        return (uint32_t)hmap_mix(h ^ w32);
+    } else if (klen == 8) {
+        memcpy(&w, p, sizeof(w));
+        return (uint32_t)hmap_mix(h ^ w);
+    }
+
+    while (klen >= 8) {
+        memcpy(&w, p, sizeof(w));
+        h = hmap_mix(h ^ w);
+        p += 8;
+        klen -= 8;
+    }
+    if (klen) {
+        w = 0;
+        memcpy(&w, p, klen);
+        h = hmap_mix(h ^ w);
+    }
+
+    return (uint32_t)h;
+}
+
+static ogs_inline const void *entry_key(hmap_entry_t *e)
+{
+    return e->klen > OGS_HMAP_INLINE_KEY_LEN ? e->key.ptr : e->key.bytes;
+}
+
+static int table_alloc(hmap_table_t *t, unsigned int size)
+{
+    t->entry = ogs_calloc(size, sizeof(hmap_entry_t));
+    if (!t->entry) {
+        ogs_error("ogs_calloc() failed");
+        return OGS_ERROR;
+    }
+    t->mask = size - 1;
+    t->used = 0;
+
+    return OGS_OK;
+}
+
+static hmap_entry_t *table_find(hmap_table_t *t,
+        uint32_t hash, const void *key, int klen)
+{
+    hmap_entry_t *e = NULL;
+    unsigned int i;
+
+    if (!t->entry)
+        return NULL;
+
+    for (i = hash & t->mask; ; i = (i + 1) & t->mask) {
+        e = &t->entry[i];
+        if (!e->value) {
+            if (!e->deleted)
+                return NULL;
+            continue;
+        }
+        if (e->hash == hash && e->klen == klen &&
+            memcmp(entry_key(e), key, klen) == 0)
+            return e;
+    }
+}
+
+/* The key must not be in the table */
+static hmap_entry_t *table_insert(hmap_table_t *t, uint32_t hash)
+{
+    hmap_entry_t *e = NULL;
+    unsigned int i;
+
+    for (i = hash & t->mask; ; i = (i + 1) & t->mask) {
+        e = &t->entry[i];
+        if (!e->value) {
+            if (!e->deleted)
+                t->used++;
+            return e;
+        }
+    }
+}
+
+static void hmap_migrate(ogs_hmap_t *map, unsigned int n)
+{
+    hmap_entry_t *e = NULL;
+
+    while (map->old.entry && n--) {
+        e = &map->old.entry[map->migrate++];
+        if (e->value) {
+            *table_insert(&map->cur, e->hash) = *e;
+            map->old_count--;
+
+            /* Lookups must not find the moved copy in 'old' any more */
+            e->value = NULL;
+            e->deleted = 1;
+        }
+
+        if (map->migrate > map->old.mask) {
+            ogs_free(map->old.entry);
+            memset(&map->old, 0, sizeof(map->old));
+            map->migrate = 0;
+        }
+    }
+}
+
+static int hmap_grow(ogs_hmap_t *map)
+{
+    hmap_table_t t;
+    unsigned int size = HMAP_INITIAL_SIZE;
+
+    /* Half full after the move, tombstones are dropped on the way */
+    while (size < (map->count + 1) * 2)
+        size <<= 1;
+
+    if (table_alloc(&t, size) != OGS_OK)
+        return OGS_ERROR;
+
+    /* Only one move at a time */
+    hmap_migrate(map, map->old.mask + 1);
+
+    map->old = map->cur;
+    map->old_count = map->count;
+    map->migrate = 0;
+    map->cur = t;
+
+    return OGS_OK;
+}
+
+ogs_hmap_t *ogs_hmap_create(void)
+{
+    ogs_hmap_t *map = NULL;
+    ogs_time_t now = ogs_get_monotonic_time();
+
+    map = ogs_calloc(1, sizeof(*map));
+    if (!map) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    if (table_alloc(&map->cur, HMAP_INITIAL_SIZE) != OGS_OK) {
+        ogs_free(map);
+        return NULL;
+    }
+
+    map->seed = hmap_mix((uint64_t)now ^ (uintptr_t)map);
+
+    return map;
+}
+
+void ogs_hmap_destroy(ogs_hmap_t *map)
+{
+    ogs_assert(map);
+
+    if (map->old.entry)
+        ogs_free(map->old.entry);
+    ogs_free(map->cur.entry);
+
+    ogs_free(map);
+}
+
+void ogs_hmap_set(ogs_hmap_t *map, const void *key, int klen, const void *val)
+{
+    hmap_entry_t *e = NULL;
+    bool in_old = false;
+    uint32_t hash;
+
+    ogs_assert(map);
+    ogs_assert(key);
+
+    if (klen == OGS_HASH_KEY_STRING)
+        klen = strlen(key);
+    ogs_assert(klen >= 0 && klen <= UINT16_MAX);
+
+    hash = hmap_hash(map, key, klen);
+
+    hmap_migrate(map, HMAP_MIGRATE_STEP);
+
+    e = table_find(&map->cur, hash, key, klen);
+    if (!e && map->old.entry) {
+        e = table_find(&map->old, hash, key, klen);
+        in_old = true;
+    }
+
+    if (e) {
+        if (val) {
+            if (klen > OGS_HMAP_INLINE_KEY_LEN)
+                e->key.ptr = key;
+            e->value = (void *)val;
+        } else {
+            e->value = NULL;
+            e->deleted = 1;
+            map->count--;
+            if (in_old)
+                map->old_count--;
+        }
+        return;
+    }
+
+    if (!val)
+        return;
+
+    if ((map->cur.used + map->old_count + 1) * 4 > (map->cur.mask + 1) * 3)
+        ogs_assert(hmap_grow(map) == OGS_OK);
+
+    e = table_insert(&map->cur, hash);
+    e->hash = hash;
+    e->klen = klen;
+    e->deleted = 0;
+    if (klen > OGS_HMAP_INLINE_KEY_LEN)
+        e->key.ptr = key;
+    else
+        memcpy(e->key.bytes, key, klen);
+    e->value = (void *)val;
+
+    map->count++;
+}
+
+void *ogs_hmap_get(ogs_hmap_t *map, const void *key, int klen)
+{
+    hmap_entry_t *e = NULL;
+    uint32_t hash;
+
+    ogs_assert(map);
+    ogs_assert(key);
+
+    if (klen == OGS_HASH_KEY_STRING)
+        klen = strlen(key);
+
+    hash = hmap_hash(map, key, klen);
+
+    e = table_find(&map->cur, hash, key, klen);
+    if (!e && map->old.entry)
+        e = table_find(&map->old, hash, key, klen);
+
+    return e ? e->value : NULL;
+}
+
+unsigned int ogs_hmap_count(ogs_hmap_t *map)
+{
+    ogs_assert(map);
+
+    return map->count;
+}
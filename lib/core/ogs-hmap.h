@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_CORE_INSIDE) && !defined(OGS_CORE_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_HMAP_H
+#define OGS_HMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Open Addressing Hash Map
+ *
+ * Linear probing over a flat entry array, without any allocation per
+ * insert. Keys up to OGS_HMAP_INLINE_KEY_LEN bytes (TEID, SEID, IPv4/IPv6
+ * address, IMSI, GUTI) are copied into the entry. A longer key, such as
+ * a SUPI string, is referenced like ogs_hash does, so its memory must
+ * stay valid while the key is in the map.
+ *
+ * When the map grows, the entries are moved to the new table a few at
+ * a time on each ogs_hmap_set(), so there is no full rehash pause.
+ * ogs_hmap_get() never modifies the map, so concurrent readers are safe
+ * as long as the writer is excluded.
+ *
+ * Setting a NULL value removes the key, as in ogs_hash_set().
+ */
+#define OGS_HMAP_INLINE_KEY_LEN     16
+
+typedef struct ogs_hmap_s ogs_hmap_t;
+
+ogs_hmap_t *ogs_hmap_create(void);
+void ogs_hmap_destroy(ogs_hmap_t *map);
+
+void ogs_hmap_set(ogs_hmap_t *map, const void *key, int klen, const void *val);
+void *ogs_hmap_get(ogs_hmap_t *map, const void *key, int klen);
+
+unsigned int ogs_hmap_count(ogs_hmap_t *map);
+
+/*
+ * Type-specialised accessors for fixed-width integer keys:
+ *   ogs_hmap_set_u32(map, teid, val), ogs_hmap_get_u64(map, seid), ...
+ */
+#define OGS_HMAP_KEY_TYPE(name, type) \
+static ogs_inline void ogs_hmap_set_##name( \
+        ogs_hmap_t *map, type key, const void *val) \
+{ \
+    ogs_hmap_set(map, &key, sizeof(key), val); \
+} \
+static ogs_inline void *ogs_hmap_get_##name(ogs_hmap_t *map, type key) \
+{ \
+    return ogs_hmap_get(map, &key, sizeof(key)); \
+}
+
+OGS_HMAP_KEY_TYPE(u32, uint32_t)
+OGS_HMAP_KEY_TYPE(u64, uint64_t)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_HMAP_H */
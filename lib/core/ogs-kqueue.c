@@ -205,6 +205,7 @@ static int kqueue_process(ogs_pollset_t *pollset, ogs_time_t timeout)
     n = kevent(context->kqueue,
             context->change_list, context->nchanges,
             context->event_list, context->nevents, tp);
+    ogs_loop_time_update();
 
     context->nchanges = 0;
 
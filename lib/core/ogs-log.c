@@ -27,6 +27,10 @@
 #include <stdarg.h>
 #endif
 
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 #include "ogs-core.h"
 
 #define TA_NOR              "\033[0m"       /* all off */
@@ -74,6 +78,10 @@ typedef struct ogs_log_s {
 
     void (*writer)(ogs_log_t *log, ogs_log_level_e level, const char *string);
 
+    /* Messages dropped by the asynchronous writer */
+    uint64_t dropped;
+    uint64_t reported;
+
 } ogs_log_t;
 
 typedef struct ogs_log_domain_s {
@@ -111,6 +119,66 @@ static char *log_linefeed(char *buf, char *last);
 static void file_writer(
         ogs_log_t *log, ogs_log_level_e level, const char *string);
 
+/*
+ * Asynchronous Writer
+ *
+ * Each thread formats its messages as usual, but appends them to its
+ * own ring instead of writing the file. The ring has a single producer
+ * (the thread) and a single consumer (the writer thread), so both sides
+ * only need acquire/release ordering on 'head' and 'tail'.
+ *
+ * The writer thread drains every ring and writes the records of each
+ * log with writev(). When a ring is full, the message is dropped and
+ * counted; the writer reports the count in the log later on.
+ * FATAL messages are always written synchronously.
+ */
+#define LOG_RING_SIZE           (256 * 1024)
+#define LOG_RING_MASK           (LOG_RING_SIZE - 1)
+#define LOG_IOV_MAX             64
+#define LOG_FLUSH_INTERVAL      ogs_time_from_msec(100)
+
+typedef struct log_record_s {
+    ogs_log_t *log;             /* NULL : Skip to the end of the ring */
+    uint32_t len;
+} log_record_t;
+
+#define LOG_RECORD_SIZE(len) \
+    ((sizeof(log_record_t) + (len) + 7) & ~(size_t)7)
+
+typedef struct log_ring_s {
+    ogs_lnode_t node;
+    bool orphan;                /* The thread that owned it has exited */
+
+    /* Padded, as ogs_calloc() does not align the ring to a cache line */
+    char pad0[OGS_CACHE_LINE_SIZE];
+    uint64_t head;              /* Written by the producer */
+    char pad1[OGS_CACHE_LINE_SIZE - sizeof(uint64_t)];
+    uint64_t tail;              /* Written by the writer thread */
+    char pad2[OGS_CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+    char buffer[LOG_RING_SIZE];
+} log_ring_t;
+
+static struct {
+    bool running;
+    bool waiting;               /* The writer thread is about to sleep */
+
+    ogs_thread_t *thread;
+    ogs_thread_mutex_t mutex;   /* Held while writing to the files */
+    ogs_thread_mutex_t wake_mutex;
+    ogs_thread_cond_t cond;     /* Waited on with wake_mutex */
+
+    ogs_list_t ring_list;
+    unsigned int generation;    /* Changed by each start and stop */
+} async;
+
+/* The ring is only valid while the generation is unchanged */
+static OGS_THREAD_LOCAL log_ring_t *log_ring;
+static OGS_THREAD_LOCAL unsigned int log_ring_generation;
+
+static bool async_write(ogs_log_t *log, const char *string);
+static int async_flush(void);
+
 void ogs_log_init(void)
 {
     ogs_pool_init(&log_pool, ogs_core()->log.pool);
@@ -125,6 +193,9 @@ void ogs_log_final(void)
     ogs_log_t *log, *saved_log;
     ogs_log_domain_t *domain, *saved_domain;
 
+    if (async.thread)
+        ogs_log_async_stop();
+
     ogs_list_for_each_safe(&log_list, saved_log, log)
         ogs_log_remove(log);
     ogs_pool_final(&log_pool);
@@ -138,6 +209,10 @@ void ogs_log_cycle(void)
 {
     ogs_log_t *log = NULL;
 
+    /* The writer thread must not write while the file is reopened */
+    if (async.thread)
+        ogs_thread_mutex_lock(&async.mutex);
+
     ogs_list_for_each(&log_list, log) {
         switch(log->type) {
         case OGS_LOG_FILE_TYPE:
@@ -146,6 +221,9 @@ void ogs_log_cycle(void)
             break;
         }
     }
+
+    if (async.thread)
+        ogs_thread_mutex_unlock(&async.mutex);
 }
 
 ogs_log_t *ogs_log_add_stderr(void)
@@ -189,7 +267,15 @@ void ogs_log_remove(ogs_log_t *log)
 {
     ogs_assert(log);
 
-    ogs_list_remove(&log_list, log);
+    /* Write out the pending records before the log goes away */
+    if (async.thread) {
+        ogs_thread_mutex_lock(&async.mutex);
+        async_flush();
+        ogs_list_remove(&log_list, log);
+        ogs_thread_mutex_unlock(&async.mutex);
+    } else {
+        ogs_list_remove(&log_list, log);
+    }
 
     if (log->type == OGS_LOG_FILE_TYPE) {
         ogs_assert(log->file.out);
@@ -503,6 +589,318 @@ void ogs_log_hexdump_func(ogs_log_level_e level, int id,
     ogs_log_print(level, "%s", dumpstr);
 }
 
+static log_record_t *ring_record(log_ring_t *ring, uint64_t *offset)
+{
+    log_record_t *record = NULL;
+    size_t pos = *offset & LOG_RING_MASK;
+
+    if (LOG_RING_SIZE - pos < sizeof(*record)) {
+        *offset += LOG_RING_SIZE - pos;
+        return NULL;
+    }
+
+    record = (log_record_t *)(ring->buffer + pos);
+    if (!record->log) {
+        *offset += LOG_RING_SIZE - pos;
+        return NULL;
+    }
+
+    *offset += LOG_RECORD_SIZE(record->len);
+    return record;
+}
+
+static log_ring_t *ring_get(void)
+{
+    log_ring_t *ring = NULL;
+
+    if (log_ring && log_ring_generation ==
+            __atomic_load_n(&async.generation, __ATOMIC_ACQUIRE))
+        return log_ring;
+
+    ogs_thread_mutex_lock(&async.mutex);
+
+    /* Take over the ring of a thread that has exited */
+    ogs_list_for_each(&async.ring_list, ring) {
+        if (ring->orphan == true) {
+            ring->orphan = false;
+            break;
+        }
+    }
+
+    if (!ring) {
+        ring = ogs_calloc(1, sizeof(*ring));
+        if (ring)
+            ogs_list_add(&async.ring_list, ring);
+    }
+
+    log_ring_generation = async.generation;
+
+    ogs_thread_mutex_unlock(&async.mutex);
+
+    log_ring = ring;
+    return ring;
+}
+
+static bool async_write(ogs_log_t *log, const char *string)
+{
+    log_ring_t *ring = NULL;
+    log_record_t *record = NULL;
+    uint64_t head, tail;
+    size_t len, need, pad, pos;
+
+    ring = ring_get();
+    if (!ring)
+        return false;
+
+    len = strlen(string);
+    need = LOG_RECORD_SIZE(len);
+
+    head = ring->head;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    /* A record never wraps around the end of the ring */
+    pos = head & LOG_RING_MASK;
+    pad = (LOG_RING_SIZE - pos < need) ? LOG_RING_SIZE - pos : 0;
+
+    if (head + pad + need - tail > LOG_RING_SIZE) {
+        __atomic_fetch_add(&log->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    if (pad) {
+        if (pad >= sizeof(*record)) {
+            record = (log_record_t *)(ring->buffer + pos);
+            record->log = NULL;
+        }
+        head += pad;
+        pos = 0;
+    }
+
+    record = (log_record_t *)(ring->buffer + pos);
+    record->log = log;
+    record->len = len;
+    memcpy(record + 1, string, len);
+
+    __atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+
+    /* The producer never waits for the writer thread doing I/O */
+    if (__atomic_load_n(&async.waiting, __ATOMIC_ACQUIRE)) {
+        ogs_thread_mutex_lock(&async.wake_mutex);
+        ogs_thread_cond_signal(&async.cond);
+        ogs_thread_mutex_unlock(&async.wake_mutex);
+    }
+
+    return true;
+}
+
+static void log_writev(ogs_log_t *log, struct iovec *iov, int iovcnt)
+{
+#if HAVE_SYS_UIO_H
+    ssize_t sent;
+    int fd = fileno(log->file.out);
+
+    while (iovcnt > 0) {
+        sent = writev(fd, iov, iovcnt);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        /* Skip what has been written on a partial write */
+        while (iovcnt > 0 && sent >= (ssize_t)iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+#else
+    int i;
+
+    for (i = 0; i < iovcnt; i++)
+        fwrite(iov[i].iov_base, 1, iov[i].iov_len, log->file.out);
+    fflush(log->file.out);
+#endif
+}
+
+static int ring_drain(log_ring_t *ring)
+{
+    ogs_log_t *log = NULL;
+    log_record_t *record = NULL;
+    struct iovec iov[LOG_IOV_MAX];
+    uint64_t head, tail, offset;
+    int n;
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    tail = ring->tail;
+
+    if (head != tail) {
+        ogs_list_for_each(&log_list, log) {
+            n = 0;
+            for (offset = tail; offset < head; ) {
+                record = ring_record(ring, &offset);
+                if (!record || record->log != log)
+                    continue;
+
+                iov[n].iov_base = record + 1;
+                iov[n].iov_len = record->len;
+                if (++n == LOG_IOV_MAX) {
+                    log_writev(log, iov, n);
+                    n = 0;
+                }
+            }
+            if (n)
+                log_writev(log, iov, n);
+        }
+
+        __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    }
+
+    return head != tail;
+}
+
+static void log_report(ogs_log_t *log)
+{
+    char buf[OGS_HUGE_LEN];
+    struct iovec iov;
+    uint64_t dropped;
+
+    dropped = __atomic_load_n(&log->dropped, __ATOMIC_RELAXED);
+    if (dropped == log->reported)
+        return;
+
+    ogs_snprintf(buf, sizeof(buf), "%llu log messages dropped\n",
+            (unsigned long long)(dropped - log->reported));
+    log->reported = dropped;
+
+    iov.iov_base = buf;
+    iov.iov_len = strlen(buf);
+    log_writev(log, &iov, 1);
+}
+
+/* Called with async.mutex held */
+static int async_flush(void)
+{
+    ogs_log_t *log = NULL;
+    log_ring_t *ring = NULL;
+    int drained = 0;
+
+    ogs_list_for_each(&async.ring_list, ring)
+        drained += ring_drain(ring);
+    ogs_list_for_each(&log_list, log)
+        log_report(log);
+
+    return drained;
+}
+
+static void async_main(void *data)
+{
+    bool running;
+    int drained;
+
+    do {
+        running = __atomic_load_n(&async.running, __ATOMIC_ACQUIRE);
+
+        ogs_thread_mutex_lock(&async.mutex);
+        drained = async_flush();
+        ogs_thread_mutex_unlock(&async.mutex);
+
+        if (running && !drained) {
+            ogs_thread_mutex_lock(&async.wake_mutex);
+            __atomic_store_n(&async.waiting, true, __ATOMIC_RELEASE);
+            if (__atomic_load_n(&async.running, __ATOMIC_ACQUIRE))
+                ogs_thread_cond_timedwait(
+                        &async.cond, &async.wake_mutex, LOG_FLUSH_INTERVAL);
+            __atomic_store_n(&async.waiting, false, __ATOMIC_RELEASE);
+            ogs_thread_mutex_unlock(&async.wake_mutex);
+        }
+    } while (running);
+}
+
+int ogs_log_async_start(void)
+{
+    ogs_assert(!async.thread);
+
+    ogs_thread_mutex_init(&async.mutex);
+    ogs_thread_mutex_init(&async.wake_mutex);
+    ogs_thread_cond_init(&async.cond);
+    ogs_list_init(&async.ring_list);
+
+    __atomic_add_fetch(&async.generation, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&async.running, true, __ATOMIC_RELEASE);
+
+    async.thread = ogs_thread_create(async_main, NULL);
+    if (!async.thread) {
+        ogs_error("ogs_thread_create() failed");
+        __atomic_store_n(&async.running, false, __ATOMIC_RELEASE);
+        ogs_thread_cond_destroy(&async.cond);
+        ogs_thread_mutex_destroy(&async.wake_mutex);
+        ogs_thread_mutex_destroy(&async.mutex);
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+void ogs_log_async_stop(void)
+{
+    log_ring_t *ring = NULL, *next_ring = NULL;
+
+    ogs_assert(async.thread);
+
+    /* Messages are written synchronously from now on */
+    ogs_thread_mutex_lock(&async.wake_mutex);
+    __atomic_store_n(&async.running, false, __ATOMIC_RELEASE);
+    ogs_thread_cond_signal(&async.cond);
+    ogs_thread_mutex_unlock(&async.wake_mutex);
+
+    ogs_thread_destroy(async.thread);
+    async.thread = NULL;
+
+    /* The rings cached by the other threads are dropped on their next use */
+    __atomic_add_fetch(&async.generation, 1, __ATOMIC_RELEASE);
+
+    ogs_list_for_each_safe(&async.ring_list, next_ring, ring) {
+        ogs_list_remove(&async.ring_list, ring);
+        ogs_free(ring);
+    }
+    log_ring = NULL;
+
+    ogs_thread_cond_destroy(&async.cond);
+    ogs_thread_mutex_destroy(&async.wake_mutex);
+    ogs_thread_mutex_destroy(&async.mutex);
+}
+
+void ogs_log_async_release(void)
+{
+    if (!log_ring)
+        return;
+
+    /* Already freed by ogs_log_async_stop() */
+    if (log_ring_generation !=
+            __atomic_load_n(&async.generation, __ATOMIC_ACQUIRE)) {
+        log_ring = NULL;
+        return;
+    }
+
+    ogs_thread_mutex_lock(&async.mutex);
+    log_ring->orphan = true;
+    ogs_thread_mutex_unlock(&async.mutex);
+
+    log_ring = NULL;
+}
+
+uint64_t ogs_log_async_dropped(ogs_log_t *log)
+{
+    ogs_assert(log);
+
+    return __atomic_load_n(&log->dropped, __ATOMIC_RELAXED);
+}
+
 static ogs_log_t *add_log(ogs_log_type_e type)
 {
     ogs_log_t *log = NULL;
@@ -540,13 +938,18 @@ static int file_cycle(ogs_log_t *log)
 static char *log_timestamp(char *buf, char *last,
         int use_color)
 {
+    /* localtime() is only needed once a second */
+    static OGS_THREAD_LOCAL time_t cached_sec = -1;
+    static OGS_THREAD_LOCAL char nowstr[32];
     struct timeval tv;
     struct tm tm;
-    char nowstr[32];
 
     ogs_gettimeofday(&tv);
-    ogs_localtime(tv.tv_sec, &tm);
-    strftime(nowstr, sizeof nowstr, "%m/%d %H:%M:%S", &tm);
+    if (tv.tv_sec != cached_sec) {
+        ogs_localtime(tv.tv_sec, &tm);
+        strftime(nowstr, sizeof nowstr, "%m/%d %H:%M:%S", &tm);
+        cached_sec = tv.tv_sec;
+    }
 
     buf = ogs_slprintf(buf, last, "%s%s.%03d%s: ",
             use_color ? TA_FGC_GREEN : "",
@@ -619,6 +1022,21 @@ static char *log_linefeed(char *buf, char *last)
 static void file_writer(
         ogs_log_t *log, ogs_log_level_e level, const char *string)
 {
+    if (__atomic_load_n(&async.running, __ATOMIC_ACQUIRE)) {
+        if (level != OGS_LOG_FATAL) {
+            if (async_write(log, string) == true)
+                return;
+        } else {
+            /* Write out the pending records before aborting */
+            ogs_thread_mutex_lock(&async.mutex);
+            async_flush();
+            fprintf(log->file.out, "%s", string);
+            fflush(log->file.out);
+            ogs_thread_mutex_unlock(&async.mutex);
+            return;
+        }
+    }
+
     fprintf(log->file.out, "%s", string);
     fflush(log->file.out);
 }
@@ -102,6 +102,11 @@ void ogs_log_printf(ogs_log_level_e level, int domain_id,
 void ogs_log_hexdump_func(ogs_log_level_e level, int domain_id,
     const unsigned char *data, size_t len);
 
+int ogs_log_async_start(void);
+void ogs_log_async_stop(void);
+void ogs_log_async_release(void);
+uint64_t ogs_log_async_dropped(ogs_log_t *log);
+
 #define ogs_assert(expr) \
     do { \
         if (ogs_likely(expr)) ; \
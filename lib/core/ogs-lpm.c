@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+
+#define LPM_L0_BITS         16
+#define LPM_L0_SIZE         (1 << LPM_L0_BITS)
+#define LPM_LN_BITS         8
+#define LPM_LN_SIZE         (1 << LPM_LN_BITS)
+
+/*
+ * Each entry holds the longest prefix covering the whole entry.
+ * If a longer prefix lives below it, the entry also owns a child table
+ * whose entries were seeded with this one, so the lookup only needs
+ * the data of the last entry it reaches.
+ */
+typedef struct lpm_entry_s {
+    void *data;                 /* NULL : No route */
+    struct lpm_entry_s *child;  /* Next stride table */
+    uint8_t depth;              /* Prefix length of the data */
+} lpm_entry_t;
+
+/* Prefix length followed by the masked key, used as the hash key */
+typedef struct lpm_rule_s {
+    uint8_t hkey[1 + OGS_LPM_MAX_KEY_LEN];
+    void *data;
+} lpm_rule_t;
+
+struct ogs_lpm_s {
+    int key_len;
+    lpm_entry_t *table;
+
+    ogs_hash_t *rule_hash;
+};
+
+static void lpm_mask(uint8_t *dst, const uint8_t *key, int key_len, int len)
+{
+    int i;
+
+    for (i = 0; i < key_len; i++) {
+        if (len >= 8)
+            dst[i] = key[i];
+        else if (len > 0)
+            dst[i] = key[i] & (uint8_t)(0xff << (8 - len));
+        else
+            dst[i] = 0;
+
+        len -= 8;
+    }
+}
+
+static lpm_rule_t *lpm_rule_find(ogs_lpm_t *lpm, const uint8_t *key, int len)
+{
+    uint8_t hkey[1 + OGS_LPM_MAX_KEY_LEN];
+
+    hkey[0] = len;
+    lpm_mask(hkey + 1, key, lpm->key_len, len);
+
+    return ogs_hash_get(lpm->rule_hash, hkey, 1 + lpm->key_len);
+}
+
+/* Level 0 covers the first 16 bits, level N the 8 bits below it */
+static int lpm_level(int len)
+{
+    if (len <= LPM_L0_BITS)
+        return 0;
+
+    return (len - LPM_L0_BITS + LPM_LN_BITS - 1) / LPM_LN_BITS;
+}
+
+static int lpm_level_end(int level)
+{
+    return LPM_L0_BITS + level * LPM_LN_BITS;
+}
+
+static lpm_entry_t *lpm_child_create(lpm_entry_t *parent)
+{
+    lpm_entry_t *child = NULL;
+    int i;
+
+    child = ogs_calloc(LPM_LN_SIZE, sizeof(*child));
+    if (!child) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    for (i = 0; i < LPM_LN_SIZE; i++) {
+        child[i].data = parent->data;
+        child[i].depth = parent->depth;
+    }
+
+    parent->child = child;
+
+    return child;
+}
+
+static void lpm_child_destroy(lpm_entry_t *parent)
+{
+    int i;
+
+    if (!parent->child)
+        return;
+
+    for (i = 0; i < LPM_LN_SIZE; i++)
+        lpm_child_destroy(&parent->child[i]);
+
+    ogs_free(parent->child);
+    parent->child = NULL;
+}
+
+/*
+ * Returns the table that holds prefixes of the given length,
+ * and the first entry/number of entries expanded from the prefix.
+ */
+static lpm_entry_t *lpm_table_range(ogs_lpm_t *lpm,
+        const uint8_t *key, int len, bool create, int *first, int *num)
+{
+    lpm_entry_t *table = lpm->table;
+    int level, i, span;
+
+    level = lpm_level(len);
+    span = 1 << (lpm_level_end(level) - len);
+
+    if (level == 0) {
+        *first = ((key[0] << 8) | key[1]) & ~(span - 1);
+        *num = span;
+        return table;
+    }
+
+    table = &table[(key[0] << 8) | key[1]];
+    for (i = 1; i < level; i++) {
+        if (!table->child) {
+            if (!create) return NULL;
+            if (!lpm_child_create(table)) return NULL;
+        }
+        table = &table->child[key[i+1]];
+    }
+
+    if (!table->child) {
+        if (!create) return NULL;
+        if (!lpm_child_create(table)) return NULL;
+    }
+
+    *first = key[level+1] & ~(span - 1);
+    *num = span;
+    return table->child;
+}
+
+static void lpm_entry_update(lpm_entry_t *entry, void *data, int len)
+{
+    int i;
+
+    if (!entry->data || entry->depth <= len) {
+        entry->data = data;
+        entry->depth = len;
+    }
+
+    if (entry->child) {
+        for (i = 0; i < LPM_LN_SIZE; i++)
+            lpm_entry_update(&entry->child[i], data, len);
+    }
+}
+
+static void lpm_entry_replace(lpm_entry_t *entry,
+        int len, void *data, int depth)
+{
+    int i;
+
+    if (entry->data && entry->depth == len) {
+        entry->data = data;
+        entry->depth = data ? depth : 0;
+    }
+
+    if (entry->child) {
+        lpm_entry_t *child = entry->child;
+
+        for (i = 0; i < LPM_LN_SIZE; i++)
+            lpm_entry_replace(&child[i], len, data, depth);
+
+        /* Release the child table once it no longer adds anything */
+        for (i = 0; i < LPM_LN_SIZE; i++) {
+            if (child[i].child ||
+                child[i].data != entry->data ||
+                child[i].depth != entry->depth)
+                break;
+        }
+        if (i == LPM_LN_SIZE) {
+            ogs_free(child);
+            entry->child = NULL;
+        }
+    }
+}
+
+ogs_lpm_t *ogs_lpm_create(int key_len)
+{
+    ogs_lpm_t *lpm = NULL;
+
+    ogs_assert(key_len == 4 || key_len == OGS_LPM_MAX_KEY_LEN);
+
+    lpm = ogs_calloc(1, sizeof(*lpm));
+    if (!lpm) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    lpm->key_len = key_len;
+
+    lpm->table = ogs_calloc(LPM_L0_SIZE, sizeof(lpm_entry_t));
+    if (!lpm->table) {
+        ogs_error("ogs_calloc() failed");
+        ogs_free(lpm);
+        return NULL;
+    }
+
+    lpm->rule_hash = ogs_hash_make();
+    ogs_assert(lpm->rule_hash);
+
+    return lpm;
+}
+
+void ogs_lpm_destroy(ogs_lpm_t *lpm)
+{
+    ogs_hash_index_t *hi = NULL;
+    int i;
+
+    ogs_assert(lpm);
+
+    for (hi = ogs_hash_first(lpm->rule_hash); hi; hi = ogs_hash_next(hi)) {
+        lpm_rule_t *rule = ogs_hash_this_val(hi);
+        ogs_hash_set(lpm->rule_hash, rule->hkey, 1 + lpm->key_len, NULL);
+        ogs_free(rule);
+    }
+    ogs_hash_destroy(lpm->rule_hash);
+
+    for (i = 0; i < LPM_L0_SIZE; i++)
+        lpm_child_destroy(&lpm->table[i]);
+    ogs_free(lpm->table);
+
+    ogs_free(lpm);
+}
+
+int ogs_lpm_add(ogs_lpm_t *lpm, const void *key, int prefix_len, void *data)
+{
+    uint8_t masked[OGS_LPM_MAX_KEY_LEN];
+    lpm_entry_t *table = NULL;
+    lpm_rule_t *rule = NULL;
+    int i, first, num;
+
+    ogs_assert(lpm);
+    ogs_assert(key);
+    ogs_assert(data);
+
+    if (prefix_len < 0 || prefix_len > lpm->key_len * 8) {
+        ogs_error("Invalid prefix length [%d]", prefix_len);
+        return OGS_ERROR;
+    }
+
+    lpm_mask(masked, key, lpm->key_len, prefix_len);
+
+    table = lpm_table_range(lpm, masked, prefix_len, true, &first, &num);
+    if (!table) {
+        ogs_error("lpm_table_range() failed");
+        return OGS_ERROR;
+    }
+
+    rule = lpm_rule_find(lpm, masked, prefix_len);
+    if (!rule) {
+        rule = ogs_calloc(1, sizeof(*rule));
+        if (!rule) {
+            ogs_error("ogs_calloc() failed");
+            return OGS_ERROR;
+        }
+        rule->hkey[0] = prefix_len;
+        memcpy(rule->hkey + 1, masked, lpm->key_len);
+        ogs_hash_set(lpm->rule_hash, rule->hkey, 1 + lpm->key_len, rule);
+    }
+    rule->data = data;
+
+    for (i = first; i < first + num; i++)
+        lpm_entry_update(&table[i], data, prefix_len);
+
+    return OGS_OK;
+}
+
+int ogs_lpm_delete(ogs_lpm_t *lpm, const void *key, int prefix_len)
+{
+    uint8_t masked[OGS_LPM_MAX_KEY_LEN];
+    lpm_entry_t *table = NULL;
+    lpm_rule_t *rule = NULL, *parent = NULL;
+    int i, first, num, depth;
+
+    ogs_assert(lpm);
+    ogs_assert(key);
+
+    if (prefix_len < 0 || prefix_len > lpm->key_len * 8) {
+        ogs_error("Invalid prefix length [%d]", prefix_len);
+        return OGS_ERROR;
+    }
+
+    lpm_mask(masked, key, lpm->key_len, prefix_len);
+
+    rule = lpm_rule_find(lpm, masked, prefix_len);
+    if (!rule)
+        return OGS_ERROR;
+
+    ogs_hash_set(lpm->rule_hash, rule->hkey, 1 + lpm->key_len, NULL);
+    ogs_free(rule);
+
+    /* The entries fall back to the longest prefix covering this one */
+    for (depth = prefix_len - 1; depth >= 0; depth--) {
+        parent = lpm_rule_find(lpm, masked, depth);
+        if (parent)
+            break;
+    }
+
+    table = lpm_table_range(lpm, masked, prefix_len, false, &first, &num);
+    ogs_assert(table);
+
+    for (i = first; i < first + num; i++)
+        lpm_entry_replace(&table[i], prefix_len,
+                parent ? parent->data : NULL, parent ? depth : 0);
+
+    return OGS_OK;
+}
+
+void *ogs_lpm_find(ogs_lpm_t *lpm, const void *key)
+{
+    const uint8_t *k = key;
+    lpm_entry_t *entry = NULL;
+    int i = 2;
+
+    ogs_assert(lpm);
+    ogs_assert(key);
+
+    entry = &lpm->table[(k[0] << 8) | k[1]];
+    while (entry->child)
+        entry = &entry->child[k[i++]];
+
+    return entry->data;
+}
+
+void *ogs_lpm_find_exact(ogs_lpm_t *lpm, const void *key, int prefix_len)
+{
+    lpm_rule_t *rule = NULL;
+
+    ogs_assert(lpm);
+    ogs_assert(key);
+
+    if (prefix_len < 0 || prefix_len > lpm->key_len * 8)
+        return NULL;
+
+    rule = lpm_rule_find(lpm, key, prefix_len);
+
+    return rule ? rule->data : NULL;
+}
+
+unsigned int ogs_lpm_count(ogs_lpm_t *lpm)
+{
+    ogs_assert(lpm);
+
+    return ogs_hash_count(lpm->rule_hash);
+}
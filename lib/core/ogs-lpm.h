@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_CORE_INSIDE) && !defined(OGS_CORE_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_LPM_H
+#define OGS_LPM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Longest Prefix Match
+ *
+ * Multibit trie with a 16-bit first stride and 8-bit strides below it
+ * (DIR-16-8-8 for IPv4). Prefixes are expanded into the stride tables,
+ * so a lookup is one array access per level without any comparison.
+ *
+ * Keys are in network byte order. Key length is 4 (IPv4) or 16 (IPv6).
+ */
+#define OGS_LPM_MAX_KEY_LEN     16
+
+typedef struct ogs_lpm_s ogs_lpm_t;
+
+ogs_lpm_t *ogs_lpm_create(int key_len);
+void ogs_lpm_destroy(ogs_lpm_t *lpm);
+
+int ogs_lpm_add(ogs_lpm_t *lpm, const void *key, int prefix_len, void *data);
+int ogs_lpm_delete(ogs_lpm_t *lpm, const void *key, int prefix_len);
+
+void *ogs_lpm_find(ogs_lpm_t *lpm, const void *key);
+void *ogs_lpm_find_exact(ogs_lpm_t *lpm, const void *key, int prefix_len);
+
+unsigned int ogs_lpm_count(ogs_lpm_t *lpm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_LPM_H */
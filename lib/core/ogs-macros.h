@@ -42,6 +42,12 @@ extern "C" {
 #define ogs_inline __inline__
 #endif
 
+#if defined(_MSC_VER)
+#define OGS_THREAD_LOCAL __declspec(thread)
+#else
+#define OGS_THREAD_LOCAL __thread
+#endif
+
 #if defined(_WIN32)
 #define OGS_FUNC __FUNCTION__
 #elif defined(__STDC_VERSION__) && __STDC_VERSION__ < 199901L
@@ -76,6 +82,8 @@ extern "C" {
 #define OGS_GNUC_FALLTHROUGH
 #endif
 
+#define OGS_CACHE_LINE_SIZE 64
+
 #if defined(_WIN32)
 #define htole16(x) (x)
 #define htole32(x) (x)
@@ -76,9 +76,12 @@ typedef struct ogs_pkbuf_pool_s {
     OGS_POOL(cluster_big, ogs_cluster_big_t);
 
     ogs_thread_mutex_t mutex;
+
+    unsigned int generation;    /* 0 once destroyed */
 } ogs_pkbuf_pool_t;
 
 static OGS_POOL(pkbuf_pool, ogs_pkbuf_pool_t);
+static unsigned int pkbuf_pool_generation = 0;
 static ogs_pkbuf_pool_t *default_pool = NULL;
 
 static ogs_cluster_t *cluster_alloc(
@@ -105,6 +108,8 @@ void ogs_pkbuf_init(void)
 
 void ogs_pkbuf_final(void)
 {
+    ogs_pkbuf_cache_flush();
+
 #if OGS_USE_TALLOC == 0
     ogs_pool_final(&pkbuf_pool);
 #endif
@@ -155,6 +160,9 @@ ogs_pkbuf_pool_t *ogs_pkbuf_pool_create(ogs_pkbuf_config_t *config)
 
     ogs_thread_mutex_init(&pool->mutex);
 
+    pool->generation =
+        __atomic_add_fetch(&pkbuf_pool_generation, 1, __ATOMIC_RELAXED);
+
     tmp = config->cluster_128_pool + config->cluster_256_pool +
         config->cluster_512_pool + config->cluster_1024_pool +
         config->cluster_2048_pool + config->cluster_8192_pool +
@@ -196,9 +204,14 @@ ogs_pkbuf_pool_t *ogs_pkbuf_pool_create(ogs_pkbuf_config_t *config)
 
 void ogs_pkbuf_pool_destroy(ogs_pkbuf_pool_t *pool)
 {
+    ogs_pkbuf_cache_flush();
+
 #if OGS_USE_TALLOC == 0
     ogs_assert(pool);
 
+    /* The magazines of the other threads drop the buffers of this pool */
+    __atomic_store_n(&pool->generation, 0, __ATOMIC_RELEASE);
+
     ogs_pkbuf_pool_final(&pool->pkbuf);
     ogs_pool_final(&pool->cluster);
 
@@ -217,12 +230,267 @@ void ogs_pkbuf_pool_destroy(ogs_pkbuf_pool_t *pool)
 #endif
 }
 
+/*
+ * Per-thread pkbuf cache
+ *
+ * The buffers of the common sizes freed by a thread are kept in its
+ * magazines and handed out again without touching the shared pool.
+ * An empty magazine is refilled, and a full one is spilled,
+ * OGS_PKBUF_CACHE_BATCH buffers at a time under a single lock.
+ * A magazine only holds the buffers of one pool.
+ *
+ * ogs_pkbuf_pool_destroy() can only return the magazines of the calling
+ * thread. The other threads see the generation of the pool change and
+ * forget the buffers they still hold, their memory is gone with the pool.
+ */
+#define OGS_PKBUF_CACHE_SIZE        64
+#define OGS_PKBUF_CACHE_BATCH       32
+#define OGS_PKBUF_CACHE_NUM_CLASS   5
+
+static const unsigned int cache_class_size[OGS_PKBUF_CACHE_NUM_CLASS] = {
+    128, 256, 512, 1024, 2048
+};
+
+typedef struct pkbuf_magazine_s {
+    ogs_pkbuf_pool_t *pool;
+    unsigned int generation;
+    int num;
+    ogs_pkbuf_t *pkbuf[OGS_PKBUF_CACHE_SIZE];
+} pkbuf_magazine_t;
+
+typedef struct pkbuf_cache_s {
+    pkbuf_magazine_t magazine[OGS_PKBUF_CACHE_NUM_CLASS];
+    ogs_pkbuf_cache_stat_t stat;
+} pkbuf_cache_t;
+
+static OGS_THREAD_LOCAL pkbuf_cache_t pkbuf_cache;
+
+static void magazine_set_pool(
+        pkbuf_magazine_t *magazine, ogs_pkbuf_pool_t *pool)
+{
+    magazine->pool = pool;
+#if OGS_USE_TALLOC == 0
+    magazine->generation = pool->generation;
+#endif
+}
+
+static void magazine_check(pkbuf_magazine_t *magazine)
+{
+#if OGS_USE_TALLOC == 0
+    if (magazine->num && magazine->generation !=
+            __atomic_load_n(&magazine->pool->generation, __ATOMIC_ACQUIRE)) {
+        magazine->num = 0;
+        magazine->pool = NULL;
+    }
+#endif
+}
+
+static int pkbuf_batch_alloc(ogs_pkbuf_pool_t *pool,
+        unsigned int size, ogs_pkbuf_t **pkbuf, int num)
+{
+    int i;
+#if OGS_USE_TALLOC == 1
+    ogs_thread_mutex_t *mutex = ogs_mem_get_mutex();
+
+    ogs_thread_mutex_lock(mutex);
+
+    for (i = 0; i < num; i++) {
+        pkbuf[i] = talloc_named_const(
+                pool, sizeof(ogs_pkbuf_t) + size, OGS_FILE_LINE);
+        if (!pkbuf[i])
+            break;
+
+        memset(pkbuf[i], 0, sizeof(ogs_pkbuf_t));
+        pkbuf[i]->pool = pool;
+        pkbuf[i]->capacity = size;
+    }
+
+    ogs_thread_mutex_unlock(mutex);
+#else
+    ogs_cluster_t *cluster = NULL;
+
+    ogs_thread_mutex_lock(&pool->mutex);
+
+    for (i = 0; i < num; i++) {
+        cluster = cluster_alloc(pool, size);
+        if (!cluster)
+            break;
+
+        ogs_pool_alloc(&pool->pkbuf, &pkbuf[i]);
+        if (!pkbuf[i]) {
+            cluster_free(pool, cluster);
+            break;
+        }
+
+        memset(pkbuf[i], 0, sizeof(ogs_pkbuf_t));
+        OGS_OBJECT_REF(cluster);
+        pkbuf[i]->cluster = cluster;
+        pkbuf[i]->pool = pool;
+    }
+
+    ogs_thread_mutex_unlock(&pool->mutex);
+#endif
+
+    return i;
+}
+
+static void pkbuf_batch_free(
+        ogs_pkbuf_pool_t *pool, ogs_pkbuf_t **pkbuf, int num)
+{
+    int i;
+#if OGS_USE_TALLOC == 1
+    ogs_thread_mutex_t *mutex = ogs_mem_get_mutex();
+
+    ogs_thread_mutex_lock(mutex);
+
+    for (i = 0; i < num; i++)
+        _talloc_free(pkbuf[i], OGS_FILE_LINE);
+
+    ogs_thread_mutex_unlock(mutex);
+#else
+    ogs_thread_mutex_lock(&pool->mutex);
+
+    for (i = 0; i < num; i++) {
+        cluster_free(pool, pkbuf[i]->cluster);
+        ogs_pool_free(&pool->pkbuf, pkbuf[i]);
+    }
+
+    ogs_thread_mutex_unlock(&pool->mutex);
+#endif
+}
+
+static ogs_pkbuf_t *pkbuf_cache_get(
+        ogs_pkbuf_pool_t *pool, unsigned int size, const char *file_line)
+{
+    pkbuf_magazine_t *magazine = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    int i;
+
+    for (i = 0; i < OGS_PKBUF_CACHE_NUM_CLASS; i++)
+        if (size <= cache_class_size[i])
+            break;
+    if (i == OGS_PKBUF_CACHE_NUM_CLASS)
+        return NULL;
+
+    magazine = &pkbuf_cache.magazine[i];
+    magazine_check(magazine);
+
+    if (magazine->num == 0) {
+        magazine_set_pool(magazine, pool);
+        magazine->num = pkbuf_batch_alloc(pool, cache_class_size[i],
+                magazine->pkbuf, OGS_PKBUF_CACHE_BATCH);
+        if (magazine->num == 0)
+            return NULL;
+
+        pkbuf_cache.stat.refill++;
+        pkbuf_cache.stat.miss++;
+    } else if (magazine->pool == pool) {
+        pkbuf_cache.stat.hit++;
+    } else {
+        pkbuf_cache.stat.miss++;
+        return NULL;
+    }
+
+    pkbuf = magazine->pkbuf[--magazine->num];
+
+    memset(&pkbuf->lnode, 0, sizeof(pkbuf->lnode));
+    memset(pkbuf->param, 0, sizeof(pkbuf->param));
+
+    pkbuf->len = 0;
+
+#if OGS_USE_TALLOC == 1
+    /* Cleared as ogs_talloc_zero_size() does below */
+    memset(pkbuf->_data, 0, size);
+
+    pkbuf->head = pkbuf->_data;
+#else
+    pkbuf->head = pkbuf->cluster->buffer;
+#endif
+    pkbuf->data = pkbuf->head;
+    pkbuf->tail = pkbuf->head;
+    pkbuf->end = pkbuf->head + size;
+
+    pkbuf->file_line = file_line; /* For debug */
+
+    return pkbuf;
+}
+
+static bool pkbuf_cache_put(ogs_pkbuf_t *pkbuf)
+{
+    pkbuf_magazine_t *magazine = NULL;
+    unsigned int size;
+    int i;
+
+#if OGS_USE_TALLOC == 1
+    size = pkbuf->capacity;
+#else
+    /* The cluster is still used by a copy */
+    if (OGS_OBJECT_IS_REF(pkbuf->cluster))
+        return false;
+    size = pkbuf->cluster->size;
+#endif
+
+    for (i = 0; i < OGS_PKBUF_CACHE_NUM_CLASS; i++)
+        if (size == cache_class_size[i])
+            break;
+    if (i == OGS_PKBUF_CACHE_NUM_CLASS)
+        return false;
+
+    magazine = &pkbuf_cache.magazine[i];
+    magazine_check(magazine);
+
+    if (magazine->num && magazine->pool != pkbuf->pool)
+        return false;
+
+    if (magazine->num == OGS_PKBUF_CACHE_SIZE) {
+        magazine->num -= OGS_PKBUF_CACHE_BATCH;
+        pkbuf_batch_free(magazine->pool,
+                magazine->pkbuf + magazine->num, OGS_PKBUF_CACHE_BATCH);
+
+        pkbuf_cache.stat.spill++;
+    }
+
+    magazine_set_pool(magazine, pkbuf->pool);
+    magazine->pkbuf[magazine->num++] = pkbuf;
+
+    return true;
+}
+
+void ogs_pkbuf_cache_flush(void)
+{
+    pkbuf_magazine_t *magazine = NULL;
+    int i;
+
+    for (i = 0; i < OGS_PKBUF_CACHE_NUM_CLASS; i++) {
+        magazine = &pkbuf_cache.magazine[i];
+        magazine_check(magazine);
+        if (magazine->num == 0)
+            continue;
+
+        pkbuf_batch_free(magazine->pool, magazine->pkbuf, magazine->num);
+
+        magazine->num = 0;
+        magazine->pool = NULL;
+    }
+}
+
+void ogs_pkbuf_cache_stat(ogs_pkbuf_cache_stat_t *stat)
+{
+    ogs_assert(stat);
+
+    memcpy(stat, &pkbuf_cache.stat, sizeof(*stat));
+}
+
 ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
         ogs_pkbuf_pool_t *pool, unsigned int size, const char *file_line)
 {
 #if OGS_USE_TALLOC == 1
     ogs_pkbuf_t *pkbuf = NULL;
 
+    pkbuf = pkbuf_cache_get(pool, size, file_line);
+    if (pkbuf)
+        return pkbuf;
+
     pkbuf = ogs_talloc_zero_size(pool, sizeof(*pkbuf) + size, file_line);
     if (!pkbuf) {
         ogs_error("ogs_pkbuf_alloc() failed [size=%d]", size);
@@ -239,6 +507,9 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
 
     pkbuf->file_line = file_line; /* For debug */
 
+    pkbuf->pool = pool;
+    pkbuf->capacity = size;
+
     return pkbuf;
 #else
     ogs_pkbuf_t *pkbuf = NULL;
@@ -248,6 +519,10 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
         pool = default_pool;
     ogs_assert(pool);
 
+    pkbuf = pkbuf_cache_get(pool, size, file_line);
+    if (pkbuf)
+        return pkbuf;
+
     ogs_thread_mutex_lock(&pool->mutex);
 
     cluster = cluster_alloc(pool, size);
@@ -289,12 +564,20 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
 void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf)
 {
 #if OGS_USE_TALLOC == 1
+    ogs_assert(pkbuf);
+
+    if (pkbuf_cache_put(pkbuf) == true)
+        return;
+
     ogs_talloc_free(pkbuf, OGS_FILE_LINE);
 #else
     ogs_pkbuf_pool_t *pool = NULL;
     ogs_cluster_t *cluster = NULL;
     ogs_assert(pkbuf);
 
+    if (pkbuf_cache_put(pkbuf) == true)
+        return;
+
     pool = pkbuf->pool;
     ogs_assert(pool);
 
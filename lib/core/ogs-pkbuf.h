@@ -58,6 +58,7 @@ typedef struct ogs_pkbuf_s {
     const char *file_line;
     
     ogs_pkbuf_pool_t *pool;
+    unsigned int capacity;  /* Size of _data[] (talloc only) */
 
     unsigned char _data[0]; /*!< optional immediate data array */
 } ogs_pkbuf_t;
@@ -89,6 +90,23 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
         ogs_pkbuf_pool_t *pool, unsigned int size, const char *file_line);
 void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf);
 
+/*
+ * Per-thread cache of the packet buffers up to 2048 bytes
+ *
+ * ogs_pkbuf_cache_flush() returns the buffers cached by the calling
+ * thread to their pool. It is done automatically when an ogs_thread
+ * exits and in ogs_pkbuf_pool_destroy().
+ */
+typedef struct ogs_pkbuf_cache_stat_s {
+    uint64_t hit;       /* Allocated from the cache */
+    uint64_t miss;      /* Allocated from the pool */
+    uint64_t refill;    /* Batches taken from the pool */
+    uint64_t spill;     /* Batches returned to the pool */
+} ogs_pkbuf_cache_stat_t;
+
+void ogs_pkbuf_cache_flush(void);
+void ogs_pkbuf_cache_stat(ogs_pkbuf_cache_stat_t *stat);
+
 void *ogs_pkbuf_put_data(
         ogs_pkbuf_t *pkbuf, const void *data, unsigned int len);
 #define ogs_pkbuf_copy(pkbuf) \
@@ -47,6 +47,7 @@ typedef struct ogs_pollset_s {
     struct {
         ogs_socket_t fd[2];
         ogs_poll_t *poll;
+        int pending;    /* Written but not drained yet */
     } notify;
 
     unsigned int capacity;
@@ -30,11 +30,37 @@ extern "C" {
 
 typedef uint32_t ogs_pool_id_t;
 
+/*
+ * The pool reserves 'size' nodes up front but only hands out a node
+ * it has never used when the free ring is short. The untouched part of
+ * 'array' (and of 'free'/'index', which are zero-initialized lazily)
+ * is never written, so the kernel maps its pages on first use and
+ * the resident memory follows the high-water mark, not the size.
+ *
+ * Nodes stay contiguous in 'array', so ogs_pool_index() and
+ * ogs_pool_find() keep working with plain pointer arithmetic.
+ *
+ *  used : number of nodes ever handed out (array[used..size-1] untouched)
+ *  hwm  : high-water mark of the nodes in use
+ *
+ * A freed node goes to the tail of the free ring and is reused only
+ * once 'delay' nodes are waiting there, so IDs derived from
+ * ogs_pool_index() and ogs_pool_cycle() checks of a stale pointer are not
+ * defeated right away. The delay is a quarter of the size, but at least
+ * OGS_POOL_REUSE_DELAY, so a pool of up to OGS_POOL_REUSE_DELAY nodes
+ * recycles like a plain FIFO, and a large one touches up to 'size / 4'
+ * nodes more than its high-water mark.
+ */
+#define OGS_POOL_REUSE_DELAY 4096
+#define ogs_pool_reuse_delay(_size) \
+    ogs_min((_size), ogs_max(OGS_POOL_REUSE_DELAY, (_size) / 4))
+
 #define OGS_POOL(pool, type) \
     struct { \
         const char *name; \
         int head, tail; \
         int size, avail; \
+        int used, hwm, delay; \
         type **free, *array, **index; \
     } pool
 
@@ -43,20 +69,17 @@ typedef uint32_t ogs_pool_id_t;
  * Otherwise, memory will be fragment since this function uses system malloc()
  */
 #define ogs_pool_init(pool, _size) do { \
-    int i; \
     (pool)->name = #pool; \
     (pool)->free = malloc(sizeof(*(pool)->free) * _size); \
     ogs_assert((pool)->free); \
     (pool)->array = malloc(sizeof(*(pool)->array) * _size); \
     ogs_assert((pool)->array); \
-    (pool)->index = malloc(sizeof(*(pool)->index) * _size); \
+    (pool)->index = calloc(_size, sizeof(*(pool)->index)); \
     ogs_assert((pool)->index); \
     (pool)->size = (pool)->avail = _size; \
     (pool)->head = (pool)->tail = 0; \
-    for (i = 0; i < _size; i++) { \
-        (pool)->free[i] = &((pool)->array[i]); \
-        (pool)->index[i] = NULL; \
-    } \
+    (pool)->used = (pool)->hwm = 0; \
+    (pool)->delay = ogs_pool_reuse_delay(_size); \
 } while (0)
 
 /*
@@ -79,20 +102,17 @@ typedef uint32_t ogs_pool_id_t;
  * so this function should use ogs_malloc() instead of system malloc()
  */
 #define ogs_pool_create(pool, _size) do { \
-    int i; \
     (pool)->name = #pool; \
     (pool)->free = ogs_malloc(sizeof(*(pool)->free) * _size); \
     ogs_assert((pool)->free); \
     (pool)->array = ogs_malloc(sizeof(*(pool)->array) * _size); \
     ogs_assert((pool)->array); \
-    (pool)->index = ogs_malloc(sizeof(*(pool)->index) * _size); \
+    (pool)->index = ogs_calloc(_size, sizeof(*(pool)->index)); \
     ogs_assert((pool)->index); \
     (pool)->size = (pool)->avail = _size; \
     (pool)->head = (pool)->tail = 0; \
-    for (i = 0; i < _size; i++) { \
-        (pool)->free[i] = &((pool)->array[i]); \
-        (pool)->index[i] = NULL; \
-    } \
+    (pool)->used = (pool)->hwm = 0; \
+    (pool)->delay = ogs_pool_reuse_delay(_size); \
 } while (0)
 
 /*
@@ -116,13 +136,24 @@ typedef uint32_t ogs_pool_id_t;
 #define ogs_pool_cycle(pool, node) \
     ogs_pool_find((pool), ogs_pool_index((pool), (node)))
 
+/* Number of freed nodes waiting in the free ring */
+#define ogs_pool_ring(pool) \
+    ((pool)->avail - ((pool)->size - (pool)->used))
+
 #define ogs_pool_alloc(pool, node) do { \
     *(node) = NULL; \
     if ((pool)->avail > 0) { \
+        if ((pool)->used < (pool)->size && \
+            ogs_pool_ring(pool) < (pool)->delay) { \
+            *(node) = (void*)&(pool)->array[(pool)->used++]; \
+        } else { \
+            *(node) = (void*)(pool)->free[(pool)->head]; \
+            (pool)->free[(pool)->head] = NULL; \
+            (pool)->head = ((pool)->head + 1) % ((pool)->size); \
+        } \
         (pool)->avail--; \
-        *(node) = (void*)(pool)->free[(pool)->head]; \
-        (pool)->free[(pool)->head] = NULL; \
-        (pool)->head = ((pool)->head + 1) % ((pool)->size); \
+        if ((pool)->size - (pool)->avail > (pool)->hwm) \
+            (pool)->hwm = (pool)->size - (pool)->avail; \
         (pool)->index[ogs_pool_index(pool, *(node))-1] = *(node); \
     } \
 } while (0)
@@ -138,6 +169,7 @@ typedef uint32_t ogs_pool_id_t;
 
 #define ogs_pool_size(pool) ((pool)->size)
 #define ogs_pool_avail(pool) ((pool)->avail)
+#define ogs_pool_hwm(pool) ((pool)->hwm)
 
 #define ogs_pool_sequence_id_generate(pool) do { \
     int i; \
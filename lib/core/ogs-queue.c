@@ -37,12 +37,39 @@
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_event_domain
 
+/*
+ * Bounded lock-free ring
+ *
+ * Every cell carries a sequence number telling whose turn it is.
+ * A producer owns the cell at 'in' when its sequence equals 'in',
+ * and a consumer owns the cell at 'out' when its sequence equals
+ * 'out + 1'. Both positions are claimed with a compare-and-swap,
+ * so pushing threads never serialise on a lock, and the single
+ * popper of an NF main loop never contends at all.
+ *
+ * The mutex and the condition variables are only used by the blocking
+ * and timed variants. A push or pop takes the mutex only when somebody
+ * is waiting on the other side.
+ */
+typedef struct ogs_queue_cell_s {
+    uint64_t            seq;
+    void                *data;
+} ogs_queue_cell_t;
+
 typedef struct ogs_queue_s {
-    void              **data;
-    unsigned int        nelts; /**< # elements */
-    unsigned int        in;    /**< next empty location */
-    unsigned int        out;   /**< next filled location */
+    ogs_queue_cell_t    *cell;
     unsigned int        bounds;/**< max size of queue */
+
+    /*
+     * Padded rather than aligned : the queue is allocated by
+     * ogs_calloc(), which does not guarantee a 64-byte alignment
+     */
+    char                pad0[OGS_CACHE_LINE_SIZE];
+    uint64_t            in;     /**< next empty location */
+    char                pad1[OGS_CACHE_LINE_SIZE - sizeof(uint64_t)];
+    uint64_t            out;    /**< next filled location */
+    char                pad2[OGS_CACHE_LINE_SIZE - sizeof(uint64_t)];
+
     unsigned int        full_waiters;
     unsigned int        empty_waiters;
     ogs_thread_mutex_t  one_big_mutex;
@@ -51,43 +78,35 @@ typedef struct ogs_queue_s {
     int                 terminated;
 } ogs_queue_t;
 
-/**
- * Detects when the ogs_queue_t is full. This utility function is expected
- * to be called from within critical sections, and is not threadsafe.
- */
-#define ogs_queue_full(queue) ((queue)->nelts == (queue)->bounds)
-
-/**
- * Detects when the ogs_queue_t is empty. This utility function is expected
- * to be called from within critical sections, and is not threadsafe.
- */
-#define ogs_queue_empty(queue) ((queue)->nelts == 0)
-
-/**
- * Callback routine that is called to destroy this
- * ogs_queue_t when its pool is destroyed.
- */
 ogs_queue_t *ogs_queue_create(unsigned int capacity)
 {
-    ogs_queue_t *queue = ogs_calloc(1, sizeof *queue);
+    ogs_queue_t *queue = NULL;
+    unsigned int i;
+
+    ogs_assert(capacity);
+
+    queue = ogs_calloc(1, sizeof *queue);
     if (!queue) {
         ogs_error("ogs_calloc() failed");
         return NULL;
     }
     ogs_assert(queue);
 
+    queue->cell = ogs_calloc(capacity, sizeof(ogs_queue_cell_t));
+    if (!queue->cell) {
+        ogs_error("ogs_calloc[capacity:%d, sizeof(ogs_queue_cell_t):%d] "
+                "failed", (int)capacity, (int)sizeof(ogs_queue_cell_t));
+        ogs_free(queue);
+        return NULL;
+    }
+    for (i = 0; i < capacity; i++)
+        queue->cell[i].seq = i;
+
     ogs_thread_mutex_init(&queue->one_big_mutex);
     ogs_thread_cond_init(&queue->not_empty);
     ogs_thread_cond_init(&queue->not_full);
 
-    queue->data = ogs_calloc(1, capacity * sizeof(void*));
-    if (!queue->data) {
-        ogs_error("ogs_calloc[capacity:%d, sizeof(void*):%d] failed",
-                (int)capacity, (int)sizeof(void*));
-        return NULL;
-    }
     queue->bounds = capacity;
-    queue->nelts = 0;
     queue->in = 0;
     queue->out = 0;
     queue->terminated = 0;
@@ -101,7 +120,7 @@ void ogs_queue_destroy(ogs_queue_t *queue)
 {
     ogs_assert(queue);
 
-    ogs_free(queue->data);
+    ogs_free(queue->cell);
 
     ogs_thread_cond_destroy(&queue->not_empty);
     ogs_thread_cond_destroy(&queue->not_full);
@@ -110,63 +129,131 @@ void ogs_queue_destroy(ogs_queue_t *queue)
     ogs_free(queue);
 }
 
+static bool ring_push(ogs_queue_t *queue, void *data)
+{
+    ogs_queue_cell_t *cell = NULL;
+    uint64_t pos, seq;
+
+    pos = __atomic_load_n(&queue->in, __ATOMIC_RELAXED);
+    for ( ;; ) {
+        cell = &queue->cell[pos % queue->bounds];
+        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&queue->in, &pos, pos + 1,
+                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if ((int64_t)(seq - pos) < 0) {
+            return false; /* full */
+        } else {
+            pos = __atomic_load_n(&queue->in, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = data;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool ring_pop(ogs_queue_t *queue, void **data)
+{
+    ogs_queue_cell_t *cell = NULL;
+    uint64_t pos, seq;
+
+    pos = __atomic_load_n(&queue->out, __ATOMIC_RELAXED);
+    for ( ;; ) {
+        cell = &queue->cell[pos % queue->bounds];
+        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos + 1) {
+            if (__atomic_compare_exchange_n(&queue->out, &pos, pos + 1,
+                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if ((int64_t)(seq - (pos + 1)) < 0) {
+            return false; /* empty */
+        } else {
+            pos = __atomic_load_n(&queue->out, __ATOMIC_RELAXED);
+        }
+    }
+
+    *data = cell->data;
+    __atomic_store_n(&cell->seq, pos + queue->bounds, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/*
+ * The waiter registers itself before checking the ring again,
+ * and the other side checks for waiters after updating the ring,
+ * so one of them always sees the other.
+ */
+static void wakeup(ogs_queue_t *queue,
+        unsigned int *waiters, ogs_thread_cond_t *cond)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(waiters, __ATOMIC_RELAXED))
+        return;
+
+    ogs_thread_mutex_lock(&queue->one_big_mutex);
+    ogs_thread_cond_signal(cond);
+    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+}
+
 static int queue_push(ogs_queue_t *queue, void *data, ogs_time_t timeout)
 {
     int rv;
 
-    if (queue->terminated) {
+    if (__atomic_load_n(&queue->terminated, __ATOMIC_ACQUIRE)) {
         return OGS_DONE; /* no more elements ever again */
     }
 
-    ogs_thread_mutex_lock(&queue->one_big_mutex);
-
-    if (ogs_queue_full(queue)) {
+    if (ring_push(queue, data) == false) {
         if (!timeout) {
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
             return OGS_RETRY;
         }
-        if (!queue->terminated) {
-            queue->full_waiters++;
-            if (timeout > 0) {
-                rv = ogs_thread_cond_timedwait(&queue->not_full,
-                                               &queue->one_big_mutex,
-                                               timeout);
-            }
-            else {
-                rv = ogs_thread_cond_wait(&queue->not_full,
-                                          &queue->one_big_mutex);
+
+        ogs_thread_mutex_lock(&queue->one_big_mutex);
+        __atomic_add_fetch(&queue->full_waiters, 1, __ATOMIC_SEQ_CST);
+
+        if (ring_push(queue, data) == false) {
+            if (!queue->terminated) {
+                if (timeout > 0) {
+                    rv = ogs_thread_cond_timedwait(&queue->not_full,
+                                                   &queue->one_big_mutex,
+                                                   timeout);
+                }
+                else {
+                    rv = ogs_thread_cond_wait(&queue->not_full,
+                                              &queue->one_big_mutex);
+                }
+                if (rv != OGS_OK) {
+                    __atomic_sub_fetch(&queue->full_waiters, 1,
+                            __ATOMIC_SEQ_CST);
+                    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+                    return rv;
+                }
             }
-            queue->full_waiters--;
-            if (rv != OGS_OK) {
+            /* If we wake up and it's still full, then we were interrupted */
+            if (ring_push(queue, data) == false) {
+                ogs_warn("queue full (intr)");
+                __atomic_sub_fetch(&queue->full_waiters, 1, __ATOMIC_SEQ_CST);
                 ogs_thread_mutex_unlock(&queue->one_big_mutex);
-                return rv;
-            }
-        }
-        /* If we wake up and it's still empty, then we were interrupted */
-        if (ogs_queue_full(queue)) {
-            ogs_warn("queue full (intr)");
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
-            if (queue->terminated) {
-                return OGS_DONE; /* no more elements ever again */
-            }
-            else {
-                return OGS_ERROR;
+                if (queue->terminated) {
+                    return OGS_DONE; /* no more elements ever again */
+                }
+                else {
+                    return OGS_ERROR;
+                }
             }
         }
-    }
-
-    queue->data[queue->in] = data;
-    queue->in++;
-    if (queue->in >= queue->bounds)
-        queue->in -= queue->bounds;
-    queue->nelts++;
 
-    if (queue->empty_waiters) {
-        ogs_trace("signal !empty");
-        ogs_thread_cond_signal(&queue->not_empty);
+        __atomic_sub_fetch(&queue->full_waiters, 1, __ATOMIC_SEQ_CST);
+        ogs_thread_mutex_unlock(&queue->one_big_mutex);
     }
 
-    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+    wakeup(queue, &queue->empty_waiters, &queue->not_empty);
+
     return OGS_OK;
 }
 
@@ -194,7 +281,10 @@ int ogs_queue_timedpush(ogs_queue_t *queue, void *data, ogs_time_t timeout)
  * not thread safe
  */
 unsigned int ogs_queue_size(ogs_queue_t *queue) {
-    return queue->nelts;
+    uint64_t in = __atomic_load_n(&queue->in, __ATOMIC_RELAXED);
+    uint64_t out = __atomic_load_n(&queue->out, __ATOMIC_RELAXED);
+
+    return in > out ? (unsigned int)(in - out) : 0;
 }
 
 /**
@@ -208,59 +298,57 @@ static int queue_pop(ogs_queue_t *queue, void **data, ogs_time_t timeout)
 {
     int rv;
 
-    if (queue->terminated) {
+    if (__atomic_load_n(&queue->terminated, __ATOMIC_ACQUIRE)) {
         return OGS_DONE; /* no more elements ever again */
     }
 
-    ogs_thread_mutex_lock(&queue->one_big_mutex);
-
     /* Keep waiting until we wake up and find that the queue is not empty. */
-    if (ogs_queue_empty(queue)) {
+    if (ring_pop(queue, data) == false) {
         if (!timeout) {
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
             return OGS_RETRY;
         }
-        if (!queue->terminated) {
-            queue->empty_waiters++;
-            if (timeout > 0) {
-                rv = ogs_thread_cond_timedwait(&queue->not_empty,
-                                               &queue->one_big_mutex,
-                                               timeout);
-            }
-            else {
-                rv = ogs_thread_cond_wait(&queue->not_empty,
-                                          &queue->one_big_mutex);
+
+        ogs_thread_mutex_lock(&queue->one_big_mutex);
+        __atomic_add_fetch(&queue->empty_waiters, 1, __ATOMIC_SEQ_CST);
+
+        if (ring_pop(queue, data) == false) {
+            if (!queue->terminated) {
+                if (timeout > 0) {
+                    rv = ogs_thread_cond_timedwait(&queue->not_empty,
+                                                   &queue->one_big_mutex,
+                                                   timeout);
+                }
+                else {
+                    rv = ogs_thread_cond_wait(&queue->not_empty,
+                                              &queue->one_big_mutex);
+                }
+                if (rv != OGS_OK) {
+                    __atomic_sub_fetch(&queue->empty_waiters, 1,
+                            __ATOMIC_SEQ_CST);
+                    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+                    return rv;
+                }
             }
-            queue->empty_waiters--;
-            if (rv != OGS_OK) {
+            /* If we wake up and it's still empty, then we were interrupted */
+            if (ring_pop(queue, data) == false) {
+                ogs_warn("queue empty (intr)");
+                __atomic_sub_fetch(&queue->empty_waiters, 1,
+                        __ATOMIC_SEQ_CST);
                 ogs_thread_mutex_unlock(&queue->one_big_mutex);
-                return rv;
+                if (queue->terminated) {
+                    return OGS_DONE; /* no more elements ever again */
+                } else {
+                    return OGS_ERROR;
+                }
             }
         }
-        /* If we wake up and it's still empty, then we were interrupted */
-        if (ogs_queue_empty(queue)) {
-            ogs_warn("queue empty (intr)");
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
-            if (queue->terminated) {
-                return OGS_DONE; /* no more elements ever again */
-            } else {
-                return OGS_ERROR;
-            }
-        }
-    } 
-
-    *data = queue->data[queue->out];
-    queue->nelts--;
 
-    queue->out++;
-    if (queue->out >= queue->bounds)
-        queue->out -= queue->bounds;
-    if (queue->full_waiters) {
-        ogs_trace("signal !full");
-        ogs_thread_cond_signal(&queue->not_full);
+        __atomic_sub_fetch(&queue->empty_waiters, 1, __ATOMIC_SEQ_CST);
+        ogs_thread_mutex_unlock(&queue->one_big_mutex);
     }
 
-    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+    wakeup(queue, &queue->full_waiters, &queue->not_full);
+
     return OGS_OK;
 }
 
@@ -274,6 +362,36 @@ int ogs_queue_trypop(ogs_queue_t *queue, void **data)
     return queue_pop(queue, data, 0);
 }
 
+/**
+ * Retrieves up to 'n' items without blocking. Returns the number of
+ * items placed into 'data', OGS_RETRY if the queue is empty, or
+ * OGS_DONE once the queue has been terminated.
+ */
+int ogs_queue_trypop_n(ogs_queue_t *queue, void **data, int n)
+{
+    int i;
+
+    ogs_assert(queue);
+    ogs_assert(data);
+    ogs_assert(n > 0);
+
+    if (__atomic_load_n(&queue->terminated, __ATOMIC_ACQUIRE)) {
+        return OGS_DONE; /* no more elements ever again */
+    }
+
+    for (i = 0; i < n; i++) {
+        if (ring_pop(queue, &data[i]) == false)
+            break;
+    }
+
+    if (!i)
+        return OGS_RETRY;
+
+    wakeup(queue, &queue->full_waiters, &queue->not_full);
+
+    return i;
+}
+
 int ogs_queue_timedpop(ogs_queue_t *queue, void **data, ogs_time_t timeout)
 {
     return queue_pop(queue, data, timeout);
@@ -300,9 +418,8 @@ int ogs_queue_term(ogs_queue_t *queue)
      * we could end up setting it and waking everybody up just after a 
      * would-be popper checks it but right before they block
      */
-    queue->terminated = 1;
+    __atomic_store_n(&queue->terminated, 1, __ATOMIC_RELEASE);
     ogs_thread_mutex_unlock(&queue->one_big_mutex);
 
     return ogs_queue_interrupt_all(queue);
 }
-
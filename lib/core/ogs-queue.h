@@ -43,6 +43,9 @@
 extern "C" {
 #endif
 
+/* Number of events an NF main loop takes from the queue at once */
+#define OGS_QUEUE_POP_BATCH 32
+
 typedef struct ogs_queue_s ogs_queue_t;
 
 ogs_queue_t *ogs_queue_create(unsigned int capacity);
@@ -53,6 +56,7 @@ int ogs_queue_pop(ogs_queue_t *queue, void **data);
 
 int ogs_queue_trypush(ogs_queue_t *queue, void *data);
 int ogs_queue_trypop(ogs_queue_t *queue, void **data);
+int ogs_queue_trypop_n(ogs_queue_t *queue, void **data, int n);
 
 int ogs_queue_timedpush(ogs_queue_t *queue, void *data, ogs_time_t timeout);
 int ogs_queue_timedpop(ogs_queue_t *queue, void **data, ogs_time_t timeout);
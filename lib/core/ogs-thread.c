@@ -66,6 +66,13 @@ static void *thread_worker(void *arg)
     ogs_debug("[%p] worker signal", thread);
     thread->func(thread->data);
 
+    /* Return the buffers cached by this thread */
+    ogs_pkbuf_cache_flush();
+    /* Hand over the log ring of this thread */
+    ogs_log_async_release();
+    /* Free the arena chunks of this thread */
+    ogs_arena_release();
+
     ogs_thread_mutex_lock(&thread->mutex);
     thread->running = false;
     ogs_thread_mutex_unlock(&thread->mutex);
@@ -67,6 +67,27 @@ static ogs_inline int ogs_thread_cond_timedwait(
 #define ogs_thread_cond_signal (void)pthread_cond_signal
 #define ogs_thread_cond_broadcast pthread_cond_broadcast
 #define ogs_thread_cond_destroy (void)pthread_cond_destroy
+#define ogs_thread_rwlock_t pthread_rwlock_t
+static ogs_inline void ogs_thread_rwlock_init(pthread_rwlock_t *rwlock)
+{
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+    pthread_rwlockattr_t attr;
+
+    /* Readers that keep overlapping must not starve the writer */
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr,
+            PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+#else
+    pthread_rwlock_init(rwlock, NULL);
+#endif
+}
+#define ogs_thread_rwlock_rdlock (void)pthread_rwlock_rdlock
+#define ogs_thread_rwlock_rdunlock (void)pthread_rwlock_unlock
+#define ogs_thread_rwlock_wrlock (void)pthread_rwlock_wrlock
+#define ogs_thread_rwlock_wrunlock (void)pthread_rwlock_unlock
+#define ogs_thread_rwlock_destroy (void)pthread_rwlock_destroy
 #define ogs_thread_id_t pthread_t
 #define ogs_thread_join(_n) pthread_join((_n), NULL)
 #else
@@ -103,6 +124,13 @@ static ogs_inline int ogs_thread_cond_destroy(ogs_thread_cond_t *_ignored)
 {
    return 0;
 }
+#define ogs_thread_rwlock_t SRWLOCK
+#define ogs_thread_rwlock_init InitializeSRWLock
+#define ogs_thread_rwlock_rdlock AcquireSRWLockShared
+#define ogs_thread_rwlock_rdunlock ReleaseSRWLockShared
+#define ogs_thread_rwlock_wrlock AcquireSRWLockExclusive
+#define ogs_thread_rwlock_wrunlock ReleaseSRWLockExclusive
+#define ogs_thread_rwlock_destroy(_n) (void)(_n)
 #endif
 
 typedef struct ogs_thread_s ogs_thread_t;
@@ -272,6 +272,36 @@ ogs_time_t ogs_get_monotonic_time(void)
 #endif
 }
 
+static OGS_THREAD_LOCAL struct {
+    ogs_time_t monotonic;   /* 0 : The thread has no poll loop */
+    ogs_time_t now;         /* 0 : Not read since the last update */
+} loop_clock;
+
+void ogs_loop_time_update(void)
+{
+    loop_clock.monotonic = ogs_get_monotonic_time();
+    loop_clock.now = 0;
+}
+
+ogs_time_t ogs_loop_monotonic_time(void)
+{
+    if (!loop_clock.monotonic)
+        return ogs_get_monotonic_time();
+
+    return loop_clock.monotonic;
+}
+
+ogs_time_t ogs_loop_time_now(void)
+{
+    if (!loop_clock.monotonic)
+        return ogs_time_now();
+
+    if (!loop_clock.now)
+        loop_clock.now = ogs_time_now();
+
+    return loop_clock.now;
+}
+
 void ogs_localtime(time_t s, struct tm *tm)
 {
     ogs_assert(tm);
@@ -106,6 +106,21 @@ uint32_t ogs_time_to_ntp32(ogs_time_t time);
 
 /** @return number of microseconds since an arbitrary point */
 ogs_time_t ogs_get_monotonic_time(void);
+
+/*
+ * Loop clock
+ *
+ * The poll loop of each thread refreshes its clock when ogs_pollset_poll()
+ * returns, when ogs_timer_mgr_expire() runs and right before it goes to
+ * sleep in ogs_timer_mgr_next(). Handlers, timer starts and events of the
+ * same iteration then share one reading instead of asking the kernel
+ * every time.
+ *
+ * A thread that has no poll loop always gets the current time.
+ */
+void ogs_loop_time_update(void);
+ogs_time_t ogs_loop_monotonic_time(void);
+ogs_time_t ogs_loop_time_now(void); /* This returns GMT */
 /** @return the GMT offset in seconds */
 int ogs_timezone(void);
 
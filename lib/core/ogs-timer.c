@@ -22,21 +22,41 @@
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_event_domain
 
+/*
+ * Hierarchical Timing Wheel
+ *
+ * Level N has 64 slots of 64^N ticks each, so five levels cover
+ * 64^5 ticks (about 12 days at 1 ms). A timer is linked into the level
+ * that matches its distance from the current tick. When the wheel
+ * reaches the start of a higher level slot, the timers in that slot
+ * are cascaded down, and the timers of a level 0 slot are expired.
+ */
+#define TIMER_WHEEL_BITS        6
+#define TIMER_WHEEL_SIZE        (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS      5
+#define TIMER_WHEEL_RANGE       (1ULL << (TIMER_WHEEL_BITS*TIMER_WHEEL_LEVELS))
+
+typedef struct timer_wheel_s {
+    uint64_t tick;              /* Last tick processed */
+    unsigned int count;
+    uint64_t occupied[TIMER_WHEEL_LEVELS];  /* Non-empty slot bitmap */
+    ogs_list_t slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+} timer_wheel_t;
+
 typedef struct ogs_timer_mgr_s {
     OGS_POOL(pool, ogs_timer_t);
     ogs_rbtree_t tree;
+    timer_wheel_t *wheel;       /* NULL : Red-black tree */
 } ogs_timer_mgr_t;
 
-static void add_timer_node(
-        ogs_rbtree_t *tree, ogs_timer_t *timer, ogs_time_t duration)
+static void add_timer_node(ogs_rbtree_t *tree, ogs_timer_t *timer)
 {
     ogs_rbnode_t **new = NULL;
     ogs_rbnode_t *parent = NULL;
     ogs_assert(tree);
     ogs_assert(timer);
 
-    timer->timeout = ogs_get_monotonic_time() + duration;
-
     new = &tree->root;
     while (*new) {
         ogs_timer_t *this = ogs_rb_entry(*new, ogs_timer_t, rbnode);
@@ -52,6 +72,172 @@ static void add_timer_node(
     ogs_rbtree_insert_color(tree, timer);
 }
 
+static uint64_t wheel_tick(ogs_time_t timeout)
+{
+    /* Round up so that a timer never fires before its timeout */
+    return (timeout + OGS_TIMER_WHEEL_RESOLUTION - 1) /
+        OGS_TIMER_WHEEL_RESOLUTION;
+}
+
+static void wheel_link(timer_wheel_t *wheel, ogs_timer_t *timer, uint64_t tick)
+{
+    uint64_t delta;
+    int level, idx;
+
+    ogs_assert(wheel);
+    ogs_assert(timer);
+
+    if (tick < wheel->tick)
+        tick = wheel->tick;
+
+    delta = tick - wheel->tick;
+    if (delta >= TIMER_WHEEL_RANGE) {
+        /* Parked in the last slot, and placed again when cascaded */
+        delta = TIMER_WHEEL_RANGE - 1;
+        tick = wheel->tick + delta;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < (1ULL << (TIMER_WHEEL_BITS * (level + 1))))
+            break;
+    }
+    idx = (tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+
+    timer->slot = &wheel->slot[level][idx];
+    ogs_list_add(timer->slot, &timer->lnode);
+    wheel->occupied[level] |= 1ULL << idx;
+    wheel->count++;
+}
+
+static void wheel_add(timer_wheel_t *wheel, ogs_timer_t *timer)
+{
+    uint64_t tick;
+
+    ogs_assert(wheel);
+    ogs_assert(timer);
+
+    /*
+     * The slot of the current tick has already been expired,
+     * so a timer that is due by now fires on the next tick
+     */
+    tick = wheel_tick(timer->timeout);
+    if (tick <= wheel->tick)
+        tick = wheel->tick + 1;
+
+    wheel_link(wheel, timer, tick);
+}
+
+static void wheel_remove(timer_wheel_t *wheel, ogs_timer_t *timer)
+{
+    int n;
+
+    ogs_assert(wheel);
+    ogs_assert(timer);
+    ogs_assert(timer->slot);
+
+    ogs_list_remove(timer->slot, &timer->lnode);
+    if (ogs_list_first(timer->slot) == NULL) {
+        n = timer->slot - &wheel->slot[0][0];
+        wheel->occupied[n / TIMER_WHEEL_SIZE] &=
+            ~(1ULL << (n % TIMER_WHEEL_SIZE));
+    }
+    timer->slot = NULL;
+
+    ogs_assert(wheel->count);
+    wheel->count--;
+}
+
+/*
+ * Returns the next tick that has timers to expire or to cascade,
+ * or 0 if the wheel is empty.
+ */
+static uint64_t wheel_next(timer_wheel_t *wheel)
+{
+    uint64_t next = 0, block;
+    int level, shift, d;
+
+    ogs_assert(wheel);
+
+    if (!wheel->count)
+        return 0;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!wheel->occupied[level])
+            continue;
+
+        shift = TIMER_WHEEL_BITS * level;
+        for (d = 1; d <= TIMER_WHEEL_SIZE; d++) {
+            block = (wheel->tick >> shift) + d;
+            if (wheel->occupied[level] & (1ULL << (block & TIMER_WHEEL_MASK))) {
+                if (!next || (block << shift) < next)
+                    next = block << shift;
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+static void wheel_cascade(timer_wheel_t *wheel)
+{
+    ogs_list_t *slot = NULL;
+    ogs_lnode_t *lnode = NULL;
+    ogs_timer_t *timer = NULL;
+    int level, idx;
+
+    ogs_assert(wheel);
+
+    for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        idx = (wheel->tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+        slot = &wheel->slot[level][idx];
+
+        /* Cascaded before the level 0 slot of the current tick expires */
+        while ((lnode = ogs_list_first(slot)) != NULL) {
+            timer = ogs_rb_entry(lnode, ogs_timer_t, lnode);
+            wheel_remove(wheel, timer);
+            wheel_link(wheel, timer, wheel_tick(timer->timeout));
+        }
+
+        if (idx)
+            break;
+    }
+}
+
+static void wheel_expire(timer_wheel_t *wheel, ogs_time_t current)
+{
+    ogs_list_t *slot = NULL;
+    ogs_lnode_t *lnode = NULL;
+    ogs_timer_t *this = NULL;
+    uint64_t target, next;
+
+    ogs_assert(wheel);
+
+    target = current / OGS_TIMER_WHEEL_RESOLUTION;
+
+    while (wheel->tick < target) {
+        next = wheel_next(wheel);
+        if (!next || next > target) {
+            /* Nothing to expire or cascade in between */
+            wheel->tick = target;
+            break;
+        }
+
+        wheel->tick = next;
+        if ((next & TIMER_WHEEL_MASK) == 0)
+            wheel_cascade(wheel);
+
+        slot = &wheel->slot[0][next & TIMER_WHEEL_MASK];
+        while ((lnode = ogs_list_first(slot)) != NULL) {
+            this = ogs_rb_entry(lnode, ogs_timer_t, lnode);
+            wheel_remove(wheel, this);
+            this->running = false;
+            if (this->cb)
+                this->cb(this->data);
+        }
+    }
+}
+
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
 {
     ogs_timer_mgr_t *manager = ogs_calloc(1, sizeof *manager);
@@ -65,10 +251,35 @@ ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
     return manager;
 }
 
+ogs_timer_mgr_t *ogs_timer_mgr_create_wheel(unsigned int capacity)
+{
+    ogs_timer_mgr_t *manager = NULL;
+
+    manager = ogs_timer_mgr_create(capacity);
+    if (!manager) {
+        ogs_error("ogs_timer_mgr_create() failed");
+        return NULL;
+    }
+
+    manager->wheel = ogs_calloc(1, sizeof(*manager->wheel));
+    if (!manager->wheel) {
+        ogs_error("ogs_calloc() failed");
+        ogs_timer_mgr_destroy(manager);
+        return NULL;
+    }
+    manager->wheel->tick =
+        ogs_get_monotonic_time() / OGS_TIMER_WHEEL_RESOLUTION;
+
+    return manager;
+}
+
 void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager)
 {
     ogs_assert(manager);
 
+    if (manager->wheel)
+        ogs_free(manager->wheel);
+
     ogs_pool_final(&manager->pool);
     ogs_free(manager);
 }
@@ -132,11 +343,20 @@ void ogs_timer_start_debug(
         ogs_assert_if_reached();
     }
 
-    if (timer->running == true)
-        ogs_rbtree_delete(&manager->tree, timer);
+    if (timer->running == true) {
+        if (manager->wheel)
+            wheel_remove(manager->wheel, timer);
+        else
+            ogs_rbtree_delete(&manager->tree, timer);
+    }
 
     timer->running = true;
-    add_timer_node(&manager->tree, timer, duration);
+    timer->timeout = ogs_loop_monotonic_time() + duration;
+
+    if (manager->wheel)
+        wheel_add(manager->wheel, timer);
+    else
+        add_timer_node(&manager->tree, timer);
 }
 
 void ogs_timer_stop_debug(ogs_timer_t *timer, const char *file_line)
@@ -156,7 +376,10 @@ void ogs_timer_stop_debug(ogs_timer_t *timer, const char *file_line)
         return;
 
     timer->running = false;
-    ogs_rbtree_delete(&manager->tree, timer);
+    if (manager->wheel)
+        wheel_remove(manager->wheel, timer);
+    else
+        ogs_rbtree_delete(&manager->tree, timer);
 }
 
 ogs_time_t ogs_timer_mgr_next(ogs_timer_mgr_t *manager)
@@ -165,7 +388,24 @@ ogs_time_t ogs_timer_mgr_next(ogs_timer_mgr_t *manager)
     ogs_rbnode_t *rbnode = NULL;
     ogs_assert(manager);
 
-    current = ogs_get_monotonic_time();
+    /* The poll loop is about to sleep, so the clock must be exact */
+    ogs_loop_time_update();
+    current = ogs_loop_monotonic_time();
+
+    if (manager->wheel) {
+        uint64_t next = wheel_next(manager->wheel);
+        ogs_time_t timeout;
+
+        if (!next)
+            return OGS_INFINITE_TIME;
+
+        timeout = next * OGS_TIMER_WHEEL_RESOLUTION;
+        if (timeout > current)
+            return (timeout - current);
+        else
+            return OGS_NO_WAIT_TIME;
+    }
+
     rbnode = ogs_rbtree_first(&manager->tree);
     if (rbnode) {
         ogs_timer_t *this = ogs_rb_entry(rbnode, ogs_timer_t, rbnode);
@@ -189,7 +429,14 @@ void ogs_timer_mgr_expire(ogs_timer_mgr_t *manager)
     ogs_timer_t *this;
     ogs_assert(manager);
 
-    current = ogs_get_monotonic_time();
+    /* Expiry may be driven without the poll loop, e.g. after a sleep */
+    ogs_loop_time_update();
+    current = ogs_loop_monotonic_time();
+
+    if (manager->wheel) {
+        wheel_expire(manager->wheel, current);
+        return;
+    }
 
     ogs_rbtree_for_each(&manager->tree, rbnode) {
         this = ogs_rb_entry(rbnode, ogs_timer_t, rbnode);
@@ -28,10 +28,20 @@
 extern "C" {
 #endif
 
+/*
+ * A timer manager keeps its running timers either in a red-black tree
+ * or, when created with ogs_timer_mgr_create_wheel(), in a hierarchical
+ * timing wheel. The wheel makes start/stop O(1) at the cost of firing
+ * up to OGS_TIMER_WHEEL_RESOLUTION late, and may wake up the poll loop
+ * early to move timers down to the next wheel.
+ */
+#define OGS_TIMER_WHEEL_RESOLUTION  1000    /* 1 ms */
+
 typedef struct ogs_timer_mgr_s ogs_timer_mgr_t;
 typedef struct ogs_timer_s {
     ogs_rbnode_t rbnode;
     ogs_lnode_t lnode;
+    ogs_list_t *slot;   /* Timing wheel slot */
 
     void (*cb)(void*);
     void *data;
@@ -42,6 +52,7 @@ typedef struct ogs_timer_s {
 } ogs_timer_t;
 
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity);
+ogs_timer_mgr_t *ogs_timer_mgr_create_wheel(unsigned int capacity);
 void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager);
 
 ogs_timer_t *ogs_timer_add(
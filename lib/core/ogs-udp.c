@@ -17,6 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "core-config-private.h"
+
 #include "ogs-core.h"
 
 #undef OGS_LOG_DOMAIN
@@ -44,6 +46,13 @@ ogs_sock_t *ogs_udp_server(
             addr = addr->next;
             continue;
         }
+        if (option.so_reuseport) {
+            if (ogs_listen_reuseport(new->fd, true) != OGS_OK) {
+                ogs_sock_destroy(new);
+                addr = addr->next;
+                continue;
+            }
+        }
         if (ogs_sock_bind(new, addr) != OGS_OK) {
             ogs_sock_destroy(new);
             addr = addr->next;
@@ -143,3 +152,129 @@ int ogs_udp_connect(ogs_sock_t *sock, ogs_sockaddr_t *sa_list)
 
     return OGS_OK;
 }
+
+/*
+ * Receive up to 'num' datagrams with as few system calls as possible.
+ *
+ * The receive area of each pkbuf is [data, data+len), so the caller
+ * should ogs_pkbuf_put() the buffer in advance. Every received pkbuf
+ * is trimmed to the datagram size and its source is stored in from[i].
+ *
+ * Returns the number of datagrams received, or -1 if nothing was received.
+ */
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, int flags)
+{
+#if HAVE_RECVMMSG
+    struct mmsghdr msg[OGS_MAX_MMSG];
+    struct iovec iov[OGS_MAX_MMSG];
+    int i;
+#endif
+    int n;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(from);
+    ogs_assert(num > 0 && num <= OGS_MAX_MMSG);
+
+#if HAVE_RECVMMSG
+    memset(msg, 0, sizeof(msg[0]) * num);
+    for (i = 0; i < num; i++) {
+        ogs_assert(pkbuf[i]);
+
+        iov[i].iov_base = pkbuf[i]->data;
+        iov[i].iov_len = pkbuf[i]->len;
+
+        memset(&from[i], 0, sizeof(from[i]));
+        msg[i].msg_hdr.msg_name = &from[i].sa;
+        msg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = recvmmsg(fd, msg, num, flags, NULL);
+    if (n <= 0)
+        return -1;
+
+    for (i = 0; i < n; i++)
+        ogs_pkbuf_trim(pkbuf[i], msg[i].msg_len);
+#else
+    for (n = 0; n < num; n++) {
+        ssize_t size;
+
+        ogs_assert(pkbuf[n]);
+        size = ogs_recvfrom(fd, pkbuf[n]->data, pkbuf[n]->len, flags, &from[n]);
+        if (size < 0)
+            break;
+
+        ogs_pkbuf_trim(pkbuf[n], size);
+    }
+
+    if (n == 0)
+        return -1;
+#endif
+
+    return n;
+}
+
+/*
+ * Send 'num' datagrams to the same destination.
+ *
+ * Returns the number of datagrams sent, or -1 if nothing was sent.
+ */
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, int num, int flags, const ogs_sockaddr_t *to)
+{
+#if HAVE_SENDMMSG
+    struct mmsghdr msg[OGS_MAX_MMSG];
+    struct iovec iov[OGS_MAX_MMSG];
+    socklen_t addrlen;
+    int i, rv;
+#endif
+    int sent;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(to);
+    ogs_assert(num > 0 && num <= OGS_MAX_MMSG);
+
+#if HAVE_SENDMMSG
+    addrlen = ogs_sockaddr_len(to);
+    ogs_assert(addrlen);
+
+    memset(msg, 0, sizeof(msg[0]) * num);
+    for (i = 0; i < num; i++) {
+        ogs_assert(pkbuf[i]);
+
+        iov[i].iov_base = pkbuf[i]->data;
+        iov[i].iov_len = pkbuf[i]->len;
+
+        msg[i].msg_hdr.msg_name = (void *)&to->sa;
+        msg[i].msg_hdr.msg_namelen = addrlen;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* sendmmsg(2) may return early, so keep going until all are sent */
+    for (sent = 0; sent < num; sent += rv) {
+        rv = sendmmsg(fd, msg + sent, num - sent, flags);
+        if (rv <= 0)
+            break;
+    }
+#else
+    for (sent = 0; sent < num; sent++) {
+        ssize_t size;
+
+        ogs_assert(pkbuf[sent]);
+        size = ogs_sendto(fd,
+                pkbuf[sent]->data, pkbuf[sent]->len, flags, to);
+        if (size < 0 || size != pkbuf[sent]->len)
+            break;
+    }
+#endif
+
+    if (sent == 0)
+        return -1;
+
+    return sent;
+}
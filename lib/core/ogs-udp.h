@@ -28,12 +28,19 @@
 extern "C" {
 #endif
 
+#define OGS_MAX_MMSG 64
+
 ogs_sock_t *ogs_udp_server(
         ogs_sockaddr_t *sa_list, ogs_sockopt_t *socket_option);
 ogs_sock_t *ogs_udp_client(
         ogs_sockaddr_t *sa_list, ogs_sockopt_t *socket_option);
 int ogs_udp_connect(ogs_sock_t *sock, ogs_sockaddr_t *sa_list);
 
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, int flags);
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, int num, int flags, const ogs_sockaddr_t *to);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+#define WATCH_AWAIT_MSEC        500
+#define WATCH_RETRY_MSEC        1000
+
+/* The statistics are logged by the watcher, if they changed */
+#define STATS_LOG_SEC           60
+
+/*
+ * A document read from the database is not cached if its SUPI or _id
+ * was invalidated while the read was in flight. The last invalidations
+ * are kept in a ring for this check.
+ */
+#define NUM_OF_INVALIDATION     1024
+
+typedef struct cache_entry_s {
+    ogs_lnode_t lnode;          /* LRU order, the most recent first */
+
+    char *supi;
+    bson_oid_t oid;
+    bson_t *document;
+} cache_entry_t;
+
+typedef struct invalidation_s {
+    bool by_oid;
+    bson_oid_t oid;
+    unsigned int supi_hash;
+} invalidation_t;
+
+static struct {
+    int capacity;
+    bool watching;              /* The change stream is open */
+    bool terminated;
+
+    ogs_thread_mutex_t mutex;
+
+    ogs_list_t lru_list;
+    ogs_hash_t *supi_hash;
+    ogs_hash_t *oid_hash;
+
+    uint64_t epoch;
+    uint64_t flush_epoch;
+    invalidation_t invalidation[NUM_OF_INVALIDATION];
+
+    ogs_dbi_cache_stats_t stats;
+
+    ogs_mongoc_conn_t conn;
+#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
+    mongoc_change_stream_t *stream;
+#endif
+    ogs_thread_t *thread;
+} self;
+
+static OGS_POOL(cache_entry_pool, cache_entry_t);
+
+static unsigned int supi_hash(const char *supi)
+{
+    int klen = OGS_HASH_KEY_STRING;
+    return ogs_hashfunc_default(supi, &klen);
+}
+
+static void entry_remove(cache_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    ogs_list_remove(&self.lru_list, entry);
+    ogs_hash_set(self.supi_hash, entry->supi, OGS_HASH_KEY_STRING, NULL);
+    ogs_hash_set(self.oid_hash, &entry->oid, sizeof(entry->oid), NULL);
+
+    bson_destroy(entry->document);
+    ogs_free(entry->supi);
+
+    ogs_pool_free(&cache_entry_pool, entry);
+}
+
+static void entry_remove_all(void)
+{
+    cache_entry_t *entry = NULL, *next_entry = NULL;
+
+    ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+        entry_remove(entry);
+}
+
+static void invalidate_oid(const bson_oid_t *oid)
+{
+    invalidation_t *invalidation = NULL;
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(oid);
+
+    self.epoch++;
+    invalidation = &self.invalidation[self.epoch % NUM_OF_INVALIDATION];
+    invalidation->by_oid = true;
+    bson_oid_copy(oid, &invalidation->oid);
+
+    entry = ogs_hash_get(self.oid_hash, oid, sizeof(*oid));
+    if (entry) {
+        entry_remove(entry);
+        self.stats.invalidation++;
+    }
+}
+
+static void invalidate_supi(char *supi)
+{
+    invalidation_t *invalidation = NULL;
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+
+    self.epoch++;
+    invalidation = &self.invalidation[self.epoch % NUM_OF_INVALIDATION];
+    invalidation->by_oid = false;
+    invalidation->supi_hash = supi_hash(supi);
+
+    entry = ogs_hash_get(self.supi_hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        entry_remove(entry);
+        self.stats.invalidation++;
+    }
+}
+
+static void invalidate_all(void)
+{
+    self.stats.invalidation += ogs_list_count(&self.lru_list);
+    entry_remove_all();
+
+    self.flush_epoch = ++self.epoch;
+}
+
+static bool is_invalidated(
+        uint64_t epoch, char *supi, const bson_oid_t *oid)
+{
+    invalidation_t *invalidation = NULL;
+    unsigned int hash;
+    uint64_t i;
+
+    if (self.flush_epoch > epoch)
+        return true;
+    if (self.epoch - epoch >= NUM_OF_INVALIDATION)
+        return true;
+
+    hash = supi_hash(supi);
+    for (i = epoch + 1; i <= self.epoch; i++) {
+        invalidation = &self.invalidation[i % NUM_OF_INVALIDATION];
+        if (invalidation->by_oid) {
+            if (bson_oid_equal(&invalidation->oid, oid))
+                return true;
+        } else {
+            if (invalidation->supi_hash == hash)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+static void cache_add(uint64_t epoch, char *supi, const bson_t *document)
+{
+    bson_iter_t iter;
+    const bson_oid_t *oid = NULL;
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(document);
+
+    if (!bson_iter_init_find(&iter, document, "_id") ||
+        !BSON_ITER_HOLDS_OID(&iter))
+        return;
+    oid = bson_iter_oid(&iter);
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    if (!self.watching || is_invalidated(epoch, supi, oid))
+        goto out;
+    if (ogs_hash_get(self.supi_hash, supi, OGS_HASH_KEY_STRING))
+        goto out;
+
+    if (!ogs_pool_avail(&cache_entry_pool)) {
+        entry_remove(ogs_list_last(&self.lru_list));
+        self.stats.eviction++;
+    }
+
+    ogs_pool_alloc(&cache_entry_pool, &entry);
+    ogs_assert(entry);
+    memset(entry, 0, sizeof(*entry));
+
+    entry->supi = ogs_strdup(supi);
+    ogs_assert(entry->supi);
+    bson_oid_copy(oid, &entry->oid);
+    entry->document = bson_copy(document);
+    ogs_assert(entry->document);
+
+    ogs_hash_set(self.supi_hash, entry->supi, OGS_HASH_KEY_STRING, entry);
+    ogs_hash_set(self.oid_hash, &entry->oid, sizeof(entry->oid), entry);
+    ogs_list_prepend(&self.lru_list, entry);
+
+out:
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+static bson_t *subscriber_find(char *supi)
+{
+    ogs_mongoc_conn_t conn;
+    mongoc_cursor_t *cursor = NULL;
+    bson_t *query = NULL;
+    bson_error_t error;
+    const bson_t *document;
+    bson_t *copy = NULL;
+
+    char *supi_type = NULL;
+    char *supi_id = NULL;
+
+    ogs_assert(supi);
+
+    supi_type = ogs_id_get_type(supi);
+    ogs_assert(supi_type);
+    supi_id = ogs_id_get_value(supi);
+    ogs_assert(supi_id);
+
+    ogs_mongoc_conn_pop(&conn);
+
+    query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
+#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 5
+    cursor = mongoc_collection_find_with_opts(
+            conn.subscriber, query, NULL, NULL);
+#else
+    cursor = mongoc_collection_find(conn.subscriber,
+            MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
+#endif
+
+    if (!mongoc_cursor_next(cursor, &document)) {
+        if (mongoc_cursor_error(cursor, &error))
+            ogs_error("Cursor Failure: %s", error.message);
+        goto out;
+    }
+
+    copy = bson_copy(document);
+    ogs_assert(copy);
+
+out:
+    if (query) bson_destroy(query);
+    if (cursor) mongoc_cursor_destroy(cursor);
+
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_free(supi_type);
+    ogs_free(supi_id);
+
+    return copy;
+}
+
+bson_t *ogs_dbi_subscriber_document(char *supi)
+{
+    cache_entry_t *entry = NULL;
+    bson_t *document = NULL;
+    uint64_t epoch = 0;
+
+    ogs_assert(supi);
+
+    if (!self.capacity)
+        return subscriber_find(supi);
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.supi_hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        ogs_list_remove(&self.lru_list, entry);
+        ogs_list_prepend(&self.lru_list, entry);
+
+        document = bson_copy(entry->document);
+        ogs_assert(document);
+        self.stats.hit++;
+    } else {
+        self.stats.miss++;
+    }
+    epoch = self.epoch;
+
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    if (document)
+        return document;
+
+    document = subscriber_find(supi);
+    if (document)
+        cache_add(epoch, supi, document);
+
+    return document;
+}
+
+void ogs_dbi_cache_remove(char *supi)
+{
+    ogs_assert(supi);
+
+    if (!self.capacity)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    invalidate_supi(supi);
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+static void stats_log(ogs_dbi_cache_stats_t *stats)
+{
+    ogs_assert(stats);
+
+    ogs_info("Subscriber cache: %llu hits, %llu misses, "
+            "%llu evictions, %llu invalidations",
+            (unsigned long long)stats->hit,
+            (unsigned long long)stats->miss,
+            (unsigned long long)stats->eviction,
+            (unsigned long long)stats->invalidation);
+}
+
+void ogs_dbi_cache_stats(ogs_dbi_cache_stats_t *stats)
+{
+    ogs_assert(stats);
+
+    if (!self.capacity) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    ogs_thread_mutex_lock(&self.mutex);
+    memcpy(stats, &self.stats, sizeof(*stats));
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
+static mongoc_change_stream_t *watch_open(void)
+{
+    mongoc_change_stream_t *stream = NULL;
+    bson_t empty = BSON_INITIALIZER;
+    bson_t *options = NULL;
+    const bson_t *err_document;
+    bson_error_t error;
+
+    options = BCON_NEW("maxAwaitTimeMS", BCON_INT64(WATCH_AWAIT_MSEC));
+    ogs_assert(options);
+
+    stream = mongoc_collection_watch(self.conn.subscriber, &empty, options);
+    ogs_assert(stream);
+
+    bson_destroy(options);
+
+    if (mongoc_change_stream_error_document(stream, &error, &err_document)) {
+        ogs_warn("Subscriber cache cannot watch the change stream: %s",
+                error.message);
+        mongoc_change_stream_destroy(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+static void watch_event(const bson_t *event)
+{
+    bson_iter_t iter, child_iter;
+    const char *operation = NULL;
+    const bson_oid_t *oid = NULL;
+
+    if (bson_iter_init_find(&iter, event, "operationType") &&
+        BSON_ITER_HOLDS_UTF8(&iter))
+        operation = bson_iter_utf8(&iter, NULL);
+
+    if (bson_iter_init(&iter, event) &&
+        bson_iter_find_descendant(&iter, "documentKey._id", &child_iter) &&
+        BSON_ITER_HOLDS_OID(&child_iter))
+        oid = bson_iter_oid(&child_iter);
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    if (operation && !strcmp(operation, "insert")) {
+        /* Nothing is cached for a new document */
+    } else if (operation && oid &&
+            (!strcmp(operation, "update") ||
+             !strcmp(operation, "replace") ||
+             !strcmp(operation, "delete"))) {
+        invalidate_oid(oid);
+    } else {
+        /* drop, rename, dropDatabase, invalidate, ... */
+        ogs_warn("Subscriber cache flushed by [%s]",
+                operation ? operation : "Unknown");
+        invalidate_all();
+    }
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+static void watch_main(void *data)
+{
+    const bson_t *event = NULL;
+    const bson_t *err_document;
+    bson_error_t error;
+
+    ogs_dbi_cache_stats_t stats, logged_stats;
+    ogs_time_t now, stats_time;
+
+    memset(&logged_stats, 0, sizeof(logged_stats));
+    stats_time = ogs_get_monotonic_time();
+
+    for ( ;; ) {
+        ogs_thread_mutex_lock(&self.mutex);
+        if (self.terminated) {
+            ogs_thread_mutex_unlock(&self.mutex);
+            break;
+        }
+        memcpy(&stats, &self.stats, sizeof(stats));
+        ogs_thread_mutex_unlock(&self.mutex);
+
+        now = ogs_get_monotonic_time();
+        if (now - stats_time >= ogs_time_from_sec(STATS_LOG_SEC)) {
+            if (memcmp(&stats, &logged_stats, sizeof(stats))) {
+                stats_log(&stats);
+                memcpy(&logged_stats, &stats, sizeof(stats));
+            }
+            stats_time = now;
+        }
+
+        if (!self.stream) {
+            ogs_msleep(WATCH_RETRY_MSEC);
+
+            self.stream = watch_open();
+            if (!self.stream)
+                continue;
+
+            ogs_info("Subscriber cache is watching the change stream again");
+
+            /* Documents read while the stream was lost may be stale */
+            ogs_thread_mutex_lock(&self.mutex);
+            self.watching = true;
+            invalidate_all();
+            ogs_thread_mutex_unlock(&self.mutex);
+        }
+
+        if (mongoc_change_stream_next(self.stream, &event)) {
+            watch_event(event);
+            continue;
+        }
+
+        if (mongoc_change_stream_error_document(
+                    self.stream, &error, &err_document)) {
+            ogs_warn("Subscriber cache lost the change stream: %s",
+                    error.message);
+
+            /* Changes may be missed until the stream is reopened */
+            ogs_thread_mutex_lock(&self.mutex);
+            self.watching = false;
+            invalidate_all();
+            ogs_thread_mutex_unlock(&self.mutex);
+
+            mongoc_change_stream_destroy(self.stream);
+            self.stream = NULL;
+        }
+    }
+}
+#endif
+
+int ogs_dbi_cache_init(int capacity)
+{
+    memset(&self, 0, sizeof(self));
+
+    if (capacity <= 0)
+        return OGS_OK;
+
+#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
+    ogs_mongoc_conn_pop(&self.conn);
+
+    self.stream = watch_open();
+    if (!self.stream) {
+        ogs_warn("Subscriber cache is disabled, "
+                "MongoDB change streams need a replica set");
+        ogs_mongoc_conn_push(&self.conn);
+        return OGS_OK;
+    }
+
+    ogs_thread_mutex_init(&self.mutex);
+    ogs_list_init(&self.lru_list);
+
+    self.supi_hash = ogs_hash_make();
+    ogs_assert(self.supi_hash);
+    self.oid_hash = ogs_hash_make();
+    ogs_assert(self.oid_hash);
+
+    ogs_pool_init(&cache_entry_pool, capacity);
+
+    self.capacity = capacity;
+    self.watching = true;
+
+    self.thread = ogs_thread_create(watch_main, NULL);
+    if (!self.thread) {
+        ogs_error("ogs_thread_create() failed");
+        return OGS_ERROR;
+    }
+
+    ogs_info("Subscriber cache: %d entries", capacity);
+#else
+    ogs_warn("Subscriber cache is disabled, "
+            "MongoDB change streams need mongo-c-driver 1.9 or later");
+#endif
+
+    return OGS_OK;
+}
+
+void ogs_dbi_cache_final(void)
+{
+    if (!self.capacity)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    self.terminated = true;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    if (self.thread)
+        ogs_thread_destroy(self.thread);
+
+    stats_log(&self.stats);
+
+    entry_remove_all();
+
+    ogs_pool_final(&cache_entry_pool);
+    ogs_hash_destroy(self.oid_hash);
+    ogs_hash_destroy(self.supi_hash);
+
+#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
+    if (self.stream)
+        mongoc_change_stream_destroy(self.stream);
+#endif
+    ogs_mongoc_conn_push(&self.conn);
+
+    ogs_thread_mutex_destroy(&self.mutex);
+
+    self.capacity = 0;
+}
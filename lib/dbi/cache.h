@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_CACHE_H
+#define OGS_DBI_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Subscriber Cache
+ *
+ * Keeps the most recently used subscriber documents, keyed by SUPI,
+ * up to 'capacity' entries. Every lookup by SUPI (authentication,
+ * subscription, session and IMS data) decodes from a copy of the
+ * cached document, so a hit does not touch the database.
+ *
+ * A dedicated thread watches the change stream of the subscribers
+ * collection and drops the entry of each updated, replaced or deleted
+ * document by its _id. If the stream is lost, the whole cache is flushed
+ * and bypassed until the stream is reopened. Without change streams
+ * (MongoDB is not a replica set), the cache stays disabled.
+ *
+ * The writes in lib/dbi drop the entry of the SUPI right away.
+ *
+ * The hit, miss, eviction and invalidation counters are logged every
+ * minute while they change, and at ogs_dbi_cache_final().
+ */
+typedef struct ogs_dbi_cache_stats_s {
+    uint64_t hit;
+    uint64_t miss;
+    uint64_t eviction;
+    uint64_t invalidation;
+} ogs_dbi_cache_stats_t;
+
+int ogs_dbi_cache_init(int capacity);
+void ogs_dbi_cache_final(void);
+
+/* Returns a copy of the subscriber document, released by bson_destroy() */
+bson_t *ogs_dbi_subscriber_document(char *supi);
+
+void ogs_dbi_cache_remove(char *supi);
+void ogs_dbi_cache_stats(ogs_dbi_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_CACHE_H */
@@ -31,6 +31,9 @@
 #include "dbi/ims.h"
 #include "dbi/path.h"
 #include "dbi/timer.h"
+#include "dbi/query.h"
+#include "dbi/cache.h"
+#include "dbi/sqn.h"
 
 #undef OGS_DBI_INSIDE
 
@@ -83,8 +83,6 @@ int ogs_mongoc_init(const char *db_uri)
     bson_error_t error;
     bson_iter_t iter;
 
-    const mongoc_uri_t *uri;
-
     if (!db_uri) {
         ogs_error("No DB_URI");
         return OGS_ERROR;
@@ -98,22 +96,25 @@ int ogs_mongoc_init(const char *db_uri)
 
     self.initialized = true;
 
-    self.client = mongoc_client_new(db_uri);
-    if (!self.client) {
+    self.uri = mongoc_uri_new(db_uri);
+    if (!self.uri) {
         ogs_error("Failed to parse DB URI [%s]", self.masked_db_uri);
         return OGS_ERROR;
     }
 
+    self.pool = mongoc_client_pool_new(self.uri);
+    ogs_assert(self.pool);
+
 #if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 4
-    mongoc_client_set_error_api(self.client, 2);
+    mongoc_client_pool_set_error_api(self.pool, 2);
 #endif
 
-    uri = mongoc_client_get_uri(self.client);
-    ogs_assert(uri);
-
-    self.name = mongoc_uri_get_database(uri);
+    self.name = mongoc_uri_get_database(self.uri);
     ogs_assert(self.name);
 
+    self.client = mongoc_client_pool_pop(self.pool);
+    ogs_assert(self.client);
+
     self.database = mongoc_client_get_database(self.client, self.name);
     ogs_assert(self.database);
 
@@ -139,9 +140,17 @@ void ogs_mongoc_final(void)
         self.database = NULL;
     }
     if (self.client) {
-        mongoc_client_destroy(self.client);
+        mongoc_client_pool_push(self.pool, self.client);
         self.client = NULL;
     }
+    if (self.pool) {
+        mongoc_client_pool_destroy(self.pool);
+        self.pool = NULL;
+    }
+    if (self.uri) {
+        mongoc_uri_destroy(self.uri);
+        self.uri = NULL;
+    }
     if (self.masked_db_uri) {
         ogs_free(self.masked_db_uri);
         self.masked_db_uri = NULL;
@@ -158,6 +167,33 @@ ogs_mongoc_t *ogs_mongoc(void)
     return &self;
 }
 
+void ogs_mongoc_conn_pop(ogs_mongoc_conn_t *conn)
+{
+    ogs_assert(conn);
+    ogs_assert(self.pool);
+    ogs_assert(self.name);
+
+    /* Waits if all the clients of the pool are in use */
+    conn->client = mongoc_client_pool_pop(self.pool);
+    ogs_assert(conn->client);
+
+    conn->subscriber = mongoc_client_get_collection(
+            conn->client, self.name, "subscribers");
+    ogs_assert(conn->subscriber);
+}
+
+void ogs_mongoc_conn_push(ogs_mongoc_conn_t *conn)
+{
+    ogs_assert(conn);
+    ogs_assert(conn->client);
+    ogs_assert(conn->subscriber);
+
+    mongoc_collection_destroy(conn->subscriber);
+    mongoc_client_pool_push(self.pool, conn->client);
+
+    memset(conn, 0, sizeof(*conn));
+}
+
 int ogs_dbi_init(const char *db_uri)
 {
     int rv;
@@ -173,11 +209,20 @@ int ogs_dbi_init(const char *db_uri)
         ogs_assert(self.collection.subscriber);
     }
 
+    rv = ogs_dbi_cache_init(ogs_app()->subscriber_cache);
+    if (rv != OGS_OK) return rv;
+
+    rv = ogs_dbi_sqn_init(ogs_app()->sqn_reservation, ogs_app()->max.ue);
+    if (rv != OGS_OK) return rv;
+
     return OGS_OK;
 }
 
 void ogs_dbi_final(void)
 {
+    ogs_dbi_sqn_final();
+    ogs_dbi_cache_final();
+
     if (self.collection.subscriber) {
         mongoc_collection_destroy(self.collection.subscriber);
     }
@@ -34,7 +34,8 @@ typedef struct ogs_mongoc_s {
     bool initialized;
     const char *name;
     void *uri;
-    void *client;
+    void *pool;
+    void *client;               /* Popped for the main thread */
     void *database;
 
 #if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
@@ -48,10 +49,22 @@ typedef struct ogs_mongoc_s {
     } collection;
 } ogs_mongoc_t;
 
+/*
+ * A DB operation takes its own client from the pool, so that
+ * the Diameter worker threads no longer wait for each other.
+ */
+typedef struct ogs_mongoc_conn_s {
+    mongoc_client_t *client;
+    mongoc_collection_t *subscriber;
+} ogs_mongoc_conn_t;
+
 int ogs_mongoc_init(const char *db_uri);
 void ogs_mongoc_final(void);
 ogs_mongoc_t *ogs_mongoc(void);
 
+void ogs_mongoc_conn_pop(ogs_mongoc_conn_t *conn);
+void ogs_mongoc_conn_push(ogs_mongoc_conn_t *conn);
+
 int ogs_dbi_init(const char *db_uri);
 void ogs_dbi_final(void);
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+static struct {
+    ogs_thread_mutex_t mutex;
+    ogs_thread_cond_t cond;
+
+    ogs_list_t wait_list;       /* Submitted, not yet running */
+    int num_of_waiting;
+    int max_waiting;            /* 0 : No limit */
+    bool terminated;
+
+    int num_of_worker;
+    ogs_thread_t **worker;
+} self;
+
+static void query_complete(ogs_dbi_query_t *query)
+{
+    int rv;
+    ogs_event_t *e = NULL;
+
+    e = ogs_event_new(OGS_EVENT_DBI_QUERY);
+    ogs_assert(e);
+    e->dbi.query = query;
+
+    rv = ogs_queue_push(ogs_app()->queue, e);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed:%d", (int)rv);
+        ogs_event_free(e);
+        query->discard(query);
+    } else {
+        ogs_pollset_notify(ogs_app()->pollset);
+    }
+}
+
+static void worker_main(void *data)
+{
+    ogs_dbi_query_t *query = NULL;
+
+    for ( ;; ) {
+        ogs_thread_mutex_lock(&self.mutex);
+        while (!self.terminated && !ogs_list_first(&self.wait_list))
+            ogs_thread_cond_wait(&self.cond, &self.mutex);
+
+        if (self.terminated) {
+            ogs_thread_mutex_unlock(&self.mutex);
+            break;
+        }
+
+        query = ogs_list_first(&self.wait_list);
+        ogs_list_remove(&self.wait_list, query);
+        self.num_of_waiting--;
+        ogs_thread_mutex_unlock(&self.mutex);
+
+        query->run(query);
+        query_complete(query);
+    }
+}
+
+int ogs_dbi_query_init(int num_of_worker, int max_waiting)
+{
+    int i;
+
+    ogs_assert(num_of_worker >= 0);
+    ogs_assert(max_waiting >= 0);
+
+    memset(&self, 0, sizeof(self));
+    self.max_waiting = max_waiting;
+
+    ogs_thread_mutex_init(&self.mutex);
+    ogs_thread_cond_init(&self.cond);
+    ogs_list_init(&self.wait_list);
+
+    if (!num_of_worker)
+        return OGS_OK;
+
+    self.worker = ogs_calloc(num_of_worker, sizeof(ogs_thread_t *));
+    if (!self.worker) {
+        ogs_error("ogs_calloc() failed");
+        return OGS_ERROR;
+    }
+
+    for (i = 0; i < num_of_worker; i++) {
+        self.worker[i] = ogs_thread_create(worker_main, NULL);
+        if (!self.worker[i]) {
+            ogs_error("ogs_thread_create() failed");
+            return OGS_ERROR;
+        }
+        self.num_of_worker++;
+    }
+
+    return OGS_OK;
+}
+
+void ogs_dbi_query_final(void)
+{
+    ogs_dbi_query_t *query = NULL, *next_query = NULL;
+    int i;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    self.terminated = true;
+    ogs_thread_cond_broadcast(&self.cond);
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    for (i = 0; i < self.num_of_worker; i++)
+        ogs_thread_destroy(self.worker[i]);
+
+    if (self.worker)
+        ogs_free(self.worker);
+
+    ogs_list_for_each_safe(&self.wait_list, next_query, query) {
+        ogs_list_remove(&self.wait_list, query);
+        query->discard(query);
+    }
+
+    ogs_thread_cond_destroy(&self.cond);
+    ogs_thread_mutex_destroy(&self.mutex);
+}
+
+int ogs_dbi_query_submit(ogs_dbi_query_t *query)
+{
+    ogs_assert(query);
+    ogs_assert(query->run);
+    ogs_assert(query->discard);
+
+    if (!self.num_of_worker) {
+        query->run(query);
+        query_complete(query);
+        return OGS_OK;
+    }
+
+    ogs_thread_mutex_lock(&self.mutex);
+    if (self.max_waiting && self.num_of_waiting >= self.max_waiting) {
+        ogs_thread_mutex_unlock(&self.mutex);
+        return OGS_RETRY;
+    }
+    ogs_list_add(&self.wait_list, query);
+    self.num_of_waiting++;
+    ogs_thread_cond_signal(&self.cond);
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return OGS_OK;
+}
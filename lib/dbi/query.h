@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_QUERY_H
+#define OGS_DBI_QUERY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous DB Query
+ *
+ * ogs_dbi_query_submit() hands the query over to a worker thread,
+ * which calls 'run'. The result comes back to the main loop as
+ * an OGS_EVENT_DBI_QUERY event with e->dbi.query set, and the NF
+ * releases the query there.
+ *
+ * 'run' must only access the DB and the query itself.
+ * 'discard' releases a query that cannot be completed
+ * because the NF is terminating.
+ *
+ * At most 'num_of_worker' queries run at once, the others wait in order.
+ * Without any worker, 'run' is called from ogs_dbi_query_submit().
+ *
+ * When 'max_waiting' queries are already waiting (0 : no limit),
+ * ogs_dbi_query_submit() returns OGS_RETRY and the caller keeps the query.
+ */
+typedef struct ogs_dbi_query_s ogs_dbi_query_t;
+typedef void (*ogs_dbi_query_f)(ogs_dbi_query_t *query);
+
+struct ogs_dbi_query_s {
+    ogs_lnode_t lnode;
+
+    ogs_dbi_query_f run;
+    ogs_dbi_query_f discard;
+};
+
+int ogs_dbi_query_init(int num_of_worker, int max_waiting);
+void ogs_dbi_query_final(void);
+
+int ogs_dbi_query_submit(ogs_dbi_query_t *query);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_QUERY_H */
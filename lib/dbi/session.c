@@ -23,11 +23,8 @@ int ogs_dbi_session_data(char *supi, ogs_s_nssai_t *s_nssai, char *dnn,
         ogs_session_data_t *session_data)
 {
     int rv = OGS_OK;
-    mongoc_cursor_t *cursor = NULL;
-    bson_t *query = NULL;
     bson_t *opts = NULL;
-    bson_error_t error;
-    const bson_t *document;
+    bson_t *document = NULL;
     bson_iter_t iter;
     bson_iter_t child1_iter, child2_iter, child3_iter, child4_iter, child5_iter;
     bson_iter_t child6_iter, child7_iter, child8_iter, child9_iter;
@@ -37,9 +34,6 @@ int ogs_dbi_session_data(char *supi, ogs_s_nssai_t *s_nssai, char *dnn,
 
     ogs_session_t *session = NULL;
 
-    char *supi_type = NULL;
-    char *supi_id = NULL;
-
     ogs_session_data_t zero_data;
 
     ogs_assert(supi);
@@ -51,34 +45,14 @@ int ogs_dbi_session_data(char *supi, ogs_s_nssai_t *s_nssai, char *dnn,
     /* session_data should be initialized to zero */
     ogs_assert(memcmp(session_data, &zero_data, sizeof(zero_data)) == 0);
 
-    supi_type = ogs_id_get_type(supi);
-    ogs_assert(supi_type);
-    supi_id = ogs_id_get_value(supi);
-    ogs_assert(supi_id);
-
-    query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
-#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 5
-    cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
-#else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
-            MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
-#endif
-
-    if (!mongoc_cursor_next(cursor, &document)) {
+    document = ogs_dbi_subscriber_document(supi);
+    if (!document) {
         ogs_error("[%s] Cannot find IMSI in DB", supi);
 
         rv = OGS_ERROR;
         goto out;
     }
 
-    if (mongoc_cursor_error(cursor, &error)) {
-        ogs_error("Cursor Failure: %s", error.message);
-
-        rv = OGS_ERROR;
-        goto out;
-    }
-
     /* Finding Session for S_NSSAI+DNN */
     if (!bson_iter_init(&iter, document)) {
         ogs_error("bson_iter_init failed in this document");
@@ -491,12 +465,8 @@ done:
     }
 
 out:
-    if (query) bson_destroy(query);
+    if (document) bson_destroy(document);
     if (opts) bson_destroy(opts);
-    if (cursor) mongoc_cursor_destroy(cursor);
-
-    ogs_free(supi_type);
-    ogs_free(supi_id);
 
     return rv;
 }
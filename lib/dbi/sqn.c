@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+/* SEQ is advanced by one, IND (5 bits) is left as it is */
+#define SQN_STEP                32
+
+typedef struct sqn_entry_s {
+    ogs_lnode_t lnode;          /* LRU order, the most recent first */
+
+    char *supi;
+    uint64_t next;              /* SQN of the next vector */
+    uint64_t ceiling;           /* End of the reserved range in the DB */
+} sqn_entry_t;
+
+static struct {
+    uint64_t range;             /* num_of_vector * SQN_STEP */
+
+    ogs_thread_mutex_t mutex;
+
+    ogs_list_t lru_list;
+    ogs_hash_t *supi_hash;
+} self;
+
+static OGS_POOL(sqn_entry_pool, sqn_entry_t);
+
+static void entry_remove(sqn_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    ogs_list_remove(&self.lru_list, entry);
+    ogs_hash_set(self.supi_hash, entry->supi, OGS_HASH_KEY_STRING, NULL);
+    ogs_free(entry->supi);
+
+    ogs_pool_free(&sqn_entry_pool, entry);
+}
+
+static sqn_entry_t *entry_find(char *supi)
+{
+    sqn_entry_t *entry = NULL;
+
+    entry = ogs_hash_get(self.supi_hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        ogs_list_remove(&self.lru_list, entry);
+        ogs_list_prepend(&self.lru_list, entry);
+    }
+
+    return entry;
+}
+
+static sqn_entry_t *entry_find_or_add(char *supi)
+{
+    sqn_entry_t *entry = NULL;
+
+    entry = entry_find(supi);
+    if (entry)
+        return entry;
+
+    /* The rest of the evicted range is skipped */
+    if (!ogs_pool_avail(&sqn_entry_pool))
+        entry_remove(ogs_list_last(&self.lru_list));
+
+    ogs_pool_alloc(&sqn_entry_pool, &entry);
+    ogs_assert(entry);
+    memset(entry, 0, sizeof(*entry));
+
+    entry->supi = ogs_strdup(supi);
+    ogs_assert(entry->supi);
+
+    ogs_hash_set(self.supi_hash, entry->supi, OGS_HASH_KEY_STRING, entry);
+    ogs_list_prepend(&self.lru_list, entry);
+
+    return entry;
+}
+
+/*
+ * The SQNs in [ceiling - range, ceiling) now belong to this process.
+ * Any other range held by the entry is abandoned, unless it is the higher
+ * one, as a racing reservation made without the lock may have set it.
+ */
+static void entry_set_range(sqn_entry_t *entry, uint64_t ceiling)
+{
+    ogs_assert(entry);
+    ogs_assert(ceiling >= self.range);
+
+    if (ceiling <= entry->ceiling)
+        return;
+
+    if (entry->next < ceiling - self.range || entry->next >= ceiling)
+        entry->next = ceiling - self.range;
+    entry->ceiling = ceiling;
+}
+
+/*
+ * Raises 'security.sqn' to 'sqn' first if 'raise' is set,
+ * and then reserves a range above it.
+ */
+static int reserve(char *supi, bool raise, uint64_t sqn, uint64_t *ceiling)
+{
+    int rv = OGS_OK;
+    ogs_mongoc_conn_t conn;
+    bson_t *query = NULL;
+    bson_t *update = NULL;
+    bson_t *fields = NULL;
+    bson_t reply;
+    bson_error_t error;
+    bson_iter_t iter, child_iter;
+
+    char *supi_type = NULL;
+    char *supi_id = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(ceiling);
+
+    supi_type = ogs_id_get_type(supi);
+    ogs_assert(supi_type);
+    supi_id = ogs_id_get_value(supi);
+    ogs_assert(supi_id);
+
+    ogs_mongoc_conn_pop(&conn);
+
+    query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
+
+    if (raise) {
+        update = BCON_NEW("$max",
+                "{",
+                    "security.sqn", BCON_INT64(sqn),
+                "}");
+        if (!mongoc_collection_update(conn.subscriber,
+                MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
+            ogs_error("mongoc_collection_update() failure: %s",
+                    error.message);
+
+            rv = OGS_ERROR;
+            goto out;
+        }
+        bson_destroy(update);
+    }
+
+    update = BCON_NEW("$inc",
+            "{",
+                "security.sqn", BCON_INT64(self.range),
+            "}");
+    fields = BCON_NEW("security.sqn", BCON_INT32(1));
+
+    if (!mongoc_collection_find_and_modify(conn.subscriber,
+            query, NULL, update, fields, false, false, true, &reply, &error)) {
+        ogs_error("mongoc_collection_find_and_modify() failure: %s",
+                error.message);
+
+        rv = OGS_ERROR;
+    } else if (!bson_iter_init(&iter, &reply) ||
+            !bson_iter_find_descendant(
+                &iter, "value.security.sqn", &child_iter) ||
+            !BSON_ITER_HOLDS_INT64(&child_iter)) {
+        ogs_error("[%s] Cannot reserve SQN", supi);
+
+        rv = OGS_ERROR;
+    } else {
+        *ceiling = bson_iter_int64(&child_iter);
+    }
+    bson_destroy(&reply);
+
+out:
+    if (query) bson_destroy(query);
+    if (update) bson_destroy(update);
+    if (fields) bson_destroy(fields);
+
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_dbi_cache_remove(supi);
+
+    ogs_free(supi_type);
+    ogs_free(supi_id);
+
+    return rv;
+}
+
+int ogs_dbi_sqn_get(char *supi, uint64_t *sqn)
+{
+    int rv;
+    sqn_entry_t *entry = NULL;
+    uint64_t ceiling = 0;
+
+    ogs_assert(supi);
+    ogs_assert(sqn);
+    ogs_assert(self.range);
+
+    ogs_thread_mutex_lock(&self.mutex);
+    entry = entry_find(supi);
+
+    /* The range kept by entry_set_range() may be used up already */
+    while (!entry || entry->next >= entry->ceiling) {
+        ogs_thread_mutex_unlock(&self.mutex);
+
+        rv = reserve(supi, false, 0, &ceiling);
+        if (rv != OGS_OK)
+            return rv;
+
+        ogs_thread_mutex_lock(&self.mutex);
+        entry = entry_find_or_add(supi);
+        entry_set_range(entry, ceiling);
+    }
+
+    *sqn = entry->next & OGS_MAX_SQN;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return OGS_OK;
+}
+
+int ogs_dbi_sqn_update(char *supi, uint64_t sqn)
+{
+    int rv;
+    sqn_entry_t *entry = NULL;
+    uint64_t ceiling = 0;
+
+    ogs_assert(supi);
+    ogs_assert(self.range);
+
+    ogs_thread_mutex_lock(&self.mutex);
+    entry = entry_find(supi);
+    if (entry && sqn < entry->ceiling) {
+        entry->next = sqn;
+        ogs_thread_mutex_unlock(&self.mutex);
+        return OGS_OK;
+    }
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    /* Re-synchronization beyond the range */
+    rv = reserve(supi, true, sqn, &ceiling);
+    if (rv != OGS_OK)
+        return rv;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    entry = entry_find_or_add(supi);
+    entry_set_range(entry, ceiling);
+    entry->next = sqn;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return OGS_OK;
+}
+
+int ogs_dbi_sqn_increment(char *supi)
+{
+    sqn_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(self.range);
+
+    /*
+     * Nothing is written. Once the range is used up,
+     * or the entry is evicted, ogs_dbi_sqn_get() reserves the next one.
+     */
+    ogs_thread_mutex_lock(&self.mutex);
+    entry = entry_find(supi);
+    if (entry)
+        entry->next += SQN_STEP;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return OGS_OK;
+}
+
+bool ogs_dbi_sqn_enabled(void)
+{
+    return self.range != 0;
+}
+
+int ogs_dbi_sqn_init(int num_of_vector, int capacity)
+{
+    memset(&self, 0, sizeof(self));
+
+    if (num_of_vector <= 0)
+        return OGS_OK;
+
+    ogs_assert(capacity > 0);
+
+    ogs_thread_mutex_init(&self.mutex);
+    ogs_list_init(&self.lru_list);
+
+    self.supi_hash = ogs_hash_make();
+    ogs_assert(self.supi_hash);
+
+    ogs_pool_init(&sqn_entry_pool, capacity);
+
+    self.range = (uint64_t)num_of_vector * SQN_STEP;
+
+    ogs_info("SQN reservation: %d vectors", num_of_vector);
+
+    return OGS_OK;
+}
+
+void ogs_dbi_sqn_final(void)
+{
+    sqn_entry_t *entry = NULL, *next_entry = NULL;
+
+    if (!self.range)
+        return;
+
+    ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+        entry_remove(entry);
+
+    ogs_pool_final(&sqn_entry_pool);
+    ogs_hash_destroy(self.supi_hash);
+
+    ogs_thread_mutex_destroy(&self.mutex);
+
+    self.range = 0;
+}
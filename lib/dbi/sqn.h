@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_SQN_H
+#define OGS_DBI_SQN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SQN Reservation
+ *
+ * Instead of writing 'security.sqn' for every authentication vector,
+ * a range of 'num_of_vector' SQNs is reserved at once with an atomic $inc,
+ * and the SQNs of the range are handed out from memory.
+ * ogs_dbi_auth_info(), ogs_dbi_update_sqn() and ogs_dbi_increment_sqn()
+ * go through it when it is enabled.
+ *
+ * The DB keeps the end of the last reserved range. A range is written
+ * before any of its SQNs is used, so an SQN is never reused after
+ * a restart, at the cost of skipping the rest of the range.
+ *
+ * An SQN changed in the DB by someone else (e.g. WebUI) is only seen
+ * once the current range is used up.
+ */
+int ogs_dbi_sqn_init(int num_of_vector, int capacity);
+void ogs_dbi_sqn_final(void);
+
+bool ogs_dbi_sqn_enabled(void);
+
+int ogs_dbi_sqn_get(char *supi, uint64_t *sqn);
+int ogs_dbi_sqn_update(char *supi, uint64_t sqn);
+int ogs_dbi_sqn_increment(char *supi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_SQN_H */
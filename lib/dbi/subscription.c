@@ -22,50 +22,24 @@
 int ogs_dbi_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info)
 {
     int rv = OGS_OK;
-    mongoc_cursor_t *cursor = NULL;
-    bson_t *query = NULL;
-    bson_error_t error;
-    const bson_t *document;
+    bson_t *document = NULL;
     bson_iter_t iter;
     bson_iter_t inner_iter;
     char buf[OGS_KEY_LEN];
     char *utf8 = NULL;
     uint32_t length = 0;
 
-    char *supi_type = NULL;
-    char *supi_id = NULL;
-
     ogs_assert(supi);
     ogs_assert(auth_info);
 
-    supi_type = ogs_id_get_type(supi);
-    ogs_assert(supi_type);
-    supi_id = ogs_id_get_value(supi);
-    ogs_assert(supi_id);
-
-    query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
-#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 5
-    cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
-#else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
-            MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
-#endif
-
-    if (!mongoc_cursor_next(cursor, &document)) {
+    document = ogs_dbi_subscriber_document(supi);
+    if (!document) {
         ogs_info("[%s] Cannot find IMSI in DB", supi);
 
         rv = OGS_ERROR;
         goto out;
     }
 
-    if (mongoc_cursor_error(cursor, &error)) {
-        ogs_error("Cursor Failure: %s", error.message);
-
-        rv = OGS_ERROR;
-        goto out;
-    }
-
     if (!bson_iter_init_find(&iter, document, "security")) {
         ogs_error("No 'security' field in this document");
 
@@ -104,12 +78,12 @@ int ogs_dbi_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info)
         }
     }
 
-out:
-    if (query) bson_destroy(query);
-    if (cursor) mongoc_cursor_destroy(cursor);
+    /* The DB only keeps the end of the reserved range */
+    if (ogs_dbi_sqn_enabled())
+        rv = ogs_dbi_sqn_get(supi, &auth_info->sqn);
 
-    ogs_free(supi_type);
-    ogs_free(supi_id);
+out:
+    if (document) bson_destroy(document);
 
     return rv;
 }
@@ -117,6 +91,7 @@ out:
 int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
 {
     int rv = OGS_OK;
+    ogs_mongoc_conn_t conn;
     bson_t *query = NULL;
     bson_t *update = NULL;
     bson_error_t error;
@@ -126,18 +101,23 @@ int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
 
     ogs_assert(supi);
 
+    if (ogs_dbi_sqn_enabled())
+        return ogs_dbi_sqn_update(supi, sqn);
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
     ogs_assert(supi_id);
 
+    ogs_mongoc_conn_pop(&conn);
+
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
     update = BCON_NEW("$set",
             "{",
                 "security.sqn", BCON_INT64(sqn),
             "}");
 
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(conn.subscriber,
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -147,6 +127,10 @@ int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
     if (query) bson_destroy(query);
     if (update) bson_destroy(update);
 
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_dbi_cache_remove(supi);
+
     ogs_free(supi_type);
     ogs_free(supi_id);
 
@@ -156,6 +140,7 @@ int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
 int ogs_dbi_update_imeisv(char *supi, char *imeisv)
 {
     int rv = OGS_OK;
+    ogs_mongoc_conn_t conn;
     bson_t *query = NULL;
     bson_t *update = NULL;
     bson_error_t error;
@@ -173,12 +158,14 @@ int ogs_dbi_update_imeisv(char *supi, char *imeisv)
     ogs_debug("SUPI type: %s, SUPI id: %s, imeisv: %s",
             supi_type, supi_id, imeisv);
 
+    ogs_mongoc_conn_pop(&conn);
+
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
     update = BCON_NEW("$set",
             "{",
                 "imeisv", BCON_UTF8(imeisv),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(conn.subscriber,
             MONGOC_UPDATE_UPSERT, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -188,6 +175,10 @@ int ogs_dbi_update_imeisv(char *supi, char *imeisv)
     if (query) bson_destroy(query);
     if (update) bson_destroy(update);
 
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_dbi_cache_remove(supi);
+
     ogs_free(supi_type);
     ogs_free(supi_id);
 
@@ -198,6 +189,7 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
     bool purge_flag)
 {
     int rv = OGS_OK;
+    ogs_mongoc_conn_t conn;
     bson_t *query = NULL;
     bson_t *update = NULL;
     bson_error_t error;
@@ -215,6 +207,8 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
     ogs_debug("SUPI type: %s, SUPI id: %s, mme_host: %s, mme_realm: %s",
             supi_type, supi_id, mme_host, mme_realm);
 
+    ogs_mongoc_conn_pop(&conn);
+
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
     update = BCON_NEW("$set",
             "{",
@@ -223,7 +217,7 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
                 "mme_timestamp", BCON_INT64(ogs_time_now()),
                 "purge_flag", BCON_BOOL(purge_flag),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(conn.subscriber,
             MONGOC_UPDATE_UPSERT, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -233,6 +227,10 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
     if (query) bson_destroy(query);
     if (update) bson_destroy(update);
 
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_dbi_cache_remove(supi);
+
     ogs_free(supi_type);
     ogs_free(supi_id);
 
@@ -242,6 +240,7 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
 int ogs_dbi_increment_sqn(char *supi)
 {
     int rv = OGS_OK;
+    ogs_mongoc_conn_t conn;
     bson_t *query = NULL;
     bson_t *update = NULL;
     bson_error_t error;
@@ -252,17 +251,22 @@ int ogs_dbi_increment_sqn(char *supi)
 
     ogs_assert(supi);
 
+    if (ogs_dbi_sqn_enabled())
+        return ogs_dbi_sqn_increment(supi);
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
     ogs_assert(supi_id);
 
+    ogs_mongoc_conn_pop(&conn);
+
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
     update = BCON_NEW("$inc",
             "{",
                 "security.sqn", BCON_INT64(32),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(conn.subscriber,
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -276,7 +280,7 @@ int ogs_dbi_increment_sqn(char *supi)
                 "security.sqn", 
                 "{", "and", BCON_INT64(max_sqn), "}",
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(conn.subscriber,
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -287,6 +291,10 @@ out:
     if (query) bson_destroy(query);
     if (update) bson_destroy(update);
 
+    ogs_mongoc_conn_push(&conn);
+
+    ogs_dbi_cache_remove(supi);
+
     ogs_free(supi_type);
     ogs_free(supi_id);
 
@@ -297,19 +305,13 @@ int ogs_dbi_subscription_data(char *supi,
         ogs_subscription_data_t *subscription_data)
 {
     int rv = OGS_OK;
-    mongoc_cursor_t *cursor = NULL;
-    bson_t *query = NULL;
-    bson_error_t error;
-    const bson_t *document;
+    bson_t *document = NULL;
     bson_iter_t iter;
     bson_iter_t child1_iter, child2_iter, child3_iter;
     bson_iter_t child4_iter, child5_iter, child6_iter;
     const char *utf8 = NULL;
     uint32_t length = 0;
 
-    char *supi_type = NULL;
-    char *supi_id = NULL;
-
     ogs_subscription_data_t zero_data;
 
     ogs_assert(subscription_data);
@@ -320,34 +322,14 @@ int ogs_dbi_subscription_data(char *supi,
     /* subscription_data should be initialized to zero */
     ogs_assert(memcmp(subscription_data, &zero_data, sizeof(zero_data)) == 0);
 
-    supi_type = ogs_id_get_type(supi);
-    ogs_assert(supi_type);
-    supi_id = ogs_id_get_value(supi);
-    ogs_assert(supi_id);
-
-    query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
-#if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 5
-    cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
-#else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
-            MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
-#endif
-
-    if (!mongoc_cursor_next(cursor, &document)) {
+    document = ogs_dbi_subscriber_document(supi);
+    if (!document) {
         ogs_error("[%s] Cannot find IMSI in DB", supi);
 
         rv = OGS_ERROR;
         goto out;
     }
 
-    if (mongoc_cursor_error(cursor, &error)) {
-        ogs_error("Cursor Failure: %s", error.message);
-
-        rv = OGS_ERROR;
-        goto out;
-    }
-
     if (!bson_iter_init(&iter, document)) {
         ogs_error("bson_iter_init failed in this document");
 
@@ -782,11 +764,7 @@ int ogs_dbi_subscription_data(char *supi,
     }
 
 out:
-    if (query) bson_destroy(query);
-    if (cursor) mongoc_cursor_destroy(cursor);
-
-    ogs_free(supi_type);
-    ogs_free(supi_id);
+    if (document) bson_destroy(document);
 
     return rv;
 }
@@ -63,12 +63,18 @@ static int ogs_gtp_context_prepare(void)
 {
     self.gtpc_port = OGS_GTPV2_C_UDP_PORT;
     self.gtpu_port = OGS_GTPV1_U_UDP_PORT;
+    self.gtpu_batch = 1;
 
     return OGS_OK;
 }
 
 static int ogs_gtp_context_validation(const char *local)
 {
+    if (self.gtpu_batch < 1 || self.gtpu_batch > OGS_MAX_MMSG) {
+        ogs_error("Invalid gtpu_batch[%d] in '%s' (1..%d)",
+                self.gtpu_batch, ogs_app()->file, OGS_MAX_MMSG);
+        return OGS_ERROR;
+    }
     return OGS_OK;
 }
 
@@ -512,6 +518,9 @@ int ogs_gtp_context_parse_config(const char *local, const char *remote)
                         ogs_list_for_each_safe(&list6, next_iter, iter)
                             ogs_list_add(&self.gtpu_list, iter);
                     }
+                } else if (!strcmp(local_key, "gtpu_batch")) {
+                    const char *v = ogs_yaml_iter_value(&local_iter);
+                    if (v) self.gtpu_batch = atoi(v);
                 }
             }
         }
@@ -548,6 +557,7 @@ void ogs_gtp_node_free(ogs_gtp_node_t *node)
 {
     ogs_assert(node);
 
+    ogs_gtp_flush(node);
     ogs_gtp_xact_delete_all(node);
 
     ogs_freeaddrinfo(node->sa_list);
@@ -129,6 +129,123 @@ int ogs_gtp_sendto(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
     return OGS_OK;
 }
 
+/*
+ * Transmit Batches
+ *
+ * Each thread keeps its own batch per peer, so the data-plane workers
+ * never share one. A thread holds batches for up to OGS_GTP_MAX_TX_BATCH
+ * peers at a time, and must flush them with ogs_gtp_flush_all() before
+ * the peers can be removed by another thread.
+ */
+typedef struct ogs_gtp_tx_batch_s {
+    ogs_gtp_node_t  *gnode;
+    int             num_of_pkbuf;
+    ogs_pkbuf_t     *pkbuf[OGS_MAX_MMSG];
+} ogs_gtp_tx_batch_t;
+
+static OGS_THREAD_LOCAL ogs_gtp_tx_batch_t tx_batch[OGS_GTP_MAX_TX_BATCH];
+static OGS_THREAD_LOCAL int num_of_tx_batch;
+
+static int tx_batch_send(ogs_gtp_tx_batch_t *tx)
+{
+    int i, sent, rv = OGS_OK;
+    ogs_gtp_node_t *gnode = NULL;
+    ogs_sock_t *sock = NULL;
+
+    gnode = tx->gnode;
+    ogs_assert(gnode);
+
+    if (tx->num_of_pkbuf == 0)
+        return OGS_OK;
+
+    sock = gnode->sock;
+    ogs_assert(sock);
+
+    sent = ogs_sendmmsg(sock->fd, tx->pkbuf, tx->num_of_pkbuf, 0, &gnode->addr);
+    if (sent != tx->num_of_pkbuf) {
+        if (ogs_socket_errno != OGS_EAGAIN) {
+            char buf[OGS_ADDRSTRLEN];
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_sendmmsg(%u, %d/%d, 0, %s:%u) failed",
+                    sock->fd, sent, tx->num_of_pkbuf,
+                    OGS_ADDR(&gnode->addr, buf), OGS_PORT(&gnode->addr));
+        }
+        rv = OGS_ERROR;
+    }
+
+    for (i = 0; i < tx->num_of_pkbuf; i++)
+        ogs_pkbuf_free(tx->pkbuf[i]);
+    tx->num_of_pkbuf = 0;
+
+    return rv;
+}
+
+/*
+ * Queue the G-PDU on the batch of the calling thread for the peer, and
+ * transmit the whole batch with a single sendmmsg() once gtpu_batch
+ * packets are pending. The pkbuf is owned by the batch and freed after
+ * transmission.
+ */
+int ogs_gtp_sendto_batch(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
+{
+    ogs_gtp_tx_batch_t *tx = NULL;
+    int i;
+
+    ogs_assert(gnode);
+    ogs_assert(pkbuf);
+
+    for (i = 0; i < num_of_tx_batch; i++) {
+        if (tx_batch[i].gnode == gnode) {
+            tx = &tx_batch[i];
+            break;
+        }
+    }
+
+    if (!tx) {
+        if (num_of_tx_batch == OGS_GTP_MAX_TX_BATCH)
+            ogs_gtp_flush_all();
+
+        tx = &tx_batch[num_of_tx_batch++];
+        tx->gnode = gnode;
+        tx->num_of_pkbuf = 0;
+    }
+
+    tx->pkbuf[tx->num_of_pkbuf++] = pkbuf;
+
+    if (tx->num_of_pkbuf >= ogs_gtp_self()->gtpu_batch)
+        return tx_batch_send(tx);
+
+    return OGS_OK;
+}
+
+/* Only the batch of the calling thread is transmitted */
+int ogs_gtp_flush(ogs_gtp_node_t *gnode)
+{
+    int i, rv;
+
+    ogs_assert(gnode);
+
+    for (i = 0; i < num_of_tx_batch; i++) {
+        if (tx_batch[i].gnode == gnode) {
+            rv = tx_batch_send(&tx_batch[i]);
+
+            tx_batch[i] = tx_batch[--num_of_tx_batch];
+            return rv;
+        }
+    }
+
+    return OGS_OK;
+}
+
+void ogs_gtp_flush_all(void)
+{
+    int i;
+
+    for (i = 0; i < num_of_tx_batch; i++)
+        tx_batch_send(&tx_batch[i]);
+    num_of_tx_batch = 0;
+}
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value)
 {
@@ -72,6 +72,12 @@ int ogs_gtp_connect(ogs_sock_t *ipv4, ogs_sock_t *ipv6, ogs_gtp_node_t *gnode);
 int ogs_gtp_send(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
 int ogs_gtp_sendto(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
 
+#define OGS_GTP_MAX_TX_BATCH 16
+
+int ogs_gtp_sendto_batch(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
+int ogs_gtp_flush(ogs_gtp_node_t *gnode);
+void ogs_gtp_flush_all(void);
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value);
 
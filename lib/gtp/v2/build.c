@@ -113,18 +113,17 @@ ogs_pkbuf_t *ogs_gtp1_build_error_indication(
     return pkbuf;
 }
 
-void ogs_gtp2_fill_header(
-        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
-        ogs_pkbuf_t *pkbuf)
+void ogs_gtp2_build_header_template(ogs_gtp2_header_template_t *tmpl,
+        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc)
 {
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_gtp2_extension_header_t *ext_h = NULL;
     uint8_t flags;
     uint8_t gtp_hlen = 0;
 
+    ogs_assert(tmpl);
     ogs_assert(gtp_hdesc);
     ogs_assert(ext_hdesc);
-    ogs_assert(pkbuf);
 
     /* Processing GTP Flags */
     flags = gtp_hdesc->flags;
@@ -139,12 +138,11 @@ void ogs_gtp2_fill_header(
     else
         gtp_hlen = OGS_GTPV1U_HEADER_LEN;
 
-    ogs_pkbuf_push(pkbuf, gtp_hlen);
+    ogs_assert(gtp_hlen <= sizeof(tmpl->data));
 
     /* Fill GTP Header */
-    gtp_h = (ogs_gtp2_header_t *)pkbuf->data;
-    ogs_assert(gtp_h);
-    memset(gtp_h, 0, gtp_hlen);
+    memset(tmpl, 0, sizeof(*tmpl));
+    gtp_h = (ogs_gtp2_header_t *)tmpl->data;
 
     gtp_h->flags = flags;
     gtp_h->type = gtp_hdesc->type;
@@ -166,22 +164,10 @@ void ogs_gtp2_fill_header(
 
     gtp_h->teid = htobe32(gtp_hdesc->teid);
 
-    /*
-     * TS29.281 5.1 General format in GTP-U header
-     *
-     * Length: This field indicates the length in octets of the payload,
-     * i.e. the rest of the packet following the mandatory part of
-     * the GTP header (that is the first 8 octets). The Sequence Number,
-     * the N-PDU Number or any Extension headers shall be considered
-     * to be part of the payload, i.e. included in the length count.
-     */
-    gtp_h->length = htobe16(pkbuf->len - OGS_GTPV1U_HEADER_LEN);
-
     /* Fill Extention Header */
     if (gtp_h->flags & OGS_GTPU_FLAGS_E) {
         ext_h = (ogs_gtp2_extension_header_t *)
-            (pkbuf->data + OGS_GTPV1U_HEADER_LEN);
-        ogs_assert(ext_h);
+            (tmpl->data + OGS_GTPV1U_HEADER_LEN);
 
         if (ext_hdesc->qos_flow_identifier) {
             /* 5G Core */
@@ -199,4 +185,48 @@ void ogs_gtp2_fill_header(
                 OGS_GTP2_EXTENSION_HEADER_TYPE_NO_MORE_EXTENSION_HEADERS;
         }
     }
+
+    tmpl->len = gtp_hlen;
+
+    tmpl->type = gtp_hdesc->type;
+    tmpl->teid = gtp_hdesc->teid;
+    tmpl->qfi = ext_hdesc->qos_flow_identifier;
+}
+
+void ogs_gtp2_fill_header_by_template(
+        ogs_gtp2_header_template_t *tmpl, ogs_pkbuf_t *pkbuf)
+{
+    ogs_gtp2_header_t *gtp_h = NULL;
+
+    ogs_assert(tmpl);
+    ogs_assert(tmpl->len);
+    ogs_assert(pkbuf);
+
+    gtp_h = ogs_pkbuf_push(pkbuf, tmpl->len);
+    memcpy(gtp_h, tmpl->data, tmpl->len);
+
+    /*
+     * TS29.281 5.1 General format in GTP-U header
+     *
+     * Length: This field indicates the length in octets of the payload,
+     * i.e. the rest of the packet following the mandatory part of
+     * the GTP header (that is the first 8 octets). The Sequence Number,
+     * the N-PDU Number or any Extension headers shall be considered
+     * to be part of the payload, i.e. included in the length count.
+     */
+    gtp_h->length = htobe16(pkbuf->len - OGS_GTPV1U_HEADER_LEN);
+}
+
+void ogs_gtp2_fill_header(
+        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
+        ogs_pkbuf_t *pkbuf)
+{
+    ogs_gtp2_header_template_t tmpl;
+
+    ogs_assert(gtp_hdesc);
+    ogs_assert(ext_hdesc);
+    ogs_assert(pkbuf);
+
+    ogs_gtp2_build_header_template(&tmpl, gtp_hdesc, ext_hdesc);
+    ogs_gtp2_fill_header_by_template(&tmpl, pkbuf);
 }
@@ -36,6 +36,25 @@ ogs_pkbuf_t *ogs_gtp2_build_echo_response(
 ogs_pkbuf_t *ogs_gtp1_build_error_indication(
         uint32_t teid, ogs_sockaddr_t *addr);
 
+/*
+ * Pre-encoded GTP-U header (with the extension header)
+ * Only the Length field is set when it is stamped into a packet.
+ */
+typedef struct ogs_gtp2_header_template_s {
+    uint8_t data[OGS_GTPV1U_5GC_HEADER_LEN];
+    uint8_t len;                /* 0 : Not built */
+
+    /* Built from */
+    uint8_t type;
+    uint32_t teid;
+    uint8_t qfi;
+} ogs_gtp2_header_template_t;
+
+void ogs_gtp2_build_header_template(ogs_gtp2_header_template_t *tmpl,
+        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc);
+void ogs_gtp2_fill_header_by_template(
+        ogs_gtp2_header_template_t *tmpl, ogs_pkbuf_t *pkbuf);
+
 void ogs_gtp2_fill_header(
         ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
         ogs_pkbuf_t *pkbuf);
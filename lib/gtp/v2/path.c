@@ -19,24 +19,23 @@
 
 #include "ogs-gtp.h"
 
-int ogs_gtp2_send_user_plane(
-        ogs_gtp_node_t *gnode,
-        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
-        ogs_pkbuf_t *pkbuf)
+static int send_user_plane(ogs_gtp_node_t *gnode,
+        uint8_t type, uint32_t teid, ogs_pkbuf_t *pkbuf)
 {
     char buf[OGS_ADDRSTRLEN];
     int rv;
 
-    ogs_gtp2_fill_header(gtp_hdesc, ext_hdesc, pkbuf);
-
     ogs_trace("SEND GTP-U[%d] to Peer[%s] : TEID[0x%x]",
-            gtp_hdesc->type, OGS_ADDR(&gnode->addr, buf), gtp_hdesc->teid);
+            type, OGS_ADDR(&gnode->addr, buf), teid);
+
+    if (ogs_gtp_self()->gtpu_batch > 1)
+        return ogs_gtp_sendto_batch(gnode, pkbuf);
 
     rv = ogs_gtp_sendto(gnode, pkbuf);
     if (rv != OGS_OK) {
         if (ogs_socket_errno != OGS_EAGAIN) {
             ogs_error("SEND GTP-U[%d] to Peer[%s] : TEID[0x%x]",
-                gtp_hdesc->type, OGS_ADDR(&gnode->addr, buf), gtp_hdesc->teid);
+                type, OGS_ADDR(&gnode->addr, buf), teid);
         }
     }
 
@@ -45,6 +44,33 @@ int ogs_gtp2_send_user_plane(
     return rv;
 }
 
+int ogs_gtp2_send_user_plane(
+        ogs_gtp_node_t *gnode,
+        ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
+        ogs_pkbuf_t *pkbuf)
+{
+    ogs_assert(gnode);
+    ogs_assert(gtp_hdesc);
+    ogs_assert(ext_hdesc);
+    ogs_assert(pkbuf);
+
+    ogs_gtp2_fill_header(gtp_hdesc, ext_hdesc, pkbuf);
+
+    return send_user_plane(gnode, gtp_hdesc->type, gtp_hdesc->teid, pkbuf);
+}
+
+int ogs_gtp2_send_user_plane_by_template(ogs_gtp_node_t *gnode,
+        ogs_gtp2_header_template_t *tmpl, ogs_pkbuf_t *pkbuf)
+{
+    ogs_assert(gnode);
+    ogs_assert(tmpl);
+    ogs_assert(pkbuf);
+
+    ogs_gtp2_fill_header_by_template(tmpl, pkbuf);
+
+    return send_user_plane(gnode, tmpl->type, tmpl->teid, pkbuf);
+}
+
 ogs_pkbuf_t *ogs_gtp2_handle_echo_req(ogs_pkbuf_t *pkb)
 {
     ogs_gtp2_header_t *gtph = NULL;
@@ -34,6 +34,8 @@ int ogs_gtp2_send_user_plane(
         ogs_gtp_node_t *gnode,
         ogs_gtp2_header_t *gtp_hdesc, ogs_gtp2_extension_header_t *ext_hdesc,
         ogs_pkbuf_t *pkbuf);
+int ogs_gtp2_send_user_plane_by_template(ogs_gtp_node_t *gnode,
+        ogs_gtp2_header_template_t *tmpl, ogs_pkbuf_t *pkbuf);
 
 ogs_pkbuf_t *ogs_gtp2_handle_echo_req(ogs_pkbuf_t *pkb);
 void ogs_gtp2_send_error_message(
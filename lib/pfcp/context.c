@@ -84,13 +84,17 @@ void ogs_pfcp_context_init(void)
     ogs_pool_init(&ogs_pfcp_dev_pool, OGS_MAX_NUM_OF_DEV);
     ogs_pool_init(&ogs_pfcp_subnet_pool, OGS_MAX_NUM_OF_SUBNET);
 
-    self.object_teid_hash = ogs_hash_make();
+    self.object_teid_hash = ogs_hmap_create();
     ogs_assert(self.object_teid_hash);
-    self.far_f_teid_hash = ogs_hash_make();
+    self.far_f_teid_hash = ogs_hmap_create();
     ogs_assert(self.far_f_teid_hash);
-    self.far_teid_hash = ogs_hash_make();
+    self.far_teid_hash = ogs_hmap_create();
     ogs_assert(self.far_teid_hash);
 
+    self.buffer.session = OGS_PFCP_DEFAULT_BUFFER_SESSION;
+    self.buffer.total = OGS_PFCP_DEFAULT_BUFFER_TOTAL;
+    ogs_thread_mutex_init(&self.buffer.mutex);
+
     context_initialized = 1;
 }
 
@@ -99,11 +103,13 @@ void ogs_pfcp_context_final(void)
     ogs_assert(context_initialized == 1);
 
     ogs_assert(self.object_teid_hash);
-    ogs_hash_destroy(self.object_teid_hash);
+    ogs_hmap_destroy(self.object_teid_hash);
     ogs_assert(self.far_f_teid_hash);
-    ogs_hash_destroy(self.far_f_teid_hash);
+    ogs_hmap_destroy(self.far_f_teid_hash);
     ogs_assert(self.far_teid_hash);
-    ogs_hash_destroy(self.far_teid_hash);
+    ogs_hmap_destroy(self.far_teid_hash);
+
+    ogs_thread_mutex_destroy(&self.buffer.mutex);
 
     ogs_pfcp_dev_remove_all();
     ogs_pfcp_subnet_remove_all();
@@ -153,6 +159,27 @@ static int ogs_pfcp_context_validation(const char *local)
     return OGS_OK;
 }
 
+static int buffer_size_parse(const char *local,
+        const char *key, const char *v, size_t *size)
+{
+    char *end = NULL;
+    long long value;
+
+    ogs_assert(v);
+    ogs_assert(size);
+
+    errno = 0;
+    value = strtoll(v, &end, 10);
+    if (errno || end == v || *end || value <= 0) {
+        ogs_error("Invalid %s.buffer.%s: `%s` in '%s'",
+                local, key, v, ogs_app()->file);
+        return OGS_ERROR;
+    }
+
+    *size = value;
+    return OGS_OK;
+}
+
 int ogs_pfcp_context_parse_config(const char *local, const char *remote)
 {
     int rv;
@@ -445,6 +472,26 @@ int ogs_pfcp_context_parse_config(const char *local, const char *remote)
 
                     } while (ogs_yaml_iter_type(&subnet_array) ==
                             YAML_SEQUENCE_NODE);
+                } else if (!strcmp(local_key, "buffer")) {
+                    ogs_yaml_iter_t buffer_iter;
+                    ogs_yaml_iter_recurse(&local_iter, &buffer_iter);
+                    while (ogs_yaml_iter_next(&buffer_iter)) {
+                        const char *buffer_key =
+                            ogs_yaml_iter_key(&buffer_iter);
+                        ogs_assert(buffer_key);
+                        if (!strcmp(buffer_key, "session")) {
+                            const char *v = ogs_yaml_iter_value(&buffer_iter);
+                            if (v && buffer_size_parse(local, buffer_key, v,
+                                        &self.buffer.session) != OGS_OK)
+                                return OGS_ERROR;
+                        } else if (!strcmp(buffer_key, "total")) {
+                            const char *v = ogs_yaml_iter_value(&buffer_iter);
+                            if (v && buffer_size_parse(local, buffer_key, v,
+                                        &self.buffer.total) != OGS_OK)
+                                return OGS_ERROR;
+                        } else
+                            ogs_warn("unknown key `%s`", buffer_key);
+                    }
                 }
             }
         } else if (!strcmp(root_key, remote)) {
@@ -1050,21 +1097,21 @@ void ogs_pfcp_object_teid_hash_set(
     }
 
     if (pdr->hash.teid.len)
-        ogs_hash_set(self.object_teid_hash,
-                &pdr->hash.teid.key, pdr->hash.teid.len, NULL);
+        ogs_hmap_set_u32(self.object_teid_hash,
+                pdr->hash.teid.key, NULL);
 
     pdr->hash.teid.key = pdr->f_teid.teid;
     pdr->hash.teid.len = sizeof(pdr->hash.teid.key);
 
     switch(type) {
     case OGS_PFCP_OBJ_PDR_TYPE:
-        ogs_hash_set(self.object_teid_hash,
-                &pdr->hash.teid.key, pdr->hash.teid.len, pdr);
+        ogs_hmap_set_u32(self.object_teid_hash,
+                pdr->hash.teid.key, &pdr->obj);
         break;
     case OGS_PFCP_OBJ_SESS_TYPE:
         ogs_assert(pdr->sess);
-        ogs_hash_set(self.object_teid_hash,
-                &pdr->hash.teid.key, pdr->hash.teid.len, pdr->sess);
+        ogs_hmap_set_u32(self.object_teid_hash,
+                pdr->hash.teid.key, &pdr->sess->obj);
         break;
     default:
         ogs_fatal("Unknown type [%d]", type);
@@ -1074,8 +1121,7 @@ void ogs_pfcp_object_teid_hash_set(
 
 ogs_pfcp_object_t *ogs_pfcp_object_find_by_teid(uint32_t teid)
 {
-    return (ogs_pfcp_object_t *)ogs_hash_get(
-            self.object_teid_hash, &teid, sizeof(teid));
+    return ogs_hmap_get_u32(self.object_teid_hash, teid);
 }
 
 int ogs_pfcp_object_count_by_teid(ogs_pfcp_sess_t *sess, uint32_t teid)
@@ -1151,6 +1197,35 @@ void ogs_pfcp_pdr_associate_qer(ogs_pfcp_pdr_t *pdr, ogs_pfcp_qer_t *qer)
     pdr->qer = qer;
 }
 
+/*
+ * Encodes the G-PDU header once, so that ogs_pfcp_send_g_pdu() only
+ * copies it and sets the Length. Must be called whenever the FAR or
+ * the QER of the PDR, or their Outer Header Creation or QFI, change.
+ */
+void ogs_pfcp_pdr_build_gpdu_template(ogs_pfcp_pdr_t *pdr)
+{
+    ogs_gtp2_header_t gtp_hdesc;
+    ogs_gtp2_extension_header_t ext_hdesc;
+
+    ogs_assert(pdr);
+
+    if (!pdr->far) {
+        memset(&pdr->gpdu_template, 0, sizeof(pdr->gpdu_template));
+        return;
+    }
+
+    memset(&gtp_hdesc, 0, sizeof(gtp_hdesc));
+    memset(&ext_hdesc, 0, sizeof(ext_hdesc));
+
+    gtp_hdesc.type = OGS_GTPU_MSGTYPE_GPDU;
+    gtp_hdesc.teid = pdr->far->outer_header_creation.teid;
+    if (pdr->qer && pdr->qer->qfi)
+        ext_hdesc.qos_flow_identifier = pdr->qer->qfi;
+
+    ogs_gtp2_build_header_template(
+            &pdr->gpdu_template, &gtp_hdesc, &ext_hdesc);
+}
+
 void ogs_pfcp_pdr_remove(ogs_pfcp_pdr_t *pdr)
 {
     int i;
@@ -1174,8 +1249,8 @@ void ogs_pfcp_pdr_remove(ogs_pfcp_pdr_t *pdr)
          * if the current list has a TEID count of 0, there are no other PDRs.
          */
         if (ogs_pfcp_object_count_by_teid(pdr->sess, pdr->f_teid.teid) == 0)
-            ogs_hash_set(self.object_teid_hash,
-                    &pdr->hash.teid.key, pdr->hash.teid.len, NULL);
+            ogs_hmap_set_u32(self.object_teid_hash,
+                    pdr->hash.teid.key, NULL);
     }
 
     if (pdr->dnn)
@@ -1290,7 +1365,7 @@ void ogs_pfcp_far_f_teid_hash_set(ogs_pfcp_far_t *far)
     ogs_assert(addr);
 
     if (far->hash.f_teid.len)
-        ogs_hash_set(self.far_f_teid_hash,
+        ogs_hmap_set(self.far_f_teid_hash,
                 &far->hash.f_teid.key, far->hash.f_teid.len, NULL);
 
     far->hash.f_teid.key.teid = far->outer_header_creation.teid;
@@ -1312,7 +1387,7 @@ void ogs_pfcp_far_f_teid_hash_set(ogs_pfcp_far_t *far)
         return;
     }
 
-    ogs_hash_set(self.far_f_teid_hash,
+    ogs_hmap_set(self.far_f_teid_hash,
             &far->hash.f_teid.key, far->hash.f_teid.len, far);
 }
 
@@ -1374,7 +1449,7 @@ ogs_pfcp_far_t *ogs_pfcp_far_find_by_gtpu_error_indication(ogs_pkbuf_t *pkbuf)
     memcpy(hashkey.addr, p, len);
     hashkey_len = 4 + len;
 
-    return (ogs_pfcp_far_t *)ogs_hash_get(
+    return (ogs_pfcp_far_t *)ogs_hmap_get(
             self.far_f_teid_hash, &hashkey, hashkey_len);
 }
 
@@ -1438,25 +1513,183 @@ void ogs_pfcp_far_teid_hash_set(ogs_pfcp_far_t *far)
     ogs_assert(far);
 
     if (far->hash.teid.len)
-        ogs_hash_set(self.far_teid_hash,
+        ogs_hmap_set(self.far_teid_hash,
                 &far->hash.teid.key, far->hash.teid.len, NULL);
 
     far->hash.teid.key = far->outer_header_creation.teid;
     far->hash.teid.len = sizeof(far->hash.teid.key);
 
-    ogs_hash_set(self.far_teid_hash,
+    ogs_hmap_set(self.far_teid_hash,
             &far->hash.teid.key, far->hash.teid.len, far);
 }
 
 ogs_pfcp_far_t *ogs_pfcp_far_find_by_teid(uint32_t teid)
 {
-    return (ogs_pfcp_far_t *)ogs_hash_get(
+    return (ogs_pfcp_far_t *)ogs_hmap_get(
             self.far_teid_hash, &teid, sizeof(teid));
 }
 
-void ogs_pfcp_far_remove(ogs_pfcp_far_t *far)
+/*
+ * Downlink Data Buffering
+ *
+ * Packets are copied into the smallest cluster of the data-plane packet
+ * pool that fits them, leaving headroom for the GTP-U header added when
+ * they are flushed. A copy is charged with its true size, the headroom
+ * included. Each session may hold up to 'buffer.session' bytes, and all
+ * sessions together up to 'buffer.total' bytes. When a packet does not
+ * fit, the oldest packets of the FAR are evicted first.
+ *
+ * The budgets are enforced by counting the bytes as they are buffered
+ * and released, whatever backs the pool. No cluster is reserved for
+ * buffering, so a copy that cannot be allocated is dropped.
+ *
+ * The caller serializes access to the FAR (see upf_sess_lock()),
+ * only the total is shared between the data-plane workers.
+ */
+static const size_t buffer_cluster_size[OGS_PFCP_NUM_OF_BUFFER_CLASS] = {
+    128, 256, 512, 1024, 2048
+};
+
+static int buffer_class(size_t size)
+{
+    int i;
+
+    for (i = 0; i < OGS_PFCP_NUM_OF_BUFFER_CLASS; i++)
+        if (size <= buffer_cluster_size[i])
+            return i;
+
+    return -1;
+}
+
+/* Returns OGS_RETRY when a byte budget is exceeded */
+static int buffer_reserve(ogs_pfcp_sess_t *sess, size_t size)
+{
+    int rv = OGS_RETRY;
+
+    if (sess->buffer.bytes + size > self.buffer.session)
+        return OGS_RETRY;
+
+    ogs_thread_mutex_lock(&self.buffer.mutex);
+    if (self.buffer.bytes + size <= self.buffer.total) {
+        self.buffer.bytes += size;
+        rv = OGS_OK;
+    }
+    ogs_thread_mutex_unlock(&self.buffer.mutex);
+
+    if (rv == OGS_OK)
+        sess->buffer.bytes += size;
+
+    return rv;
+}
+
+static void buffer_release(ogs_pfcp_sess_t *sess, size_t size)
+{
+    ogs_assert(sess->buffer.bytes >= size);
+    sess->buffer.bytes -= size;
+
+    ogs_thread_mutex_lock(&self.buffer.mutex);
+    ogs_assert(self.buffer.bytes >= size);
+    self.buffer.bytes -= size;
+    ogs_thread_mutex_unlock(&self.buffer.mutex);
+}
+
+static void buffer_drop(ogs_pfcp_sess_t *sess, size_t size)
 {
+    sess->buffer.dropped_packets++;
+    sess->buffer.dropped_bytes += size;
+
+    ogs_thread_mutex_lock(&self.buffer.mutex);
+    self.buffer.dropped_packets++;
+    self.buffer.dropped_bytes += size;
+    ogs_thread_mutex_unlock(&self.buffer.mutex);
+}
+
+int ogs_pfcp_far_buffer_add(ogs_pfcp_far_t *far, ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_sess_t *sess = NULL;
+    ogs_pkbuf_t *oldbuf = NULL, *newbuf = NULL;
+    size_t size;
     int i;
+
+    ogs_assert(far);
+    sess = far->sess;
+    ogs_assert(sess);
+    ogs_assert(pkbuf);
+
+    ogs_assert(self.buffer.pool);
+
+    size = OGS_GTPV1U_5GC_HEADER_LEN + pkbuf->len;
+    i = buffer_class(size);
+    if (i < 0) {
+        ogs_error("[%d] Too big to buffer [%d bytes]", far->id, pkbuf->len);
+        buffer_drop(sess, pkbuf->len);
+        return OGS_ERROR;
+    }
+
+    while (buffer_reserve(sess, size) != OGS_OK) {
+        oldbuf = ogs_pfcp_far_buffer_pop(far);
+        if (!oldbuf) {
+            ogs_warn("[%d] Downlink buffer full [%d:%d bytes]",
+                    far->id, (int)sess->buffer.bytes, pkbuf->len);
+            buffer_drop(sess, pkbuf->len);
+            return OGS_ERROR;
+        }
+
+        buffer_drop(sess, oldbuf->len);
+        ogs_pkbuf_free(oldbuf);
+    }
+
+    newbuf = ogs_pkbuf_alloc(self.buffer.pool, buffer_cluster_size[i]);
+    if (!newbuf) {
+        ogs_error("ogs_pkbuf_alloc() failed");
+        buffer_release(sess, size);
+        buffer_drop(sess, pkbuf->len);
+        return OGS_ERROR;
+    }
+    ogs_pkbuf_reserve(newbuf, OGS_GTPV1U_5GC_HEADER_LEN);
+    ogs_pkbuf_put_data(newbuf, pkbuf->data, pkbuf->len);
+
+    ogs_list_add(&far->buffered_list, &newbuf->lnode);
+    far->num_of_buffered_packet++;
+    far->buffered_bytes += newbuf->len;
+
+    return OGS_OK;
+}
+
+ogs_pkbuf_t *ogs_pfcp_far_buffer_pop(ogs_pfcp_far_t *far)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    ogs_assert(far);
+    ogs_assert(far->sess);
+
+    pkbuf = (ogs_pkbuf_t *)ogs_list_first(&far->buffered_list);
+    if (!pkbuf)
+        return NULL;
+
+    ogs_list_remove(&far->buffered_list, &pkbuf->lnode);
+    ogs_assert(far->num_of_buffered_packet > 0);
+    far->num_of_buffered_packet--;
+    ogs_assert(far->buffered_bytes >= pkbuf->len);
+    far->buffered_bytes -= pkbuf->len;
+
+    buffer_release(far->sess, pkbuf->tail - pkbuf->head);
+
+    return pkbuf;
+}
+
+void ogs_pfcp_far_buffer_clear(ogs_pfcp_far_t *far)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    ogs_assert(far);
+
+    while ((pkbuf = ogs_pfcp_far_buffer_pop(far)) != NULL)
+        ogs_pkbuf_free(pkbuf);
+}
+
+void ogs_pfcp_far_remove(ogs_pfcp_far_t *far)
+{
     ogs_pfcp_sess_t *sess = NULL;
 
     ogs_assert(far);
@@ -1466,18 +1699,17 @@ void ogs_pfcp_far_remove(ogs_pfcp_far_t *far)
     ogs_list_remove(&sess->far_list, far);
 
     if (far->hash.teid.len)
-        ogs_hash_set(self.far_teid_hash,
+        ogs_hmap_set(self.far_teid_hash,
                 &far->hash.teid.key, far->hash.teid.len, NULL);
 
     if (far->hash.f_teid.len)
-        ogs_hash_set(self.far_f_teid_hash,
+        ogs_hmap_set(self.far_f_teid_hash,
                 &far->hash.f_teid.key, far->hash.f_teid.len, NULL);
 
     if (far->dnn)
         ogs_free(far->dnn);
 
-    for (i = 0; i < far->num_of_buffered_packet; i++)
-        ogs_pkbuf_free(far->buffered_packet[i]);
+    ogs_pfcp_far_buffer_clear(far);
 
     if (far->id_node)
         ogs_pool_free(&far->sess->far_id_pool, far->id_node);
@@ -1665,6 +1897,105 @@ void ogs_pfcp_qer_remove_all(ogs_pfcp_sess_t *sess)
         ogs_pfcp_qer_remove(qer);
 }
 
+static void qer_bucket_setup(ogs_pfcp_qer_bucket_t *bucket, uint64_t rate)
+{
+    ogs_assert(bucket);
+
+    if (bucket->rate == rate)
+        return;
+
+    bucket->rate = rate;
+    bucket->depth = (rate >> 3) *
+        OGS_PFCP_QER_BURST_DURATION / OGS_USEC_PER_SEC;
+    if (bucket->depth < OGS_MAX_PKT_LEN)
+        bucket->depth = OGS_MAX_PKT_LEN;
+
+    bucket->tokens = bucket->depth;
+    bucket->remainder = 0;
+    bucket->timestamp = 0;
+}
+
+void ogs_pfcp_qer_meter_setup(ogs_pfcp_qer_t *qer)
+{
+    ogs_assert(qer);
+
+    qer_bucket_setup(&qer->ul_meter.mbr, qer->mbr.uplink);
+    qer_bucket_setup(&qer->ul_meter.gbr, qer->gbr.uplink);
+    qer_bucket_setup(&qer->dl_meter.mbr, qer->mbr.downlink);
+    qer_bucket_setup(&qer->dl_meter.gbr, qer->gbr.downlink);
+}
+
+/*
+ * The wakeups of the data path may be a few usec apart, which earns
+ * less than one octet at a low bitrate. What is left over is kept
+ * in the remainder, so the bucket is refilled at the exact MBR.
+ */
+static void qer_bucket_refill(ogs_pfcp_qer_bucket_t *bucket, ogs_time_t now)
+{
+    ogs_time_t elapsed;
+    uint64_t credit;
+
+    if (bucket->timestamp == 0 || now < bucket->timestamp) {
+        bucket->timestamp = now;
+        return;
+    }
+
+    elapsed = now - bucket->timestamp;
+    if (elapsed >= OGS_PFCP_QER_BURST_DURATION) {
+        bucket->tokens = bucket->depth;
+        bucket->remainder = 0;
+    } else {
+        credit = bucket->rate * elapsed + bucket->remainder;
+        bucket->tokens += credit / (8 * OGS_USEC_PER_SEC);
+        bucket->remainder = credit % (8 * OGS_USEC_PER_SEC);
+        if (bucket->tokens >= bucket->depth) {
+            bucket->tokens = bucket->depth;
+            bucket->remainder = 0;
+        }
+    }
+
+    bucket->timestamp = now;
+}
+
+int ogs_pfcp_qer_meter(ogs_pfcp_qer_t *qer,
+        bool is_uplink, uint32_t len, ogs_time_t now)
+{
+    ogs_pfcp_qer_meter_t *meter = NULL;
+    uint8_t gate;
+
+    ogs_assert(qer);
+
+    if (is_uplink) {
+        meter = &qer->ul_meter;
+        gate = qer->gate_status.uplink;
+    } else {
+        meter = &qer->dl_meter;
+        gate = qer->gate_status.downlink;
+    }
+
+    if (gate != OGS_PFCP_GATE_OPEN)
+        goto red;
+
+    if (meter->mbr.rate) {
+        qer_bucket_refill(&meter->mbr, now);
+        if (meter->mbr.tokens < len)
+            goto red;
+        meter->mbr.tokens -= len;
+    }
+
+    if (meter->gbr.rate) {
+        qer_bucket_refill(&meter->gbr, now);
+        if (meter->gbr.tokens < len)
+            return OGS_PFCP_QER_YELLOW;
+        meter->gbr.tokens -= len;
+    }
+
+    return OGS_PFCP_QER_GREEN;
+
+red:
+    return OGS_PFCP_QER_RED;
+}
+
 ogs_pfcp_bar_t *ogs_pfcp_bar_new(ogs_pfcp_sess_t *sess)
 {
     ogs_pfcp_bar_t *bar = NULL;
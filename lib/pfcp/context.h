@@ -41,6 +41,8 @@ extern "C" {
 
 typedef struct ogs_pfcp_node_s ogs_pfcp_node_t;
 
+#define OGS_PFCP_NUM_OF_BUFFER_CLASS        5   /* 128 to 2048 bytes */
+
 typedef struct ogs_pfcp_context_s {
     uint32_t        pfcp_port;      /* PFCP local port */
 
@@ -69,11 +71,27 @@ typedef struct ogs_pfcp_context_s {
     ogs_list_t      dev_list;       /* Tun Device List */
     ogs_list_t      subnet_list;    /* UE Subnet List */
 
-    ogs_hash_t      *object_teid_hash; /* hash table for PFCP OBJ(TEID) */
-    ogs_hash_t      *far_f_teid_hash;  /* hash table for FAR(TEID+ADDR) */
-    ogs_hash_t      *far_teid_hash; /* hash table for FAR(TEID) */
+    ogs_hmap_t      *object_teid_hash; /* hash table for PFCP OBJ(TEID) */
+    ogs_hmap_t      *far_f_teid_hash;  /* hash table for FAR(TEID+ADDR) */
+    ogs_hmap_t      *far_teid_hash; /* hash table for FAR(TEID) */
+
+    struct {
+        size_t session;             /* Byte budget per session */
+        size_t total;               /* Byte cap over all sessions */
+
+        ogs_thread_mutex_t mutex;   /* Data-plane workers share the total */
+        size_t bytes;               /* Currently buffered */
+
+        ogs_pkbuf_pool_t *pool;     /* Data-plane packet pool (UPF/SGW-U) */
+
+        uint64_t dropped_packets;   /* Evicted or refused */
+        uint64_t dropped_bytes;
+    } buffer; /* Downlink Data Buffering */
 } ogs_pfcp_context_t;
 
+#define OGS_PFCP_DEFAULT_BUFFER_SESSION     (128 * 1024)
+#define OGS_PFCP_DEFAULT_BUFFER_TOTAL       (64 * 1024 * 1024)
+
 #define OGS_SETUP_PFCP_NODE(__cTX, __pNODE) \
     do { \
         ogs_assert((__cTX)); \
@@ -185,6 +203,12 @@ typedef struct ogs_pfcp_pdr_s {
 
     ogs_pfcp_qer_t          *qer;
 
+    /*
+     * G-PDU header from the TEID of the FAR and the QFI of the QER,
+     * built by the PFCP handlers (see ogs_pfcp_pdr_build_gpdu_template())
+     */
+    ogs_gtp2_header_template_t gpdu_template;
+
     int                     num_of_flow;
     char                    *flow_description[OGS_MAX_NUM_OF_FLOW_IN_PDR];
 
@@ -229,8 +253,9 @@ typedef struct ogs_pfcp_far_s {
 
     ogs_pfcp_smreq_flags_t  smreq_flags;
 
+    ogs_list_t              buffered_list;  /* Oldest packet first */
     uint32_t                num_of_buffered_packet;
-    ogs_pkbuf_t             *buffered_packet[OGS_MAX_NUM_OF_PACKET_BUFFER];
+    size_t                  buffered_bytes;
 
     struct {
         bool prepared;
@@ -270,6 +295,33 @@ typedef struct ogs_pfcp_urr_s {
     ogs_pfcp_sess_t         *sess;
 } ogs_pfcp_urr_t;
 
+/* Token bucket enforcing a bitrate of the QER */
+typedef struct ogs_pfcp_qer_bucket_s {
+    uint64_t                rate;           /* bps, 0 : not limited */
+    uint64_t                depth;          /* octets */
+    uint64_t                tokens;         /* octets */
+    uint64_t                remainder;      /* bit-usec short of an octet */
+    ogs_time_t              timestamp;      /* Last refill */
+} ogs_pfcp_qer_bucket_t;
+
+/*
+ * Two rate three color meter (RFC2698) for one direction
+ *
+ * A packet exceeding the MBR is dropped. A packet exceeding the GBR
+ * only is forwarded as non-guaranteed traffic, the caller counts it.
+ */
+typedef struct ogs_pfcp_qer_meter_s {
+    ogs_pfcp_qer_bucket_t   mbr;
+    ogs_pfcp_qer_bucket_t   gbr;
+} ogs_pfcp_qer_meter_t;
+
+#define OGS_PFCP_QER_GREEN      0
+#define OGS_PFCP_QER_YELLOW     1       /* Above the GBR */
+#define OGS_PFCP_QER_RED        2       /* Dropped */
+
+/* Burst allowed above the bitrate, expressed as time at that bitrate */
+#define OGS_PFCP_QER_BURST_DURATION ogs_time_from_msec(100)
+
 typedef struct ogs_pfcp_qer_s {
     ogs_lnode_t             lnode;
 
@@ -280,6 +332,9 @@ typedef struct ogs_pfcp_qer_s {
     ogs_pfcp_bitrate_t      mbr;
     ogs_pfcp_bitrate_t      gbr;
 
+    ogs_pfcp_qer_meter_t    ul_meter;
+    ogs_pfcp_qer_meter_t    dl_meter;
+
     uint8_t                 qfi;
 
     ogs_pfcp_sess_t         *sess;
@@ -308,6 +363,12 @@ typedef struct ogs_pfcp_sess_s {
     OGS_POOL(urr_id_pool, uint8_t);
     OGS_POOL(qer_id_pool, uint8_t);
     OGS_POOL(bar_id_pool, uint8_t);
+
+    struct {
+        size_t bytes;               /* Buffered in all FARs */
+        uint64_t dropped_packets;
+        uint64_t dropped_bytes;
+    } buffer;
 } ogs_pfcp_sess_t;
 
 typedef struct ogs_pfcp_subnet_s ogs_pfcp_subnet_t;
@@ -417,6 +478,7 @@ void ogs_pfcp_pdr_reorder_by_precedence(
 void ogs_pfcp_pdr_associate_far(ogs_pfcp_pdr_t *pdr, ogs_pfcp_far_t *far);
 void ogs_pfcp_pdr_associate_urr(ogs_pfcp_pdr_t *pdr, ogs_pfcp_urr_t *urr);
 void ogs_pfcp_pdr_associate_qer(ogs_pfcp_pdr_t *pdr, ogs_pfcp_qer_t *qer);
+void ogs_pfcp_pdr_build_gpdu_template(ogs_pfcp_pdr_t *pdr);
 void ogs_pfcp_pdr_remove(ogs_pfcp_pdr_t *pdr);
 void ogs_pfcp_pdr_remove_all(ogs_pfcp_sess_t *sess);
 
@@ -436,6 +498,9 @@ ogs_pfcp_far_t *ogs_pfcp_far_find_by_pfcp_session_report(
 void ogs_pfcp_far_teid_hash_set(ogs_pfcp_far_t *far);
 ogs_pfcp_far_t *ogs_pfcp_far_find_by_teid(uint32_t teid);
 
+int ogs_pfcp_far_buffer_add(ogs_pfcp_far_t *far, ogs_pkbuf_t *pkbuf);
+ogs_pkbuf_t *ogs_pfcp_far_buffer_pop(ogs_pfcp_far_t *far);
+void ogs_pfcp_far_buffer_clear(ogs_pfcp_far_t *far);
 void ogs_pfcp_far_remove(ogs_pfcp_far_t *far);
 void ogs_pfcp_far_remove_all(ogs_pfcp_sess_t *sess);
 
@@ -455,6 +520,10 @@ ogs_pfcp_qer_t *ogs_pfcp_qer_find_or_add(
 void ogs_pfcp_qer_remove(ogs_pfcp_qer_t *qer);
 void ogs_pfcp_qer_remove_all(ogs_pfcp_sess_t *sess);
 
+void ogs_pfcp_qer_meter_setup(ogs_pfcp_qer_t *qer);
+int ogs_pfcp_qer_meter(ogs_pfcp_qer_t *qer,
+        bool is_uplink, uint32_t len, ogs_time_t now);
+
 ogs_pfcp_bar_t *ogs_pfcp_bar_new(ogs_pfcp_sess_t *sess);
 void ogs_pfcp_bar_delete(ogs_pfcp_bar_t *bar);
 
@@ -235,12 +235,6 @@ bool ogs_pfcp_up_handle_pdr(
 
     memset(report, 0, sizeof(*report));
 
-    sendbuf = ogs_pkbuf_copy(recvbuf);
-    if (!sendbuf) {
-        ogs_error("ogs_pkbuf_copy() failed");
-        return false;
-    }
-
     buffering = false;
 
     if (!far->gnode) {
@@ -250,6 +244,11 @@ bool ogs_pfcp_up_handle_pdr(
         if (far->apply_action & OGS_PFCP_APPLY_ACTION_FORW) {
 
             /* Forward packet */
+            sendbuf = ogs_pkbuf_copy(recvbuf);
+            if (!sendbuf) {
+                ogs_error("ogs_pkbuf_copy() failed");
+                return false;
+            }
             ogs_pfcp_send_g_pdu(pdr, type, sendbuf);
 
         } else if (far->apply_action & OGS_PFCP_APPLY_ACTION_BUFF) {
@@ -258,7 +257,6 @@ bool ogs_pfcp_up_handle_pdr(
 
         } else {
             ogs_error("Not implemented = %d", far->apply_action);
-            ogs_pkbuf_free(sendbuf);
         }
     }
 
@@ -270,11 +268,8 @@ bool ogs_pfcp_up_handle_pdr(
             report->type.downlink_data_report = 1;
         }
 
-        if (far->num_of_buffered_packet < OGS_MAX_NUM_OF_PACKET_BUFFER) {
-            far->buffered_packet[far->num_of_buffered_packet++] = sendbuf;
-        } else {
-            ogs_pkbuf_free(sendbuf);
-        }
+        /* A packet that does not fit the buffer budget is dropped */
+        ogs_pfcp_far_buffer_add(far, recvbuf);
     }
 
     return true;
@@ -318,6 +313,28 @@ bool ogs_pfcp_up_handle_error_indication(
     return true;
 }
 
+static void gpdu_template_build_by_far(
+        ogs_pfcp_sess_t *sess, ogs_pfcp_far_t *far)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+
+    ogs_list_for_each(&sess->pdr_list, pdr) {
+        if (pdr->far == far)
+            ogs_pfcp_pdr_build_gpdu_template(pdr);
+    }
+}
+
+static void gpdu_template_build_by_qer(
+        ogs_pfcp_sess_t *sess, ogs_pfcp_qer_t *qer)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+
+    ogs_list_for_each(&sess->pdr_list, pdr) {
+        if (pdr->qer == qer)
+            ogs_pfcp_pdr_build_gpdu_template(pdr);
+    }
+}
+
 ogs_pfcp_pdr_t *ogs_pfcp_handle_create_pdr(ogs_pfcp_sess_t *sess,
         ogs_pfcp_tlv_create_pdr_t *message,
         ogs_pfcp_sereq_flags_t *sereq_flags,
@@ -627,6 +644,8 @@ ogs_pfcp_pdr_t *ogs_pfcp_handle_create_pdr(ogs_pfcp_sess_t *sess,
         ogs_pfcp_pdr_associate_qer(pdr, qer);
     }
 
+    ogs_pfcp_pdr_build_gpdu_template(pdr);
+
     return pdr;
 }
 
@@ -969,6 +988,8 @@ ogs_pfcp_far_t *ogs_pfcp_handle_create_far(ogs_pfcp_sess_t *sess,
         }
     }
 
+    gpdu_template_build_by_far(sess, far);
+
     return far;
 }
 
@@ -1004,6 +1025,9 @@ ogs_pfcp_far_t *ogs_pfcp_handle_update_far_flags(ogs_pfcp_sess_t *sess,
         if (message->update_forwarding_parameters.pfcpsmreq_flags.presence) {
             far->smreq_flags.value =
                 message->update_forwarding_parameters.pfcpsmreq_flags.u8;
+
+            if (far->smreq_flags.drop_buffered_packets)
+                ogs_pfcp_far_buffer_clear(far);
         }
     }
 
@@ -1077,6 +1101,8 @@ ogs_pfcp_far_t *ogs_pfcp_handle_update_far(ogs_pfcp_sess_t *sess,
         }
     }
 
+    gpdu_template_build_by_far(sess, far);
+
     return far;
 }
 
@@ -1160,6 +1186,10 @@ ogs_pfcp_qer_t *ogs_pfcp_handle_create_qer(ogs_pfcp_sess_t *sess,
     if (message->qos_flow_identifier.presence)
         qer->qfi = message->qos_flow_identifier.u8;
 
+    ogs_pfcp_qer_meter_setup(qer);
+
+    gpdu_template_build_by_qer(sess, qer);
+
     return qer;
 }
 
@@ -1190,11 +1220,18 @@ ogs_pfcp_qer_t *ogs_pfcp_handle_update_qer(ogs_pfcp_sess_t *sess,
         return NULL;
     }
 
+    if (message->gate_status.presence)
+        qer->gate_status.value = message->gate_status.u8;
+
     if (message->maximum_bitrate.presence)
         ogs_pfcp_parse_bitrate(&qer->mbr, &message->maximum_bitrate);
     if (message->guaranteed_bitrate.presence)
         ogs_pfcp_parse_bitrate(&qer->gbr, &message->guaranteed_bitrate);
 
+    ogs_pfcp_qer_meter_setup(qer);
+
+    gpdu_template_build_by_qer(sess, qer);
+
     return qer;
 }
 
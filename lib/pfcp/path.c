@@ -373,6 +373,13 @@ void ogs_pfcp_send_g_pdu(
     ogs_assert(gnode);
     ogs_assert(gnode->sock);
 
+    if (type == OGS_GTPU_MSGTYPE_GPDU) {
+        ogs_assert(pdr->gpdu_template.len);
+        ogs_gtp2_send_user_plane_by_template(
+                gnode, &pdr->gpdu_template, sendbuf);
+        return;
+    }
+
     memset(&gtp_hdesc, 0, sizeof(gtp_hdesc));
     memset(&ext_hdesc, 0, sizeof(ext_hdesc));
 
@@ -431,18 +438,15 @@ int ogs_pfcp_send_end_marker(ogs_pfcp_pdr_t *pdr)
 void ogs_pfcp_send_buffered_packet(ogs_pfcp_pdr_t *pdr)
 {
     ogs_pfcp_far_t *far = NULL;
-    int i;
+    ogs_pkbuf_t *pkbuf = NULL;
 
     ogs_assert(pdr);
     far = pdr->far;
 
     if (far && far->gnode) {
         if (far->apply_action & OGS_PFCP_APPLY_ACTION_FORW) {
-            for (i = 0; i < far->num_of_buffered_packet; i++) {
-                ogs_pfcp_send_g_pdu(
-                        pdr, OGS_GTPU_MSGTYPE_GPDU, far->buffered_packet[i]);
-            }
-            far->num_of_buffered_packet = 0;
+            while ((pkbuf = ogs_pfcp_far_buffer_pop(far)) != NULL)
+                ogs_pfcp_send_g_pdu(pdr, OGS_GTPU_MSGTYPE_GPDU, pkbuf);
         }
     }
 }
@@ -109,172 +109,539 @@ static int decode_ipv6_header(
     return OGS_OK;
 }
 
-ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
-                    ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf)
+int ogs_pfcp_flow_key_parse(ogs_pfcp_flow_key_t *key, ogs_pkbuf_t *pkbuf)
 {
     struct ip *ip_h =  NULL;
     struct ip6_hdr *ip6_h = NULL;
-    uint32_t *src_addr = NULL;
-    uint32_t *dst_addr = NULL;
-    int addr_len = 0;
-    uint8_t proto = 0;
     uint16_t ip_hlen = 0;
 
-    ogs_pfcp_rule_t *rule = NULL;
-
+    ogs_assert(key);
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
     ogs_assert(pkbuf->data);
 
+    memset(key, 0, sizeof(*key));
+
+    ip_h = (struct ip *)pkbuf->data;
+    if (ip_h->ip_v == 4) {
+        key->proto = ip_h->ip_p;
+        ip_hlen = (ip_h->ip_hl)*4;
+
+        memcpy(key->src_addr, &ip_h->ip_src.s_addr, OGS_IPV4_LEN);
+        memcpy(key->dst_addr, &ip_h->ip_dst.s_addr, OGS_IPV4_LEN);
+        key->addr_len = OGS_IPV4_LEN;
+    } else if (ip_h->ip_v == 6) {
+        ip6_h = (struct ip6_hdr *)pkbuf->data;
+
+        decode_ipv6_header(ip6_h, &key->proto, &ip_hlen);
+
+        memcpy(key->src_addr, ip6_h->ip6_src.s6_addr, OGS_IPV6_LEN);
+        memcpy(key->dst_addr, ip6_h->ip6_dst.s6_addr, OGS_IPV6_LEN);
+        key->addr_len = OGS_IPV6_LEN;
+    } else {
+        /* Not an error in itself, e.g. a G-PDU of an Ethernet PDU session */
+        ogs_debug("Not an IP packet [IP version:%d, Packet Length:%d]",
+                ip_h->ip_v, pkbuf->len);
+        return OGS_ERROR;
+    }
+
+    /* Source and destination ports come first in both TCP and UDP */
+    if ((key->proto == IPPROTO_TCP || key->proto == IPPROTO_UDP) &&
+        pkbuf->len >= ip_hlen + 4) {
+        uint16_t port[2];
+
+        memcpy(port, (char *)pkbuf->data + ip_hlen, sizeof(port));
+        key->src_port = be16toh(port[0]);
+        key->dst_port = be16toh(port[1]);
+    }
+
+    ogs_trace("PROTO:%d SRC:%08x %08x %08x %08x",
+            key->proto, be32toh(key->src_addr[0]), be32toh(key->src_addr[1]),
+            be32toh(key->src_addr[2]), be32toh(key->src_addr[3]));
+    ogs_trace("HLEN:%d  DST:%08x %08x %08x %08x",
+            ip_hlen, be32toh(key->dst_addr[0]), be32toh(key->dst_addr[1]),
+            be32toh(key->dst_addr[2]), be32toh(key->dst_addr[3]));
+
+    return OGS_OK;
+}
+
+static bool ipfw_match_flow_key(
+        ogs_ipfw_rule_t *ipfw, ogs_pfcp_flow_key_t *key)
+{
+    int k, n;
+
+    ogs_assert(ipfw);
+    ogs_assert(key);
+
+    ogs_trace("PROTO:%d SRC:%d-%d DST:%d-%d",
+            ipfw->proto,
+            ipfw->port.src.low,
+            ipfw->port.src.high,
+            ipfw->port.dst.low,
+            ipfw->port.dst.high);
+
+    n = key->addr_len / sizeof(uint32_t);
+    for (k = 0; k < n; k++) {
+        if ((key->src_addr[k] & ipfw->ip.src.mask[k]) != ipfw->ip.src.addr[k])
+            return false;
+        if ((key->dst_addr[k] & ipfw->ip.dst.mask[k]) != ipfw->ip.dst.addr[k])
+            return false;
+    }
+
+    /* Protocol match */
+    if (ipfw->proto == 0) /* IP */
+        return true; /* No need to match port */
+
+    if (ipfw->proto != key->proto)
+        return false;
+
+    if (ipfw->proto == IPPROTO_TCP || ipfw->proto == IPPROTO_UDP) {
+        /* Source port */
+        if (ipfw->port.src.low && key->src_port < ipfw->port.src.low)
+            return false;
+        if (ipfw->port.src.high && key->src_port > ipfw->port.src.high)
+            return false;
+
+        /* Dst Port*/
+        if (ipfw->port.dst.low && key->dst_port < ipfw->port.dst.low)
+            return false;
+        if (ipfw->port.dst.high && key->dst_port > ipfw->port.dst.high)
+            return false;
+    }
+
+    /* Matched */
+    return true;
+}
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_flow_key(
+                    ogs_pfcp_pdr_t *pdr, ogs_pfcp_flow_key_t *key)
+{
+    ogs_pfcp_rule_t *rule = NULL;
+
+    ogs_assert(pdr);
+    ogs_assert(key);
+
+    if (!key->addr_len)
+        return NULL;
+
+    ogs_list_for_each(&pdr->rule_list, rule) {
+        if (ipfw_match_flow_key(&rule->ipfw, key) == true)
+            return rule;
+    }
+
+    return NULL;
+}
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
+                    ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_flow_key_t key;
+
+    ogs_assert(pdr);
+    ogs_assert(pkbuf);
+
+    if (ogs_pfcp_flow_key_parse(&key, pkbuf) != OGS_OK)
+        return NULL;
+
+    return ogs_pfcp_pdr_rule_find_by_flow_key(pdr, &key);
+}
+
+/*
+ * Classifier
+ *
+ * The PDRs are flattened into one entry per SDF filter (or a single
+ * wildcard entry when the PDR has no filter), kept in the order they
+ * were added, i.e. PDR precedence. Each entry is then indexed into
+ * the TCP, UDP and other-protocol tables.
+ *
+ * When the session is established or modified, ogs_pfcp_classifier_build()
+ * turns each table into a decision table. The source and destination
+ * ports are cut into disjoint ranges and the prefixes are deduplicated,
+ * each with the bitmap of the entries it matches. A lookup finds the port
+ * ranges by binary search, ANDs their bitmaps with those of the prefixes
+ * containing the addresses, and only checks the protocol, TEID and QFI
+ * of the remaining entries, in precedence order.
+ */
+#define CLASSIFIER_BIT_SET(__mAP, __i) \
+    ((__mAP)[(__i) >> 6] |= (uint64_t)1 << ((__i) & 63))
+
+static int classifier_table(uint8_t proto)
+{
+    if (proto == IPPROTO_TCP)
+        return OGS_PFCP_CLASSIFIER_TCP;
+    else if (proto == IPPROTO_UDP)
+        return OGS_PFCP_CLASSIFIER_UDP;
+
+    return OGS_PFCP_CLASSIFIER_OTHER;
+}
+
+static void classifier_index(ogs_pfcp_classifier_t *classifier, int i)
+{
+    ogs_pfcp_classifier_table_t *table = &classifier->table[i];
+    int n;
+
+    n = table->num_of_index;
+    table->index = ogs_realloc(table->index, (n + 1) * sizeof(int));
+    ogs_assert(table->index);
+
+    table->index[n] = classifier->num_of_entry - 1;
+    table->num_of_index++;
+}
+
+static ogs_pfcp_classifier_entry_t *classifier_entry_add(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_pdr_t *pdr)
+{
+    ogs_pfcp_classifier_entry_t *entry = NULL;
+    int n;
+
+    n = classifier->num_of_entry;
+    classifier->entry = ogs_realloc(
+            classifier->entry, (n + 1) * sizeof(*entry));
+    ogs_assert(classifier->entry);
+    classifier->num_of_entry++;
+
+    entry = &classifier->entry[n];
+    memset(entry, 0, sizeof(*entry));
+
+    entry->pdr = pdr;
+    entry->teid = pdr->f_teid.teid;
+    entry->qfi = pdr->qfi;
+
+    entry->src_port.high = 0xffff;
+    entry->dst_port.high = 0xffff;
+
+    return entry;
+}
+
+void ogs_pfcp_classifier_add(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_pdr_t *pdr)
+{
+    ogs_pfcp_classifier_entry_t *entry = NULL;
+    ogs_pfcp_rule_t *rule = NULL;
+    int i;
+
+    ogs_assert(classifier);
+    ogs_assert(pdr);
+
+    /* The decision tables are stale until the next build */
+    ogs_assert(classifier->built == false);
+
+    if (ogs_list_first(&pdr->rule_list) == NULL) {
+        /* No SDF Filter : any packet matches this PDR */
+        entry = classifier_entry_add(classifier, pdr);
+        entry->any = true;
+
+        for (i = 0; i < OGS_PFCP_MAX_NUM_OF_CLASSIFIER; i++)
+            classifier_index(classifier, i);
+
+        return;
+    }
+
     ogs_list_for_each(&pdr->rule_list, rule) {
-        int k;
-        uint32_t src_mask[4];
-        uint32_t dst_mask[4];
-        ogs_ipfw_rule_t *ipfw = NULL;
-
-        ipfw = &rule->ipfw;
-        ogs_assert(ipfw);
-
-        ip_h = (struct ip *)pkbuf->data;
-        if (ip_h->ip_v == 4) {
-            ip_h = (struct ip *)pkbuf->data;
-            ip6_h = NULL;
-
-            proto = ip_h->ip_p;
-            ip_hlen = (ip_h->ip_hl)*4;
-
-            src_addr = (void *)&ip_h->ip_src.s_addr;
-            dst_addr = (void *)&ip_h->ip_dst.s_addr;
-            addr_len = OGS_IPV4_LEN;
-        } else if (ip_h->ip_v == 6) {
-            ip_h = NULL;
-            ip6_h = (struct ip6_hdr *)pkbuf->data;
-
-            decode_ipv6_header(ip6_h, &proto, &ip_hlen);
-
-            src_addr = (void *)ip6_h->ip6_src.s6_addr;
-            dst_addr = (void *)ip6_h->ip6_dst.s6_addr;
-            addr_len = OGS_IPV6_LEN;
+        ogs_ipfw_rule_t *ipfw = &rule->ipfw;
+
+        entry = classifier_entry_add(classifier, pdr);
+
+        entry->proto = ipfw->proto;
+        memcpy(entry->src_addr, ipfw->ip.src.addr, sizeof(entry->src_addr));
+        memcpy(entry->src_mask, ipfw->ip.src.mask, sizeof(entry->src_mask));
+        memcpy(entry->dst_addr, ipfw->ip.dst.addr, sizeof(entry->dst_addr));
+        memcpy(entry->dst_mask, ipfw->ip.dst.mask, sizeof(entry->dst_mask));
+
+        if (ipfw->proto == IPPROTO_TCP || ipfw->proto == IPPROTO_UDP) {
+            if (ipfw->port.src.low)
+                entry->src_port.low = ipfw->port.src.low;
+            if (ipfw->port.src.high)
+                entry->src_port.high = ipfw->port.src.high;
+            if (ipfw->port.dst.low)
+                entry->dst_port.low = ipfw->port.dst.low;
+            if (ipfw->port.dst.high)
+                entry->dst_port.high = ipfw->port.dst.high;
+        }
+
+        if (ipfw->proto == 0) {
+            for (i = 0; i < OGS_PFCP_MAX_NUM_OF_CLASSIFIER; i++)
+                classifier_index(classifier, i);
         } else {
-            ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
-                    ip_h->ip_v, pkbuf->len);
-            ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+            classifier_index(classifier, classifier_table(ipfw->proto));
+        }
+    }
+}
+
+static int port_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void port_build(ogs_pfcp_classifier_t *classifier,
+        ogs_pfcp_classifier_table_t *table, bool is_src)
+{
+    ogs_pfcp_classifier_port_t *port = NULL;
+    ogs_pfcp_classifier_entry_t *entry = NULL;
+    uint32_t low, high;
+    int i, r, n = 0;
+
+    port = is_src ? &table->src_port : &table->dst_port;
+
+    /* Every lower bound and every upper bound + 1 starts a new range */
+    port->low = ogs_malloc((2 * table->num_of_index + 1) * sizeof(uint32_t));
+    ogs_assert(port->low);
+
+    port->low[n++] = 0;
+    for (i = 0; i < table->num_of_index; i++) {
+        entry = &classifier->entry[table->index[i]];
+        low = is_src ? entry->src_port.low : entry->dst_port.low;
+        high = is_src ? entry->src_port.high : entry->dst_port.high;
+
+        port->low[n++] = low;
+        if (high < 0xffff)
+            port->low[n++] = high + 1;
+    }
+
+    qsort(port->low, n, sizeof(uint32_t), port_compare);
+
+    port->num_of_range = 1;
+    for (i = 1; i < n; i++) {
+        if (port->low[i] != port->low[port->num_of_range-1])
+            port->low[port->num_of_range++] = port->low[i];
+    }
+
+    port->map = ogs_calloc(port->num_of_range * table->num_of_word,
+            sizeof(uint64_t));
+    ogs_assert(port->map);
+
+    for (r = 0; r < port->num_of_range; r++) {
+        for (i = 0; i < table->num_of_index; i++) {
+            entry = &classifier->entry[table->index[i]];
+            low = is_src ? entry->src_port.low : entry->dst_port.low;
+            high = is_src ? entry->src_port.high : entry->dst_port.high;
+
+            if (low <= port->low[r] && port->low[r] <= high)
+                CLASSIFIER_BIT_SET(
+                        &port->map[r * table->num_of_word], i);
+        }
+    }
+}
+
+static void prefix_build(ogs_pfcp_classifier_t *classifier,
+        ogs_pfcp_classifier_table_t *table, bool is_src)
+{
+    ogs_pfcp_classifier_prefix_t *prefix = NULL;
+    ogs_pfcp_classifier_entry_t *entry = NULL;
+    uint32_t *addr = NULL, *mask = NULL;
+    int i, p;
+
+    prefix = is_src ? &table->src_prefix : &table->dst_prefix;
+
+    prefix->addr = ogs_malloc(table->num_of_index * sizeof(*prefix->addr));
+    ogs_assert(prefix->addr);
+    prefix->mask = ogs_malloc(table->num_of_index * sizeof(*prefix->mask));
+    ogs_assert(prefix->mask);
+    prefix->map = ogs_calloc(table->num_of_index * table->num_of_word,
+            sizeof(uint64_t));
+    ogs_assert(prefix->map);
+
+    for (i = 0; i < table->num_of_index; i++) {
+        entry = &classifier->entry[table->index[i]];
+        addr = is_src ? entry->src_addr : entry->dst_addr;
+        mask = is_src ? entry->src_mask : entry->dst_mask;
+
+        for (p = 0; p < prefix->num_of_prefix; p++) {
+            if (memcmp(prefix->addr[p], addr, sizeof(prefix->addr[p])) == 0 &&
+                memcmp(prefix->mask[p], mask, sizeof(prefix->mask[p])) == 0)
+                break;
+        }
+        if (p == prefix->num_of_prefix) {
+            memcpy(prefix->addr[p], addr, sizeof(prefix->addr[p]));
+            memcpy(prefix->mask[p], mask, sizeof(prefix->mask[p]));
+            prefix->num_of_prefix++;
+        }
+
+        CLASSIFIER_BIT_SET(&prefix->map[p * table->num_of_word], i);
+    }
+}
+
+void ogs_pfcp_classifier_build(ogs_pfcp_classifier_t *classifier)
+{
+    ogs_pfcp_classifier_table_t *table = NULL;
+    int i, t;
+
+    ogs_assert(classifier);
+    ogs_assert(classifier->built == false);
+
+    for (t = 0; t < OGS_PFCP_MAX_NUM_OF_CLASSIFIER; t++) {
+        table = &classifier->table[t];
+        if (!table->num_of_index)
             continue;
+
+        table->num_of_word = (table->num_of_index + 63) / 64;
+
+        table->any = ogs_calloc(table->num_of_word, sizeof(uint64_t));
+        ogs_assert(table->any);
+        for (i = 0; i < table->num_of_index; i++) {
+            if (classifier->entry[table->index[i]].any)
+                CLASSIFIER_BIT_SET(table->any, i);
         }
 
-        ogs_trace("PROTO:%d SRC:%08x %08x %08x %08x",
-                proto, be32toh(src_addr[0]), be32toh(src_addr[1]),
-                be32toh(src_addr[2]), be32toh(src_addr[3]));
-        ogs_trace("HLEN:%d  DST:%08x %08x %08x %08x",
-                ip_hlen, be32toh(dst_addr[0]), be32toh(dst_addr[1]),
-                be32toh(dst_addr[2]), be32toh(dst_addr[3]));
-
-        ogs_trace("PROTO:%d SRC:%d-%d DST:%d-%d",
-                ipfw->proto,
-                ipfw->port.src.low,
-                ipfw->port.src.high,
-                ipfw->port.dst.low,
-                ipfw->port.dst.high);
-        ogs_trace("SRC:%08x %08x %08x %08x/%08x %08x %08x %08x",
-                be32toh(ipfw->ip.src.addr[0]),
-                be32toh(ipfw->ip.src.addr[1]),
-                be32toh(ipfw->ip.src.addr[2]),
-                be32toh(ipfw->ip.src.addr[3]),
-                be32toh(ipfw->ip.src.mask[0]),
-                be32toh(ipfw->ip.src.mask[1]),
-                be32toh(ipfw->ip.src.mask[2]),
-                be32toh(ipfw->ip.src.mask[3]));
-        ogs_trace("DST:%08x %08x %08x %08x/%08x %08x %08x %08x",
-                be32toh(ipfw->ip.dst.addr[0]),
-                be32toh(ipfw->ip.dst.addr[1]),
-                be32toh(ipfw->ip.dst.addr[2]),
-                be32toh(ipfw->ip.dst.addr[3]),
-                be32toh(ipfw->ip.dst.mask[0]),
-                be32toh(ipfw->ip.dst.mask[1]),
-                be32toh(ipfw->ip.dst.mask[2]),
-                be32toh(ipfw->ip.dst.mask[3]));
-
-        for (k = 0; k < 4; k++) {
-            src_mask[k] = src_addr[k] & ipfw->ip.src.mask[k];
-            dst_mask[k] = dst_addr[k] & ipfw->ip.dst.mask[k];
+        port_build(classifier, table, true);
+        port_build(classifier, table, false);
+        prefix_build(classifier, table, true);
+        prefix_build(classifier, table, false);
+    }
+
+    classifier->built = true;
+}
+
+void ogs_pfcp_classifier_clear(ogs_pfcp_classifier_t *classifier)
+{
+    ogs_pfcp_classifier_table_t *table = NULL;
+    int t;
+
+    ogs_assert(classifier);
+
+    if (classifier->entry)
+        ogs_free(classifier->entry);
+
+    for (t = 0; t < OGS_PFCP_MAX_NUM_OF_CLASSIFIER; t++) {
+        table = &classifier->table[t];
+
+        if (table->index)
+            ogs_free(table->index);
+        if (table->any)
+            ogs_free(table->any);
+
+        if (table->src_port.low)
+            ogs_free(table->src_port.low);
+        if (table->src_port.map)
+            ogs_free(table->src_port.map);
+        if (table->dst_port.low)
+            ogs_free(table->dst_port.low);
+        if (table->dst_port.map)
+            ogs_free(table->dst_port.map);
+
+        if (table->src_prefix.addr)
+            ogs_free(table->src_prefix.addr);
+        if (table->src_prefix.mask)
+            ogs_free(table->src_prefix.mask);
+        if (table->src_prefix.map)
+            ogs_free(table->src_prefix.map);
+        if (table->dst_prefix.addr)
+            ogs_free(table->dst_prefix.addr);
+        if (table->dst_prefix.mask)
+            ogs_free(table->dst_prefix.mask);
+        if (table->dst_prefix.map)
+            ogs_free(table->dst_prefix.map);
+    }
+
+    memset(classifier, 0, sizeof(*classifier));
+}
+
+static uint64_t *port_find(ogs_pfcp_classifier_table_t *table,
+        ogs_pfcp_classifier_port_t *port, uint16_t value)
+{
+    int low = 0, high = port->num_of_range - 1, mid;
+
+    /* The last range starting at or below the value, low[0] is 0 */
+    while (low < high) {
+        mid = (low + high + 1) / 2;
+        if (port->low[mid] <= value)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    return &port->map[low * table->num_of_word];
+}
+
+static uint64_t prefix_find(ogs_pfcp_classifier_table_t *table,
+        ogs_pfcp_classifier_prefix_t *prefix, uint32_t *addr, int n, int w)
+{
+    uint64_t map = 0;
+    int p, k;
+
+    for (p = 0; p < prefix->num_of_prefix; p++) {
+        for (k = 0; k < n; k++) {
+            if ((addr[k] & prefix->mask[p][k]) != prefix->addr[p][k])
+                break;
         }
+        if (k == n)
+            map |= prefix->map[p * table->num_of_word + w];
+    }
 
-        if (memcmp(src_mask, ipfw->ip.src.addr, addr_len) == 0 &&
-            memcmp(dst_mask, ipfw->ip.dst.addr, addr_len) == 0) {
-            /* Protocol match */
-            if (ipfw->proto == 0) { /* IP */
-                /* No need to match port */
-                return rule;
-            }
+    return map;
+}
+
+static ogs_pfcp_pdr_t *classifier_find(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_flow_key_t *key,
+        bool by_teid, uint32_t teid, uint8_t qfi)
+{
+    ogs_pfcp_classifier_table_t *table = NULL;
+    ogs_pfcp_classifier_entry_t *entry = NULL;
+    uint64_t *src_port = NULL, *dst_port = NULL, map;
+    int n, w, i;
 
-            if (ipfw->proto == proto) {
-                if (ipfw->proto == IPPROTO_TCP) {
-                    struct tcphdr *tcph =
-                        (struct tcphdr *)((char *)pkbuf->data + ip_hlen);
-
-                    /* Source port */
-                    if (ipfw->port.src.low &&
-                          be16toh(tcph->th_sport) < ipfw->port.src.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.src.high &&
-                          be16toh(tcph->th_sport) > ipfw->port.src.high) {
-                        continue;
-                    }
-
-                    /* Dst Port*/
-                    if (ipfw->port.dst.low &&
-                          be16toh(tcph->th_dport) < ipfw->port.dst.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.dst.high &&
-                          be16toh(tcph->th_dport) > ipfw->port.dst.high) {
-                        continue;
-                    }
-
-                    /* Matched */
-                    return rule;
-
-                } else if (ipfw->proto == IPPROTO_UDP) {
-                    struct udphdr *udph =
-                        (struct udphdr *)((char *)pkbuf->data + ip_hlen);
-
-                    /* Source port */
-                    if (ipfw->port.src.low &&
-                          be16toh(udph->uh_sport) < ipfw->port.src.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.src.high &&
-                          be16toh(udph->uh_sport) > ipfw->port.src.high) {
-                        continue;
-                    }
-
-                    /* Dst Port*/
-                    if (ipfw->port.dst.low &&
-                          be16toh(udph->uh_dport) < ipfw->port.dst.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.dst.high &&
-                          be16toh(udph->uh_dport) > ipfw->port.dst.high) {
-                        continue;
-                    }
-
-                    /* Matched */
-                    return rule;
-
-                } else {
-
-                    /* No need to match port */
-                    return rule;
-
-                }
+    ogs_assert(classifier);
+    ogs_assert(key);
+
+    ogs_assert(classifier->built == true || classifier->num_of_entry == 0);
+
+    table = &classifier->table[classifier_table(key->proto)];
+    if (!table->num_of_index)
+        return NULL;
+
+    n = key->addr_len / sizeof(uint32_t);
+    if (n) {
+        src_port = port_find(table, &table->src_port, key->src_port);
+        dst_port = port_find(table, &table->dst_port, key->dst_port);
+    }
+
+    for (w = 0; w < table->num_of_word; w++) {
+        if (n) {
+            map = src_port[w] & dst_port[w];
+            if (map)
+                map &= prefix_find(table,
+                        &table->src_prefix, key->src_addr, n, w);
+            if (map)
+                map &= prefix_find(table,
+                        &table->dst_prefix, key->dst_addr, n, w);
+        } else {
+            /* Not an IP packet */
+            map = table->any[w];
+        }
+
+        for ( ; map; map &= map - 1) {
+            i = w * 64 + __builtin_ctzll(map);
+            entry = &classifier->entry[table->index[i]];
+
+            /* The OTHER table holds every protocol but TCP and UDP */
+            if (!entry->any && entry->proto && entry->proto != key->proto)
+                continue;
+
+            if (by_teid == true) {
+                if (entry->teid != teid)
+                    continue;
+                if (qfi && entry->qfi != qfi)
+                    continue;
             }
+
+            return entry->pdr;
         }
     }
 
     return NULL;
 }
+
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_flow_key_t *key)
+{
+    return classifier_find(classifier, key, false, 0, 0);
+}
+
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find_by_teid(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_flow_key_t *key,
+        uint32_t teid, uint8_t qfi)
+{
+    return classifier_find(classifier, key, true, teid, qfi);
+}
@@ -28,9 +28,104 @@
 extern "C" {
 #endif
 
+/* 5-tuple of an IP packet, addresses kept in network byte order */
+typedef struct ogs_pfcp_flow_key_s {
+    int addr_len;               /* 0 if not an IPv4/IPv6 packet */
+    uint8_t proto;
+    uint32_t src_addr[4];
+    uint32_t dst_addr[4];
+    uint16_t src_port;
+    uint16_t dst_port;
+} ogs_pfcp_flow_key_t;
+
+/*
+ * Returns OGS_ERROR if pkbuf is not an IPv4/IPv6 packet. The key is then
+ * cleared, and only matches a PDR without SDF Filter.
+ */
+int ogs_pfcp_flow_key_parse(ogs_pfcp_flow_key_t *key, ogs_pkbuf_t *pkbuf);
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_flow_key(
+                    ogs_pfcp_pdr_t *pdr, ogs_pfcp_flow_key_t *key);
 ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
                     ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf);
 
+typedef struct ogs_pfcp_classifier_entry_s {
+    ogs_pfcp_pdr_t *pdr;
+
+    uint32_t teid;
+    uint8_t qfi;
+
+    bool any;                   /* PDR without SDF Filter */
+    uint8_t proto;              /* 0 : any protocol */
+    uint32_t src_addr[4];
+    uint32_t src_mask[4];
+    uint32_t dst_addr[4];
+    uint32_t dst_mask[4];
+    struct {
+        uint16_t low;
+        uint16_t high;
+    } src_port, dst_port;
+} ogs_pfcp_classifier_entry_t;
+
+#define OGS_PFCP_CLASSIFIER_TCP         0
+#define OGS_PFCP_CLASSIFIER_UDP         1
+#define OGS_PFCP_CLASSIFIER_OTHER       2
+#define OGS_PFCP_MAX_NUM_OF_CLASSIFIER  3
+
+/* Disjoint port ranges, each with the bitmap of the entries covering it */
+typedef struct ogs_pfcp_classifier_port_s {
+    int num_of_range;
+    uint32_t *low;              /* Lower bound of each range, ascending */
+    uint64_t *map;
+} ogs_pfcp_classifier_port_t;
+
+/* Distinct prefixes, each with the bitmap of the entries using it */
+typedef struct ogs_pfcp_classifier_prefix_s {
+    int num_of_prefix;
+    uint32_t (*addr)[4];
+    uint32_t (*mask)[4];
+    uint64_t *map;
+} ogs_pfcp_classifier_prefix_t;
+
+/*
+ * Decision table of a protocol. Bit i of a bitmap stands for index[i],
+ * so the lowest bit set in the intersection is the matching entry with
+ * the highest precedence.
+ */
+typedef struct ogs_pfcp_classifier_table_s {
+    int num_of_index;
+    int *index;                 /* Entries in precedence order */
+
+    int num_of_word;            /* uint64_t words per bitmap */
+    uint64_t *any;              /* Entries without SDF Filter */
+    ogs_pfcp_classifier_port_t src_port, dst_port;
+    ogs_pfcp_classifier_prefix_t src_prefix, dst_prefix;
+} ogs_pfcp_classifier_table_t;
+
+/*
+ * Compiled PDR set of a session.
+ * Rebuild it whenever the PDRs or their SDF Filters change: clear it,
+ * add the PDRs in precedence order, then build the decision tables.
+ */
+typedef struct ogs_pfcp_classifier_s {
+    int num_of_entry;
+    ogs_pfcp_classifier_entry_t *entry;
+
+    bool built;
+    ogs_pfcp_classifier_table_t table[OGS_PFCP_MAX_NUM_OF_CLASSIFIER];
+} ogs_pfcp_classifier_t;
+
+void ogs_pfcp_classifier_add(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_pdr_t *pdr);
+void ogs_pfcp_classifier_build(ogs_pfcp_classifier_t *classifier);
+void ogs_pfcp_classifier_clear(ogs_pfcp_classifier_t *classifier);
+
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_flow_key_t *key);
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find_by_teid(
+        ogs_pfcp_classifier_t *classifier, ogs_pfcp_flow_key_t *key,
+        uint32_t teid, uint8_t qfi);
+
 #ifdef __cplusplus
 }
 #endif
@@ -586,7 +586,7 @@ ogs_sbi_request_t *ogs_sbi_build_request(ogs_sbi_message_t *message)
     }
 
     ogs_assert(OGS_OK ==
-            ogs_sbi_rfc7231_string(sender_timestamp, ogs_time_now()));
+            ogs_sbi_rfc7231_string(sender_timestamp, ogs_loop_time_now()));
     ogs_sbi_header_set(request->http.headers,
             OGS_SBI_OPTIONAL_CUSTOM_SENDER_TIMESTAMP, sender_timestamp);
 
@@ -473,7 +473,7 @@ static char *get_date_string(char *date)
     ogs_assert(date);
 
     struct tm tm;
-    ogs_gmtime(ogs_time_sec(ogs_time_now()), &tm);
+    ogs_gmtime(ogs_time_sec(ogs_loop_time_now()), &tm);
 
     ogs_snprintf(date, DATE_STRLEN, "%3s, %02u %3s %04u %02u:%02u:%02u GMT",
             days[tm.tm_wday % 7],
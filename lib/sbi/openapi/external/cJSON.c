@@ -183,17 +183,17 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 #include "ogs-core.h"
 static void *internal_malloc(size_t size)
 {
-    void *ptr = ogs_malloc(size);
+    void *ptr = ogs_arena_malloc(size);
     ogs_assert(ptr);
     return ptr;
 }
 static void internal_free(void *pointer)
 {
-    ogs_free(pointer);
+    ogs_arena_free(pointer);
 }
 static void *internal_realloc(void *pointer, size_t size)
 {
-    void *ptr = ogs_realloc(pointer, size);
+    void *ptr = ogs_arena_realloc(pointer, size);
     ogs_assert(ptr);
     return ptr;
 }
@@ -1117,6 +1117,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
     cJSON *item = NULL;
 
+    /* modified by acetcom : the tree is taken from the per-thread arena */
+    ogs_arena_enter();
+
     /* reset error position */
     global_error.json = NULL;
     global_error.position = 0;
@@ -1157,6 +1160,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
         *return_parse_end = (const char*)buffer_at_offset(&buffer);
     }
 
+    ogs_arena_leave();
     return item;
 
 fail:
@@ -1164,6 +1168,7 @@ fail:
     {
         cJSON_Delete(item);
     }
+    ogs_arena_leave();
 
     if (value != NULL)
     {
@@ -34,14 +34,13 @@
 #define IFNAMSIZ 32
 #endif
 
-ogs_socket_t ogs_tun_open(char *ifname, int len, int is_tap)
+static ogs_socket_t tun_open(char *ifname, int is_tap, int flags)
 {
     ogs_socket_t fd = INVALID_SOCKET;
 
     const char *dev = "/dev/net/tun";
     int rc;
     struct ifreq ifr;
-    int flags = IFF_NO_PI;
 
     ogs_assert(ifname);
 
@@ -71,6 +70,48 @@ cleanup:
     return INVALID_SOCKET;
 }
 
+ogs_socket_t ogs_tun_open(char *ifname, int len, int is_tap)
+{
+    return tun_open(ifname, is_tap, IFF_NO_PI);
+}
+
+int ogs_tun_open_multi_queue(char *ifname, int len, int is_tap,
+        ogs_socket_t *fd, int num_of_queue)
+{
+#if defined(IFF_MULTI_QUEUE)
+    int i;
+
+    ogs_assert(ifname);
+    ogs_assert(fd);
+    ogs_assert(num_of_queue > 0);
+
+    /*
+     * Each TUNSETIFF with IFF_MULTI_QUEUE attaches one more queue
+     * to the same interface. A persistent interface must have been
+     * created with the 'multi_queue' option.
+     *
+     * $ sudo ip tuntap add name ogstun mode tun multi_queue
+     */
+    for (i = 0; i < num_of_queue; i++) {
+        fd[i] = tun_open(ifname, is_tap, IFF_NO_PI | IFF_MULTI_QUEUE);
+        if (fd[i] == INVALID_SOCKET) {
+            ogs_error("Cannot attach queue[%d/%d] to dev[%s]",
+                    i, num_of_queue, ifname);
+            while (i-- > 0) {
+                close(fd[i]);
+                fd[i] = INVALID_SOCKET;
+            }
+            return OGS_ERROR;
+        }
+    }
+
+    return OGS_OK;
+#else
+    ogs_error("IFF_MULTI_QUEUE is not supported");
+    return OGS_ERROR;
+#endif
+}
+
 int ogs_tun_set_ip(char *ifname, ogs_ipsubnet_t *gw, ogs_ipsubnet_t *sub)
 {
     return OGS_OK;
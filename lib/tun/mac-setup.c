@@ -110,6 +110,13 @@ ogs_socket_t ogs_tun_open(char *ifname, int maxlen, int is_tap)
     return fd;
 }
 
+int ogs_tun_open_multi_queue(char *ifname, int maxlen, int is_tap,
+        ogs_socket_t *fd, int num_of_queue)
+{
+    ogs_error("Multi-queue TUN is not supported on this platform");
+    return OGS_ERROR;
+}
+
 #define TUN_ALIGN(size, boundary) \
         (((size) + ((boundary) - 1)) & ~((boundary) - 1))
 
@@ -30,13 +30,25 @@ ogs_pkbuf_t *ogs_tun_read(ogs_socket_t fd, ogs_pkbuf_pool_t *packet_pool)
     ogs_assert(fd != INVALID_SOCKET);
 
     recvbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-    ogs_assert(recvbuf);
+    if (!recvbuf) {
+        uint8_t dropbuf[OGS_MAX_PKT_LEN];
+
+        /* Drop the packet so that the poll does not spin */
+        ogs_error("[DROP] No packet buffer");
+        if (ogs_read(fd, dropbuf, sizeof(dropbuf)) < 0 &&
+                ogs_socket_errno != OGS_EAGAIN)
+            ogs_log_message(OGS_LOG_WARN,
+                    ogs_socket_errno, "ogs_read() failed");
+        return NULL;
+    }
     ogs_pkbuf_reserve(recvbuf, OGS_TUN_MAX_HEADROOM);
     ogs_pkbuf_put(recvbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
 
     n = ogs_read(fd, recvbuf->data, recvbuf->len);
     if (n <= 0) {
-        ogs_log_message(OGS_LOG_WARN, ogs_socket_errno, "ogs_read() failed");
+        if (ogs_socket_errno != OGS_EAGAIN)
+            ogs_log_message(OGS_LOG_WARN,
+                    ogs_socket_errno, "ogs_read() failed");
         ogs_pkbuf_free(recvbuf);
         return NULL;
     }
@@ -29,6 +29,14 @@ ogs_socket_t ogs_tun_open(char *ifname, int len, int is_tap)
     return INVALID_SOCKET;
 }
 
+int ogs_tun_open_multi_queue(char *ifname, int maxlen, int is_tap,
+        ogs_socket_t *fd, int num_of_queue)
+{
+    ogs_error("Not implemented");
+    ogs_assert_if_reached();
+    return OGS_ERROR;
+}
+
 int ogs_tun_set_ip(char *ifname, ogs_ipsubnet_t *gw, ogs_ipsubnet_t *sub)
 {
     ogs_error("Not implemented");
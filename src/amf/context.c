@@ -72,12 +72,14 @@ void amf_context_init(void)
     ogs_assert(self.gnb_addr_hash);
     self.gnb_id_hash = ogs_hash_make();
     ogs_assert(self.gnb_id_hash);
-    self.guti_ue_hash = ogs_hash_make();
+    self.guti_ue_hash = ogs_hmap_create();
     ogs_assert(self.guti_ue_hash);
-    self.suci_hash = ogs_hash_make();
+    self.suci_hash = ogs_hmap_create();
     ogs_assert(self.suci_hash);
-    self.supi_hash = ogs_hash_make();
+    self.supi_hash = ogs_hmap_create();
     ogs_assert(self.supi_hash);
+    self.tai_gnb_hash = ogs_hmap_create();
+    ogs_assert(self.tai_gnb_hash);
 
     context_initialized = 1;
 }
@@ -95,11 +97,13 @@ void amf_context_final(void)
     ogs_hash_destroy(self.gnb_id_hash);
 
     ogs_assert(self.guti_ue_hash);
-    ogs_hash_destroy(self.guti_ue_hash);
+    ogs_hmap_destroy(self.guti_ue_hash);
     ogs_assert(self.suci_hash);
-    ogs_hash_destroy(self.suci_hash);
+    ogs_hmap_destroy(self.suci_hash);
     ogs_assert(self.supi_hash);
-    ogs_hash_destroy(self.supi_hash);
+    ogs_hmap_destroy(self.supi_hash);
+    ogs_assert(self.tai_gnb_hash);
+    ogs_hmap_destroy(self.tai_gnb_hash);
 
     ogs_pool_final(&m_tmsi_pool);
     ogs_pool_final(&amf_sess_pool);
@@ -1164,6 +1168,8 @@ amf_gnb_t *amf_gnb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
     gnb->ostream_id = 0;
 
     ogs_list_init(&gnb->ran_ue_list);
+    gnb->ran_ue_hash = ogs_hmap_create();
+    ogs_assert(gnb->ran_ue_hash);
 
     ogs_hash_set(self.gnb_addr_hash,
             gnb->sctp.addr, sizeof(ogs_sockaddr_t), gnb);
@@ -1184,6 +1190,7 @@ amf_gnb_t *amf_gnb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
 void amf_gnb_remove(amf_gnb_t *gnb)
 {
     amf_event_t e;
+    ran_ue_t *ran_ue = NULL;
 
     ogs_assert(gnb);
     ogs_assert(gnb->sctp.sock);
@@ -1197,6 +1204,18 @@ void amf_gnb_remove(amf_gnb_t *gnb)
     ogs_hash_set(self.gnb_addr_hash,
             gnb->sctp.addr, sizeof(ogs_sockaddr_t), NULL);
     ogs_hash_set(self.gnb_id_hash, &gnb->gnb_id, sizeof(gnb->gnb_id), NULL);
+    amf_gnb_tai_hash_clear(gnb);
+
+    /*
+     * A RAN UE waiting for an SBI response may outlive its gNB.
+     * It is no longer indexed, see ran_ue_hash_clear().
+     */
+    ogs_list_for_each(&gnb->ran_ue_list, ran_ue) {
+        ran_ue->ran_ue_ngap_id_shadowed = false;
+        ran_ue->num_of_shadowed = 0;
+    }
+    ogs_hmap_destroy(gnb->ran_ue_hash);
+    gnb->ran_ue_hash = NULL;
 
     ogs_sctp_flush_and_destroy(&gnb->sctp);
 
@@ -1240,6 +1259,112 @@ int amf_gnb_set_gnb_id(amf_gnb_t *gnb, uint32_t gnb_id)
     return OGS_OK;
 }
 
+static void tai_gnb_add(ogs_5gs_tai_t *tai, amf_gnb_t *gnb)
+{
+    amf_tai_gnb_t *tai_gnb = NULL;
+    int i;
+
+    tai_gnb = ogs_hmap_get(self.tai_gnb_hash, tai, sizeof(*tai));
+    if (!tai_gnb) {
+        tai_gnb = ogs_calloc(1, sizeof(*tai_gnb));
+        ogs_assert(tai_gnb);
+        memcpy(&tai_gnb->tai, tai, sizeof(tai_gnb->tai));
+        ogs_hmap_set(self.tai_gnb_hash,
+                &tai_gnb->tai, sizeof(tai_gnb->tai), tai_gnb);
+    }
+
+    for (i = 0; i < tai_gnb->num_of_gnb; i++)
+        if (tai_gnb->gnb[i] == gnb)
+            return;
+
+    if (tai_gnb->num_of_gnb == tai_gnb->max_num_of_gnb) {
+        tai_gnb->max_num_of_gnb =
+            tai_gnb->max_num_of_gnb ? tai_gnb->max_num_of_gnb * 2 : 4;
+        tai_gnb->gnb = ogs_realloc(tai_gnb->gnb,
+                tai_gnb->max_num_of_gnb * sizeof(amf_gnb_t *));
+        ogs_assert(tai_gnb->gnb);
+    }
+    tai_gnb->gnb[tai_gnb->num_of_gnb++] = gnb;
+}
+
+static void tai_gnb_remove(ogs_5gs_tai_t *tai, amf_gnb_t *gnb)
+{
+    amf_tai_gnb_t *tai_gnb = NULL;
+    int i;
+
+    tai_gnb = ogs_hmap_get(self.tai_gnb_hash, tai, sizeof(*tai));
+    if (!tai_gnb)
+        return;
+
+    for (i = 0; i < tai_gnb->num_of_gnb; i++) {
+        if (tai_gnb->gnb[i] == gnb) {
+            tai_gnb->gnb[i] = tai_gnb->gnb[--tai_gnb->num_of_gnb];
+            break;
+        }
+    }
+
+    if (tai_gnb->num_of_gnb == 0) {
+        ogs_hmap_set(self.tai_gnb_hash,
+                &tai_gnb->tai, sizeof(tai_gnb->tai), NULL);
+        if (tai_gnb->gnb)
+            ogs_free(tai_gnb->gnb);
+        ogs_free(tai_gnb);
+    }
+}
+
+/*
+ * Index the gNB by every TAI of its Supported TA List,
+ * so that Paging does not have to scan all gNBs.
+ */
+void amf_gnb_tai_hash_set(amf_gnb_t *gnb)
+{
+    ogs_5gs_tai_t *tai = NULL;
+    int i, j;
+
+    ogs_assert(gnb);
+
+    amf_gnb_tai_hash_clear(gnb);
+
+    for (i = 0; i < gnb->num_of_supported_ta_list; i++) {
+        for (j = 0; j < gnb->supported_ta_list[i].num_of_bplmn_list; j++) {
+            tai = &gnb->paging_tai[gnb->num_of_paging_tai++];
+
+            memset(tai, 0, sizeof(*tai));
+            memcpy(&tai->plmn_id,
+                    &gnb->supported_ta_list[i].bplmn_list[j].plmn_id,
+                    OGS_PLMN_ID_LEN);
+            tai->tac.v = gnb->supported_ta_list[i].tac.v;
+
+            tai_gnb_add(tai, gnb);
+        }
+    }
+}
+
+void amf_gnb_tai_hash_clear(amf_gnb_t *gnb)
+{
+    int i;
+
+    ogs_assert(gnb);
+
+    for (i = 0; i < gnb->num_of_paging_tai; i++)
+        tai_gnb_remove(&gnb->paging_tai[i], gnb);
+
+    gnb->num_of_paging_tai = 0;
+}
+
+amf_tai_gnb_t *amf_tai_gnb_find(ogs_5gs_tai_t *tai)
+{
+    ogs_5gs_tai_t key;
+
+    ogs_assert(tai);
+
+    memset(&key, 0, sizeof(key));
+    memcpy(&key.plmn_id, &tai->plmn_id, OGS_PLMN_ID_LEN);
+    key.tac.v = tai->tac.v;
+
+    return ogs_hmap_get(self.tai_gnb_hash, &key, sizeof(key));
+}
+
 int amf_gnb_sock_type(ogs_sock_t *sock)
 {
     ogs_socknode_t *snode = NULL;
@@ -1261,6 +1386,75 @@ amf_gnb_t *amf_gnb_cycle(amf_gnb_t *gnb)
 }
 
 /** ran_ue_context handling function */
+static void ran_ue_hash_set(ran_ue_t *ran_ue)
+{
+    amf_gnb_t *gnb = ran_ue->gnb;
+    ran_ue_t *old_ran_ue = NULL;
+
+    if (!gnb->ran_ue_hash)
+        return;
+    if (ran_ue->ran_ue_ngap_id == INVALID_UE_NGAP_ID)
+        return;
+
+    /*
+     * The gNB reused the ID while an older UE still holds it.
+     * As with the scan of ran_ue_list, the older UE is found first,
+     * and the newer one is indexed once the older one is gone.
+     */
+    old_ran_ue = ogs_hmap_get_u32(gnb->ran_ue_hash, ran_ue->ran_ue_ngap_id);
+    if (old_ran_ue && old_ran_ue != ran_ue) {
+        ogs_warn("Duplicated RAN_UE_NGAP_ID[%d] in gNB[%d]",
+                ran_ue->ran_ue_ngap_id, gnb->gnb_id);
+        ran_ue->ran_ue_ngap_id_shadowed = true;
+        old_ran_ue->num_of_shadowed++;
+        return;
+    }
+
+    ogs_hmap_set_u32(gnb->ran_ue_hash, ran_ue->ran_ue_ngap_id, ran_ue);
+}
+
+static void ran_ue_hash_clear(ran_ue_t *ran_ue)
+{
+    amf_gnb_t *gnb = ran_ue->gnb;
+    ran_ue_t *old_ran_ue = NULL, *new_ran_ue = NULL;
+
+    if (!gnb->ran_ue_hash)
+        return;
+    if (ran_ue->ran_ue_ngap_id == INVALID_UE_NGAP_ID)
+        return;
+
+    old_ran_ue = ogs_hmap_get_u32(gnb->ran_ue_hash, ran_ue->ran_ue_ngap_id);
+
+    if (ran_ue->ran_ue_ngap_id_shadowed) {
+        ran_ue->ran_ue_ngap_id_shadowed = false;
+        ogs_assert(old_ran_ue);
+        ogs_assert(old_ran_ue->num_of_shadowed > 0);
+        old_ran_ue->num_of_shadowed--;
+        return;
+    }
+
+    if (old_ran_ue != ran_ue)
+        return;
+
+    ogs_hmap_set_u32(gnb->ran_ue_hash, ran_ue->ran_ue_ngap_id, NULL);
+
+    if (!ran_ue->num_of_shadowed)
+        return;
+
+    /* The oldest of the newer UEs takes over the ID */
+    ogs_list_for_each(&gnb->ran_ue_list, new_ran_ue) {
+        if (new_ran_ue->ran_ue_ngap_id_shadowed &&
+            new_ran_ue->ran_ue_ngap_id == ran_ue->ran_ue_ngap_id) {
+            new_ran_ue->ran_ue_ngap_id_shadowed = false;
+            new_ran_ue->num_of_shadowed = ran_ue->num_of_shadowed - 1;
+            ogs_hmap_set_u32(gnb->ran_ue_hash,
+                    new_ran_ue->ran_ue_ngap_id, new_ran_ue);
+            break;
+        }
+    }
+    ran_ue->num_of_shadowed = 0;
+}
+
 ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint32_t ran_ue_ngap_id)
 {
     ran_ue_t *ran_ue = NULL;
@@ -1302,6 +1496,7 @@ ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint32_t ran_ue_ngap_id)
     ran_ue->gnb = gnb;
 
     ogs_list_add(&gnb->ran_ue_list, ran_ue);
+    ran_ue_hash_set(ran_ue);
 
     stats_add_ran_ue();
 
@@ -1314,6 +1509,7 @@ void ran_ue_remove(ran_ue_t *ran_ue)
     ogs_assert(ran_ue->gnb);
 
     ogs_list_remove(&ran_ue->gnb->ran_ue_list, ran_ue);
+    ran_ue_hash_clear(ran_ue);
 
     ogs_assert(ran_ue->t_ng_holding);
     ogs_timer_delete(ran_ue->t_ng_holding);
@@ -1331,25 +1527,33 @@ void ran_ue_switch_to_gnb(ran_ue_t *ran_ue, amf_gnb_t *new_gnb)
 
     /* Remove from the old gnb */
     ogs_list_remove(&ran_ue->gnb->ran_ue_list, ran_ue);
+    ran_ue_hash_clear(ran_ue);
 
     /* Add to the new gnb */
     ogs_list_add(&new_gnb->ran_ue_list, ran_ue);
 
     /* Switch to gnb */
     ran_ue->gnb = new_gnb;
+    ran_ue_hash_set(ran_ue);
+}
+
+void ran_ue_set_ran_ue_ngap_id(ran_ue_t *ran_ue, uint32_t ran_ue_ngap_id)
+{
+    ogs_assert(ran_ue);
+    ogs_assert(ran_ue->gnb);
+
+    ran_ue_hash_clear(ran_ue);
+    ran_ue->ran_ue_ngap_id = ran_ue_ngap_id;
+    ran_ue_hash_set(ran_ue);
 }
 
 ran_ue_t *ran_ue_find_by_ran_ue_ngap_id(
         amf_gnb_t *gnb, uint32_t ran_ue_ngap_id)
 {
-    ran_ue_t *ran_ue = NULL;
-
-    ogs_list_for_each(&gnb->ran_ue_list, ran_ue) {
-        if (ran_ue_ngap_id == ran_ue->ran_ue_ngap_id)
-            break;
-    }
+    ogs_assert(gnb);
+    ogs_assert(gnb->ran_ue_hash);
 
-    return ran_ue;
+    return ogs_hmap_get_u32(gnb->ran_ue_hash, ran_ue_ngap_id);
 }
 
 ran_ue_t *ran_ue_find(uint32_t index)
@@ -1416,7 +1620,7 @@ void amf_ue_confirm_guti(amf_ue_t *amf_ue)
     if (amf_ue->current.m_tmsi) {
         /* AMF has a VALID GUTI
          * As such, we need to remove previous GUTI in hash table */
-        ogs_hash_set(self.guti_ue_hash,
+        ogs_hmap_set(self.guti_ue_hash,
                 &amf_ue->current.guti, sizeof(ogs_nas_5gs_guti_t), NULL);
         ogs_assert(amf_m_tmsi_free(amf_ue->current.m_tmsi) == OGS_OK);
     }
@@ -1449,7 +1653,7 @@ void amf_ue_confirm_guti(amf_ue_t *amf_ue)
             &amf_ue->next.guti, sizeof(ogs_nas_5gs_guti_t));
 
     /* Hashing Current GUTI */
-    ogs_hash_set(self.guti_ue_hash,
+    ogs_hmap_set(self.guti_ue_hash,
             &amf_ue->current.guti, sizeof(ogs_nas_5gs_guti_t), amf_ue);
 
     /* Clear Next GUTI */
@@ -1591,7 +1795,7 @@ void amf_ue_remove(amf_ue_t *amf_ue)
     amf_sess_remove_all(amf_ue);
 
     if (amf_ue->current.m_tmsi) {
-        ogs_hash_set(self.guti_ue_hash,
+        ogs_hmap_set(self.guti_ue_hash,
                 &amf_ue->current.guti, sizeof(ogs_nas_5gs_guti_t), NULL);
         ogs_assert(amf_m_tmsi_free(amf_ue->current.m_tmsi) == OGS_OK);
     }
@@ -1599,11 +1803,11 @@ void amf_ue_remove(amf_ue_t *amf_ue)
         ogs_assert(amf_m_tmsi_free(amf_ue->next.m_tmsi) == OGS_OK);
     }
     if (amf_ue->suci) {
-        ogs_hash_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), NULL);
+        ogs_hmap_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), NULL);
         ogs_free(amf_ue->suci);
     }
     if (amf_ue->supi) {
-        ogs_hash_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), NULL);
+        ogs_hmap_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), NULL);
         ogs_free(amf_ue->supi);
     }
 
@@ -1696,20 +1900,20 @@ amf_ue_t *amf_ue_find_by_guti(ogs_nas_5gs_guti_t *guti)
 {
     ogs_assert(guti);
 
-    return (amf_ue_t *)ogs_hash_get(
+    return (amf_ue_t *)ogs_hmap_get(
             self.guti_ue_hash, guti, sizeof(ogs_nas_5gs_guti_t));
 }
 
 amf_ue_t *amf_ue_find_by_suci(char *suci)
 {
     ogs_assert(suci);
-    return (amf_ue_t *)ogs_hash_get(self.suci_hash, suci, strlen(suci));
+    return (amf_ue_t *)ogs_hmap_get(self.suci_hash, suci, strlen(suci));
 }
 
 amf_ue_t *amf_ue_find_by_supi(char *supi)
 {
     ogs_assert(supi);
-    return (amf_ue_t *)ogs_hash_get(self.supi_hash, supi, strlen(supi));
+    return (amf_ue_t *)ogs_hmap_get(self.supi_hash, supi, strlen(supi));
 }
 
 amf_ue_t *amf_ue_find_by_message(ogs_nas_5gs_message_t *message)
@@ -1950,11 +2154,11 @@ void amf_ue_set_suci(amf_ue_t *amf_ue,
     }
 
     if (amf_ue->suci) {
-        ogs_hash_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), NULL);
+        ogs_hmap_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), NULL);
         ogs_free(amf_ue->suci);
     }
     amf_ue->suci = suci;
-    ogs_hash_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), amf_ue);
+    ogs_hmap_set(self.suci_hash, amf_ue->suci, strlen(amf_ue->suci), amf_ue);
 }
 
 void amf_ue_set_supi(amf_ue_t *amf_ue, char *supi)
@@ -1962,12 +2166,12 @@ void amf_ue_set_supi(amf_ue_t *amf_ue, char *supi)
     ogs_assert(supi);
 
     if (amf_ue->supi) {
-        ogs_hash_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), NULL);
+        ogs_hmap_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), NULL);
         ogs_free(amf_ue->supi);
     }
     amf_ue->supi = ogs_strdup(supi);
     ogs_assert(amf_ue->supi);
-    ogs_hash_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), amf_ue);
+    ogs_hmap_set(self.supi_hash, amf_ue->supi, strlen(amf_ue->supi), amf_ue);
 }
 
 OpenAPI_rat_type_e amf_ue_rat_type(amf_ue_t *amf_ue)
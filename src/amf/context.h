@@ -107,9 +107,10 @@ typedef struct amf_context_s {
 
     ogs_hash_t      *gnb_addr_hash; /* hash table for GNB Address */
     ogs_hash_t      *gnb_id_hash;   /* hash table for GNB-ID */
-    ogs_hash_t      *guti_ue_hash;          /* hash table (GUTI : AMF_UE) */
-    ogs_hash_t      *suci_hash;     /* hash table (SUCI) */
-    ogs_hash_t      *supi_hash;     /* hash table (SUPI) */
+    ogs_hmap_t      *guti_ue_hash;          /* hash table (GUTI : AMF_UE) */
+    ogs_hmap_t      *suci_hash;     /* hash table (SUCI) */
+    ogs_hmap_t      *supi_hash;     /* hash table (SUPI) */
+    ogs_hmap_t      *tai_gnb_hash;  /* hash table (TAI : gNBs for Paging) */
 
     uint16_t        ngap_port;      /* Default NGAP Port */
 
@@ -150,14 +151,27 @@ typedef struct amf_gnb_s {
         } bplmn_list[OGS_MAX_NUM_OF_BPLMN];
     } supported_ta_list[OGS_MAX_NUM_OF_TAI];
 
+    /* TAIs under which this gNB is in amf_self()->tai_gnb_hash */
+    int             num_of_paging_tai;
+    ogs_5gs_tai_t   paging_tai[OGS_MAX_NUM_OF_TAI*OGS_MAX_NUM_OF_BPLMN];
+
     OpenAPI_rat_type_e rat_type;
 
     ogs_pkbuf_t     *ng_reset_ack; /* Reset message */
 
     ogs_list_t      ran_ue_list;
+    ogs_hmap_t      *ran_ue_hash;   /* hash table (RAN-UE-NGAP-ID : RAN_UE) */
 
 } amf_gnb_t;
 
+typedef struct amf_tai_gnb_s {
+    ogs_5gs_tai_t   tai;            /* Key of amf_self()->tai_gnb_hash */
+
+    int             num_of_gnb;
+    int             max_num_of_gnb;
+    amf_gnb_t       **gnb;
+} amf_tai_gnb_t;
+
 struct ran_ue_s {
     ogs_lnode_t     lnode;
     uint32_t        index;
@@ -167,6 +181,13 @@ struct ran_ue_s {
     uint32_t        ran_ue_ngap_id; /* eNB-UE-NGAP-ID received from eNB */
     uint64_t        amf_ue_ngap_id; /* AMF-UE-NGAP-ID received from AMF */
 
+    /*
+     * An older UE of the gNB holds the same RAN-UE-NGAP-ID in ran_ue_hash.
+     * The indexed UE counts the newer ones that wait for the ID.
+     */
+    bool            ran_ue_ngap_id_shadowed;
+    int             num_of_shadowed;
+
     uint16_t        gnb_ostream_id; /* SCTP output stream id for eNB */
 
     /* UE context */
@@ -663,12 +684,16 @@ void amf_gnb_remove_all(void);
 amf_gnb_t *amf_gnb_find_by_addr(ogs_sockaddr_t *addr);
 amf_gnb_t *amf_gnb_find_by_gnb_id(uint32_t gnb_id);
 int amf_gnb_set_gnb_id(amf_gnb_t *gnb, uint32_t gnb_id);
+void amf_gnb_tai_hash_set(amf_gnb_t *gnb);
+void amf_gnb_tai_hash_clear(amf_gnb_t *gnb);
+amf_tai_gnb_t *amf_tai_gnb_find(ogs_5gs_tai_t *tai);
 int amf_gnb_sock_type(ogs_sock_t *sock);
 amf_gnb_t *amf_gnb_cycle(amf_gnb_t *gnb);
 
 ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint32_t ran_ue_ngap_id);
 void ran_ue_remove(ran_ue_t *ran_ue);
 void ran_ue_switch_to_gnb(ran_ue_t *ran_ue, amf_gnb_t *new_gnb);
+void ran_ue_set_ran_ue_ngap_id(ran_ue_t *ran_ue, uint32_t ran_ue_ngap_id);
 ran_ue_t *ran_ue_find_by_ran_ue_ngap_id(
         amf_gnb_t *gnb, uint32_t ran_ue_ngap_id);
 ran_ue_t *ran_ue_find(uint32_t index);
@@ -132,9 +132,11 @@ static void amf_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            amf_event_t *e = NULL;
+            amf_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -143,9 +145,11 @@ static void amf_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&amf_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&amf_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
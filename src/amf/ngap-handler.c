@@ -284,6 +284,7 @@ void ngap_handle_ng_setup_request(amf_gnb_t *gnb, ogs_ngap_message_t *message)
 
         gnb->num_of_supported_ta_list++;
     }
+    amf_gnb_tai_hash_set(gnb);
 
     if (maximum_number_of_gnbs_is_reached()) {
         ogs_warn("NG-Setup failure:");
@@ -2731,7 +2732,7 @@ void ngap_handle_path_switch_request(
         amf_ue->nr_tai.tac.v, (long long)amf_ue->nr_cgi.cell_id);
 
     /* Update RAN-UE-NGAP-ID */
-    ran_ue->ran_ue_ngap_id = *RAN_UE_NGAP_ID;
+    ran_ue_set_ran_ue_ngap_id(ran_ue, *RAN_UE_NGAP_ID);
 
     /* Change ran_ue to the NEW gNB */
     ran_ue_switch_to_gnb(ran_ue, gnb);
@@ -3369,7 +3370,7 @@ void ngap_handle_handover_request_ack(
         return;
     }
 
-    target_ue->ran_ue_ngap_id = *RAN_UE_NGAP_ID;
+    ran_ue_set_ran_ue_ngap_id(target_ue, *RAN_UE_NGAP_ID);
 
     source_ue = target_ue->source_ue;
     if (!source_ue) {
@@ -4230,6 +4231,7 @@ void ngap_handle_ran_configuration_update(
 
             gnb->num_of_supported_ta_list++;
         }
+        amf_gnb_tai_hash_set(gnb);
 
         if (gnb->num_of_supported_ta_list == 0) {
             ogs_warn("RANConfigurationUpdate failure:");
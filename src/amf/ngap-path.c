@@ -411,8 +411,8 @@ int ngap_send_amf_ue_context_release_command(
 int ngap_send_paging(amf_ue_t *amf_ue)
 {
     ogs_pkbuf_t *ngapbuf = NULL;
-    amf_gnb_t *gnb = NULL;
-    int i, j;
+    amf_tai_gnb_t *tai_gnb = NULL;
+    int i;
     int rv;
 
     ogs_debug("NG-Paging");
@@ -422,38 +422,32 @@ int ngap_send_paging(amf_ue_t *amf_ue)
         return OGS_NOTFOUND;
     }
 
-    ogs_list_for_each(&amf_self()->gnb_list, gnb) {
-        for (i = 0; i < gnb->num_of_supported_ta_list; i++) {
-            for (j = 0; j < gnb->supported_ta_list[i].num_of_bplmn_list; j++) {
-                if (memcmp(&gnb->supported_ta_list[i].bplmn_list[j].plmn_id,
-                            &amf_ue->nr_tai.plmn_id, OGS_PLMN_ID_LEN) == 0 &&
-                    gnb->supported_ta_list[i].tac.v == amf_ue->nr_tai.tac.v) {
-
-                    if (amf_ue->t3513.pkbuf) {
-                        ngapbuf = amf_ue->t3513.pkbuf;
-                    } else {
-                        ngapbuf = ngap_build_paging(amf_ue);
-                        if (!ngapbuf) {
-                            ogs_error("ngap_build_paging() failed");
-                            return OGS_ERROR;
-                        }
-                    }
-
-                    amf_ue->t3513.pkbuf = ogs_pkbuf_copy(ngapbuf);
-                    if (!amf_ue->t3513.pkbuf) {
-                        ogs_error("ogs_pkbuf_copy() failed");
-                        ogs_pkbuf_free(ngapbuf);
-                        return OGS_ERROR;
-                    }
-
-                    amf_metrics_inst_global_inc(AMF_METR_GLOB_CTR_MM_PAGING_5G_REQ);
-
-                    rv = ngap_send_to_gnb(gnb, ngapbuf, NGAP_NON_UE_SIGNALLING);
-                    if (rv != OGS_OK) {
-                        ogs_error("ngap_send_to_gnb() failed");
-                        return rv;
-                    }
-                }
+    /* Find gNBs with matched TAI */
+    tai_gnb = amf_tai_gnb_find(&amf_ue->nr_tai);
+    if (tai_gnb && tai_gnb->num_of_gnb) {
+        /* The Paging PDU is encoded once, and kept for T3513 */
+        if (!amf_ue->t3513.pkbuf) {
+            amf_ue->t3513.pkbuf = ngap_build_paging(amf_ue);
+            if (!amf_ue->t3513.pkbuf) {
+                ogs_error("ngap_build_paging() failed");
+                return OGS_ERROR;
+            }
+        }
+
+        for (i = 0; i < tai_gnb->num_of_gnb; i++) {
+            ngapbuf = ogs_pkbuf_copy(amf_ue->t3513.pkbuf);
+            if (!ngapbuf) {
+                ogs_error("ogs_pkbuf_copy() failed");
+                return OGS_ERROR;
+            }
+
+            amf_metrics_inst_global_inc(AMF_METR_GLOB_CTR_MM_PAGING_5G_REQ);
+
+            rv = ngap_send_to_gnb(
+                    tai_gnb->gnb[i], ngapbuf, NGAP_NON_UE_SIGNALLING);
+            if (rv != OGS_OK) {
+                ogs_error("ngap_send_to_gnb() failed");
+                return rv;
             }
         }
     }
@@ -115,9 +115,11 @@ static void bsf_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            bsf_event_t *e = NULL;
+            bsf_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -126,9 +128,11 @@ static void bsf_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&bsf_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&bsf_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
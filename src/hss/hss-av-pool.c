@@ -0,0 +1,478 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "hss-av-pool.h"
+
+#define MAX_NUM_OF_AV           16
+
+/* Refill is deferred until no vector was generated inline for this time */
+#define IDLE_MSEC               100
+
+typedef struct av_refill_s av_refill_t;
+
+typedef struct av_entry_s {
+    ogs_lnode_t lnode;          /* LRU order, the most recent first */
+
+    char imsi_bcd[OGS_MAX_IMSI_BCD_LEN+1];
+    uint64_t generation;        /* Changed whenever the pool is flushed */
+
+    uint64_t last_sqn;          /* SQN of the last vector handed out */
+
+    int num_of_av;
+    hss_av_t av[MAX_NUM_OF_AV]; /* In SQN order */
+
+    av_refill_t *refill;
+} av_entry_t;
+
+typedef struct av_refill_s {
+    ogs_lnode_t lnode;
+
+    av_entry_t *entry;
+} av_refill_t;
+
+static struct {
+    int num_of_av;
+    bool watching;              /* Database changes are seen */
+    bool terminated;
+
+    ogs_thread_mutex_t mutex;
+    ogs_thread_cond_t cond;
+
+    ogs_list_t lru_list;
+    ogs_hash_t *imsi_hash;
+
+    ogs_list_t refill_list;
+    uint64_t generation;
+    ogs_time_t busy_until;
+
+    ogs_thread_t *thread;
+} self;
+
+static OGS_POOL(av_entry_pool, av_entry_t);
+static OGS_POOL(av_refill_pool, av_refill_t);
+
+static void refill_remove(av_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    if (!entry->refill)
+        return;
+
+    ogs_list_remove(&self.refill_list, entry->refill);
+    ogs_pool_free(&av_refill_pool, entry->refill);
+    entry->refill = NULL;
+}
+
+static void refill_add(av_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    if (entry->refill || entry->num_of_av >= self.num_of_av)
+        return;
+
+    ogs_pool_alloc(&av_refill_pool, &entry->refill);
+    ogs_assert(entry->refill);
+    entry->refill->entry = entry;
+
+    ogs_list_add(&self.refill_list, entry->refill);
+    ogs_thread_cond_signal(&self.cond);
+}
+
+static void entry_remove(av_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    refill_remove(entry);
+
+    ogs_list_remove(&self.lru_list, entry);
+    ogs_hash_set(self.imsi_hash, entry->imsi_bcd, OGS_HASH_KEY_STRING, NULL);
+
+    ogs_pool_free(&av_entry_pool, entry);
+}
+
+static av_entry_t *entry_find(char *imsi_bcd)
+{
+    av_entry_t *entry = NULL;
+
+    entry = ogs_hash_get(self.imsi_hash, imsi_bcd, OGS_HASH_KEY_STRING);
+    if (entry) {
+        ogs_list_remove(&self.lru_list, entry);
+        ogs_list_prepend(&self.lru_list, entry);
+    }
+
+    return entry;
+}
+
+static av_entry_t *entry_find_or_add(char *imsi_bcd)
+{
+    av_entry_t *entry = NULL;
+
+    entry = entry_find(imsi_bcd);
+    if (entry)
+        return entry;
+
+    if (!ogs_pool_avail(&av_entry_pool))
+        entry_remove(ogs_list_last(&self.lru_list));
+
+    ogs_pool_alloc(&av_entry_pool, &entry);
+    ogs_assert(entry);
+    memset(entry, 0, sizeof(*entry));
+
+    ogs_cpystrn(entry->imsi_bcd, imsi_bcd, sizeof(entry->imsi_bcd));
+    entry->generation = ++self.generation;
+
+    ogs_hash_set(self.imsi_hash, entry->imsi_bcd, OGS_HASH_KEY_STRING, entry);
+    ogs_list_prepend(&self.lru_list, entry);
+
+    return entry;
+}
+
+static void entry_push(av_entry_t *entry, hss_av_t *av)
+{
+    uint64_t sqn;
+
+    ogs_assert(entry);
+    ogs_assert(av);
+
+    if (entry->num_of_av >= self.num_of_av)
+        return;
+
+    sqn = entry->num_of_av ?
+        entry->av[entry->num_of_av-1].sqn : entry->last_sqn;
+    if (av->sqn <= sqn) {
+        ogs_debug("[%s] Pre-computed vector discarded, SQN went backwards",
+                entry->imsi_bcd);
+        return;
+    }
+
+    memcpy(&entry->av[entry->num_of_av++], av, sizeof(*av));
+}
+
+/* Takes the next SQN the same way as an AIR without re-synchronization */
+static int generate(char *imsi_bcd, hss_av_t *av)
+{
+    int rv;
+    ogs_dbi_auth_info_t auth_info;
+    uint8_t zero[OGS_RAND_LEN];
+
+    ogs_assert(imsi_bcd);
+    ogs_assert(av);
+
+    rv = hss_db_auth_info(imsi_bcd, &auth_info);
+    if (rv != OGS_OK)
+        return rv;
+
+    memset(zero, 0, sizeof(zero));
+    if (memcmp(auth_info.rand, zero, OGS_RAND_LEN) == 0) {
+        ogs_random(auth_info.rand, OGS_RAND_LEN);
+    }
+
+    rv = hss_db_increment_sqn(imsi_bcd);
+    if (rv != OGS_OK) {
+        ogs_error("Cannot increment sqn for IMSI:'%s'", imsi_bcd);
+        return rv;
+    }
+
+    hss_av_generate(&auth_info, av);
+
+    return OGS_OK;
+}
+
+static void generator_main(void *data)
+{
+    int rv;
+    av_refill_t *refill = NULL;
+    av_entry_t *entry = NULL;
+    char imsi_bcd[OGS_MAX_IMSI_BCD_LEN+1];
+    uint64_t generation;
+    ogs_time_t now;
+    hss_av_t av;
+
+    for ( ;; ) {
+        ogs_thread_mutex_lock(&self.mutex);
+        while (!self.terminated && !ogs_list_first(&self.refill_list))
+            ogs_thread_cond_wait(&self.cond, &self.mutex);
+
+        if (self.terminated) {
+            ogs_thread_mutex_unlock(&self.mutex);
+            break;
+        }
+
+        now = ogs_get_monotonic_time();
+        if (now < self.busy_until) {
+            ogs_thread_cond_timedwait(
+                    &self.cond, &self.mutex, self.busy_until - now);
+            ogs_thread_mutex_unlock(&self.mutex);
+            continue;
+        }
+
+        /* One vector at a time, round-robin between the subscribers */
+        refill = ogs_list_first(&self.refill_list);
+        ogs_list_remove(&self.refill_list, refill);
+        ogs_list_add(&self.refill_list, refill);
+
+        entry = refill->entry;
+        ogs_cpystrn(imsi_bcd, entry->imsi_bcd, sizeof(imsi_bcd));
+        generation = entry->generation;
+        ogs_thread_mutex_unlock(&self.mutex);
+
+        rv = generate(imsi_bcd, &av);
+
+        ogs_thread_mutex_lock(&self.mutex);
+        entry = ogs_hash_get(self.imsi_hash, imsi_bcd, OGS_HASH_KEY_STRING);
+        if (entry && entry->generation == generation) {
+            if (rv == OGS_OK)
+                entry_push(entry, &av);
+            else
+                refill_remove(entry);
+
+            if (entry->num_of_av >= self.num_of_av)
+                refill_remove(entry);
+        }
+        ogs_thread_mutex_unlock(&self.mutex);
+    }
+}
+
+void hss_av_generate(ogs_dbi_auth_info_t *auth_info, hss_av_t *av)
+{
+    uint8_t opc[OGS_KEY_LEN];
+    uint8_t sqn[OGS_SQN_LEN];
+
+    ogs_assert(auth_info);
+    ogs_assert(av);
+
+    if (auth_info->use_opc)
+        memcpy(opc, auth_info->opc, sizeof(opc));
+    else
+        milenage_opc(auth_info->k, auth_info->op, opc);
+
+    memset(av, 0, sizeof(*av));
+    av->sqn = auth_info->sqn;
+    memcpy(av->rand, auth_info->rand, OGS_RAND_LEN);
+    av->xres_len = 8;
+
+    milenage_generate(opc, auth_info->amf, auth_info->k,
+        ogs_uint64_to_buffer(av->sqn, OGS_SQN_LEN, sqn), av->rand,
+        av->autn, av->ik, av->ck, av->ak, av->xres, &av->xres_len);
+}
+
+int hss_av_pool_pop(char *imsi_bcd, hss_av_t *av)
+{
+    av_entry_t *entry = NULL;
+    int rv = OGS_ERROR;
+
+    ogs_assert(imsi_bcd);
+    ogs_assert(av);
+
+    if (!self.num_of_av)
+        return OGS_ERROR;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    if (!self.watching)
+        goto out;
+
+    entry = entry_find(imsi_bcd);
+    if (!entry)
+        goto out;
+
+    while (entry->num_of_av) {
+        memcpy(av, &entry->av[0], sizeof(*av));
+        entry->num_of_av--;
+        memmove(&entry->av[0], &entry->av[1],
+                entry->num_of_av * sizeof(hss_av_t));
+
+        /* An SQN at or below the last one would be rejected by the USIM */
+        if (av->sqn > entry->last_sqn) {
+            entry->last_sqn = av->sqn;
+            rv = OGS_OK;
+            break;
+        }
+    }
+
+    refill_add(entry);
+
+out:
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return rv;
+}
+
+void hss_av_pool_refill(char *imsi_bcd, uint64_t sqn)
+{
+    av_entry_t *entry = NULL;
+    int i;
+
+    ogs_assert(imsi_bcd);
+
+    if (!self.num_of_av)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    if (!self.watching) {
+        ogs_thread_mutex_unlock(&self.mutex);
+        return;
+    }
+
+    entry = entry_find_or_add(imsi_bcd);
+    entry->last_sqn = sqn;
+
+    for (i = 0; i < entry->num_of_av; i++)
+        if (entry->av[i].sqn > sqn)
+            break;
+    entry->num_of_av -= i;
+    memmove(&entry->av[0], &entry->av[i],
+            entry->num_of_av * sizeof(hss_av_t));
+
+    self.busy_until =
+        ogs_get_monotonic_time() + ogs_time_from_msec(IDLE_MSEC);
+
+    refill_add(entry);
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void hss_av_pool_flush(char *imsi_bcd)
+{
+    av_entry_t *entry = NULL;
+
+    ogs_assert(imsi_bcd);
+
+    if (!self.num_of_av)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.imsi_hash, imsi_bcd, OGS_HASH_KEY_STRING);
+    if (entry) {
+        /* A vector being generated is discarded as well */
+        entry->generation = ++self.generation;
+        entry->num_of_av = 0;
+        refill_remove(entry);
+    }
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void hss_av_pool_flush_all(void)
+{
+    av_entry_t *entry = NULL, *next_entry = NULL;
+
+    if (!self.num_of_av)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+        entry_remove(entry);
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void hss_av_pool_watch(bool watching)
+{
+    av_entry_t *entry = NULL, *next_entry = NULL;
+
+    if (!self.num_of_av)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    if (self.watching && !watching) {
+        ogs_warn("Authentication vector pool is disabled, "
+                "database changes can no longer be seen");
+        ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+            entry_remove(entry);
+    }
+    self.watching = watching;
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+int hss_av_pool_init(int num_of_av, int capacity)
+{
+    memset(&self, 0, sizeof(self));
+
+    if (num_of_av <= 0)
+        return OGS_OK;
+
+    ogs_assert(capacity > 0);
+
+    /* A pooled vector would outlive a change of K, OPc or AMF */
+    if (!ogs_app()->use_mongodb_change_stream) {
+        ogs_warn("Authentication vector pool is disabled, "
+                "it needs the MongoDB change stream");
+        return OGS_OK;
+    }
+
+    if (num_of_av > MAX_NUM_OF_AV) {
+        ogs_warn("Authentication vector pool is limited to %d vectors",
+                MAX_NUM_OF_AV);
+        num_of_av = MAX_NUM_OF_AV;
+    }
+
+    ogs_thread_mutex_init(&self.mutex);
+    ogs_thread_cond_init(&self.cond);
+    ogs_list_init(&self.lru_list);
+    ogs_list_init(&self.refill_list);
+
+    self.imsi_hash = ogs_hash_make();
+    ogs_assert(self.imsi_hash);
+
+    ogs_pool_init(&av_entry_pool, capacity);
+    ogs_pool_init(&av_refill_pool, capacity);
+
+    self.num_of_av = num_of_av;
+
+    self.thread = ogs_thread_create(generator_main, NULL);
+    if (!self.thread) {
+        ogs_error("ogs_thread_create() failed");
+        return OGS_ERROR;
+    }
+
+    ogs_info("Authentication vector pool: %d vectors, %d subscribers",
+            num_of_av, capacity);
+
+    return OGS_OK;
+}
+
+void hss_av_pool_final(void)
+{
+    av_entry_t *entry = NULL, *next_entry = NULL;
+
+    if (!self.num_of_av)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+    self.terminated = true;
+    ogs_thread_cond_signal(&self.cond);
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    if (self.thread)
+        ogs_thread_destroy(self.thread);
+
+    ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+        entry_remove(entry);
+
+    ogs_pool_final(&av_refill_pool);
+    ogs_pool_final(&av_entry_pool);
+    ogs_hash_destroy(self.imsi_hash);
+
+    ogs_thread_cond_destroy(&self.cond);
+    ogs_thread_mutex_destroy(&self.mutex);
+
+    self.num_of_av = 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HSS_AV_POOL_H
+#define HSS_AV_POOL_H
+
+#include "ogs-crypt.h"
+
+#include "hss-context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Authentication Vector Pool
+ *
+ * Keeps up to 'num_of_av' vectors ready for each subscriber
+ * which was recently authenticated over S6a. A background thread
+ * refills the pools once no vector has been generated inline
+ * for a while, so an AIR answered from the pool neither touches
+ * the database nor runs Milenage. KASME depends on the serving network,
+ * and is still derived for each request.
+ *
+ * The SQN of each vector is taken from the database like an AIR does.
+ * Vectors are handed out in SQN order, and a vector whose SQN is not above
+ * the last one handed out is discarded. Re-synchronization, an SQN taken
+ * by Cx/SWx, or a change of the keys in the database flushes the pool.
+ *
+ * Database changes are only seen through the MongoDB change stream,
+ * so vectors are pooled only while hss_av_pool_watch() reports
+ * the change stream as working.
+ */
+typedef struct hss_av_s {
+    uint64_t sqn;
+    uint8_t rand[OGS_RAND_LEN];
+    uint8_t autn[OGS_AUTN_LEN];
+    uint8_t ik[OGS_KEY_LEN];
+    uint8_t ck[OGS_KEY_LEN];
+    uint8_t ak[OGS_AK_LEN];
+    uint8_t xres[OGS_MAX_RES_LEN];
+    size_t xres_len;
+} hss_av_t;
+
+int hss_av_pool_init(int num_of_av, int capacity);
+void hss_av_pool_final(void);
+
+void hss_av_generate(ogs_dbi_auth_info_t *auth_info, hss_av_t *av);
+
+int hss_av_pool_pop(char *imsi_bcd, hss_av_t *av);
+void hss_av_pool_refill(char *imsi_bcd, uint64_t sqn);
+void hss_av_pool_flush(char *imsi_bcd);
+void hss_av_pool_flush_all(void);
+void hss_av_pool_watch(bool watching);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HSS_AV_POOL_H */
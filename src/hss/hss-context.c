@@ -21,6 +21,7 @@
 #include "hss-context.h"
 #include "hss-event.h"
 #include "hss-s6a-path.h"
+#include "hss-av-pool.h"
 
 
 typedef struct hss_impi_s hss_impi_t;
@@ -110,7 +111,6 @@ void hss_context_init(void)
     self.impu_hash = ogs_hash_make();
     ogs_assert(self.impu_hash);
 
-    ogs_thread_mutex_init(&self.db_lock);
     ogs_thread_mutex_init(&self.cx_lock);
 
     context_initialized = 1;
@@ -134,7 +134,6 @@ void hss_context_final(void)
     ogs_pool_final(&impi_pool);
     ogs_pool_final(&impu_pool);
 
-    ogs_thread_mutex_destroy(&self.db_lock);
     ogs_thread_mutex_destroy(&self.cx_lock);
 
     context_initialized = 0;
@@ -329,6 +328,9 @@ int hss_context_parse_config(void)
                 } else if (!strcmp(hss_key, "sms_over_ims")) {
                             self.sms_over_ims = 
                                 ogs_yaml_iter_value(&hss_iter);
+                } else if (!strcmp(hss_key, "av_pool")) {
+                    const char *v = ogs_yaml_iter_value(&hss_iter);
+                    if (v) self.av_pool = atoi(v);
                 } else
                     ogs_warn("unknown key `%s`", hss_key);
             }
@@ -349,14 +351,12 @@ int hss_db_auth_info(char *imsi_bcd, ogs_dbi_auth_info_t *auth_info)
     ogs_assert(imsi_bcd);
     ogs_assert(auth_info);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_auth_info(supi, auth_info);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -368,14 +368,12 @@ int hss_db_update_sqn(char *imsi_bcd, uint8_t *rand, uint64_t sqn)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_sqn(supi, sqn);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -387,14 +385,12 @@ int hss_db_update_imeisv(char *imsi_bcd, char *imeisv)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_imeisv(supi, imeisv);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -407,14 +403,12 @@ int hss_db_update_mme(char *imsi_bcd, char *mme_host, char *mme_realm,
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_mme(supi, mme_host, mme_realm, purge_flag);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -426,14 +420,12 @@ int hss_db_increment_sqn(char *imsi_bcd)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_increment_sqn(supi);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -447,14 +439,12 @@ int hss_db_subscription_data(
     ogs_assert(imsi_bcd);
     ogs_assert(subscription_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_subscription_data(supi, subscription_data);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -466,12 +456,8 @@ int hss_db_msisdn_data(char *imsi_or_msisdn_bcd, ogs_msisdn_data_t *msisdn_data)
     ogs_assert(imsi_or_msisdn_bcd);
     ogs_assert(msisdn_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
-
     rv = ogs_dbi_msisdn_data(imsi_or_msisdn_bcd, msisdn_data);
 
-    ogs_thread_mutex_unlock(&self.db_lock);
-
     return rv;
 }
 
@@ -483,14 +469,12 @@ int hss_db_ims_data(char *imsi_bcd, ogs_ims_data_t *ims_data)
     ogs_assert(imsi_bcd);
     ogs_assert(ims_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_ims_data(supi, ims_data);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
 
     return rv;
 }
@@ -1179,11 +1163,10 @@ int hss_db_poll_change_stream(void)
 {
     int rv;
 
-    ogs_thread_mutex_lock(&self.db_lock);
-
     rv = ogs_dbi_poll_change_stream();
-
-    ogs_thread_mutex_unlock(&self.db_lock);
+    if (rv != OGS_OK)
+        /* Changes may be missed from now on */
+        hss_av_pool_watch(false);
 
     return rv;
 }
@@ -1197,6 +1180,7 @@ int hss_handle_change_event(const bson_t *document)
 
     bool send_clr_flag = false;
     bool send_idr_flag = false;
+    bool flush_av_flag = false;
     uint32_t subdatamask = 0;
 
     char *imsi_bcd = NULL;
@@ -1209,6 +1193,8 @@ int hss_handle_change_event(const bson_t *document)
     ogs_debug("Received change stream document.");
 #endif
     if (!bson_iter_init_find(&iter, document, "fullDocument")) {
+        /* Deleted subscriber */
+        hss_av_pool_flush_all();
         ogs_error("No 'imsi' field in this document.");
         return OGS_ERROR;
     } else {
@@ -1273,14 +1259,24 @@ int hss_handle_change_event(const bson_t *document)
                         send_idr_flag = true;
                         subdatamask = (subdatamask | 
                             OGS_DIAM_S6A_SUBDATA_APN_CONFIG);
+                    } else if (!strncmp(child2_key,
+                            "security", strlen("security")) &&
+                            strcmp(child2_key, "security.sqn") &&
+                            strcmp(child2_key, "security.rand")) {
+                        /* SQN is written by every vector, keys are not */
+                        flush_av_flag = true;
                     }
                 }
             }
         }
     } else {
         ogs_debug("No 'updateDescription' field in this document");
+        flush_av_flag = true;
     }
 
+    if (flush_av_flag)
+        hss_av_pool_flush(imsi_bcd);
+
     if (send_clr_flag) {
         ogs_info("[%s] Cancel Location Requested", imsi_bcd);
         hss_s6a_send_clr(imsi_bcd, NULL, NULL,
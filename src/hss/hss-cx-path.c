@@ -21,6 +21,7 @@
 
 #include "hss-context.h"
 #include "hss-fd-path.h"
+#include "hss-av-pool.h"
 
 /* handler for fallback cb */
 static struct disp_hdl *hdl_cx_fb = NULL;
@@ -406,6 +407,9 @@ static int hss_ogs_diam_cx_mar_cb( struct msg **msg, struct avp *avp,
         goto out;
     }
 
+    /* Pre-computed S6a vectors are behind this SQN */
+    hss_av_pool_flush(imsi_bcd);
+
     milenage_generate(opc, auth_info.amf, auth_info.k,
         ogs_uint64_to_buffer(auth_info.sqn, OGS_SQN_LEN, sqn), auth_info.rand,
         autn, ik, ck, ak, xres, &xres_len);
@@ -20,6 +20,7 @@
 #include "hss-context.h"
 #include "hss-fd-path.h"
 #include "hss-sm.h"
+#include "hss-av-pool.h"
 
 
 static ogs_thread_t *thread;
@@ -43,6 +44,9 @@ int hss_initialize(void)
     rv = ogs_dbi_init(ogs_app()->db_uri);
     if (rv != OGS_OK) return rv;
 
+    rv = hss_av_pool_init(hss_self()->av_pool, ogs_app()->max.ue);
+    if (rv != OGS_OK) return rv;
+
     rv = hss_fd_init();
     if (rv != OGS_OK) return OGS_ERROR;
 
@@ -63,6 +67,7 @@ void hss_terminate(void)
 
     hss_fd_final();
 
+    hss_av_pool_final();
     ogs_dbi_final();
     hss_context_final();
 
@@ -94,9 +99,11 @@ static void hss_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            ogs_event_t *e = NULL;
+            ogs_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -105,9 +112,11 @@ static void hss_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&hss_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&hss_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
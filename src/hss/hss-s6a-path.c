@@ -22,6 +22,7 @@
 #include "hss-context.h"
 #include "hss-fd-path.h"
 #include "hss-s6a-path.h"
+#include "hss-av-pool.h"
 
 /* handler for fallback cb */
 static struct disp_hdl *hdl_s6a_fb = NULL;
@@ -77,17 +78,12 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
     char imsi_bcd[OGS_MAX_IMSI_BCD_LEN+1];
     uint8_t opc[OGS_KEY_LEN];
     uint8_t sqn[OGS_SQN_LEN];
-    uint8_t autn[OGS_AUTN_LEN];
-    uint8_t ik[OGS_KEY_LEN];
-    uint8_t ck[OGS_KEY_LEN];
-    uint8_t ak[OGS_AK_LEN];
-    uint8_t xres[OGS_MAX_RES_LEN];
     uint8_t kasme[OGS_SHA256_DIGEST_SIZE];
-    size_t xres_len = 8;
 
     uint8_t mac_s[OGS_MAC_S_LEN];
 
     ogs_dbi_auth_info_t auth_info;
+    hss_av_t av;
     uint8_t zero[OGS_RAND_LEN];
     int rv;
     uint32_t result_code = 0;
@@ -111,6 +107,19 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
     ogs_cpystrn(imsi_bcd, (char*)hdr->avp_value->os.data,
         ogs_min(hdr->avp_value->os.len, OGS_MAX_IMSI_BCD_LEN)+1);
 
+    ret = fd_msg_search_avp(qry, ogs_diam_s6a_req_eutran_auth_info, &avp);
+    ogs_assert(ret == 0);
+    avpch = NULL;
+    if (avp) {
+        ret = fd_avp_search_avp(
+                avp, ogs_diam_s6a_re_synchronization_info, &avpch);
+        ogs_assert(ret == 0);
+    }
+
+    /* Pre-computed vector */
+    if (!avpch && hss_av_pool_pop(imsi_bcd, &av) == OGS_OK)
+        goto vector;
+
     rv = hss_db_auth_info(imsi_bcd, &auth_info);
     if (rv != OGS_OK) {
         result_code = OGS_DIAM_S6A_ERROR_USER_UNKNOWN;
@@ -127,38 +136,34 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
     else
         milenage_opc(auth_info.k, auth_info.op, opc);
 
-    ret = fd_msg_search_avp(qry, ogs_diam_s6a_req_eutran_auth_info, &avp);
-    ogs_assert(ret == 0);
-    if (avp) {
-        ret = fd_avp_search_avp(
-                avp, ogs_diam_s6a_re_synchronization_info, &avpch);
+    if (avpch) {
+        ret = fd_msg_avp_hdr(avpch, &hdr);
         ogs_assert(ret == 0);
-        if (avpch) {
-            ret = fd_msg_avp_hdr(avpch, &hdr);
-            ogs_assert(ret == 0);
-            ogs_auc_sqn(opc, auth_info.k,
-                    hdr->avp_value->os.data,
-                    hdr->avp_value->os.data + OGS_RAND_LEN,
-                    sqn, mac_s);
-            if (memcmp(mac_s, hdr->avp_value->os.data +
-                        OGS_RAND_LEN + OGS_SQN_LEN, OGS_MAC_S_LEN) == 0) {
-                ogs_random(auth_info.rand, OGS_RAND_LEN);
-                auth_info.sqn = ogs_buffer_to_uint64(sqn, OGS_SQN_LEN);
-                /* 33.102 C.3.4 Guide : IND + 1 */
-                auth_info.sqn = (auth_info.sqn + 32 + 1) & OGS_MAX_SQN;
-            } else {
-                ogs_error("Re-synch MAC failed for IMSI:`%s`", imsi_bcd);
-                ogs_log_print(OGS_LOG_ERROR, "MAC_S: ");
-                ogs_log_hexdump(OGS_LOG_ERROR, mac_s, OGS_MAC_S_LEN);
-                ogs_log_hexdump(OGS_LOG_ERROR,
-                    (void*)(hdr->avp_value->os.data +
-                        OGS_RAND_LEN + OGS_SQN_LEN),
-                    OGS_MAC_S_LEN);
-                ogs_log_print(OGS_LOG_ERROR, "SQN: ");
-                ogs_log_hexdump(OGS_LOG_ERROR, sqn, OGS_SQN_LEN);
-                result_code = OGS_DIAM_S6A_AUTHENTICATION_DATA_UNAVAILABLE;
-                goto out;
-            }
+        ogs_auc_sqn(opc, auth_info.k,
+                hdr->avp_value->os.data,
+                hdr->avp_value->os.data + OGS_RAND_LEN,
+                sqn, mac_s);
+        if (memcmp(mac_s, hdr->avp_value->os.data +
+                    OGS_RAND_LEN + OGS_SQN_LEN, OGS_MAC_S_LEN) == 0) {
+            ogs_random(auth_info.rand, OGS_RAND_LEN);
+            auth_info.sqn = ogs_buffer_to_uint64(sqn, OGS_SQN_LEN);
+            /* 33.102 C.3.4 Guide : IND + 1 */
+            auth_info.sqn = (auth_info.sqn + 32 + 1) & OGS_MAX_SQN;
+
+            /* Pre-computed vectors follow the SQN rejected by the USIM */
+            hss_av_pool_flush(imsi_bcd);
+        } else {
+            ogs_error("Re-synch MAC failed for IMSI:`%s`", imsi_bcd);
+            ogs_log_print(OGS_LOG_ERROR, "MAC_S: ");
+            ogs_log_hexdump(OGS_LOG_ERROR, mac_s, OGS_MAC_S_LEN);
+            ogs_log_hexdump(OGS_LOG_ERROR,
+                (void*)(hdr->avp_value->os.data +
+                    OGS_RAND_LEN + OGS_SQN_LEN),
+                OGS_MAC_S_LEN);
+            ogs_log_print(OGS_LOG_ERROR, "SQN: ");
+            ogs_log_hexdump(OGS_LOG_ERROR, sqn, OGS_SQN_LEN);
+            result_code = OGS_DIAM_S6A_AUTHENTICATION_DATA_UNAVAILABLE;
+            goto out;
         }
     }
 
@@ -176,16 +181,18 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
         goto out;
     }
 
+    hss_av_generate(&auth_info, &av);
+    hss_av_pool_refill(imsi_bcd, av.sqn);
+
+vector:
     ret = fd_msg_search_avp(qry, ogs_diam_visited_plmn_id, &avp);
     ogs_assert(ret == 0);
     ret = fd_msg_avp_hdr(avp, &hdr);
     ogs_assert(ret == 0);
     memcpy(&visited_plmn_id, hdr->avp_value->os.data, hdr->avp_value->os.len);
 
-    milenage_generate(opc, auth_info.amf, auth_info.k,
-        ogs_uint64_to_buffer(auth_info.sqn, OGS_SQN_LEN, sqn), auth_info.rand,
-        autn, ik, ck, ak, xres, &xres_len);
-    ogs_auc_kasme(ck, ik, hdr->avp_value->os.data, sqn, ak, kasme);
+    ogs_auc_kasme(av.ck, av.ik, hdr->avp_value->os.data,
+        ogs_uint64_to_buffer(av.sqn, OGS_SQN_LEN, sqn), av.ak, kasme);
 
     /* Set the Authentication-Info */
     ret = fd_msg_avp_new(ogs_diam_s6a_authentication_info, 0, &avp);
@@ -195,7 +202,7 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
 
     ret = fd_msg_avp_new(ogs_diam_s6a_rand, 0, &avp_rand);
     ogs_assert(ret == 0);
-    val.os.data = auth_info.rand;
+    val.os.data = av.rand;
     val.os.len = OGS_KEY_LEN;
     ret = fd_msg_avp_setvalue(avp_rand, &val);
     ogs_assert(ret == 0);
@@ -204,8 +211,8 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
 
     ret = fd_msg_avp_new(ogs_diam_s6a_xres, 0, &avp_xres);
     ogs_assert(ret == 0);
-    val.os.data = xres;
-    val.os.len = xres_len;
+    val.os.data = av.xres;
+    val.os.len = av.xres_len;
     ret = fd_msg_avp_setvalue(avp_xres, &val);
     ogs_assert(ret == 0);
     ret = fd_msg_avp_add(avp_e_utran_vector, MSG_BRW_LAST_CHILD, avp_xres);
@@ -213,7 +220,7 @@ static int hss_ogs_diam_s6a_air_cb( struct msg **msg, struct avp *avp,
 
     ret = fd_msg_avp_new(ogs_diam_s6a_autn, 0, &avp_autn);
     ogs_assert(ret == 0);
-    val.os.data = autn;
+    val.os.data = av.autn;
     val.os.len = OGS_AUTN_LEN;
     ret = fd_msg_avp_setvalue(avp_autn, &val);
     ogs_assert(ret == 0);
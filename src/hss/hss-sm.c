@@ -20,6 +20,7 @@
 #include "hss-sm.h"
 #include "hss-context.h"
 #include "hss-event.h"
+#include "hss-av-pool.h"
 
 #define DB_POLLING_TIME ogs_time_from_msec(100)
 
@@ -33,7 +34,8 @@ void hss_state_initial(ogs_fsm_t *s, ogs_event_t *e)
 
 #if MONGOC_MAJOR_VERSION >= 1 && MONGOC_MINOR_VERSION >= 9
     if (ogs_app()->use_mongodb_change_stream) {
-        ogs_dbi_collection_watch_init();
+        if (ogs_dbi_collection_watch_init() == OGS_OK)
+            hss_av_pool_watch(true);
 
         t_db_polling = ogs_timer_add(ogs_app()->timer_mgr,
                 ogs_timer_dbi_poll_change_stream, 0);
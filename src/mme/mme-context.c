@@ -122,12 +122,14 @@ void mme_context_init(void)
     ogs_assert(self.enb_addr_hash);
     self.enb_id_hash = ogs_hash_make();
     ogs_assert(self.enb_id_hash);
-    self.imsi_ue_hash = ogs_hash_make();
+    self.imsi_ue_hash = ogs_hmap_create();
     ogs_assert(self.imsi_ue_hash);
-    self.guti_ue_hash = ogs_hash_make();
+    self.guti_ue_hash = ogs_hmap_create();
     ogs_assert(self.guti_ue_hash);
-    self.mme_s11_teid_hash = ogs_hash_make();
+    self.mme_s11_teid_hash = ogs_hmap_create();
     ogs_assert(self.mme_s11_teid_hash);
+    self.tai_enb_hash = ogs_hmap_create();
+    ogs_assert(self.tai_enb_hash);
 
     ogs_list_init(&self.mme_ue_list);
 
@@ -153,11 +155,13 @@ void mme_context_final(void)
     ogs_hash_destroy(self.enb_id_hash);
 
     ogs_assert(self.imsi_ue_hash);
-    ogs_hash_destroy(self.imsi_ue_hash);
+    ogs_hmap_destroy(self.imsi_ue_hash);
     ogs_assert(self.guti_ue_hash);
-    ogs_hash_destroy(self.guti_ue_hash);
+    ogs_hmap_destroy(self.guti_ue_hash);
     ogs_assert(self.mme_s11_teid_hash);
-    ogs_hash_destroy(self.mme_s11_teid_hash);
+    ogs_hmap_destroy(self.mme_s11_teid_hash);
+    ogs_assert(self.tai_enb_hash);
+    ogs_hmap_destroy(self.tai_enb_hash);
 
     ogs_pool_final(&m_tmsi_pool);
     ogs_pool_final(&mme_bearer_pool);
@@ -2535,6 +2539,8 @@ mme_enb_t *mme_enb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
     enb->ostream_id = 0;
 
     ogs_list_init(&enb->enb_ue_list);
+    enb->enb_ue_hash = ogs_hmap_create();
+    ogs_assert(enb->enb_ue_hash);
 
     ogs_hash_set(self.enb_addr_hash,
             enb->sctp.addr, sizeof(ogs_sockaddr_t), enb);
@@ -2555,6 +2561,7 @@ mme_enb_t *mme_enb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
 int mme_enb_remove(mme_enb_t *enb)
 {
     mme_event_t e;
+    enb_ue_t *enb_ue = NULL;
 
     ogs_assert(enb);
     ogs_assert(enb->sctp.sock);
@@ -2568,6 +2575,18 @@ int mme_enb_remove(mme_enb_t *enb)
     ogs_hash_set(self.enb_addr_hash,
             enb->sctp.addr, sizeof(ogs_sockaddr_t), NULL);
     ogs_hash_set(self.enb_id_hash, &enb->enb_id, sizeof(enb->enb_id), NULL);
+    mme_enb_tai_hash_clear(enb);
+
+    /*
+     * An eNB UE with a pending transaction may outlive its eNB.
+     * It is no longer indexed, see enb_ue_hash_clear().
+     */
+    ogs_list_for_each(&enb->enb_ue_list, enb_ue) {
+        enb_ue->enb_ue_s1ap_id_shadowed = false;
+        enb_ue->num_of_shadowed = 0;
+    }
+    ogs_hmap_destroy(enb->enb_ue_hash);
+    enb->enb_ue_hash = NULL;
 
     /*
      * CHECK:
@@ -2622,6 +2641,97 @@ int mme_enb_set_enb_id(mme_enb_t *enb, uint32_t enb_id)
     return OGS_OK;
 }
 
+static void tai_enb_add(ogs_eps_tai_t *tai, mme_enb_t *enb)
+{
+    mme_tai_enb_t *tai_enb = NULL;
+    int i;
+
+    tai_enb = ogs_hmap_get(self.tai_enb_hash, tai, sizeof(*tai));
+    if (!tai_enb) {
+        tai_enb = ogs_calloc(1, sizeof(*tai_enb));
+        ogs_assert(tai_enb);
+        memcpy(&tai_enb->tai, tai, sizeof(tai_enb->tai));
+        ogs_hmap_set(self.tai_enb_hash,
+                &tai_enb->tai, sizeof(tai_enb->tai), tai_enb);
+    }
+
+    for (i = 0; i < tai_enb->num_of_enb; i++)
+        if (tai_enb->enb[i] == enb)
+            return;
+
+    if (tai_enb->num_of_enb == tai_enb->max_num_of_enb) {
+        tai_enb->max_num_of_enb =
+            tai_enb->max_num_of_enb ? tai_enb->max_num_of_enb * 2 : 4;
+        tai_enb->enb = ogs_realloc(tai_enb->enb,
+                tai_enb->max_num_of_enb * sizeof(mme_enb_t *));
+        ogs_assert(tai_enb->enb);
+    }
+    tai_enb->enb[tai_enb->num_of_enb++] = enb;
+}
+
+static void tai_enb_remove(ogs_eps_tai_t *tai, mme_enb_t *enb)
+{
+    mme_tai_enb_t *tai_enb = NULL;
+    int i;
+
+    tai_enb = ogs_hmap_get(self.tai_enb_hash, tai, sizeof(*tai));
+    if (!tai_enb)
+        return;
+
+    for (i = 0; i < tai_enb->num_of_enb; i++) {
+        if (tai_enb->enb[i] == enb) {
+            tai_enb->enb[i] = tai_enb->enb[--tai_enb->num_of_enb];
+            break;
+        }
+    }
+
+    if (tai_enb->num_of_enb == 0) {
+        ogs_hmap_set(self.tai_enb_hash,
+                &tai_enb->tai, sizeof(tai_enb->tai), NULL);
+        if (tai_enb->enb)
+            ogs_free(tai_enb->enb);
+        ogs_free(tai_enb);
+    }
+}
+
+/*
+ * Index the eNB by every TAI of its Supported TAs,
+ * so that Paging does not have to scan all eNBs.
+ */
+void mme_enb_tai_hash_set(mme_enb_t *enb)
+{
+    int i;
+
+    ogs_assert(enb);
+
+    mme_enb_tai_hash_clear(enb);
+
+    for (i = 0; i < enb->num_of_supported_ta_list; i++) {
+        memcpy(&enb->paging_tai[i],
+                &enb->supported_ta_list[i], sizeof(ogs_eps_tai_t));
+        tai_enb_add(&enb->paging_tai[i], enb);
+    }
+    enb->num_of_paging_tai = enb->num_of_supported_ta_list;
+}
+
+void mme_enb_tai_hash_clear(mme_enb_t *enb)
+{
+    int i;
+
+    ogs_assert(enb);
+
+    for (i = 0; i < enb->num_of_paging_tai; i++)
+        tai_enb_remove(&enb->paging_tai[i], enb);
+
+    enb->num_of_paging_tai = 0;
+}
+
+mme_tai_enb_t *mme_tai_enb_find(ogs_eps_tai_t *tai)
+{
+    ogs_assert(tai);
+    return ogs_hmap_get(self.tai_enb_hash, tai, sizeof(*tai));
+}
+
 int mme_enb_sock_type(ogs_sock_t *sock)
 {
     ogs_socknode_t *snode = NULL;
@@ -2643,6 +2753,75 @@ mme_enb_t *mme_enb_cycle(mme_enb_t *enb)
 }
 
 /** enb_ue_context handling function */
+static void enb_ue_hash_set(enb_ue_t *enb_ue)
+{
+    mme_enb_t *enb = enb_ue->enb;
+    enb_ue_t *old_enb_ue = NULL;
+
+    if (!enb->enb_ue_hash)
+        return;
+    if (enb_ue->enb_ue_s1ap_id == INVALID_UE_S1AP_ID)
+        return;
+
+    /*
+     * The eNB reused the ID while an older UE still holds it.
+     * As with the scan of enb_ue_list, the older UE is found first,
+     * and the newer one is indexed once the older one is gone.
+     */
+    old_enb_ue = ogs_hmap_get_u32(enb->enb_ue_hash, enb_ue->enb_ue_s1ap_id);
+    if (old_enb_ue && old_enb_ue != enb_ue) {
+        ogs_warn("Duplicated ENB_UE_S1AP_ID[%d] in eNB[%d]",
+                enb_ue->enb_ue_s1ap_id, enb->enb_id);
+        enb_ue->enb_ue_s1ap_id_shadowed = true;
+        old_enb_ue->num_of_shadowed++;
+        return;
+    }
+
+    ogs_hmap_set_u32(enb->enb_ue_hash, enb_ue->enb_ue_s1ap_id, enb_ue);
+}
+
+static void enb_ue_hash_clear(enb_ue_t *enb_ue)
+{
+    mme_enb_t *enb = enb_ue->enb;
+    enb_ue_t *old_enb_ue = NULL, *new_enb_ue = NULL;
+
+    if (!enb->enb_ue_hash)
+        return;
+    if (enb_ue->enb_ue_s1ap_id == INVALID_UE_S1AP_ID)
+        return;
+
+    old_enb_ue = ogs_hmap_get_u32(enb->enb_ue_hash, enb_ue->enb_ue_s1ap_id);
+
+    if (enb_ue->enb_ue_s1ap_id_shadowed) {
+        enb_ue->enb_ue_s1ap_id_shadowed = false;
+        ogs_assert(old_enb_ue);
+        ogs_assert(old_enb_ue->num_of_shadowed > 0);
+        old_enb_ue->num_of_shadowed--;
+        return;
+    }
+
+    if (old_enb_ue != enb_ue)
+        return;
+
+    ogs_hmap_set_u32(enb->enb_ue_hash, enb_ue->enb_ue_s1ap_id, NULL);
+
+    if (!enb_ue->num_of_shadowed)
+        return;
+
+    /* The oldest of the newer UEs takes over the ID */
+    ogs_list_for_each(&enb->enb_ue_list, new_enb_ue) {
+        if (new_enb_ue->enb_ue_s1ap_id_shadowed &&
+            new_enb_ue->enb_ue_s1ap_id == enb_ue->enb_ue_s1ap_id) {
+            new_enb_ue->enb_ue_s1ap_id_shadowed = false;
+            new_enb_ue->num_of_shadowed = enb_ue->num_of_shadowed - 1;
+            ogs_hmap_set_u32(enb->enb_ue_hash,
+                    new_enb_ue->enb_ue_s1ap_id, new_enb_ue);
+            break;
+        }
+    }
+    enb_ue->num_of_shadowed = 0;
+}
+
 enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
 {
     enb_ue_t *enb_ue = NULL;
@@ -2684,6 +2863,7 @@ enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
     enb_ue->enb = enb;
 
     ogs_list_add(&enb->enb_ue_list, enb_ue);
+    enb_ue_hash_set(enb_ue);
 
     stats_add_enb_ue();
 
@@ -2699,6 +2879,7 @@ void enb_ue_remove(enb_ue_t *enb_ue)
     ogs_assert(enb);
 
     ogs_list_remove(&enb->enb_ue_list, enb_ue);
+    enb_ue_hash_clear(enb_ue);
 
     ogs_assert(enb_ue->t_s1_holding);
     ogs_timer_delete(enb_ue->t_s1_holding);
@@ -2716,25 +2897,33 @@ void enb_ue_switch_to_enb(enb_ue_t *enb_ue, mme_enb_t *new_enb)
 
     /* Remove from the old enb */
     ogs_list_remove(&enb_ue->enb->enb_ue_list, enb_ue);
+    enb_ue_hash_clear(enb_ue);
 
     /* Add to the new enb */
     ogs_list_add(&new_enb->enb_ue_list, enb_ue);
 
     /* Switch to enb */
     enb_ue->enb = new_enb;
+    enb_ue_hash_set(enb_ue);
+}
+
+void enb_ue_set_enb_ue_s1ap_id(enb_ue_t *enb_ue, uint32_t enb_ue_s1ap_id)
+{
+    ogs_assert(enb_ue);
+    ogs_assert(enb_ue->enb);
+
+    enb_ue_hash_clear(enb_ue);
+    enb_ue->enb_ue_s1ap_id = enb_ue_s1ap_id;
+    enb_ue_hash_set(enb_ue);
 }
 
 enb_ue_t *enb_ue_find_by_enb_ue_s1ap_id(
         mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
 {
-    enb_ue_t *enb_ue = NULL;
-
-    ogs_list_for_each(&enb->enb_ue_list, enb_ue) {
-        if (enb_ue_s1ap_id == enb_ue->enb_ue_s1ap_id)
-            break;
-    }
+    ogs_assert(enb);
+    ogs_assert(enb->enb_ue_hash);
 
-    return enb_ue;
+    return ogs_hmap_get_u32(enb->enb_ue_hash, enb_ue_s1ap_id);
 }
 
 enb_ue_t *enb_ue_find(uint32_t index)
@@ -2892,7 +3081,7 @@ void mme_ue_confirm_guti(mme_ue_t *mme_ue)
     if (mme_ue->current.m_tmsi) {
         /* MME has a VALID GUTI
          * As such, we need to remove previous GUTI in hash table */
-        ogs_hash_set(self.guti_ue_hash,
+        ogs_hmap_set(self.guti_ue_hash,
                 &mme_ue->current.guti, sizeof(ogs_nas_eps_guti_t), NULL);
         ogs_assert(mme_m_tmsi_free(mme_ue->current.m_tmsi) == OGS_OK);
     }
@@ -2903,7 +3092,7 @@ void mme_ue_confirm_guti(mme_ue_t *mme_ue)
             &mme_ue->next.guti, sizeof(ogs_nas_eps_guti_t));
 
     /* Hashing Current GUTI */
-    ogs_hash_set(self.guti_ue_hash,
+    ogs_hmap_set(self.guti_ue_hash,
             &mme_ue->current.guti, sizeof(ogs_nas_eps_guti_t), mme_ue);
 
     /* Clear Next GUTI */
@@ -3048,7 +3237,7 @@ mme_ue_t *mme_ue_add(enb_ue_t *enb_ue)
 
     mme_ue->mme_s11_teid = *(mme_ue->mme_s11_teid_node);
 
-    ogs_hash_set(self.mme_s11_teid_hash,
+    ogs_hmap_set(self.mme_s11_teid_hash,
             &mme_ue->mme_s11_teid, sizeof(mme_ue->mme_s11_teid), mme_ue);
 
     /*
@@ -3092,18 +3281,18 @@ void mme_ue_remove(mme_ue_t *mme_ue)
 
     mme_ue_fsm_fini(mme_ue);
 
-    ogs_hash_set(self.mme_s11_teid_hash,
+    ogs_hmap_set(self.mme_s11_teid_hash,
             &mme_ue->mme_s11_teid, sizeof(mme_ue->mme_s11_teid), NULL);
 
     ogs_assert(mme_ue->sgw_ue);
     sgw_ue_remove(mme_ue->sgw_ue);
 
     if (mme_ue->imsi_len != 0)
-        ogs_hash_set(mme_self()->imsi_ue_hash,
+        ogs_hmap_set(mme_self()->imsi_ue_hash,
                 mme_ue->imsi, mme_ue->imsi_len, NULL);
 
     if (mme_ue->current.m_tmsi) {
-        ogs_hash_set(self.guti_ue_hash,
+        ogs_hmap_set(self.guti_ue_hash,
                 &mme_ue->current.guti, sizeof(ogs_nas_eps_guti_t), NULL);
         ogs_assert(mme_m_tmsi_free(mme_ue->current.m_tmsi) == OGS_OK);
     }
@@ -3203,20 +3392,20 @@ mme_ue_t *mme_ue_find_by_imsi(uint8_t *imsi, int imsi_len)
 {
     ogs_assert(imsi && imsi_len);
 
-    return (mme_ue_t *)ogs_hash_get(self.imsi_ue_hash, imsi, imsi_len);
+    return (mme_ue_t *)ogs_hmap_get(self.imsi_ue_hash, imsi, imsi_len);
 }
 
 mme_ue_t *mme_ue_find_by_guti(ogs_nas_eps_guti_t *guti)
 {
     ogs_assert(guti);
 
-    return (mme_ue_t *)ogs_hash_get(
+    return (mme_ue_t *)ogs_hmap_get(
             self.guti_ue_hash, guti, sizeof(ogs_nas_eps_guti_t));
 }
 
 mme_ue_t *mme_ue_find_by_teid(uint32_t teid)
 {
-    return ogs_hash_get(self.mme_s11_teid_hash, &teid, sizeof(teid));
+    return ogs_hmap_get(self.mme_s11_teid_hash, &teid, sizeof(teid));
 }
 
 mme_ue_t *mme_ue_find_by_message(ogs_nas_eps_message_t *message)
@@ -3455,10 +3644,10 @@ int mme_ue_set_imsi(mme_ue_t *mme_ue, char *imsi_bcd)
     }
 
     if (mme_ue->imsi_len != 0)
-        ogs_hash_set(mme_self()->imsi_ue_hash,
+        ogs_hmap_set(mme_self()->imsi_ue_hash,
                 mme_ue->imsi, mme_ue->imsi_len, NULL);
 
-    ogs_hash_set(self.imsi_ue_hash, mme_ue->imsi, mme_ue->imsi_len, mme_ue);
+    ogs_hmap_set(self.imsi_ue_hash, mme_ue->imsi, mme_ue->imsi_len, mme_ue);
 
     return OGS_OK;
 }
@@ -152,10 +152,11 @@ typedef struct mme_context_s {
 
     ogs_hash_t *enb_addr_hash;  /* hash table for ENB Address */
     ogs_hash_t *enb_id_hash;    /* hash table for ENB-ID */
-    ogs_hash_t *imsi_ue_hash;   /* hash table (IMSI : MME_UE) */
-    ogs_hash_t *guti_ue_hash;   /* hash table (GUTI : MME_UE) */
+    ogs_hmap_t *imsi_ue_hash;   /* hash table (IMSI : MME_UE) */
+    ogs_hmap_t *guti_ue_hash;   /* hash table (GUTI : MME_UE) */
 
-    ogs_hash_t *mme_s11_teid_hash;  /* hash table (MME-S11-TEID : MME_UE) */
+    ogs_hmap_t *mme_s11_teid_hash;  /* hash table (MME-S11-TEID : MME_UE) */
+    ogs_hmap_t *tai_enb_hash;   /* hash table (TAI : eNBs for Paging) */
 
     struct {
         struct {
@@ -251,12 +252,25 @@ typedef struct mme_enb_s {
     int             num_of_supported_ta_list;
     ogs_eps_tai_t   supported_ta_list[OGS_MAX_NUM_OF_TAI*OGS_MAX_NUM_OF_BPLMN];
 
+    /* TAIs under which this eNB is in mme_self()->tai_enb_hash */
+    int             num_of_paging_tai;
+    ogs_eps_tai_t   paging_tai[OGS_MAX_NUM_OF_TAI*OGS_MAX_NUM_OF_BPLMN];
+
     ogs_pkbuf_t     *s1_reset_ack; /* Reset message */
 
     ogs_list_t      enb_ue_list;
+    ogs_hmap_t      *enb_ue_hash;   /* hash table (ENB-UE-S1AP-ID : ENB_UE) */
 
 } mme_enb_t;
 
+typedef struct mme_tai_enb_s {
+    ogs_eps_tai_t   tai;            /* Key of mme_self()->tai_enb_hash */
+
+    int             num_of_enb;
+    int             max_num_of_enb;
+    mme_enb_t       **enb;
+} mme_tai_enb_t;
+
 struct enb_ue_s {
     ogs_lnode_t     lnode;
     uint32_t        index;
@@ -266,6 +280,13 @@ struct enb_ue_s {
     uint32_t        enb_ue_s1ap_id; /* eNB-UE-S1AP-ID received from eNB */
     uint32_t        mme_ue_s1ap_id; /* MME-UE-S1AP-ID received from MME */
 
+    /*
+     * An older UE of the eNB holds the same eNB-UE-S1AP-ID in enb_ue_hash.
+     * The indexed UE counts the newer ones that wait for the ID.
+     */
+    bool            enb_ue_s1ap_id_shadowed;
+    int             num_of_shadowed;
+
     uint16_t        enb_ostream_id; /* SCTP output stream id for eNB */
 
     /* Handover Info */
@@ -828,12 +849,16 @@ int mme_enb_remove_all(void);
 mme_enb_t *mme_enb_find_by_addr(ogs_sockaddr_t *addr);
 mme_enb_t *mme_enb_find_by_enb_id(uint32_t enb_id);
 int mme_enb_set_enb_id(mme_enb_t *enb, uint32_t enb_id);
+void mme_enb_tai_hash_set(mme_enb_t *enb);
+void mme_enb_tai_hash_clear(mme_enb_t *enb);
+mme_tai_enb_t *mme_tai_enb_find(ogs_eps_tai_t *tai);
 int mme_enb_sock_type(ogs_sock_t *sock);
 mme_enb_t *mme_enb_cycle(mme_enb_t *enb);
 
 enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id);
 void enb_ue_remove(enb_ue_t *enb_ue);
 void enb_ue_switch_to_enb(enb_ue_t *enb_ue, mme_enb_t *new_enb);
+void enb_ue_set_enb_ue_s1ap_id(enb_ue_t *enb_ue, uint32_t enb_ue_s1ap_id);
 enb_ue_t *enb_ue_find_by_enb_ue_s1ap_id(
         mme_enb_t *enb, uint32_t enb_ue_s1ap_id);
 enb_ue_t *enb_ue_find(uint32_t index);
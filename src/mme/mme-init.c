@@ -133,9 +133,11 @@ static void mme_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            mme_event_t *e = NULL;
+            mme_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -144,9 +146,11 @@ static void mme_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&mme_sm, e);
-            mme_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&mme_sm, e[i]);
+                mme_event_free(e[i]);
+            }
         }
     }
 done:
@@ -156,6 +156,7 @@ void s1ap_handle_s1_setup_request(mme_enb_t *enb, ogs_s1ap_message_t *message)
             enb->num_of_supported_ta_list++;
         }
     }
+    mme_enb_tai_hash_set(enb);
 
     if (maximum_number_of_enbs_is_reached()) {
         ogs_warn("S1-Setup failure:");
@@ -2229,7 +2230,7 @@ void s1ap_handle_path_switch_request(
             mme_ue->e_cgi.cell_id);
 
     /* Update ENB-UE-S1AP-ID */
-    enb_ue->enb_ue_s1ap_id = *ENB_UE_S1AP_ID;
+    enb_ue_set_enb_ue_s1ap_id(enb_ue, *ENB_UE_S1AP_ID);
 
     /* Change enb_ue to the NEW eNB */
     enb_ue_switch_to_enb(enb_ue, enb);
@@ -2817,7 +2818,7 @@ void s1ap_handle_handover_request_ack(
     ogs_debug("    Target : ENB_UE_S1AP_ID[%d] MME_UE_S1AP_ID[%d]",
             target_ue->enb_ue_s1ap_id, target_ue->mme_ue_s1ap_id);
 
-    target_ue->enb_ue_s1ap_id = *ENB_UE_S1AP_ID;
+    enb_ue_set_enb_ue_s1ap_id(target_ue, *ENB_UE_S1AP_ID);
 
     for (i = 0; i < E_RABAdmittedList->list.count; i++) {
         S1AP_E_RABAdmittedItemIEs_t *item = NULL;
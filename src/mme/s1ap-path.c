@@ -408,7 +408,7 @@ int s1ap_send_ue_context_release_command(
 int s1ap_send_paging(mme_ue_t *mme_ue, S1AP_CNDomain_t cn_domain)
 {
     ogs_pkbuf_t *s1apbuf = NULL;
-    mme_enb_t *enb = NULL;
+    mme_tai_enb_t *tai_enb = NULL;
     int i;
     int rv;
 
@@ -420,34 +420,29 @@ int s1ap_send_paging(mme_ue_t *mme_ue, S1AP_CNDomain_t cn_domain)
     }
 
     /* Find enB with matched TAI */
-    ogs_list_for_each(&mme_self()->enb_list, enb) {
-        for (i = 0; i < enb->num_of_supported_ta_list; i++) {
-
-            if (memcmp(&enb->supported_ta_list[i], &mme_ue->tai,
-                        sizeof(ogs_eps_tai_t)) == 0) {
-
-                if (mme_ue->t3413.pkbuf) {
-                    s1apbuf = mme_ue->t3413.pkbuf;
-                } else {
-                    s1apbuf = s1ap_build_paging(mme_ue, cn_domain);
-                    if (!s1apbuf) {
-                        ogs_error("s1ap_build_paging() failed");
-                        return OGS_ERROR;
-                    }
-                }
-
-                mme_ue->t3413.pkbuf = ogs_pkbuf_copy(s1apbuf);
-                if (!mme_ue->t3413.pkbuf) {
-                    ogs_error("ogs_pkbuf_copy() failed");
-                    ogs_pkbuf_free(s1apbuf);
-                    return OGS_ERROR;
-                }
-
-                rv = s1ap_send_to_enb(enb, s1apbuf, S1AP_NON_UE_SIGNALLING);
-                if (rv != OGS_OK) {
-                    ogs_error("s1ap_send_to_enb() failed");
-                    return rv;
-                }
+    tai_enb = mme_tai_enb_find(&mme_ue->tai);
+    if (tai_enb && tai_enb->num_of_enb) {
+        /* The Paging PDU is encoded once, and kept for T3413 */
+        if (!mme_ue->t3413.pkbuf) {
+            mme_ue->t3413.pkbuf = s1ap_build_paging(mme_ue, cn_domain);
+            if (!mme_ue->t3413.pkbuf) {
+                ogs_error("s1ap_build_paging() failed");
+                return OGS_ERROR;
+            }
+        }
+
+        for (i = 0; i < tai_enb->num_of_enb; i++) {
+            s1apbuf = ogs_pkbuf_copy(mme_ue->t3413.pkbuf);
+            if (!s1apbuf) {
+                ogs_error("ogs_pkbuf_copy() failed");
+                return OGS_ERROR;
+            }
+
+            rv = s1ap_send_to_enb(
+                    tai_enb->enb[i], s1apbuf, S1AP_NON_UE_SIGNALLING);
+            if (rv != OGS_OK) {
+                ogs_error("s1ap_send_to_enb() failed");
+                return rv;
             }
         }
     }
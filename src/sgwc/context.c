@@ -60,11 +60,11 @@ void sgwc_context_init(void)
     ogs_pool_init(&sgwc_sxa_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&sgwc_sxa_seid_pool);
 
-    self.imsi_ue_hash = ogs_hash_make();
+    self.imsi_ue_hash = ogs_hmap_create();
     ogs_assert(self.imsi_ue_hash);
-    self.sgw_s11_teid_hash = ogs_hash_make();
+    self.sgw_s11_teid_hash = ogs_hmap_create();
     ogs_assert(self.sgw_s11_teid_hash);
-    self.sgwc_sxa_seid_hash = ogs_hash_make();
+    self.sgwc_sxa_seid_hash = ogs_hmap_create();
     ogs_assert(self.sgwc_sxa_seid_hash);
 
     ogs_list_init(&self.sgw_ue_list);
@@ -79,11 +79,11 @@ void sgwc_context_final(void)
     sgwc_ue_remove_all();
 
     ogs_assert(self.imsi_ue_hash);
-    ogs_hash_destroy(self.imsi_ue_hash);
+    ogs_hmap_destroy(self.imsi_ue_hash);
     ogs_assert(self.sgw_s11_teid_hash);
-    ogs_hash_destroy(self.sgw_s11_teid_hash);
+    ogs_hmap_destroy(self.sgw_s11_teid_hash);
     ogs_assert(self.sgwc_sxa_seid_hash);
-    ogs_hash_destroy(self.sgwc_sxa_seid_hash);
+    ogs_hmap_destroy(self.sgwc_sxa_seid_hash);
 
     ogs_pool_final(&sgwc_tunnel_pool);
     ogs_pool_final(&sgwc_bearer_pool);
@@ -220,7 +220,7 @@ sgwc_ue_t *sgwc_ue_add(uint8_t *imsi, int imsi_len)
 
     sgwc_ue->sgw_s11_teid = *(sgwc_ue->sgw_s11_teid_node);
 
-    ogs_hash_set(self.sgw_s11_teid_hash,
+    ogs_hmap_set(self.sgw_s11_teid_hash,
             &sgwc_ue->sgw_s11_teid, sizeof(sgwc_ue->sgw_s11_teid), sgwc_ue);
 
     /* Set IMSI */
@@ -230,7 +230,7 @@ sgwc_ue_t *sgwc_ue_add(uint8_t *imsi, int imsi_len)
 
     ogs_list_init(&sgwc_ue->sess_list);
 
-    ogs_hash_set(self.imsi_ue_hash, sgwc_ue->imsi, sgwc_ue->imsi_len, sgwc_ue);
+    ogs_hmap_set(self.imsi_ue_hash, sgwc_ue->imsi, sgwc_ue->imsi_len, sgwc_ue);
 
     ogs_list_add(&self.sgw_ue_list, sgwc_ue);
 
@@ -246,9 +246,9 @@ int sgwc_ue_remove(sgwc_ue_t *sgwc_ue)
 
     ogs_list_remove(&self.sgw_ue_list, sgwc_ue);
 
-    ogs_hash_set(self.sgw_s11_teid_hash,
+    ogs_hmap_set(self.sgw_s11_teid_hash,
             &sgwc_ue->sgw_s11_teid, sizeof(sgwc_ue->sgw_s11_teid), NULL);
-    ogs_hash_set(self.imsi_ue_hash, sgwc_ue->imsi, sgwc_ue->imsi_len, NULL);
+    ogs_hmap_set(self.imsi_ue_hash, sgwc_ue->imsi, sgwc_ue->imsi_len, NULL);
 
     sgwc_sess_remove_all(sgwc_ue);
 
@@ -285,12 +285,12 @@ sgwc_ue_t *sgwc_ue_find_by_imsi(uint8_t *imsi, int imsi_len)
 {
     ogs_assert(imsi && imsi_len);
 
-    return ogs_hash_get(self.imsi_ue_hash, imsi, imsi_len);
+    return ogs_hmap_get(self.imsi_ue_hash, imsi, imsi_len);
 }
 
 sgwc_ue_t *sgwc_ue_find_by_teid(uint32_t teid)
 {
-    return ogs_hash_get(self.sgw_s11_teid_hash, &teid, sizeof(teid));
+    return ogs_hmap_get(self.sgw_s11_teid_hash, &teid, sizeof(teid));
 }
 
 sgwc_sess_t *sgwc_sess_add(sgwc_ue_t *sgwc_ue, char *apn)
@@ -316,7 +316,7 @@ sgwc_sess_t *sgwc_sess_add(sgwc_ue_t *sgwc_ue, char *apn)
     sess->sgw_s5c_teid = *(sess->sgwc_sxa_seid_node);
     sess->sgwc_sxa_seid = *(sess->sgwc_sxa_seid_node);
 
-    ogs_hash_set(self.sgwc_sxa_seid_hash,
+    ogs_hmap_set(self.sgwc_sxa_seid_hash,
             &sess->sgwc_sxa_seid, sizeof(sess->sgwc_sxa_seid), sess);
 
     /* Create BAR in PFCP Session */
@@ -433,7 +433,7 @@ int sgwc_sess_remove(sgwc_sess_t *sess)
 
     ogs_list_remove(&sgwc_ue->sess_list, sess);
 
-    ogs_hash_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_seid,
+    ogs_hmap_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_seid,
             sizeof(sess->sgwc_sxa_seid), NULL);
 
     sgwc_bearer_remove_all(sess);
@@ -470,7 +470,7 @@ sgwc_sess_t* sgwc_sess_find_by_teid(uint32_t teid)
 
 sgwc_sess_t *sgwc_sess_find_by_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.sgwc_sxa_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.sgwc_sxa_seid_hash, &seid, sizeof(seid));
 }
 
 sgwc_sess_t* sgwc_sess_find_by_apn(sgwc_ue_t *sgwc_ue, char *apn)
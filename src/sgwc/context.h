@@ -42,9 +42,9 @@ typedef struct sgwc_context_s {
     ogs_list_t mme_s11_list;    /* MME GTPC Node List */
     ogs_list_t pgw_s5c_list;    /* PGW GTPC Node List */
 
-    ogs_hash_t *imsi_ue_hash;   /* hash table (IMSI : SGW_UE) */
-    ogs_hash_t *sgw_s11_teid_hash;  /* hash table (SGW-S11-TEID : SGW_UE) */
-    ogs_hash_t *sgwc_sxa_seid_hash; /* hash table (SGWC-SXA-SEID : Session) */
+    ogs_hmap_t *imsi_ue_hash;   /* hash table (IMSI : SGW_UE) */
+    ogs_hmap_t *sgw_s11_teid_hash;  /* hash table (SGW-S11-TEID : SGW_UE) */
+    ogs_hmap_t *sgwc_sxa_seid_hash; /* hash table (SGWC-SXA-SEID : Session) */
 
     ogs_list_t sgw_ue_list;    /* SGW_UE List */
 } sgwc_context_t;
@@ -47,11 +47,11 @@ void sgwu_context_init(void)
     ogs_pool_init(&sgwu_sxa_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&sgwu_sxa_seid_pool);
 
-    self.sgwu_sxa_seid_hash = ogs_hash_make();
+    self.sgwu_sxa_seid_hash = ogs_hmap_create();
     ogs_assert(self.sgwu_sxa_seid_hash);
-    self.sgwc_sxa_seid_hash = ogs_hash_make();
+    self.sgwc_sxa_seid_hash = ogs_hmap_create();
     ogs_assert(self.sgwc_sxa_seid_hash);
-    self.sgwc_sxa_f_seid_hash = ogs_hash_make();
+    self.sgwc_sxa_f_seid_hash = ogs_hmap_create();
     ogs_assert(self.sgwc_sxa_f_seid_hash);
 
     context_initialized = 1;
@@ -64,11 +64,11 @@ void sgwu_context_final(void)
     sgwu_sess_remove_all();
 
     ogs_assert(self.sgwu_sxa_seid_hash);
-    ogs_hash_destroy(self.sgwu_sxa_seid_hash);
+    ogs_hmap_destroy(self.sgwu_sxa_seid_hash);
     ogs_assert(self.sgwc_sxa_seid_hash);
-    ogs_hash_destroy(self.sgwc_sxa_seid_hash);
+    ogs_hmap_destroy(self.sgwc_sxa_seid_hash);
     ogs_assert(self.sgwc_sxa_f_seid_hash);
-    ogs_hash_destroy(self.sgwc_sxa_f_seid_hash);
+    ogs_hmap_destroy(self.sgwc_sxa_f_seid_hash);
 
     ogs_pool_final(&sgwu_sess_pool);
     ogs_pool_final(&sgwu_sxa_seid_pool);
@@ -151,7 +151,7 @@ sgwu_sess_t *sgwu_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
 
     sess->sgwu_sxa_seid = *(sess->sgwu_sxa_seid_node);
 
-    ogs_hash_set(self.sgwu_sxa_seid_hash, &sess->sgwu_sxa_seid,
+    ogs_hmap_set(self.sgwu_sxa_seid_hash, &sess->sgwu_sxa_seid,
             sizeof(sess->sgwu_sxa_seid), sess);
 
     /* Since F-SEID is composed of ogs_ip_t and uint64-seid,
@@ -161,9 +161,9 @@ sgwu_sess_t *sgwu_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
     ogs_assert(OGS_OK ==
             ogs_pfcp_f_seid_to_ip(cp_f_seid, &sess->sgwc_sxa_f_seid.ip));
 
-    ogs_hash_set(self.sgwc_sxa_f_seid_hash, &sess->sgwc_sxa_f_seid,
+    ogs_hmap_set(self.sgwc_sxa_f_seid_hash, &sess->sgwc_sxa_f_seid,
             sizeof(sess->sgwc_sxa_f_seid), sess);
-    ogs_hash_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_f_seid.seid,
+    ogs_hmap_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_f_seid.seid,
             sizeof(sess->sgwc_sxa_f_seid.seid), sess);
 
     ogs_info("UE F-SEID[UP:0x%lx CP:0x%lx]",
@@ -184,12 +184,12 @@ int sgwu_sess_remove(sgwu_sess_t *sess)
     ogs_list_remove(&self.sess_list, sess);
     ogs_pfcp_sess_clear(&sess->pfcp);
 
-    ogs_hash_set(self.sgwu_sxa_seid_hash, &sess->sgwu_sxa_seid,
+    ogs_hmap_set(self.sgwu_sxa_seid_hash, &sess->sgwu_sxa_seid,
             sizeof(sess->sgwu_sxa_seid), NULL);
 
-    ogs_hash_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_f_seid.seid,
+    ogs_hmap_set(self.sgwc_sxa_seid_hash, &sess->sgwc_sxa_f_seid.seid,
             sizeof(sess->sgwc_sxa_f_seid.seid), NULL);
-    ogs_hash_set(self.sgwc_sxa_f_seid_hash, &sess->sgwc_sxa_f_seid,
+    ogs_hmap_set(self.sgwc_sxa_f_seid_hash, &sess->sgwc_sxa_f_seid,
             sizeof(sess->sgwc_sxa_f_seid), NULL);
 
     ogs_pfcp_pool_final(&sess->pfcp);
@@ -214,7 +214,7 @@ void sgwu_sess_remove_all(void)
 
 sgwu_sess_t *sgwu_sess_find_by_sgwc_sxa_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.sgwc_sxa_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.sgwc_sxa_seid_hash, &seid, sizeof(seid));
 }
 
 sgwu_sess_t *sgwu_sess_find_by_sgwc_sxa_f_seid(ogs_pfcp_f_seid_t *f_seid)
@@ -228,12 +228,12 @@ sgwu_sess_t *sgwu_sess_find_by_sgwc_sxa_f_seid(ogs_pfcp_f_seid_t *f_seid)
     ogs_assert(OGS_OK == ogs_pfcp_f_seid_to_ip(f_seid, &key.ip));
     key.seid = f_seid->seid;
 
-    return ogs_hash_get(self.sgwc_sxa_f_seid_hash, &key, sizeof(key));
+    return ogs_hmap_get(self.sgwc_sxa_f_seid_hash, &key, sizeof(key));
 }
 
 sgwu_sess_t *sgwu_sess_find_by_sgwu_sxa_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.sgwu_sxa_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.sgwu_sxa_seid_hash, &seid, sizeof(seid));
 }
 
 sgwu_sess_t *sgwu_sess_add_by_message(ogs_pfcp_message_t *message)
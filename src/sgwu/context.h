@@ -37,9 +37,9 @@ extern int __sgwu_log_domain;
 #define OGS_LOG_DOMAIN __sgwu_log_domain
 
 typedef struct sgwu_context_s {
-    ogs_hash_t *sgwu_sxa_seid_hash;    /* hash table (SGWU-SXA-SEID) */
-    ogs_hash_t *sgwc_sxa_seid_hash;    /* hash table (SGWC-SXA-SEID) */
-    ogs_hash_t *sgwc_sxa_f_seid_hash;  /* hash table (SGWC-SXA-F-SEID) */
+    ogs_hmap_t *sgwu_sxa_seid_hash;    /* hash table (SGWU-SXA-SEID) */
+    ogs_hmap_t *sgwc_sxa_seid_hash;    /* hash table (SGWC-SXA-SEID) */
+    ogs_hmap_t *sgwc_sxa_f_seid_hash;  /* hash table (SGWC-SXA-F-SEID) */
 
     ogs_list_t sess_list;
 } sgwu_context_t;
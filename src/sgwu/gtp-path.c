@@ -309,7 +309,17 @@ int sgwu_gtp_init(void)
     ogs_pkbuf_config_t config;
     memset(&config, 0, sizeof config);
 
-    config.cluster_2048_pool = ogs_app()->pool.packet;
+    /*
+     * Packets in flight: the receive batch, the pkbuf cache, and the
+     * G-PDUs waiting for sendmmsg() in the transmit batches of up to
+     * OGS_GTP_MAX_TX_BATCH peers. Twice that plus one packet per UE is
+     * kept as headroom. This only bounds the pool without talloc,
+     * downlink data buffering is bounded by its own byte count
+     * (see ogs_pfcp_far_buffer_add()).
+     */
+    config.cluster_2048_pool = 2 * (OGS_MAX_MMSG * 2 +
+            OGS_GTP_MAX_TX_BATCH * ogs_gtp_self()->gtpu_batch) +
+        ogs_app()->max.ue;
 
 #if OGS_USE_TALLOC == 1
     /* allocate a talloc pool for GTP to ensure it doesn't have to go back
@@ -319,12 +329,14 @@ int sgwu_gtp_init(void)
 #else
     packet_pool = ogs_pkbuf_pool_create(&config);
 #endif
+    ogs_pfcp_self()->buffer.pool = packet_pool;
 
     return OGS_OK;
 }
 
 void sgwu_gtp_final(void)
 {
+    ogs_pfcp_self()->buffer.pool = NULL;
     ogs_pkbuf_pool_destroy(packet_pool);
 }
 
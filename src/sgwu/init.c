@@ -35,7 +35,6 @@ int sgwu_initialize(void)
 
     sgwu_context_init();
     sgwu_event_init();
-    sgwu_gtp_init();
 
     rv = ogs_pfcp_xact_init();
     if (rv != OGS_OK) return rv;
@@ -49,6 +48,9 @@ int sgwu_initialize(void)
     rv = sgwu_context_parse_config();
     if (rv != OGS_OK) return rv;
 
+    rv = sgwu_gtp_init();
+    if (rv != OGS_OK) return rv;
+
     rv = ogs_log_config_domain(
             ogs_app()->logger.domain, ogs_app()->logger.level);
     if (rv != OGS_OK) return rv;
@@ -97,6 +99,12 @@ static void sgwu_main(void *data)
     ogs_fsm_init(&sgwu_sm, sgwu_state_initial, sgwu_state_final, 0);
 
     for ( ;; ) {
+        /*
+         * Transmit the G-PDUs batched during the previous iteration
+         * before going to sleep in ogs_pollset_poll().
+         */
+        ogs_gtp_flush_all();
+
         ogs_pollset_poll(ogs_app()->pollset,
                 ogs_timer_mgr_next(ogs_app()->timer_mgr));
 
@@ -114,9 +122,11 @@ static void sgwu_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            sgwu_event_t *e = NULL;
+            sgwu_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -125,9 +135,11 @@ static void sgwu_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&sgwu_sm, e);
-            sgwu_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&sgwu_sm, e[i]);
+                sgwu_event_free(e[i]);
+            }
         }
     }
 done:
@@ -91,15 +91,15 @@ void smf_context_init(void)
     ogs_pool_init(&smf_n4_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&smf_n4_seid_pool);
 
-    self.supi_hash = ogs_hash_make();
+    self.supi_hash = ogs_hmap_create();
     ogs_assert(self.supi_hash);
-    self.imsi_hash = ogs_hash_make();
+    self.imsi_hash = ogs_hmap_create();
     ogs_assert(self.imsi_hash);
-    self.smf_n4_seid_hash = ogs_hash_make();
+    self.smf_n4_seid_hash = ogs_hmap_create();
     ogs_assert(self.smf_n4_seid_hash);
-    self.ipv4_hash = ogs_hash_make();
+    self.ipv4_hash = ogs_hmap_create();
     ogs_assert(self.ipv4_hash);
-    self.ipv6_hash = ogs_hash_make();
+    self.ipv6_hash = ogs_hmap_create();
     ogs_assert(self.ipv6_hash);
     self.n1n2message_hash = ogs_hash_make();
     ogs_assert(self.n1n2message_hash);
@@ -115,15 +115,15 @@ void smf_context_final(void)
     smf_ue_remove_all();
 
     ogs_assert(self.supi_hash);
-    ogs_hash_destroy(self.supi_hash);
+    ogs_hmap_destroy(self.supi_hash);
     ogs_assert(self.imsi_hash);
-    ogs_hash_destroy(self.imsi_hash);
+    ogs_hmap_destroy(self.imsi_hash);
     ogs_assert(self.smf_n4_seid_hash);
-    ogs_hash_destroy(self.smf_n4_seid_hash);
+    ogs_hmap_destroy(self.smf_n4_seid_hash);
     ogs_assert(self.ipv4_hash);
-    ogs_hash_destroy(self.ipv4_hash);
+    ogs_hmap_destroy(self.ipv4_hash);
     ogs_assert(self.ipv6_hash);
-    ogs_hash_destroy(self.ipv6_hash);
+    ogs_hmap_destroy(self.ipv6_hash);
     ogs_assert(self.n1n2message_hash);
     ogs_hash_destroy(self.n1n2message_hash);
 
@@ -1023,7 +1023,7 @@ smf_ue_t *smf_ue_add_by_supi(char *supi)
 
     smf_ue->supi = ogs_strdup(supi);
     ogs_assert(smf_ue->supi);
-    ogs_hash_set(self.supi_hash, smf_ue->supi, strlen(smf_ue->supi), smf_ue);
+    ogs_hmap_set(self.supi_hash, smf_ue->supi, strlen(smf_ue->supi), smf_ue);
 
     return smf_ue;
 }
@@ -1041,7 +1041,7 @@ smf_ue_t *smf_ue_add_by_imsi(uint8_t *imsi, int imsi_len)
     smf_ue->imsi_len = imsi_len;
     memcpy(smf_ue->imsi, imsi, smf_ue->imsi_len);
     ogs_buffer_to_bcd(smf_ue->imsi, smf_ue->imsi_len, smf_ue->imsi_bcd);
-    ogs_hash_set(self.imsi_hash, smf_ue->imsi, smf_ue->imsi_len, smf_ue);
+    ogs_hmap_set(self.imsi_hash, smf_ue->imsi, smf_ue->imsi_len, smf_ue);
 
     return smf_ue;
 }
@@ -1055,12 +1055,12 @@ void smf_ue_remove(smf_ue_t *smf_ue)
     smf_sess_remove_all(smf_ue);
 
     if (smf_ue->supi) {
-        ogs_hash_set(self.supi_hash, smf_ue->supi, strlen(smf_ue->supi), NULL);
+        ogs_hmap_set(self.supi_hash, smf_ue->supi, strlen(smf_ue->supi), NULL);
         ogs_free(smf_ue->supi);
     }
 
     if (smf_ue->imsi_len) {
-        ogs_hash_set(self.imsi_hash, smf_ue->imsi, smf_ue->imsi_len, NULL);
+        ogs_hmap_set(self.imsi_hash, smf_ue->imsi, smf_ue->imsi_len, NULL);
     }
 
     ogs_pool_free(&smf_ue_pool, smf_ue);
@@ -1081,14 +1081,14 @@ void smf_ue_remove_all(void)
 smf_ue_t *smf_ue_find_by_supi(char *supi)
 {
     ogs_assert(supi);
-    return (smf_ue_t *)ogs_hash_get(self.supi_hash, supi, strlen(supi));
+    return (smf_ue_t *)ogs_hmap_get(self.supi_hash, supi, strlen(supi));
 }
 
 smf_ue_t *smf_ue_find_by_imsi(uint8_t *imsi, int imsi_len)
 {
     ogs_assert(imsi);
     ogs_assert(imsi_len);
-    return (smf_ue_t *)ogs_hash_get(self.imsi_hash, imsi, imsi_len);
+    return (smf_ue_t *)ogs_hmap_get(self.imsi_hash, imsi, imsi_len);
 }
 
 static bool compare_ue_info(ogs_pfcp_node_t *node, smf_sess_t *sess)
@@ -1211,7 +1211,7 @@ smf_sess_t *smf_sess_add_by_apn(smf_ue_t *smf_ue, char *apn, uint8_t rat_type)
     sess->smf_n4_teid = *(sess->smf_n4_seid_node);
     sess->smf_n4_seid = *(sess->smf_n4_seid_node);
 
-    ogs_hash_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
+    ogs_hmap_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
             sizeof(sess->smf_n4_seid), sess);
 
     /* Set Charging ID */
@@ -1423,7 +1423,7 @@ smf_sess_t *smf_sess_add_by_psi(smf_ue_t *smf_ue, uint8_t psi)
     sess->smf_n4_teid = *(sess->smf_n4_seid_node);
     sess->smf_n4_seid = *(sess->smf_n4_seid_node);
 
-    ogs_hash_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
+    ogs_hmap_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
             sizeof(sess->smf_n4_seid), sess);
 
     /* Set SmContextRef in 5GC */
@@ -1542,12 +1542,12 @@ uint8_t smf_sess_set_ue_ip(smf_sess_t *sess)
     ogs_assert(sess->session.session_type);
 
     if (sess->ipv4) {
-        ogs_hash_set(smf_self()->ipv4_hash,
+        ogs_hmap_set(smf_self()->ipv4_hash,
                 sess->ipv4->addr, OGS_IPV4_LEN, NULL);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(smf_self()->ipv6_hash,
+        ogs_hmap_set(smf_self()->ipv6_hash,
                 sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
@@ -1560,7 +1560,7 @@ uint8_t smf_sess_set_ue_ip(smf_sess_t *sess)
             return cause_value;
         }
         sess->session.paa.addr = sess->ipv4->addr[0];
-        ogs_hash_set(smf_self()->ipv4_hash,
+        ogs_hmap_set(smf_self()->ipv4_hash,
                 sess->ipv4->addr, OGS_IPV4_LEN, sess);
     } else if (sess->session.session_type == OGS_PDU_SESSION_TYPE_IPV6) {
         sess->ipv6 = ogs_pfcp_ue_ip_alloc(&cause_value, AF_INET6,
@@ -1575,7 +1575,7 @@ uint8_t smf_sess_set_ue_ip(smf_sess_t *sess)
 
         sess->session.paa.len = OGS_IPV6_DEFAULT_PREFIX_LEN >> 3;
         memcpy(sess->session.paa.addr6, sess->ipv6->addr, OGS_IPV6_LEN);
-        ogs_hash_set(smf_self()->ipv6_hash,
+        ogs_hmap_set(smf_self()->ipv6_hash,
                 sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
     } else if (sess->session.session_type == OGS_PDU_SESSION_TYPE_IPV4V6) {
         sess->ipv4 = ogs_pfcp_ue_ip_alloc(&cause_value, AF_INET,
@@ -1590,7 +1590,7 @@ uint8_t smf_sess_set_ue_ip(smf_sess_t *sess)
             ogs_error("ogs_pfcp_ue_ip_alloc() failed[%d]", cause_value);
             ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
             if (sess->ipv4) {
-                ogs_hash_set(smf_self()->ipv4_hash,
+                ogs_hmap_set(smf_self()->ipv4_hash,
                         sess->ipv4->addr, OGS_IPV4_LEN, NULL);
                 ogs_pfcp_ue_ip_free(sess->ipv4);
                 sess->ipv4 = NULL;
@@ -1604,9 +1604,9 @@ uint8_t smf_sess_set_ue_ip(smf_sess_t *sess)
         sess->session.paa.both.addr = sess->ipv4->addr[0];
         sess->session.paa.both.len = OGS_IPV6_DEFAULT_PREFIX_LEN >> 3;
         memcpy(sess->session.paa.both.addr6, sess->ipv6->addr, OGS_IPV6_LEN);
-        ogs_hash_set(smf_self()->ipv4_hash,
+        ogs_hmap_set(smf_self()->ipv4_hash,
                 sess->ipv4->addr, OGS_IPV4_LEN, sess);
-        ogs_hash_set(smf_self()->ipv6_hash,
+        ogs_hmap_set(smf_self()->ipv6_hash,
                 sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
     } else {
         ogs_fatal("Invalid sess->session.session_type[%d]",
@@ -1678,15 +1678,15 @@ void smf_sess_remove(smf_sess_t *sess)
         OGS_PCC_RULE_FREE(&sess->policy.pcc_rule[i]);
     sess->policy.num_of_pcc_rule = 0;
 
-    ogs_hash_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
+    ogs_hmap_set(self.smf_n4_seid_hash, &sess->smf_n4_seid,
             sizeof(sess->smf_n4_seid), NULL);
 
     if (sess->ipv4) {
-        ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+        ogs_hmap_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, NULL);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(self.ipv6_hash,
+        ogs_hmap_set(self.ipv6_hash,
                 sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
@@ -1790,7 +1790,7 @@ smf_sess_t *smf_sess_find_by_teid(uint32_t teid)
 
 smf_sess_t *smf_sess_find_by_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.smf_n4_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.smf_n4_seid_hash, &seid, sizeof(seid));
 }
 
 smf_sess_t *smf_sess_find_by_apn(smf_ue_t *smf_ue, char *apn, uint8_t rat_type)
@@ -1844,14 +1844,14 @@ smf_sess_t *smf_sess_find_by_sm_context_ref(char *sm_context_ref)
 smf_sess_t *smf_sess_find_by_ipv4(uint32_t addr)
 {
     ogs_assert(self.ipv4_hash);
-    return (smf_sess_t *)ogs_hash_get(self.ipv4_hash, &addr, OGS_IPV4_LEN);
+    return (smf_sess_t *)ogs_hmap_get(self.ipv4_hash, &addr, OGS_IPV4_LEN);
 }
 
 smf_sess_t *smf_sess_find_by_ipv6(uint32_t *addr6)
 {
     ogs_assert(self.ipv6_hash);
     ogs_assert(addr6);
-    return (smf_sess_t *)ogs_hash_get(
+    return (smf_sess_t *)ogs_hmap_get(
             self.ipv6_hash, addr6, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3);
 }
 
@@ -84,11 +84,11 @@ typedef struct smf_context_s {
     ogs_list_t      sgw_s5c_list;   /* SGW GTPC Node List */
     ogs_list_t      ip_pool_list;
 
-    ogs_hash_t      *supi_hash;     /* hash table (SUPI) */
-    ogs_hash_t      *imsi_hash;     /* hash table (IMSI) */
-    ogs_hash_t      *ipv4_hash;     /* hash table (IPv4 Address) */
-    ogs_hash_t      *ipv6_hash;     /* hash table (IPv6 Address) */
-    ogs_hash_t      *smf_n4_seid_hash; /* hash table (SMF-N4-SEID) */
+    ogs_hmap_t      *supi_hash;     /* hash table (SUPI) */
+    ogs_hmap_t      *imsi_hash;     /* hash table (IMSI) */
+    ogs_hmap_t      *ipv4_hash;     /* hash table (IPv4 Address) */
+    ogs_hmap_t      *ipv6_hash;     /* hash table (IPv6 Address) */
+    ogs_hmap_t      *smf_n4_seid_hash; /* hash table (SMF-N4-SEID) */
     ogs_hash_t      *n1n2message_hash; /* hash table (N1N2Message Location) */
 
     uint16_t        mtu;            /* MTU to advertise in PCO */
@@ -149,6 +149,12 @@ static void smf_main(void *data)
     ogs_fsm_init(&smf_sm, smf_state_initial, smf_state_final, 0);
 
     for ( ;; ) {
+        /*
+         * Transmit the G-PDUs batched during the previous iteration
+         * before going to sleep in ogs_pollset_poll().
+         */
+        ogs_gtp_flush_all();
+
         ogs_pollset_poll(ogs_app()->pollset,
                 ogs_timer_mgr_next(ogs_app()->timer_mgr));
 
@@ -166,9 +172,11 @@ static void smf_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            smf_event_t *e = NULL;
+            smf_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -177,9 +185,11 @@ static void smf_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&smf_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&smf_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
@@ -35,6 +35,9 @@ void udr_context_init(void)
     ogs_log_install_domain(&__ogs_dbi_domain, "dbi", ogs_core()->log.level);
     ogs_log_install_domain(&__udr_log_domain, "udr", ogs_core()->log.level);
 
+    self.num_of_db_worker = UDR_DEFAULT_NUM_OF_DB_WORKER;
+    self.max_db_queue = UDR_DEFAULT_MAX_DB_QUEUE;
+
     context_initialized = 1;
 }
 
@@ -57,6 +60,19 @@ static int udr_context_prepare(void)
 
 static int udr_context_validation(void)
 {
+    if (self.num_of_db_worker < 0 ||
+        self.num_of_db_worker > UDR_MAX_NUM_OF_DB_WORKER) {
+        ogs_error("udr.db_worker must be between 0 and %d in '%s'",
+                UDR_MAX_NUM_OF_DB_WORKER, ogs_app()->file);
+        return OGS_ERROR;
+    }
+
+    if (self.max_db_queue < 0) {
+        ogs_error("udr.db_queue must not be negative in '%s'",
+                ogs_app()->file);
+        return OGS_ERROR;
+    }
+
     return OGS_OK;
 }
 
@@ -88,6 +104,12 @@ int udr_context_parse_config(void)
                     /* handle config in sbi library */
                 } else if (!strcmp(udr_key, "discovery")) {
                     /* handle config in sbi library */
+                } else if (!strcmp(udr_key, "db_worker")) {
+                    const char *v = ogs_yaml_iter_value(&udr_iter);
+                    if (v) self.num_of_db_worker = atoi(v);
+                } else if (!strcmp(udr_key, "db_queue")) {
+                    const char *v = ogs_yaml_iter_value(&udr_iter);
+                    if (v) self.max_db_queue = atoi(v);
                 } else
                     ogs_warn("unknown key `%s`", udr_key);
             }
@@ -99,3 +121,98 @@ int udr_context_parse_config(void)
 
     return OGS_OK;
 }
+
+static void db_query_discard(ogs_dbi_query_t *query)
+{
+    udr_db_query_free((udr_db_query_t *)query);
+}
+
+udr_db_query_t *udr_db_query_new(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *message, char *supi,
+        ogs_dbi_query_f run, udr_db_query_handler_f handler)
+{
+    udr_db_query_t *query = NULL;
+    int i;
+
+    ogs_assert(stream);
+    ogs_assert(message);
+    ogs_assert(supi);
+    ogs_assert(run);
+    ogs_assert(handler);
+
+    query = ogs_calloc(1, sizeof(*query));
+    if (!query) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    query->h.run = run;
+    query->h.discard = db_query_discard;
+    query->stream = stream;
+    query->handler = handler;
+
+    if (message->h.method)
+        query->message.h.method = ogs_strdup(message->h.method);
+    if (message->h.service.name)
+        query->message.h.service.name = ogs_strdup(message->h.service.name);
+    if (message->h.api.version)
+        query->message.h.api.version = ogs_strdup(message->h.api.version);
+    for (i = 0; i < OGS_SBI_MAX_NUM_OF_RESOURCE_COMPONENT &&
+                message->h.resource.component[i]; i++) {
+        query->message.h.resource.component[i] =
+            ogs_strdup(message->h.resource.component[i]);
+        if (message->h.resource.component[i] == supi)
+            query->supi = query->message.h.resource.component[i];
+    }
+    ogs_assert(query->supi);
+
+    if (message->param.dnn)
+        query->message.param.dnn = ogs_strdup(message->param.dnn);
+    query->message.param.s_nssai = message->param.s_nssai;
+    query->message.param.snssai_presence = message->param.snssai_presence;
+    query->message.param.single_nssai_presence =
+        message->param.single_nssai_presence;
+
+    return query;
+}
+
+void udr_db_query_free(udr_db_query_t *query)
+{
+    int i;
+
+    ogs_assert(query);
+
+    if (query->message.h.method)
+        ogs_free(query->message.h.method);
+    if (query->message.h.service.name)
+        ogs_free(query->message.h.service.name);
+    if (query->message.h.api.version)
+        ogs_free(query->message.h.api.version);
+    for (i = 0; i < OGS_SBI_MAX_NUM_OF_RESOURCE_COMPONENT &&
+                query->message.h.resource.component[i]; i++)
+        ogs_free(query->message.h.resource.component[i]);
+    if (query->message.param.dnn)
+        ogs_free(query->message.param.dnn);
+
+    ogs_subscription_data_free(&query->subscription_data);
+
+    ogs_free(query);
+}
+
+/* Answers 503 if too many queries are waiting for the DB already */
+bool udr_db_query_submit(udr_db_query_t *query)
+{
+    ogs_assert(query);
+
+    if (ogs_dbi_query_submit(&query->h) != OGS_OK) {
+        ogs_warn("[%s] Too many DB queries waiting", query->supi);
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(query->stream,
+                OGS_SBI_HTTP_STATUS_SERVICE_UNAVAILABLE, &query->message,
+                "Too many DB queries waiting", query->supi));
+        udr_db_query_free(query);
+        return false;
+    }
+
+    return true;
+}
@@ -35,15 +35,57 @@ extern int __udr_log_domain;
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __udr_log_domain
 
+#define UDR_DEFAULT_NUM_OF_DB_WORKER 4
+#define UDR_MAX_NUM_OF_DB_WORKER 64
+#define UDR_DEFAULT_MAX_DB_QUEUE 1024
+
 typedef struct udr_context_s {
+    /* DB queries running at once (0 : run in the main loop) */
+    int num_of_db_worker;
+    /* DB queries waiting for a worker (0 : no limit) */
+    int max_db_queue;
 } udr_context_t;
 
+/*
+ * A request waiting for the DB. The SBI message is freed
+ * when the handler returns, so the parts of the header and
+ * the query parameters needed for the response are copied.
+ */
+typedef struct udr_db_query_s udr_db_query_t;
+typedef void (*udr_db_query_handler_f)(udr_db_query_t *query);
+
+struct udr_db_query_s {
+    ogs_dbi_query_t h;
+
+    ogs_sbi_stream_t *stream;
+    ogs_sbi_message_t message;
+    char *supi;                 /* One of message.h.resource.component[] */
+
+    /* Called in the main loop with the result */
+    udr_db_query_handler_f handler;
+
+    /* Input */
+    uint64_t sqn;
+
+    /* Output : 'status' is set if the query failed */
+    int status;
+    const char *strerror;
+    ogs_dbi_auth_info_t auth_info;
+    ogs_subscription_data_t subscription_data;
+};
+
 void udr_context_init(void);
 void udr_context_final(void);
 udr_context_t *udr_self(void);
 
 int udr_context_parse_config(void);
 
+udr_db_query_t *udr_db_query_new(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *message, char *supi,
+        ogs_dbi_query_f run, udr_db_query_handler_f handler);
+void udr_db_query_free(udr_db_query_t *query);
+bool udr_db_query_submit(udr_db_query_t *query);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,10 @@ int udr_initialize(void)
     rv = ogs_dbi_init(ogs_app()->db_uri);
     if (rv != OGS_OK) return rv;
 
+    rv = ogs_dbi_query_init(
+            udr_self()->num_of_db_worker, udr_self()->max_db_queue);
+    if (rv != OGS_OK) return rv;
+
     rv = udr_sbi_open();
     if (rv != OGS_OK) return rv;
 
@@ -86,6 +90,7 @@ void udr_terminate(void)
 
     udr_sbi_close();
 
+    ogs_dbi_query_final();
     ogs_dbi_final();
 
     udr_context_final();
@@ -117,9 +122,11 @@ static void udr_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            udr_event_t *e = NULL;
+            udr_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -128,9 +135,11 @@ static void udr_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&udr_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&udr_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
@@ -20,14 +20,61 @@
 #include "sbi-path.h"
 #include "nudr-handler.h"
 
-bool udr_nudr_dr_handle_subscription_authentication(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+static void auth_info_run(ogs_dbi_query_t *h)
+{
+    udr_db_query_t *query = (udr_db_query_t *)h;
+    char *supi = query->supi;
+
+    if (ogs_dbi_auth_info(supi, &query->auth_info) != OGS_OK) {
+        query->status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
+        query->strerror = "Cannot find SUPI in DB";
+    }
+}
+
+static void sqn_update_run(ogs_dbi_query_t *h)
+{
+    udr_db_query_t *query = (udr_db_query_t *)h;
+    char *supi = query->supi;
+
+    auth_info_run(h);
+    if (query->status)
+        return;
+
+    if (ogs_dbi_update_sqn(supi, query->sqn) != OGS_OK) {
+        query->status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        query->strerror = "Cannot update SQN";
+        return;
+    }
+
+    if (ogs_dbi_increment_sqn(supi) != OGS_OK) {
+        query->status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        query->strerror = "Cannot increment SQN";
+    }
+}
+
+static void sqn_increment_run(ogs_dbi_query_t *h)
+{
+    udr_db_query_t *query = (udr_db_query_t *)h;
+    char *supi = query->supi;
+
+    auth_info_run(h);
+    if (query->status)
+        return;
+
+    if (ogs_dbi_increment_sqn(supi) != OGS_OK) {
+        query->status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        query->strerror = "Cannot increment SQN";
+    }
+}
+
+static void handle_subscription_authentication(udr_db_query_t *query)
 {
-    int rv;
+    ogs_sbi_stream_t *stream = NULL;
+    ogs_sbi_message_t *recvmsg = NULL;
 
     ogs_sbi_message_t sendmsg;
     ogs_sbi_response_t *response = NULL;
-    ogs_dbi_auth_info_t auth_info;
+    ogs_dbi_auth_info_t *auth_info = NULL;
 
     char k_string[OGS_KEYSTRLEN(OGS_KEY_LEN)];
     char opc_string[OGS_KEYSTRLEN(OGS_KEY_LEN)];
@@ -39,84 +86,143 @@ bool udr_nudr_dr_handle_subscription_authentication(
 
     OpenAPI_authentication_subscription_t AuthenticationSubscription;
     OpenAPI_sequence_number_t SequenceNumber;
-    OpenAPI_list_t *PatchItemList = NULL;
-    OpenAPI_lnode_t *node = NULL;
 
+    ogs_assert(query);
+    stream = query->stream;
     ogs_assert(stream);
-    ogs_assert(recvmsg);
-
-    supi = recvmsg->h.resource.component[1];
-    if (!supi) {
-        ogs_error("No SUPI");
-        ogs_assert(true ==
-            ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_BAD_REQUEST,
-                recvmsg, "No SUPI", NULL));
-        return false;
-    }
+    recvmsg = &query->message;
+    supi = query->supi;
+    ogs_assert(supi);
 
-    if (strncmp(supi,
-            OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
-        ogs_error("[%s] Unknown SUPI Type", supi);
+    if (query->status) {
+        if (query->status == OGS_SBI_HTTP_STATUS_NOT_FOUND)
+            ogs_warn("[%s] %s", supi, query->strerror);
+        else
+            ogs_fatal("[%s] %s", supi, query->strerror);
         ogs_assert(true ==
-            ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_FORBIDDEN,
-                recvmsg, "Unknwon SUPI Type", supi));
-        return false;
+            ogs_sbi_server_send_error(stream, query->status,
+                recvmsg, query->strerror, supi));
+        return;
     }
 
-    rv = ogs_dbi_auth_info(supi, &auth_info);
-    if (rv != OGS_OK) {
-        ogs_warn("[%s] Cannot find SUPI in DB", supi);
-        ogs_assert(true ==
-            ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_NOT_FOUND,
-                recvmsg, "Cannot find SUPI Type", supi));
-        return false;
-    }
+    memset(&sendmsg, 0, sizeof(sendmsg));
 
     SWITCH(recvmsg->h.resource.component[3])
     CASE(OGS_SBI_RESOURCE_NAME_AUTHENTICATION_SUBSCRIPTION)
         SWITCH(recvmsg->h.method)
         CASE(OGS_SBI_HTTP_METHOD_GET)
+            auth_info = &query->auth_info;
+
             memset(&AuthenticationSubscription, 0,
                     sizeof(AuthenticationSubscription));
 
             AuthenticationSubscription.authentication_method =
                 OpenAPI_auth_method_5G_AKA;
 
-            ogs_hex_to_ascii(auth_info.k, sizeof(auth_info.k),
+            ogs_hex_to_ascii(auth_info->k, sizeof(auth_info->k),
                     k_string, sizeof(k_string));
             AuthenticationSubscription.enc_permanent_key = k_string;
 
-            ogs_hex_to_ascii(auth_info.amf, sizeof(auth_info.amf),
+            ogs_hex_to_ascii(auth_info->amf, sizeof(auth_info->amf),
                     amf_string, sizeof(amf_string));
             AuthenticationSubscription.authentication_management_field =
                     amf_string;
 
-            if (!auth_info.use_opc)
-                milenage_opc(auth_info.k, auth_info.op, auth_info.opc);
+            if (!auth_info->use_opc)
+                milenage_opc(auth_info->k, auth_info->op, auth_info->opc);
 
-            ogs_hex_to_ascii(auth_info.opc, sizeof(auth_info.opc),
+            ogs_hex_to_ascii(auth_info->opc, sizeof(auth_info->opc),
                     opc_string, sizeof(opc_string));
             AuthenticationSubscription.enc_opc_key = opc_string;
 
-            ogs_uint64_to_buffer(auth_info.sqn, OGS_SQN_LEN, sqn);
+            ogs_uint64_to_buffer(auth_info->sqn, OGS_SQN_LEN, sqn);
             ogs_hex_to_ascii(sqn, sizeof(sqn), sqn_string, sizeof(sqn_string));
 
             memset(&SequenceNumber, 0, sizeof(SequenceNumber));
             SequenceNumber.sqn = sqn_string;
             AuthenticationSubscription.sequence_number = &SequenceNumber;
 
-            memset(&sendmsg, 0, sizeof(sendmsg));
-
             ogs_assert(AuthenticationSubscription.authentication_method);
             sendmsg.AuthenticationSubscription =
                 &AuthenticationSubscription;
 
             response = ogs_sbi_build_response(
                     &sendmsg, OGS_SBI_HTTP_STATUS_OK);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+            break;
 
-            return true;
+        DEFAULT
+            /* PATCH */
+            response = ogs_sbi_build_response(
+                    &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
+        END
+        break;
+
+    DEFAULT
+        /* AUTHENTICATION_STATUS */
+        response = ogs_sbi_build_response(
+                &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
+    END
+
+    ogs_assert(response);
+    ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+}
+
+static bool subscription_authentication_submit(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg, char *supi,
+        ogs_dbi_query_f run, uint64_t sqn)
+{
+    udr_db_query_t *query = NULL;
+
+    query = udr_db_query_new(stream, recvmsg, supi,
+            run, handle_subscription_authentication);
+    if (!query) {
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream,
+                OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
+                recvmsg, "No memory", NULL));
+        return false;
+    }
+
+    query->sqn = sqn;
+
+    return udr_db_query_submit(query);
+}
+
+bool udr_nudr_dr_handle_subscription_authentication(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+{
+    char *supi = NULL;
+
+    OpenAPI_list_t *PatchItemList = NULL;
+    OpenAPI_lnode_t *node = NULL;
+
+    ogs_assert(stream);
+    ogs_assert(recvmsg);
+
+    supi = recvmsg->h.resource.component[1];
+    if (!supi) {
+        ogs_error("No SUPI");
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_BAD_REQUEST,
+                recvmsg, "No SUPI", NULL));
+        return false;
+    }
+
+    if (strncmp(supi,
+            OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
+        ogs_error("[%s] Unknown SUPI Type", supi);
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_FORBIDDEN,
+                recvmsg, "Unknwon SUPI Type", supi));
+        return false;
+    }
+
+    SWITCH(recvmsg->h.resource.component[3])
+    CASE(OGS_SBI_RESOURCE_NAME_AUTHENTICATION_SUBSCRIPTION)
+        SWITCH(recvmsg->h.method)
+        CASE(OGS_SBI_HTTP_METHOD_GET)
+            return subscription_authentication_submit(
+                    stream, recvmsg, supi, auth_info_run, 0);
 
         CASE(OGS_SBI_HTTP_METHOD_PATCH)
             char *sqn_string = NULL;
@@ -154,34 +260,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
                     sqn_ms, sizeof(sqn_ms));
             sqn = ogs_buffer_to_uint64(sqn_ms, OGS_SQN_LEN);
 
-            rv = ogs_dbi_update_sqn(supi, sqn);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot update SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot update SQN", supi));
-                return false;
-            }
-
-            rv = ogs_dbi_increment_sqn(supi);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot increment SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot increment SQN", supi));
-                return false;
-            }
-
-            memset(&sendmsg, 0, sizeof(sendmsg));
-
-            response = ogs_sbi_build_response(
-                    &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
-
-            return true;
+            return subscription_authentication_submit(
+                    stream, recvmsg, supi, sqn_update_run, sqn);
 
         DEFAULT
             ogs_error("Invalid HTTP method [%s]", recvmsg->h.method);
@@ -209,23 +289,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
                 return false;
             }
 
-            memset(&sendmsg, 0, sizeof(sendmsg));
-            rv = ogs_dbi_increment_sqn(supi);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot increment SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot increment SQN", supi));
-                return false;
-            }
-
-            response = ogs_sbi_build_response(
-                    &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
-
-            return true;
+            return subscription_authentication_submit(
+                    stream, recvmsg, supi, sqn_increment_run, 0);
 
         DEFAULT
             ogs_error("Invalid HTTP method [%s]", recvmsg->h.method);
@@ -349,46 +414,47 @@ bool udr_nudr_dr_handle_subscription_context(
     return false;
 }
 
-bool udr_nudr_dr_handle_subscription_provisioned(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+static void subscription_data_run(ogs_dbi_query_t *h)
+{
+    udr_db_query_t *query = (udr_db_query_t *)h;
+
+    if (ogs_dbi_subscription_data(
+                query->supi, &query->subscription_data) != OGS_OK) {
+        query->status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
+        query->strerror = "Cannot find SUPI in DB";
+    }
+}
+
+static void handle_subscription_provisioned(udr_db_query_t *query)
 {
-    int rv, status = 0;
+    int status = 0;
     char *strerror = NULL;
 
+    ogs_sbi_stream_t *stream = NULL;
+    ogs_sbi_message_t *recvmsg = NULL;
+
     ogs_sbi_message_t sendmsg;
     ogs_sbi_response_t *response = NULL;
-    ogs_subscription_data_t subscription_data;
+    ogs_subscription_data_t *subscription_data = NULL;
     ogs_slice_data_t *slice_data = NULL;
 
     char *supi = NULL;
 
+    ogs_assert(query);
+    stream = query->stream;
     ogs_assert(stream);
-    ogs_assert(recvmsg);
-
-    memset(&subscription_data, 0, sizeof(ogs_subscription_data_t));
-
-    supi = recvmsg->h.resource.component[1];
-    if (!supi) {
-        strerror = ogs_msprintf("No SUPI");
-        status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
-        goto cleanup;
-    }
-
-    if (strncmp(supi,
-            OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
-        strerror = ogs_msprintf("[%s] Unknown SUPI Type", supi);
-        status = OGS_SBI_HTTP_STATUS_FORBIDDEN;
-        goto cleanup;
-    }
-
-    rv = ogs_dbi_subscription_data(supi, &subscription_data);
-    if (rv != OGS_OK) {
-        strerror = ogs_msprintf("[%s] Cannot find SUPI in DB", supi);
-        status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
+    recvmsg = &query->message;
+    supi = query->supi;
+    ogs_assert(supi);
+    subscription_data = &query->subscription_data;
+
+    if (query->status) {
+        strerror = ogs_msprintf("[%s] %s", supi, query->strerror);
+        status = query->status;
         goto cleanup;
     }
 
-    if (!subscription_data.ambr.uplink && !subscription_data.ambr.downlink) {
+    if (!subscription_data->ambr.uplink && !subscription_data->ambr.downlink) {
         strerror = ogs_msprintf("[%s] No UE-AMBR", supi);
         status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
         goto cleanup;
@@ -411,22 +477,22 @@ bool udr_nudr_dr_handle_subscription_provisioned(
         OpenAPI_lnode_t *node = NULL;
 
         GpsiList = OpenAPI_list_create();
-        for (i = 0; i < subscription_data.num_of_msisdn; i++) {
+        for (i = 0; i < subscription_data->num_of_msisdn; i++) {
             char *gpsi = ogs_msprintf("%s-%s",
-                    OGS_ID_GPSI_TYPE_MSISDN, subscription_data.msisdn[i].bcd);
+                    OGS_ID_GPSI_TYPE_MSISDN, subscription_data->msisdn[i].bcd);
             ogs_assert(gpsi);
             OpenAPI_list_add(GpsiList, gpsi);
         }
 
         SubscribedUeAmbr.uplink = ogs_sbi_bitrate_to_string(
-                subscription_data.ambr.uplink, OGS_SBI_BITRATE_KBPS);
+                subscription_data->ambr.uplink, OGS_SBI_BITRATE_KBPS);
         SubscribedUeAmbr.downlink = ogs_sbi_bitrate_to_string(
-                subscription_data.ambr.downlink, OGS_SBI_BITRATE_KBPS);
+                subscription_data->ambr.downlink, OGS_SBI_BITRATE_KBPS);
 
         memset(&NSSAI, 0, sizeof(NSSAI));
         DefaultSingleNssaiList = OpenAPI_list_create();
-        for (i = 0; i < subscription_data.num_of_slice; i++) {
-            slice_data = &subscription_data.slice[i];
+        for (i = 0; i < subscription_data->num_of_slice; i++) {
+            slice_data = &subscription_data->slice[i];
 
             if (slice_data->default_indicator == false)
                 continue;
@@ -444,8 +510,8 @@ bool udr_nudr_dr_handle_subscription_provisioned(
         }
 
         SingleNssaiList = OpenAPI_list_create();
-        for (i = 0; i < subscription_data.num_of_slice; i++) {
-            slice_data = &subscription_data.slice[i];
+        for (i = 0; i < subscription_data->num_of_slice; i++) {
+            slice_data = &subscription_data->slice[i];
 
             if (slice_data->default_indicator == true)
                 continue;
@@ -538,13 +604,13 @@ bool udr_nudr_dr_handle_subscription_provisioned(
         SubscribedSnssaiInfoList = OpenAPI_list_create();
         ogs_assert(SubscribedSnssaiInfoList);
 
-        for (i = 0; i < subscription_data.num_of_slice; i++) {
+        for (i = 0; i < subscription_data->num_of_slice; i++) {
             if (i >= OGS_MAX_NUM_OF_SLICE) {
                 ogs_warn("Ignore max slice count overflow [%d>=%d]",
-                    subscription_data.num_of_slice, OGS_MAX_NUM_OF_SLICE);
+                    subscription_data->num_of_slice, OGS_MAX_NUM_OF_SLICE);
                 break;
             }
-            slice_data = &subscription_data.slice[i];
+            slice_data = &subscription_data->slice[i];
 
             DnnInfoList = OpenAPI_list_create();
             ogs_assert(DnnInfoList);
@@ -658,7 +724,7 @@ bool udr_nudr_dr_handle_subscription_provisioned(
         };
 
         slice_data = ogs_slice_find_by_s_nssai(
-                subscription_data.slice, subscription_data.num_of_slice,
+                subscription_data->slice, subscription_data->num_of_slice,
                 &recvmsg->param.s_nssai);
 
         if (!slice_data) {
@@ -967,9 +1033,7 @@ bool udr_nudr_dr_handle_subscription_provisioned(
         goto cleanup;
     END
 
-    ogs_subscription_data_free(&subscription_data);
-
-    return true;
+    return;
 
 cleanup:
     ogs_assert(strerror);
@@ -979,228 +1043,310 @@ cleanup:
         ogs_sbi_server_send_error(stream, status, recvmsg, strerror, NULL));
     ogs_free(strerror);
 
-    ogs_subscription_data_free(&subscription_data);
+    return;
+}
+
+bool udr_nudr_dr_handle_subscription_provisioned(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+{
+    int status = 0;
+    char *strerror = NULL;
+
+    udr_db_query_t *query = NULL;
+    char *supi = NULL;
+
+    ogs_assert(stream);
+    ogs_assert(recvmsg);
+
+    supi = recvmsg->h.resource.component[1];
+    if (!supi) {
+        strerror = ogs_msprintf("No SUPI");
+        status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
+        goto cleanup;
+    }
+
+    if (strncmp(supi,
+            OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
+        strerror = ogs_msprintf("[%s] Unknown SUPI Type", supi);
+        status = OGS_SBI_HTTP_STATUS_FORBIDDEN;
+        goto cleanup;
+    }
+
+    query = udr_db_query_new(stream, recvmsg, supi,
+            subscription_data_run, handle_subscription_provisioned);
+    if (!query) {
+        strerror = ogs_msprintf("[%s] No memory", supi);
+        status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        goto cleanup;
+    }
+
+    return udr_db_query_submit(query);
+
+cleanup:
+    ogs_assert(strerror);
+    ogs_assert(status);
+    ogs_error("%s", strerror);
+    ogs_assert(true ==
+        ogs_sbi_server_send_error(stream, status, recvmsg, strerror, NULL));
+    ogs_free(strerror);
 
     return false;
 }
 
-bool udr_nudr_dr_handle_policy_data(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+static void handle_policy_data(udr_db_query_t *query)
 {
-    int rv, i, status = 0;
+    int i, status = 0;
     char *strerror = NULL;
 
+    ogs_sbi_stream_t *stream = NULL;
+    ogs_sbi_message_t *recvmsg = NULL;
+
     ogs_sbi_message_t sendmsg;
     ogs_sbi_response_t *response = NULL;
 
-    ogs_subscription_data_t subscription_data;
+    ogs_subscription_data_t *subscription_data = NULL;
     ogs_slice_data_t *slice_data = NULL;
 
+    OpenAPI_lnode_t *node = NULL, *node2 = NULL;
+    char *supi = NULL;
+
+    ogs_assert(query);
+    stream = query->stream;
     ogs_assert(stream);
-    ogs_assert(recvmsg);
+    recvmsg = &query->message;
+    supi = query->supi;
+    ogs_assert(supi);
+    subscription_data = &query->subscription_data;
+
+    if (query->status) {
+        strerror = ogs_msprintf("[%s] %s", supi, query->strerror);
+        status = query->status;
+        goto cleanup;
+    }
 
-    memset(&subscription_data, 0, sizeof(ogs_subscription_data_t));
+    SWITCH(recvmsg->h.resource.component[3])
+    CASE(OGS_SBI_RESOURCE_NAME_AM_DATA)
+        OpenAPI_am_policy_data_t AmPolicyData;
 
-    SWITCH(recvmsg->h.resource.component[1])
-    CASE(OGS_SBI_RESOURCE_NAME_UES)
-        char *supi = recvmsg->h.resource.component[2];
+        memset(&AmPolicyData, 0, sizeof(AmPolicyData));
 
-        if (!supi) {
-            strerror = ogs_msprintf("No SUPI");
+        memset(&sendmsg, 0, sizeof(sendmsg));
+        sendmsg.AmPolicyData = &AmPolicyData;
+
+        response = ogs_sbi_build_response(
+                &sendmsg, OGS_SBI_HTTP_STATUS_OK);
+        ogs_assert(response);
+        ogs_assert(true ==
+                ogs_sbi_server_send_response(stream, response));
+
+        break;
+
+    CASE(OGS_SBI_RESOURCE_NAME_SM_DATA)
+        OpenAPI_sm_policy_data_t SmPolicyData;
+
+        OpenAPI_list_t *SmPolicySnssaiDataList = NULL;
+        OpenAPI_map_t *SmPolicySnssaiDataMap = NULL;
+        OpenAPI_sm_policy_snssai_data_t *SmPolicySnssaiData = NULL;
+
+        OpenAPI_snssai_t *sNSSAI = NULL;
+
+        OpenAPI_list_t *SmPolicyDnnDataList = NULL;
+        OpenAPI_map_t *SmPolicyDnnDataMap = NULL;
+        OpenAPI_sm_policy_dnn_data_t *SmPolicyDnnData = NULL;
+
+        if (!recvmsg->param.snssai_presence) {
+            strerror = ogs_msprintf("[%s] No S_NSSAI", supi);
             status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
             goto cleanup;
         }
 
-        if (strncmp(supi,
-                OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
-            strerror = ogs_msprintf("[%s] Unknown SUPI Type", supi);
-            status = OGS_SBI_HTTP_STATUS_FORBIDDEN;
+        slice_data = ogs_slice_find_by_s_nssai(
+                subscription_data->slice, subscription_data->num_of_slice,
+                &recvmsg->param.s_nssai);
+
+        if (!slice_data) {
+            strerror = ogs_msprintf(
+                    "[%s] Cannot find S_NSSAI[SST:%d SD:0x%x]",
+                    supi,
+                    recvmsg->param.s_nssai.sst,
+                    recvmsg->param.s_nssai.sd.v);
+            status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
             goto cleanup;
         }
 
-        SWITCH(recvmsg->h.method)
-        CASE(OGS_SBI_HTTP_METHOD_GET)
-            OpenAPI_lnode_t *node = NULL, *node2 = NULL;
-
-            rv = ogs_dbi_subscription_data(supi, &subscription_data);
-            if (rv != OGS_OK) {
-                strerror = ogs_msprintf("[%s] Cannot find SUPI in DB", supi);
-                status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
-                goto cleanup;
-            }
+        sNSSAI = ogs_calloc(1, sizeof(*sNSSAI));
+        ogs_assert(sNSSAI);
+        sNSSAI->sst = slice_data->s_nssai.sst;
+        sNSSAI->sd = ogs_s_nssai_sd_to_string(slice_data->s_nssai.sd);
 
-            SWITCH(recvmsg->h.resource.component[3])
-            CASE(OGS_SBI_RESOURCE_NAME_AM_DATA)
-                OpenAPI_am_policy_data_t AmPolicyData;
+        SmPolicyDnnDataList = OpenAPI_list_create();
+        ogs_assert(SmPolicyDnnDataList);
 
-                memset(&AmPolicyData, 0, sizeof(AmPolicyData));
+        slice_data = &subscription_data->slice[0];
 
-                memset(&sendmsg, 0, sizeof(sendmsg));
-                sendmsg.AmPolicyData = &AmPolicyData;
-
-                response = ogs_sbi_build_response(
-                        &sendmsg, OGS_SBI_HTTP_STATUS_OK);
-                ogs_assert(response);
-                ogs_assert(true ==
-                        ogs_sbi_server_send_response(stream, response));
+        for (i = 0; i < slice_data->num_of_session; i++) {
+            ogs_session_t *session = NULL;
 
+            if (i >= OGS_MAX_NUM_OF_SESS) {
+                ogs_warn("Ignore max session count overflow [%d>=%d]",
+                    slice_data->num_of_session, OGS_MAX_NUM_OF_SESS);
                 break;
+            }
 
-            CASE(OGS_SBI_RESOURCE_NAME_SM_DATA)
-                OpenAPI_sm_policy_data_t SmPolicyData;
-
-                OpenAPI_list_t *SmPolicySnssaiDataList = NULL;
-                OpenAPI_map_t *SmPolicySnssaiDataMap = NULL;
-                OpenAPI_sm_policy_snssai_data_t *SmPolicySnssaiData = NULL;
-
-                OpenAPI_snssai_t *sNSSAI = NULL;
+            session = &slice_data->session[i];
+            ogs_assert(session);
+            ogs_assert(session->name);
 
-                OpenAPI_list_t *SmPolicyDnnDataList = NULL;
-                OpenAPI_map_t *SmPolicyDnnDataMap = NULL;
-                OpenAPI_sm_policy_dnn_data_t *SmPolicyDnnData = NULL;
+            if (recvmsg->param.dnn &&
+                ogs_strcasecmp(recvmsg->param.dnn, session->name) != 0)
+                continue;
 
-                if (!recvmsg->param.snssai_presence) {
-                    strerror = ogs_msprintf("[%s] No S_NSSAI", supi);
-                    status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
-                    goto cleanup;
-                }
+            SmPolicyDnnData = ogs_calloc(1, sizeof(*SmPolicyDnnData));
+            ogs_assert(SmPolicyDnnData);
 
-                slice_data = ogs_slice_find_by_s_nssai(
-                        subscription_data.slice, subscription_data.num_of_slice,
-                        &recvmsg->param.s_nssai);
-
-                if (!slice_data) {
-                    strerror = ogs_msprintf(
-                            "[%s] Cannot find S_NSSAI[SST:%d SD:0x%x]",
-                            supi,
-                            recvmsg->param.s_nssai.sst,
-                            recvmsg->param.s_nssai.sd.v);
-                    status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
-                    goto cleanup;
-                }
+            SmPolicyDnnData->dnn = session->name;
 
-                sNSSAI = ogs_calloc(1, sizeof(*sNSSAI));
-                ogs_assert(sNSSAI);
-                sNSSAI->sst = slice_data->s_nssai.sst;
-                sNSSAI->sd = ogs_s_nssai_sd_to_string(slice_data->s_nssai.sd);
+            SmPolicyDnnDataMap = OpenAPI_map_create(
+                    session->name, SmPolicyDnnData);
+            ogs_assert(SmPolicyDnnDataMap);
 
-                SmPolicyDnnDataList = OpenAPI_list_create();
-                ogs_assert(SmPolicyDnnDataList);
+            OpenAPI_list_add(SmPolicyDnnDataList, SmPolicyDnnDataMap);
+        }
 
-                slice_data = &subscription_data.slice[0];
+        SmPolicySnssaiData = ogs_calloc(1, sizeof(*SmPolicySnssaiData));
+        ogs_assert(SmPolicySnssaiData);
 
-                for (i = 0; i < slice_data->num_of_session; i++) {
-                    ogs_session_t *session = NULL;
+        SmPolicySnssaiData->snssai = sNSSAI;
+        if (SmPolicyDnnDataList->count)
+            SmPolicySnssaiData->sm_policy_dnn_data =
+                SmPolicyDnnDataList;
+        else
+            OpenAPI_list_free(SmPolicyDnnDataList);
 
-                    if (i >= OGS_MAX_NUM_OF_SESS) {
-                        ogs_warn("Ignore max session count overflow [%d>=%d]",
-                            slice_data->num_of_session, OGS_MAX_NUM_OF_SESS);
-                        break;
-                    }
+        SmPolicySnssaiDataMap = OpenAPI_map_create(
+                ogs_sbi_s_nssai_to_string(&recvmsg->param.s_nssai),
+                SmPolicySnssaiData);
+        ogs_assert(SmPolicySnssaiDataMap);
+        ogs_assert(SmPolicySnssaiDataMap->key);
 
-                    session = &slice_data->session[i];
-                    ogs_assert(session);
-                    ogs_assert(session->name);
+        SmPolicySnssaiDataList = OpenAPI_list_create();
+        ogs_assert(SmPolicySnssaiDataList);
 
-                    if (recvmsg->param.dnn &&
-                        ogs_strcasecmp(recvmsg->param.dnn, session->name) != 0)
-                        continue;
+        OpenAPI_list_add(SmPolicySnssaiDataList, SmPolicySnssaiDataMap);
 
-                    SmPolicyDnnData = ogs_calloc(1, sizeof(*SmPolicyDnnData));
-                    ogs_assert(SmPolicyDnnData);
+        memset(&SmPolicyData, 0, sizeof(SmPolicyData));
 
-                    SmPolicyDnnData->dnn = session->name;
+        if (SmPolicySnssaiDataList->count)
+            SmPolicyData.sm_policy_snssai_data = SmPolicySnssaiDataList;
+        else
+            OpenAPI_list_free(SmPolicySnssaiDataList);
 
-                    SmPolicyDnnDataMap = OpenAPI_map_create(
-                            session->name, SmPolicyDnnData);
-                    ogs_assert(SmPolicyDnnDataMap);
+        memset(&sendmsg, 0, sizeof(sendmsg));
+        sendmsg.SmPolicyData = &SmPolicyData;
 
-                    OpenAPI_list_add(SmPolicyDnnDataList, SmPolicyDnnDataMap);
+        response = ogs_sbi_build_response(
+                &sendmsg, OGS_SBI_HTTP_STATUS_OK);
+        ogs_assert(response);
+        ogs_assert(true ==
+                ogs_sbi_server_send_response(stream, response));
+
+        SmPolicySnssaiDataList = SmPolicyData.sm_policy_snssai_data;
+        OpenAPI_list_for_each(SmPolicySnssaiDataList, node) {
+            SmPolicySnssaiDataMap = node->data;
+            if (SmPolicySnssaiDataMap) {
+                SmPolicySnssaiData = SmPolicySnssaiDataMap->value;
+                if (SmPolicySnssaiData) {
+                    sNSSAI = SmPolicySnssaiData->snssai;
+                    if (sNSSAI) {
+                        if (sNSSAI->sd) ogs_free(sNSSAI->sd);
+                        ogs_free(sNSSAI);
+                    }
+                    SmPolicyDnnDataList =
+                        SmPolicySnssaiData->sm_policy_dnn_data;
+                    if (SmPolicyDnnDataList) {
+                        OpenAPI_list_for_each(
+                                SmPolicyDnnDataList, node2) {
+                            SmPolicyDnnDataMap = node2->data;
+                            if (SmPolicyDnnDataMap) {
+                                SmPolicyDnnData =
+                                    SmPolicyDnnDataMap->value;
+                                if (SmPolicyDnnData) {
+                                    ogs_free(SmPolicyDnnData);
+                                }
+                                ogs_free(SmPolicyDnnDataMap);
+                            }
+                        }
+                        OpenAPI_list_free(SmPolicyDnnDataList);
+                    }
+                    ogs_free(SmPolicySnssaiData);
                 }
+                if (SmPolicySnssaiDataMap->key)
+                    ogs_free(SmPolicySnssaiDataMap->key);
+                ogs_free(SmPolicySnssaiDataMap);
+            }
+        }
+        OpenAPI_list_free(SmPolicySnssaiDataList);
 
-                SmPolicySnssaiData = ogs_calloc(1, sizeof(*SmPolicySnssaiData));
-                ogs_assert(SmPolicySnssaiData);
+        break;
 
-                SmPolicySnssaiData->snssai = sNSSAI;
-                if (SmPolicyDnnDataList->count)
-                    SmPolicySnssaiData->sm_policy_dnn_data =
-                        SmPolicyDnnDataList;
-                else
-                    OpenAPI_list_free(SmPolicyDnnDataList);
+    DEFAULT
+        strerror = ogs_msprintf("Invalid resource name [%s]",
+                recvmsg->h.resource.component[3]);
+        status = OGS_SBI_HTTP_STATUS_MEHTOD_NOT_ALLOWED;
+        goto cleanup;
+    END
 
-                SmPolicySnssaiDataMap = OpenAPI_map_create(
-                        ogs_sbi_s_nssai_to_string(&recvmsg->param.s_nssai),
-                        SmPolicySnssaiData);
-                ogs_assert(SmPolicySnssaiDataMap);
-                ogs_assert(SmPolicySnssaiDataMap->key);
+    return;
 
-                SmPolicySnssaiDataList = OpenAPI_list_create();
-                ogs_assert(SmPolicySnssaiDataList);
+cleanup:
+    ogs_assert(strerror);
+    ogs_assert(status);
+    ogs_error("%s", strerror);
+    ogs_assert(true ==
+        ogs_sbi_server_send_error(stream, status, recvmsg, strerror, NULL));
+    ogs_free(strerror);
+}
 
-                OpenAPI_list_add(SmPolicySnssaiDataList, SmPolicySnssaiDataMap);
+bool udr_nudr_dr_handle_policy_data(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+{
+    int status = 0;
+    char *strerror = NULL;
 
-                memset(&SmPolicyData, 0, sizeof(SmPolicyData));
+    udr_db_query_t *query = NULL;
 
-                if (SmPolicySnssaiDataList->count)
-                    SmPolicyData.sm_policy_snssai_data = SmPolicySnssaiDataList;
-                else
-                    OpenAPI_list_free(SmPolicySnssaiDataList);
+    ogs_assert(stream);
+    ogs_assert(recvmsg);
 
-                memset(&sendmsg, 0, sizeof(sendmsg));
-                sendmsg.SmPolicyData = &SmPolicyData;
+    SWITCH(recvmsg->h.resource.component[1])
+    CASE(OGS_SBI_RESOURCE_NAME_UES)
+        char *supi = recvmsg->h.resource.component[2];
 
-                response = ogs_sbi_build_response(
-                        &sendmsg, OGS_SBI_HTTP_STATUS_OK);
-                ogs_assert(response);
-                ogs_assert(true ==
-                        ogs_sbi_server_send_response(stream, response));
-
-                SmPolicySnssaiDataList = SmPolicyData.sm_policy_snssai_data;
-                OpenAPI_list_for_each(SmPolicySnssaiDataList, node) {
-                    SmPolicySnssaiDataMap = node->data;
-                    if (SmPolicySnssaiDataMap) {
-                        SmPolicySnssaiData = SmPolicySnssaiDataMap->value;
-                        if (SmPolicySnssaiData) {
-                            sNSSAI = SmPolicySnssaiData->snssai;
-                            if (sNSSAI) {
-                                if (sNSSAI->sd) ogs_free(sNSSAI->sd);
-                                ogs_free(sNSSAI);
-                            }
-                            SmPolicyDnnDataList =
-                                SmPolicySnssaiData->sm_policy_dnn_data;
-                            if (SmPolicyDnnDataList) {
-                                OpenAPI_list_for_each(
-                                        SmPolicyDnnDataList, node2) {
-                                    SmPolicyDnnDataMap = node2->data;
-                                    if (SmPolicyDnnDataMap) {
-                                        SmPolicyDnnData =
-                                            SmPolicyDnnDataMap->value;
-                                        if (SmPolicyDnnData) {
-                                            ogs_free(SmPolicyDnnData);
-                                        }
-                                        ogs_free(SmPolicyDnnDataMap);
-                                    }
-                                }
-                                OpenAPI_list_free(SmPolicyDnnDataList);
-                            }
-                            ogs_free(SmPolicySnssaiData);
-                        }
-                        if (SmPolicySnssaiDataMap->key)
-                            ogs_free(SmPolicySnssaiDataMap->key);
-                        ogs_free(SmPolicySnssaiDataMap);
-                    }
-                }
-                OpenAPI_list_free(SmPolicySnssaiDataList);
+        if (!supi) {
+            strerror = ogs_msprintf("No SUPI");
+            status = OGS_SBI_HTTP_STATUS_BAD_REQUEST;
+            goto cleanup;
+        }
 
-                break;
+        if (strncmp(supi,
+                OGS_ID_SUPI_TYPE_IMSI, strlen(OGS_ID_SUPI_TYPE_IMSI)) != 0) {
+            strerror = ogs_msprintf("[%s] Unknown SUPI Type", supi);
+            status = OGS_SBI_HTTP_STATUS_FORBIDDEN;
+            goto cleanup;
+        }
 
-            DEFAULT
-                strerror = ogs_msprintf("Invalid resource name [%s]",
-                        recvmsg->h.resource.component[3]);
-                status = OGS_SBI_HTTP_STATUS_MEHTOD_NOT_ALLOWED;
+        SWITCH(recvmsg->h.method)
+        CASE(OGS_SBI_HTTP_METHOD_GET)
+            query = udr_db_query_new(stream, recvmsg, supi,
+                    subscription_data_run, handle_policy_data);
+            if (!query) {
+                strerror = ogs_msprintf("[%s] No memory", supi);
+                status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
                 goto cleanup;
-            END
+            }
 
+            if (udr_db_query_submit(query) == false)
+                return false;
             break;
 
         DEFAULT
@@ -1219,8 +1365,6 @@ bool udr_nudr_dr_handle_policy_data(
         goto cleanup;
     END
 
-    ogs_subscription_data_free(&subscription_data);
-
     return true;
 
 cleanup:
@@ -1231,7 +1375,5 @@ cleanup:
         ogs_sbi_server_send_error(stream, status, recvmsg, strerror, NULL));
     ogs_free(strerror);
 
-    ogs_subscription_data_free(&subscription_data);
-
     return false;
 }
@@ -48,6 +48,8 @@ void udr_state_operational(ogs_fsm_t *s, udr_event_t *e)
     ogs_sbi_response_t *response = NULL;
     ogs_sbi_message_t message;
 
+    udr_db_query_t *db_query = NULL;
+
     udr_sm_debug(e);
 
     ogs_assert(s);
@@ -335,6 +337,14 @@ void udr_state_operational(ogs_fsm_t *s, udr_event_t *e)
         }
         break;
 
+    case OGS_EVENT_DBI_QUERY:
+        db_query = e->h.dbi.query;
+        ogs_assert(db_query);
+
+        db_query->handler(db_query);
+        udr_db_query_free(db_query);
+        break;
+
     default:
         ogs_error("No handler for event %s", udr_event_get_name(e));
         break;
@@ -31,6 +31,10 @@ static int context_initialized = 0;
 
 static void upf_sess_urr_acc_remove_all(upf_sess_t *sess);
 
+#define UPF_QER_METRICS_INTERVAL ogs_time_from_sec(5)
+
+static void upf_qer_metrics_cb(void *data);
+
 void upf_context_init(void)
 {
     ogs_assert(context_initialized == 0);
@@ -53,27 +57,25 @@ void upf_context_init(void)
     ogs_pool_init(&upf_n4_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&upf_n4_seid_pool);
 
-    self.upf_n4_seid_hash = ogs_hash_make();
+    self.upf_n4_seid_hash = ogs_hmap_create();
     ogs_assert(self.upf_n4_seid_hash);
-    self.smf_n4_seid_hash = ogs_hash_make();
+    self.smf_n4_seid_hash = ogs_hmap_create();
     ogs_assert(self.smf_n4_seid_hash);
-    self.smf_n4_f_seid_hash = ogs_hash_make();
+    self.smf_n4_f_seid_hash = ogs_hmap_create();
     ogs_assert(self.smf_n4_f_seid_hash);
-    self.ipv4_hash = ogs_hash_make();
-    ogs_assert(self.ipv4_hash);
-    self.ipv6_hash = ogs_hash_make();
-    ogs_assert(self.ipv6_hash);
+    self.ipv4_lpm = ogs_lpm_create(OGS_IPV4_LEN);
+    ogs_assert(self.ipv4_lpm);
+    self.ipv6_lpm = ogs_lpm_create(OGS_IPV6_LEN);
+    ogs_assert(self.ipv6_lpm);
 
-    context_initialized = 1;
-}
+    ogs_thread_rwlock_init(&self.rwlock);
 
-static void free_upf_route_trie_node(struct upf_route_trie_node *node)
-{
-    if (!node)
-        return;
-    free_upf_route_trie_node(node->left);
-    free_upf_route_trie_node(node->right);
-    ogs_free(node);
+    self.t_qer_metrics = ogs_timer_add(
+            ogs_app()->timer_mgr, upf_qer_metrics_cb, NULL);
+    ogs_assert(self.t_qer_metrics);
+    ogs_timer_start(self.t_qer_metrics, UPF_QER_METRICS_INTERVAL);
+
+    context_initialized = 1;
 }
 
 void upf_context_final(void)
@@ -82,23 +84,25 @@ void upf_context_final(void)
 
     upf_sess_remove_all();
 
+    ogs_assert(self.t_qer_metrics);
+    ogs_timer_delete(self.t_qer_metrics);
+
     ogs_assert(self.upf_n4_seid_hash);
-    ogs_hash_destroy(self.upf_n4_seid_hash);
+    ogs_hmap_destroy(self.upf_n4_seid_hash);
     ogs_assert(self.smf_n4_seid_hash);
-    ogs_hash_destroy(self.smf_n4_seid_hash);
+    ogs_hmap_destroy(self.smf_n4_seid_hash);
     ogs_assert(self.smf_n4_f_seid_hash);
-    ogs_hash_destroy(self.smf_n4_f_seid_hash);
-    ogs_assert(self.ipv4_hash);
-    ogs_hash_destroy(self.ipv4_hash);
-    ogs_assert(self.ipv6_hash);
-    ogs_hash_destroy(self.ipv6_hash);
-
-    free_upf_route_trie_node(self.ipv4_framed_routes);
-    free_upf_route_trie_node(self.ipv6_framed_routes);
+    ogs_hmap_destroy(self.smf_n4_f_seid_hash);
+    ogs_assert(self.ipv4_lpm);
+    ogs_lpm_destroy(self.ipv4_lpm);
+    ogs_assert(self.ipv6_lpm);
+    ogs_lpm_destroy(self.ipv6_lpm);
 
     ogs_pool_final(&upf_sess_pool);
     ogs_pool_final(&upf_n4_seid_pool);
 
+    ogs_thread_rwlock_destroy(&self.rwlock);
+
     context_initialized = 0;
 }
 
@@ -114,6 +118,12 @@ static int upf_context_prepare(void)
 
 static int upf_context_validation(void)
 {
+    if (self.num_of_worker < 0 ||
+        self.num_of_worker > UPF_MAX_NUM_OF_WORKER) {
+        ogs_error("upf.worker must be between 0 and %d in '%s'",
+                UPF_MAX_NUM_OF_WORKER, ogs_app()->file);
+        return OGS_ERROR;
+    }
     if (ogs_list_first(&ogs_gtp_self()->gtpu_list) == NULL) {
         ogs_error("No upf.gtpu in '%s'", ogs_app()->file);
         return OGS_ERROR;
@@ -149,6 +159,11 @@ int upf_context_parse_config(void)
                 ogs_assert(upf_key);
                 if (!strcmp(upf_key, "gtpu")) {
                     /* handle config in gtp library */
+                } else if (!strcmp(upf_key, "gtpu_batch")) {
+                    /* handle config in gtp library */
+                } else if (!strcmp(upf_key, "worker")) {
+                    const char *v = ogs_yaml_iter_value(&upf_iter);
+                    if (v) self.num_of_worker = atoi(v);
                 } else if (!strcmp(upf_key, "pfcp")) {
                     /* handle config in pfcp library */
                 } else if (!strcmp(upf_key, "subnet")) {
@@ -167,6 +182,48 @@ int upf_context_parse_config(void)
     return OGS_OK;
 }
 
+/*
+ * Without data-plane workers everything runs in upf_main,
+ * so the locks below are no-ops.
+ */
+void upf_context_rdlock(void)
+{
+    if (self.num_of_worker)
+        ogs_thread_rwlock_rdlock(&self.rwlock);
+}
+
+void upf_context_rdunlock(void)
+{
+    if (self.num_of_worker)
+        ogs_thread_rwlock_rdunlock(&self.rwlock);
+}
+
+void upf_context_wrlock(void)
+{
+    if (self.num_of_worker)
+        ogs_thread_rwlock_wrlock(&self.rwlock);
+}
+
+void upf_context_wrunlock(void)
+{
+    if (self.num_of_worker)
+        ogs_thread_rwlock_wrunlock(&self.rwlock);
+}
+
+void upf_sess_lock(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+    if (self.num_of_worker)
+        ogs_thread_mutex_lock(&sess->mutex);
+}
+
+void upf_sess_unlock(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+    if (self.num_of_worker)
+        ogs_thread_mutex_unlock(&sess->mutex);
+}
+
 upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
 {
     upf_sess_t *sess = NULL;
@@ -178,6 +235,7 @@ upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
     memset(sess, 0, sizeof *sess);
 
     ogs_pfcp_pool_init(&sess->pfcp);
+    ogs_thread_mutex_init(&sess->mutex);
 
     /* Set UPF-N4-SEID */
     ogs_pool_alloc(&upf_n4_seid_pool, &sess->upf_n4_seid_node);
@@ -185,7 +243,7 @@ upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
 
     sess->upf_n4_seid = *(sess->upf_n4_seid_node);
 
-    ogs_hash_set(self.upf_n4_seid_hash, &sess->upf_n4_seid,
+    ogs_hmap_set(self.upf_n4_seid_hash, &sess->upf_n4_seid,
             sizeof(sess->upf_n4_seid), sess);
 
     /* Since F-SEID is composed of ogs_ip_t and uint64-seid,
@@ -195,9 +253,9 @@ upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
     ogs_assert(OGS_OK ==
             ogs_pfcp_f_seid_to_ip(cp_f_seid, &sess->smf_n4_f_seid.ip));
 
-    ogs_hash_set(self.smf_n4_f_seid_hash, &sess->smf_n4_f_seid,
+    ogs_hmap_set(self.smf_n4_f_seid_hash, &sess->smf_n4_f_seid,
             sizeof(sess->smf_n4_f_seid), sess);
-    ogs_hash_set(self.smf_n4_seid_hash, &sess->smf_n4_f_seid.seid,
+    ogs_hmap_set(self.smf_n4_seid_hash, &sess->smf_n4_f_seid.seid,
             sizeof(sess->smf_n4_f_seid.seid), sess);
 
     ogs_list_add(&self.sess_list, sess);
@@ -214,25 +272,31 @@ int upf_sess_remove(upf_sess_t *sess)
     ogs_assert(sess);
 
     upf_sess_urr_acc_remove_all(sess);
+    upf_sess_qer_metrics_export(sess);
 
     ogs_list_remove(&self.sess_list, sess);
     ogs_pfcp_sess_clear(&sess->pfcp);
 
-    ogs_hash_set(self.upf_n4_seid_hash, &sess->upf_n4_seid,
+    ogs_pfcp_classifier_clear(&sess->dl_classifier);
+    ogs_pfcp_classifier_clear(&sess->ul_classifier);
+    sess->dl_fallback_pdr = NULL;
+
+    ogs_hmap_set(self.upf_n4_seid_hash, &sess->upf_n4_seid,
             sizeof(sess->upf_n4_seid), NULL);
 
-    ogs_hash_set(self.smf_n4_seid_hash, &sess->smf_n4_f_seid.seid,
+    ogs_hmap_set(self.smf_n4_seid_hash, &sess->smf_n4_f_seid.seid,
             sizeof(sess->smf_n4_f_seid.seid), NULL);
-    ogs_hash_set(self.smf_n4_f_seid_hash, &sess->smf_n4_f_seid,
+    ogs_hmap_set(self.smf_n4_f_seid_hash, &sess->smf_n4_f_seid,
             sizeof(sess->smf_n4_f_seid), NULL);
 
     if (sess->ipv4) {
-        ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+        ogs_lpm_delete(self.ipv4_lpm,
+                sess->ipv4->addr, OGS_IPV4_LEN * 8);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(self.ipv6_hash,
-                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+        ogs_lpm_delete(self.ipv6_lpm,
+                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
 
@@ -240,6 +304,7 @@ int upf_sess_remove(upf_sess_t *sess)
     upf_sess_set_ue_ipv6_framed_routes(sess, NULL);
 
     ogs_pfcp_pool_final(&sess->pfcp);
+    ogs_thread_mutex_destroy(&sess->mutex);
 
     ogs_pool_free(&upf_n4_seid_pool, sess->upf_n4_seid_node);
     ogs_pool_free(&upf_sess_pool, sess);
@@ -264,7 +329,7 @@ void upf_sess_remove_all(void)
 
 upf_sess_t *upf_sess_find_by_smf_n4_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.smf_n4_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.smf_n4_seid_hash, &seid, sizeof(seid));
 }
 
 upf_sess_t *upf_sess_find_by_smf_n4_f_seid(ogs_pfcp_f_seid_t *f_seid)
@@ -278,76 +343,25 @@ upf_sess_t *upf_sess_find_by_smf_n4_f_seid(ogs_pfcp_f_seid_t *f_seid)
     ogs_assert(OGS_OK == ogs_pfcp_f_seid_to_ip(f_seid, &key.ip));
     key.seid = f_seid->seid;
 
-    return ogs_hash_get(self.smf_n4_f_seid_hash, &key, sizeof(key));
+    return ogs_hmap_get(self.smf_n4_f_seid_hash, &key, sizeof(key));
 }
 
 upf_sess_t *upf_sess_find_by_upf_n4_seid(uint64_t seid)
 {
-    return ogs_hash_get(self.upf_n4_seid_hash, &seid, sizeof(seid));
+    return ogs_hmap_get(self.upf_n4_seid_hash, &seid, sizeof(seid));
 }
 
 upf_sess_t *upf_sess_find_by_ipv4(uint32_t addr)
 {
-    upf_sess_t *ret;
-    struct upf_route_trie_node *trie = self.ipv4_framed_routes;
-    const int nbits = sizeof(addr) << 3;
-    int i;
-
-    ogs_assert(self.ipv4_hash);
-
-    ret = ogs_hash_get(self.ipv4_hash, &addr, OGS_IPV4_LEN);
-    if (ret)
-        return ret;
-
-    for (i =  0; i <= nbits; i++) {
-        int bit = nbits - i - 1;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == nbits)
-            break;
-
-        if ((1 << bit) & be32toh(addr))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    ogs_assert(self.ipv4_lpm);
+    return ogs_lpm_find(self.ipv4_lpm, &addr);
 }
 
 upf_sess_t *upf_sess_find_by_ipv6(uint32_t *addr6)
 {
-    upf_sess_t *ret = NULL;
-    struct upf_route_trie_node *trie = self.ipv6_framed_routes;
-    int i;
-    const int chunk_size = sizeof(*addr6) << 3;
-
-    ogs_assert(self.ipv6_hash);
+    ogs_assert(self.ipv6_lpm);
     ogs_assert(addr6);
-    ret = ogs_hash_get(
-            self.ipv6_hash, addr6, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3);
-    if (ret)
-        return ret;
-
-    for (i = 0; i <= OGS_IPV6_128_PREFIX_LEN; i++) {
-        int part = i / chunk_size;
-        int bit = (OGS_IPV6_128_PREFIX_LEN - i - 1) % chunk_size;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == OGS_IPV6_128_PREFIX_LEN)
-            break;
-
-        if ((1 << bit) & be32toh(addr6[part]))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    return ogs_lpm_find(self.ipv6_lpm, addr6);
 }
 
 upf_sess_t *upf_sess_add_by_message(ogs_pfcp_message_t *message)
@@ -395,13 +409,13 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
     ogs_assert(ue_ip);
 
     if (sess->ipv4) {
-        ogs_hash_set(self.ipv4_hash,
-                sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+        ogs_lpm_delete(self.ipv4_lpm,
+                sess->ipv4->addr, OGS_IPV4_LEN * 8);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(self.ipv6_hash,
-                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+        ogs_lpm_delete(self.ipv6_lpm,
+                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
 
@@ -415,7 +429,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, sess);
+            ogs_assert(OGS_OK == ogs_lpm_add(self.ipv4_lpm,
+                    sess->ipv4->addr, OGS_IPV4_LEN * 8, sess));
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -430,8 +445,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv6_hash, sess->ipv6->addr,
-                    OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
+            ogs_assert(OGS_OK == ogs_lpm_add(self.ipv6_lpm,
+                    sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess));
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -446,7 +461,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, sess);
+            ogs_assert(OGS_OK == ogs_lpm_add(self.ipv4_lpm,
+                    sess->ipv4->addr, OGS_IPV4_LEN * 8, sess));
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -460,15 +476,15 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_error("ogs_pfcp_ue_ip_alloc() failed[%d]", cause_value);
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 if (sess->ipv4) {
-                    ogs_hash_set(self.ipv4_hash,
-                            sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+                    ogs_lpm_delete(self.ipv4_lpm,
+                            sess->ipv4->addr, OGS_IPV4_LEN * 8);
                     ogs_pfcp_ue_ip_free(sess->ipv4);
                     sess->ipv4 = NULL;
                 }
                 return cause_value;
             }
-            ogs_hash_set(self.ipv6_hash, sess->ipv6->addr,
-                    OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
+            ogs_assert(OGS_OK == ogs_lpm_add(self.ipv6_lpm,
+                    sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess));
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -490,83 +506,40 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
     return cause_value;
 }
 
-/* Remove amd free framed ROUTE from TRIE. It isn't an error if the framed
-   route doesn't exist in TRIE. */
-static void free_framed_route_from_trie(ogs_ipsubnet_t *route)
+static int framed_route_prefix_len(ogs_ipsubnet_t *route)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-
-    struct upf_route_trie_node **to_free_tries[OGS_IPV6_128_PREFIX_LEN + 1];
-    int free_from = 0;
-    int i = 0;
-
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
-
-        if (!*trie)
-            break;
-        to_free_tries[i] = trie;
-
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = NULL;
-            if ((*trie)->left || (*trie)->right)
-                free_from = i + 1;
-            i++;
-            break;
-        }
-
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            if ((*trie)->left || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->right;
-        } else {
-            if ((*trie)->right || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->left;
+    int i, n, len = 0;
+
+    /* IPv4 uses only the first word of the mask */
+    n = route->family == AF_INET ? 1 : 4;
+    for (i = 0; i < n; i++) {
+        uint32_t mask = be32toh(route->mask[i]);
+        while (mask & 0x80000000) {
+            len++;
+            mask <<= 1;
         }
     }
 
-    for (i = i - 1; i >= free_from; i--) {
-        trie = to_free_tries[i];
-        ogs_free(*trie);
-        *trie = NULL;
-    }
+    return len;
 }
 
-static void add_framed_route_to_trie(ogs_ipsubnet_t *route, upf_sess_t *sess)
+/* Remove framed ROUTE from LPM. It isn't an error if the framed
+   route doesn't exist in LPM. */
+static void free_framed_route_from_lpm(ogs_ipsubnet_t *route)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-    int i = 0;
-
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
+    ogs_lpm_t *lpm =
+        route->family == AF_INET ? self.ipv4_lpm : self.ipv6_lpm;
 
-        if (!*trie)
-            *trie = ogs_calloc(1, sizeof(**trie));
+    ogs_lpm_delete(lpm, route->sub, framed_route_prefix_len(route));
+}
 
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = sess;
-            break;
-        }
+static void add_framed_route_to_lpm(ogs_ipsubnet_t *route, upf_sess_t *sess)
+{
+    ogs_lpm_t *lpm =
+        route->family == AF_INET ? self.ipv4_lpm : self.ipv6_lpm;
 
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            trie = &(*trie)->right;
-        } else {
-            trie = &(*trie)->left;
-        }
-    }
+    ogs_assert(OGS_OK ==
+            ogs_lpm_add(lpm, route->sub, framed_route_prefix_len(route), sess));
 }
 
 static int parse_framed_route(ogs_ipsubnet_t *subnet, const char *framed_route)
@@ -591,7 +564,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv4_framed_routes || !sess->ipv4_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv4_framed_routes[i]);
+        free_framed_route_from_lpm(&sess->ipv4_framed_routes[i]);
         memset(&sess->ipv4_framed_routes[i], 0,
                sizeof(sess->ipv4_framed_routes[i]));
     }
@@ -614,7 +587,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv4_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv4_framed_routes[j], sess);
+        add_framed_route_to_lpm(&sess->ipv4_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv4_framed_routes) {
@@ -636,7 +609,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv6_framed_routes || !sess->ipv6_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv6_framed_routes[i]);
+        free_framed_route_from_lpm(&sess->ipv6_framed_routes[i]);
     }
 
     for (i = 0, j = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
@@ -657,7 +630,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv6_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv6_framed_routes[j], sess);
+        add_framed_route_to_lpm(&sess->ipv6_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv6_framed_routes) {
@@ -668,14 +641,73 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
     return cause_value;
 }
 
-void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink)
+/*
+ * URRs counted since the last sweep, per data-plane thread.
+ *
+ * A receive callback handles at most OGS_MAX_MMSG packets under
+ * the context read lock, so neither the session nor the URR can go
+ * away before the sweep at the end of the callback.
+ */
+#define MAX_NUM_OF_URR_ACC_PENDING (OGS_MAX_MMSG * OGS_MAX_NUM_OF_URR)
+
+static OGS_THREAD_LOCAL struct {
+    upf_sess_t *sess;
+    ogs_pfcp_urr_t *urr;
+} urr_acc_pending[MAX_NUM_OF_URR_ACC_PENDING];
+static OGS_THREAD_LOCAL int num_of_urr_acc_pending;
+
+static bool urr_acc_dropped_dl_traffic_reached(
+        upf_sess_urr_acc_t *urr_acc, const ogs_pfcp_urr_t *urr);
+
+/* The caller holds the session lock */
+static void urr_acc_check(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
 {
     upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
     uint64_t vol;
 
-    /* Increment total & ul octets + pkts */
-    urr_acc->total_octets += size;
-    urr_acc->total_pkts++;
+    urr_acc->pending = false;
+
+    /* generate report if volume threshold/quota is reached */
+    vol = (urr_acc->ul_octets - urr_acc->last_report.ul_octets) +
+        (urr_acc->dl_octets - urr_acc->last_report.dl_octets);
+    if ((urr->rep_triggers.volume_quota && urr->vol_quota.tovol && vol >= urr->vol_quota.total_volume) ||
+        (urr->rep_triggers.volume_threshold && urr->vol_threshold.tovol && vol >= urr->vol_threshold.total_volume) ||
+        urr_acc_dropped_dl_traffic_reached(urr_acc, urr)) {
+        ogs_pfcp_user_plane_report_t report;
+        memset(&report, 0, sizeof(report));
+        upf_sess_urr_acc_fill_usage_report(sess, urr, &report, 0);
+        report.num_of_usage_report = 1;
+        upf_sess_urr_acc_snapshot(sess, urr);
+
+        /* Starts new report period/iteration once the report is sent */
+        ogs_expect(OGS_OK == upf_pfcp_send_data_plane_report(sess, &report));
+    }
+}
+
+/* The caller holds the session lock */
+static void urr_acc_mark(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
+{
+    upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
+
+    if (urr_acc->pending)
+        return;
+
+    if (num_of_urr_acc_pending == MAX_NUM_OF_URR_ACC_PENDING) {
+        urr_acc_check(sess, urr);
+        return;
+    }
+
+    urr_acc->pending = true;
+    urr_acc_pending[num_of_urr_acc_pending].sess = sess;
+    urr_acc_pending[num_of_urr_acc_pending].urr = urr;
+    num_of_urr_acc_pending++;
+}
+
+void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink, ogs_time_t now)
+{
+    upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
+
     if (is_uplink) {
         urr_acc->ul_octets += size;
         urr_acc->ul_pkts++;
@@ -684,25 +716,138 @@ void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bo
         urr_acc->dl_pkts++;
     }
 
-    urr_acc->time_of_last_packet = ogs_time_now();
+    urr_acc->time_of_last_packet = now;
     if (urr_acc->time_of_first_packet == 0)
-        urr_acc->time_of_first_packet = urr_acc->time_of_last_packet;
+        urr_acc->time_of_first_packet = now;
 
-    /* generate report if volume threshold/quota is reached */
-    vol = urr_acc->total_octets - urr_acc->last_report.total_octets;
-    if ((urr->rep_triggers.volume_quota && urr->vol_quota.tovol && vol >= urr->vol_quota.total_volume) ||
-        (urr->rep_triggers.volume_threshold && urr->vol_threshold.tovol && vol >= urr->vol_threshold.total_volume)) {
-        ogs_pfcp_user_plane_report_t report;
-        memset(&report, 0, sizeof(report));
-        upf_sess_urr_acc_fill_usage_report(sess, urr, &report, 0);
-        report.num_of_usage_report = 1;
-        upf_sess_urr_acc_snapshot(sess, urr);
+    urr_acc_mark(sess, urr);
+}
 
-        ogs_assert(OGS_OK ==
-            upf_pfcp_send_session_report_request(sess, &report));
-        /* Start new report period/iteration: */
-        upf_sess_urr_acc_timers_setup(sess, urr);
+/*
+ * Checks the thresholds and quotas of every URR counted since
+ * the last sweep. Called at the end of each receive callback.
+ */
+void upf_sess_urr_acc_sweep(void)
+{
+    int i;
+
+    for (i = 0; i < num_of_urr_acc_pending; i++) {
+        upf_sess_t *sess = urr_acc_pending[i].sess;
+
+        upf_sess_lock(sess);
+        urr_acc_check(sess, urr_acc_pending[i].urr);
+        upf_sess_unlock(sess);
+    }
+
+    num_of_urr_acc_pending = 0;
+}
+
+static bool urr_acc_dropped_dl_traffic_reached(
+        upf_sess_urr_acc_t *urr_acc, const ogs_pfcp_urr_t *urr)
+{
+    const ogs_pfcp_dropped_dl_traffic_threshold_t *threshold =
+        &urr->dropped_dl_traffic_threshold;
+
+    if (!urr->rep_triggers.dropped_dl_traffic_threshold)
+        return false;
+
+    if (threshold->dlpa && urr_acc->dropped_dl_pkts -
+            urr_acc->last_report.dropped_dl_pkts >=
+            threshold->downlink_packets)
+        return true;
+    if (threshold->dlby && urr_acc->dropped_dl_octets -
+            urr_acc->last_report.dropped_dl_octets >=
+            threshold->number_of_bytes_of_downlink_data)
+        return true;
+
+    return false;
+}
+
+/*
+ * Only the dropped DL traffic has a reporting trigger (Dropped DL Traffic
+ * Threshold), the dropped UL traffic is just counted per URR.
+ */
+void upf_sess_urr_acc_drop(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink)
+{
+    upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
+
+    if (is_uplink) {
+        urr_acc->dropped_ul_octets += size;
+        urr_acc->dropped_ul_pkts++;
+        return;
     }
+
+    urr_acc->dropped_dl_octets += size;
+    urr_acc->dropped_dl_pkts++;
+
+    urr_acc_mark(sess, urr);
+}
+
+/*
+ * Polices the packet with the QER of the PDR.
+ * Returns false if the packet exceeds the MBR or the gate is closed.
+ * Packets above the GBR and dropped packets are counted in the session,
+ * dropped packets also in the URRs of the PDR.
+ * The caller holds the session lock.
+ */
+bool upf_sess_qer_meter(upf_sess_t *sess, ogs_pfcp_pdr_t *pdr,
+        size_t size, bool is_uplink, ogs_time_t now)
+{
+    int i;
+
+    ogs_assert(sess);
+    ogs_assert(pdr);
+
+    if (!pdr->qer)
+        return true;
+
+    switch (ogs_pfcp_qer_meter(pdr->qer, is_uplink, size, now)) {
+    case OGS_PFCP_QER_GREEN:
+        return true;
+    case OGS_PFCP_QER_YELLOW:
+        sess->qer.marked_pkts++;
+        return true;
+    default:
+        sess->qer.dropped_pkts++;
+        break;
+    }
+
+    for (i = 0; i < pdr->num_of_urr; i++)
+        upf_sess_urr_acc_drop(sess, pdr->urr[i], size, is_uplink);
+
+    return false;
+}
+
+/*
+ * Adds the QER results counted since the last export to the metrics.
+ * The metrics take a lock per update, so the data path does not touch them.
+ * Called by the control thread with the context write lock held.
+ */
+void upf_sess_qer_metrics_export(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+
+    if (sess->qer.marked_pkts != sess->qer.exported_marked_pkts) {
+        upf_metrics_inst_global_add(UPF_METR_GLOB_CTR_QER_MARKEDPKT,
+                sess->qer.marked_pkts - sess->qer.exported_marked_pkts);
+        sess->qer.exported_marked_pkts = sess->qer.marked_pkts;
+    }
+    if (sess->qer.dropped_pkts != sess->qer.exported_dropped_pkts) {
+        upf_metrics_inst_global_add(UPF_METR_GLOB_CTR_QER_DROPPEDPKT,
+                sess->qer.dropped_pkts - sess->qer.exported_dropped_pkts);
+        sess->qer.exported_dropped_pkts = sess->qer.dropped_pkts;
+    }
+}
+
+static void upf_qer_metrics_cb(void *data)
+{
+    upf_sess_t *sess = NULL;
+
+    ogs_list_for_each(&self.sess_list, sess)
+        upf_sess_qer_metrics_export(sess);
+
+    ogs_timer_start(self.t_qer_metrics, UPF_QER_METRICS_INTERVAL);
 }
 
 /* report struct must be memzeroed before first use of this function.
@@ -712,9 +857,10 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
 {
     upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
     ogs_time_t last_report_timestamp;
-    ogs_time_t now;
+    ogs_time_t now, monotonic;
 
-    now = ogs_time_now(); /* we need UTC for start_time and end_time */
+    now = ogs_loop_time_now(); /* we need UTC for start_time and end_time */
+    monotonic = ogs_loop_monotonic_time();
 
     if (urr_acc->last_report.timestamp)
         last_report_timestamp = urr_acc->last_report.timestamp;
@@ -733,18 +879,27 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
         .dlvol = 1,
         .ulvol = 1,
         .tovol = 1,
-        .total_volume = urr_acc->total_octets - urr_acc->last_report.total_octets,
         .uplink_volume = urr_acc->ul_octets - urr_acc->last_report.ul_octets,
         .downlink_volume = urr_acc->dl_octets - urr_acc->last_report.dl_octets,
-        .total_n_packets = urr_acc->total_pkts - urr_acc->last_report.total_pkts,
         .uplink_n_packets = urr_acc->ul_pkts - urr_acc->last_report.ul_pkts,
         .downlink_n_packets = urr_acc->dl_pkts - urr_acc->last_report.dl_pkts,
     };
+    report->usage_report[idx].vol_measurement.total_volume =
+        report->usage_report[idx].vol_measurement.uplink_volume +
+        report->usage_report[idx].vol_measurement.downlink_volume;
+    report->usage_report[idx].vol_measurement.total_n_packets =
+        report->usage_report[idx].vol_measurement.uplink_n_packets +
+        report->usage_report[idx].vol_measurement.downlink_n_packets;
     if (now >= last_report_timestamp)
         report->usage_report[idx].dur_measurement = ((now - last_report_timestamp) + (OGS_USEC_PER_SEC/2)) / OGS_USEC_PER_SEC; /* FIXME: should use MONOTONIC here */
     /* else memset sets it to 0 */
-    report->usage_report[idx].time_of_first_packet = ogs_time_to_ntp32(urr_acc->time_of_first_packet); /* TODO: First since last report? */
-    report->usage_report[idx].time_of_last_packet = ogs_time_to_ntp32(urr_acc->time_of_last_packet);
+    /* Packet times are monotonic, taken once per data-plane wakeup */
+    if (urr_acc->time_of_first_packet)
+        report->usage_report[idx].time_of_first_packet = ogs_time_to_ntp32(
+                now - (monotonic - urr_acc->time_of_first_packet)); /* TODO: First since last report? */
+    if (urr_acc->time_of_last_packet)
+        report->usage_report[idx].time_of_last_packet = ogs_time_to_ntp32(
+                now - (monotonic - urr_acc->time_of_last_packet));
 
     /* Time triggers: */
     if (urr->quota_validity_time > 0 &&
@@ -764,18 +919,35 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
     if (urr->rep_triggers.volume_threshold && urr->vol_threshold.tovol &&
             report->usage_report[idx].vol_measurement.total_volume >= urr->vol_threshold.total_volume)
         report->usage_report[idx].rep_trigger.volume_threshold = 1;
+
+    /* Dropped DL traffic trigger: */
+    if (urr_acc_dropped_dl_traffic_reached(urr_acc, urr))
+        report->usage_report[idx].rep_trigger.dropped_dl_traffic_threshold = 1;
+
+    ogs_debug("URR[%d] dropped by QER: UL %llu pkts %llu bytes, "
+            "DL %llu pkts %llu bytes", urr->id,
+            (unsigned long long)(urr_acc->dropped_ul_pkts -
+                urr_acc->last_report.dropped_ul_pkts),
+            (unsigned long long)(urr_acc->dropped_ul_octets -
+                urr_acc->last_report.dropped_ul_octets),
+            (unsigned long long)(urr_acc->dropped_dl_pkts -
+                urr_acc->last_report.dropped_dl_pkts),
+            (unsigned long long)(urr_acc->dropped_dl_octets -
+                urr_acc->last_report.dropped_dl_octets));
 }
 
 void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
 {
     upf_sess_urr_acc_t *urr_acc = &sess->urr_acc[urr->id];
-    urr_acc->last_report.total_octets = urr_acc->total_octets;
     urr_acc->last_report.dl_octets = urr_acc->dl_octets;
     urr_acc->last_report.ul_octets = urr_acc->ul_octets;
-    urr_acc->last_report.total_pkts = urr_acc->total_pkts;
     urr_acc->last_report.dl_pkts = urr_acc->dl_pkts;
     urr_acc->last_report.ul_pkts = urr_acc->ul_pkts;
-    urr_acc->last_report.timestamp = ogs_time_now();
+    urr_acc->last_report.dropped_ul_octets = urr_acc->dropped_ul_octets;
+    urr_acc->last_report.dropped_ul_pkts = urr_acc->dropped_ul_pkts;
+    urr_acc->last_report.dropped_dl_octets = urr_acc->dropped_dl_octets;
+    urr_acc->last_report.dropped_dl_pkts = urr_acc->dropped_dl_pkts;
+    urr_acc->last_report.timestamp = ogs_loop_time_now();
 }
 
 static void upf_sess_urr_acc_timers_cb(void *data)
@@ -45,54 +45,71 @@ extern int __upf_log_domain;
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __upf_log_domain
 
-struct upf_route_trie_node;
+#define UPF_MAX_NUM_OF_WORKER 64
 
 typedef struct upf_context_s {
-    ogs_hash_t *upf_n4_seid_hash;   /* hash table (UPF-N4-SEID) */
-    ogs_hash_t *smf_n4_seid_hash;   /* hash table (SMF-N4-SEID) */
-    ogs_hash_t *smf_n4_f_seid_hash; /* hash table (SMF-N4-F-SEID) */
-    ogs_hash_t *ipv4_hash;  /* hash table (IPv4 Address) */
-    ogs_hash_t *ipv6_hash;  /* hash table (IPv6 Address) */
-
-    /* IPv4 framed routes trie */
-    struct upf_route_trie_node *ipv4_framed_routes;
-    /* IPv6 framed routes trie */
-    struct upf_route_trie_node *ipv6_framed_routes;
+    ogs_hmap_t *upf_n4_seid_hash;   /* hash table (UPF-N4-SEID) */
+    ogs_hmap_t *smf_n4_seid_hash;   /* hash table (SMF-N4-SEID) */
+    ogs_hmap_t *smf_n4_f_seid_hash; /* hash table (SMF-N4-F-SEID) */
+    ogs_lpm_t *ipv4_lpm;    /* LPM (IPv4 Address, IPv4 Framed Route) */
+    ogs_lpm_t *ipv6_lpm;    /* LPM (IPv6 Prefix, IPv6 Framed Route) */
 
     ogs_list_t sess_list;
-} upf_context_t;
 
-/* trie mapping from IP framed routes to session. */
-struct upf_route_trie_node {
-    struct upf_route_trie_node *left;
-    struct upf_route_trie_node *right;
-    upf_sess_t *sess;
-};
+    /*
+     * Data-plane worker threads (0 : G-PDUs are handled in upf_main)
+     *
+     * The workers only take the read lock, upf_main takes the write lock
+     * while PFCP messages and timers modify the sessions.
+     */
+    int num_of_worker;
+    ogs_thread_rwlock_t rwlock;
+
+    /* Exports the QER counters of the sessions to the metrics */
+    ogs_timer_t *t_qer_metrics;
+} upf_context_t;
 
 /* Accounting: */
 typedef struct upf_sess_urr_acc_s {
+    /*
+     * Written for every packet, so kept together at the head.
+     * Volume thresholds and quotas are not checked here, but once per
+     * wakeup by upf_sess_urr_acc_sweep().
+     *
+     * Not aligned to a cache line : the sessions come from an ogs_pool that
+     * only guarantees the alignment of malloc().
+     */
+    struct {
+        uint64_t ul_octets;
+        uint64_t ul_pkts;
+        uint64_t dl_octets;
+        uint64_t dl_pkts;
+        ogs_time_t time_of_first_packet; /* Monotonic time */
+        ogs_time_t time_of_last_packet; /* Monotonic time */
+        bool pending; /* Queued for the sweep */
+    };
+
+    uint64_t dropped_ul_octets; /* Dropped by the QER */
+    uint64_t dropped_ul_pkts;
+    uint64_t dropped_dl_octets;
+    uint64_t dropped_dl_pkts;
+
     bool reporting_enabled;
     ogs_timer_t *t_validity_time; /* Quota Validity Time expiration handler */
     ogs_timer_t *t_time_quota; /* Time Quota expiration handler */
     ogs_timer_t *t_time_threshold; /* Time Threshold expiration handler */
     uint32_t time_start; /* When t_time_* started */
     ogs_pfcp_urr_ur_seqn_t report_seqn; /* Next seqn to use when reporting */
-    uint64_t total_octets;
-    uint64_t ul_octets;
-    uint64_t dl_octets;
-    uint64_t total_pkts;
-    uint64_t ul_pkts;
-    uint64_t dl_pkts;
-    ogs_time_t time_of_first_packet;
-    ogs_time_t time_of_last_packet;
     /* Snapshot of measurement when last report was sent: */
     struct {
-        uint64_t total_octets;
         uint64_t ul_octets;
         uint64_t dl_octets;
-        uint64_t total_pkts;
         uint64_t ul_pkts;
         uint64_t dl_pkts;
+        uint64_t dropped_ul_octets;
+        uint64_t dropped_ul_pkts;
+        uint64_t dropped_dl_octets;
+        uint64_t dropped_dl_pkts;
         ogs_time_t timestamp;
     } last_report;
 } upf_sess_urr_acc_t;
@@ -123,6 +140,25 @@ typedef struct upf_sess_s {
     /* Accounting: */
     upf_sess_urr_acc_t urr_acc[OGS_MAX_NUM_OF_URR]; /* FIXME: This probably needs to be mved to a hashtable or alike */
     char            *apn_dnn;            /* APN/DNN Item */
+
+    /* PDRs compiled by upf_sess_build_classifier() */
+    ogs_pfcp_classifier_t dl_classifier;
+    ogs_pfcp_classifier_t ul_classifier;
+    ogs_pfcp_pdr_t  *dl_fallback_pdr;   /* Lowest precedence downlink PDR */
+
+    /*
+     * Counted by the data path, added to the global metrics
+     * by the control thread in upf_sess_qer_metrics_export()
+     */
+    struct {
+        uint64_t    marked_pkts;        /* Forwarded above the GBR */
+        uint64_t    dropped_pkts;       /* Dropped by the MBR or the gate */
+        uint64_t    exported_marked_pkts;
+        uint64_t    exported_dropped_pkts;
+    } qer;
+
+    /* Serializes the data-plane workers updating URRs and buffers */
+    ogs_thread_mutex_t mutex;
 } upf_sess_t;
 
 void upf_context_init(void);
@@ -131,6 +167,11 @@ upf_context_t *upf_self(void);
 
 int upf_context_parse_config(void);
 
+void upf_context_rdlock(void);
+void upf_context_rdunlock(void);
+void upf_context_wrlock(void);
+void upf_context_wrunlock(void);
+
 upf_sess_t *upf_sess_add_by_message(ogs_pfcp_message_t *message);
 
 upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *f_seid);
@@ -142,6 +183,9 @@ upf_sess_t *upf_sess_find_by_upf_n4_seid(uint64_t seid);
 upf_sess_t *upf_sess_find_by_ipv4(uint32_t addr);
 upf_sess_t *upf_sess_find_by_ipv6(uint32_t *addr6);
 
+void upf_sess_lock(upf_sess_t *sess);
+void upf_sess_unlock(upf_sess_t *sess);
+
 uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
         uint8_t session_type, ogs_pfcp_pdr_t *pdr);
 uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
@@ -149,7 +193,14 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
 uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
         char *framed_routes[]);
 
-void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink);
+void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink, ogs_time_t now);
+void upf_sess_urr_acc_drop(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink);
+void upf_sess_urr_acc_sweep(void);
+bool upf_sess_qer_meter(upf_sess_t *sess, ogs_pfcp_pdr_t *pdr,
+        size_t size, bool is_uplink, ogs_time_t now);
+void upf_sess_qer_metrics_export(upf_sess_t *sess);
 void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *urr,
                                         ogs_pfcp_user_plane_report_t *report, unsigned int idx);
 void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr);
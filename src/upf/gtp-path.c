@@ -59,6 +59,34 @@ const uint8_t proxy_mac_addr[] = { 0x0e, 0x00, 0x00, 0x00, 0x00, 0x01 };
 
 static ogs_pkbuf_pool_t *packet_pool = NULL;
 
+/*
+ * Data-plane worker
+ *
+ * Without upf.worker, a single worker polls on ogs_app()->pollset
+ * and runs in upf_main. Otherwise, each worker runs its own thread
+ * and pollset. Worker 0 polls the GTP-U sockets and the first queue
+ * of the TUN devices, the others poll their own SO_REUSEPORT sockets
+ * and TUN queues.
+ */
+typedef struct upf_gtp_worker_s {
+    ogs_thread_t *thread;
+    bool terminated;            /* Set by upf_main, read by the worker */
+
+    ogs_pollset_t *pollset;
+
+    ogs_list_t *gtpu_list;      /* GTP-U sockets polled by this worker */
+    ogs_list_t reuseport_list;  /* SO_REUSEPORT sockets (Worker 1..N-1) */
+
+    int num_of_tun;
+    ogs_socket_t tun_fd[OGS_MAX_NUM_OF_DEV];
+    ogs_poll_t *tun_poll[OGS_MAX_NUM_OF_DEV];
+
+    ogs_pkbuf_t *recv_pkbuf[OGS_MAX_MMSG];
+} upf_gtp_worker_t;
+
+static upf_gtp_worker_t *worker = NULL;
+static int num_of_worker = 0;
+
 static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf);
 
 static int check_framed_routes(upf_sess_t *sess, int family, uint32_t *addr)
@@ -99,23 +127,16 @@ static uint16_t _get_eth_type(uint8_t *data, uint len) {
     return 0;
 }
 
-static void _gtpv1_tun_recv_common_cb(
-        short when, ogs_socket_t fd, bool has_eth, void *data)
+static void _gtpv1_tun_handle(ogs_socket_t fd,
+        bool has_eth, ogs_pkbuf_t *recvbuf, ogs_time_t now)
 {
-    ogs_pkbuf_t *recvbuf = NULL;
-
     upf_sess_t *sess = NULL;
     ogs_pfcp_pdr_t *pdr = NULL;
-    ogs_pfcp_pdr_t *fallback_pdr = NULL;
-    ogs_pfcp_far_t *far = NULL;
+    ogs_pfcp_flow_key_t key;
     ogs_pfcp_user_plane_report_t report;
     int i;
 
-    recvbuf = ogs_tun_read(fd, packet_pool);
-    if (!recvbuf) {
-        ogs_warn("ogs_tun_read() failed");
-        return;
-    }
+    ogs_assert(recvbuf);
 
     if (has_eth) {
         ogs_pkbuf_t *replybuf = NULL;
@@ -127,7 +148,8 @@ static void _gtpv1_tun_recv_common_cb(
                     upf_sess_find_by_ipv4(
                         arp_parse_target_addr(recvbuf->data, recvbuf->len))) {
                 replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-                ogs_assert(replybuf);
+                if (!replybuf)
+                    goto cleanup;
                 ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
                 ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
                 size = arp_reply(replybuf->data, recvbuf->data, recvbuf->len,
@@ -140,7 +162,8 @@ static void _gtpv1_tun_recv_common_cb(
         } else if (eth_type == ETHERTYPE_IPV6 &&
                     is_nd_req(recvbuf->data, recvbuf->len)) {
             replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-            ogs_assert(replybuf);
+            if (!replybuf)
+                goto cleanup;
             ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
             ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
             size = nd_reply(replybuf->data, recvbuf->data, recvbuf->len,
@@ -167,51 +190,32 @@ static void _gtpv1_tun_recv_common_cb(
     if (!sess)
         goto cleanup;
 
-    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
-        far = pdr->far;
-        ogs_assert(far);
-
-        /* Check if PDR is Downlink */
-        if (pdr->src_if != OGS_PFCP_INTERFACE_CORE)
-            continue;
-
-        /* Save the Fallback PDR : Lowest precedence downlink PDR */
-        fallback_pdr = pdr;
-
-        /* Check if FAR is Downlink */
-        if (far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
-            continue;
-
-        /* Check if Outer header creation */
-        if (far->outer_header_creation.ip4 == 0 &&
-            far->outer_header_creation.ip6 == 0 &&
-            far->outer_header_creation.udp4 == 0 &&
-            far->outer_header_creation.udp6 == 0 &&
-            far->outer_header_creation.gtpu4 == 0 &&
-            far->outer_header_creation.gtpu6 == 0)
-            continue;
+    if (ogs_pfcp_flow_key_parse(&key, recvbuf) != OGS_OK)
+        goto cleanup;
 
-        /* Check if Rule List in PDR */
-        if (ogs_list_first(&pdr->rule_list) &&
-            ogs_pfcp_pdr_rule_find_by_packet(pdr, recvbuf) == NULL)
-            continue;
-
-        break;
-    }
+    upf_sess_lock(sess);
 
+    pdr = ogs_pfcp_classifier_find(&sess->dl_classifier, &key);
     if (!pdr)
-        pdr = fallback_pdr;
+        pdr = sess->dl_fallback_pdr;
 
     if (!pdr) {
+        upf_sess_unlock(sess);
         if (ogs_app()->parameter.multicast) {
             upf_gtp_handle_multicast(recvbuf);
         }
         goto cleanup;
     }
 
+    /* Enforce MBR/GBR of QER */
+    if (upf_sess_qer_meter(sess, pdr, recvbuf->len, false, now) == false) {
+        upf_sess_unlock(sess);
+        goto cleanup;
+    }
+
     /* Increment total & dl octets + pkts */
     for (i = 0; i < pdr->num_of_urr; i++)
-        upf_sess_urr_acc_add(sess, pdr->urr[i], recvbuf->len, false);
+        upf_sess_urr_acc_add(sess, pdr->urr[i], recvbuf->len, false, now);
 
     ogs_assert(true == ogs_pfcp_up_handle_pdr(
                 pdr, OGS_GTPU_MSGTYPE_GPDU, recvbuf, &report));
@@ -238,14 +242,50 @@ static void _gtpv1_tun_recv_common_cb(
         if (pdr->qer && pdr->qer->qfi)
             report.downlink_data.qfi = pdr->qer->qfi; /* for 5GC */
 
-        ogs_assert(OGS_OK ==
-            upf_pfcp_send_session_report_request(sess, &report));
+        ogs_expect(OGS_OK == upf_pfcp_send_data_plane_report(sess, &report));
     }
 
+    upf_sess_unlock(sess);
+
 cleanup:
     ogs_pkbuf_free(recvbuf);
 }
 
+static void _gtpv1_tun_recv_common_cb(
+        short when, ogs_socket_t fd, bool has_eth, void *data)
+{
+    ogs_pkbuf_t *recvbuf = NULL;
+    ogs_time_t now;
+    int i;
+
+    /* QER token buckets and URR packet times use one clock per wakeup */
+    now = ogs_loop_monotonic_time();
+
+    upf_context_rdlock();
+
+    /*
+     * Drain up to gtpu_batch packets per wakeup so that the G-PDUs
+     * towards the same peer can leave in a single sendmmsg().
+     */
+    for (i = 0; i < ogs_gtp_self()->gtpu_batch; i++) {
+        recvbuf = ogs_tun_read(fd, packet_pool);
+        if (!recvbuf) {
+            if (i == 0)
+                ogs_warn("ogs_tun_read() failed");
+            break;
+        }
+
+        _gtpv1_tun_handle(fd, has_eth, recvbuf, now);
+    }
+
+    upf_sess_urr_acc_sweep();
+
+    /* The peers stay valid while the context is read-locked */
+    ogs_gtp_flush_all();
+
+    upf_context_rdunlock();
+}
+
 static void _gtpv1_tun_recv_cb(short when, ogs_socket_t fd, void *data)
 {
     _gtpv1_tun_recv_common_cb(when, fd, false, data);
@@ -256,46 +296,30 @@ static void _gtpv1_tun_recv_eth_cb(short when, ogs_socket_t fd, void *data)
     _gtpv1_tun_recv_common_cb(when, fd, true, data);
 }
 
-static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+static void _gtpv1_u_handle(ogs_sock_t *sock, ogs_socket_t fd,
+        ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from, ogs_time_t now)
 {
     int len;
-    ssize_t size;
     char buf1[OGS_ADDRSTRLEN];
     char buf2[OGS_ADDRSTRLEN];
 
     upf_sess_t *sess = NULL;
 
-    ogs_pkbuf_t *pkbuf = NULL;
-    ogs_sock_t *sock = NULL;
-    ogs_sockaddr_t from;
-
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_pfcp_user_plane_report_t report;
 
     uint32_t teid;
     uint8_t qfi;
 
-    ogs_assert(fd != INVALID_SOCKET);
-    sock = data;
     ogs_assert(sock);
-
-    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
     ogs_assert(pkbuf);
-    ogs_pkbuf_reserve(pkbuf, OGS_TUN_MAX_HEADROOM);
-    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+    ogs_assert(from);
 
-    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
-    if (size <= 0) {
-        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                "ogs_recv() failed");
+    if (!pkbuf->len) {
+        ogs_error("[DROP] Empty GTPU packet from [%s]", OGS_ADDR(from, buf1));
         goto cleanup;
     }
 
-    ogs_pkbuf_trim(pkbuf, size);
-
-    ogs_assert(pkbuf);
-    ogs_assert(pkbuf->len);
-
     gtp_h = (ogs_gtp2_header_t *)pkbuf->data;
     if (gtp_h->version != OGS_GTP2_VERSION_1) {
         ogs_error("[DROP] Invalid GTPU version [%d]", gtp_h->version);
@@ -306,16 +330,16 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     if (gtp_h->type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
         ogs_pkbuf_t *echo_rsp;
 
-        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(&from, buf1));
+        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(from, buf1));
         echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
         ogs_expect(echo_rsp);
         if (echo_rsp) {
             ssize_t sent;
 
             /* Echo reply */
-            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(&from, buf1));
+            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(from, buf1));
 
-            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, &from);
+            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, from);
             if (sent < 0 || sent != echo_rsp->len) {
                 ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                         "ogs_sendto() failed");
@@ -328,7 +352,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     teid = be32toh(gtp_h->teid);
 
     ogs_trace("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
-            gtp_h->type, OGS_ADDR(&from, buf1), teid);
+            gtp_h->type, OGS_ADDR(from, buf1), teid);
 
     qfi = 0;
     if (gtp_h->flags & OGS_GTPU_FLAGS_E) {
@@ -385,8 +409,8 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 sess = UPF_SESS(far->sess);
                 ogs_assert(sess);
 
-                ogs_assert(OGS_OK ==
-                    upf_pfcp_send_session_report_request(sess, &report));
+                ogs_expect(OGS_OK ==
+                    upf_pfcp_send_data_plane_report(sess, &report));
             }
 
         } else {
@@ -402,6 +426,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         ogs_pfcp_sess_t *pfcp_sess = NULL;
         ogs_pfcp_pdr_t *pdr = NULL;
         ogs_pfcp_far_t *far = NULL;
+        ogs_pfcp_flow_key_t key;
 
         ogs_pfcp_subnet_t *subnet = NULL;
         ogs_pfcp_dev_t *dev = NULL;
@@ -441,8 +466,8 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_error("[%s] Send Error Indication [TEID:0x%x] to [%s]",
                         OGS_ADDR(&sock->local_addr, buf1),
                         teid,
-                        OGS_ADDR(&from, buf2));
-                ogs_gtp1_send_error_indication(sock, teid, qfi, &from);
+                        OGS_ADDR(from, buf2));
+                ogs_gtp1_send_error_indication(sock, teid, qfi, from);
             }
             goto cleanup;
         }
@@ -458,28 +483,15 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
             pfcp_sess = (ogs_pfcp_sess_t *)pfcp_object;
             ogs_assert(pfcp_sess);
 
-            ogs_list_for_each(&pfcp_sess->pdr_list, pdr) {
+            sess = UPF_SESS(pfcp_sess);
+            ogs_assert(sess);
 
-                /* Check if Source Interface */
-                if (pdr->src_if != OGS_PFCP_INTERFACE_ACCESS &&
-                    pdr->src_if != OGS_PFCP_INTERFACE_CP_FUNCTION)
-                    continue;
+            /* A non-IP G-PDU only matches a PDR without SDF Filter */
+            if (ogs_pfcp_flow_key_parse(&key, pkbuf) != OGS_OK)
+                ogs_assert(key.addr_len == 0);
 
-                /* Check if TEID */
-                if (teid != pdr->f_teid.teid)
-                    continue;
-
-                /* Check if QFI */
-                if (qfi && pdr->qfi != qfi)
-                    continue;
-
-                /* Check if Rule List in PDR */
-                if (ogs_list_first(&pdr->rule_list) &&
-                    ogs_pfcp_pdr_rule_find_by_packet(pdr, pkbuf) == NULL)
-                    continue;
-
-                break;
-            }
+            pdr = ogs_pfcp_classifier_find_by_teid(
+                    &sess->ul_classifier, &key, teid, qfi);
 
             if (!pdr) {
                 /*
@@ -499,8 +511,8 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                             "[%s] Send Error Indication [TEID:0x%x] to [%s]",
                             OGS_ADDR(&sock->local_addr, buf1),
                             teid,
-                            OGS_ADDR(&from, buf2));
-                    ogs_gtp1_send_error_indication(sock, teid, qfi, &from);
+                            OGS_ADDR(from, buf2));
+                    ogs_gtp1_send_error_indication(sock, teid, qfi, from);
                 }
                 goto cleanup;
             }
@@ -521,6 +533,14 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         far = pdr->far;
         ogs_assert(far);
 
+        /* Enforce MBR/GBR of QER */
+        upf_sess_lock(sess);
+        if (upf_sess_qer_meter(sess, pdr, pkbuf->len, true, now) == false) {
+            upf_sess_unlock(sess);
+            goto cleanup;
+        }
+        upf_sess_unlock(sess);
+
         if (ip_h->ip_v == 4 && sess->ipv4) {
             src_addr = (void *)&ip_h->ip_src.s_addr;
             ogs_assert(src_addr);
@@ -658,8 +678,11 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
             ogs_assert(dev);
 
             /* Increment total & ul octets + pkts */
+            upf_sess_lock(sess);
             for (i = 0; i < pdr->num_of_urr; i++)
-                upf_sess_urr_acc_add(sess, pdr->urr[i], pkbuf->len, true);
+                upf_sess_urr_acc_add(
+                        sess, pdr->urr[i], pkbuf->len, true, now);
+            upf_sess_unlock(sess);
 
             if (dev->is_tap) {
                 ogs_assert(eth_type);
@@ -677,6 +700,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_warn("ogs_tun_write() failed");
 
         } else if (far->dst_if == OGS_PFCP_INTERFACE_ACCESS) {
+            upf_sess_lock(sess);
             ogs_assert(true == ogs_pfcp_up_handle_pdr(
                         pdr, gtp_h->type, pkbuf, &report));
 
@@ -687,9 +711,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 if (pdr->qer && pdr->qer->qfi)
                     report.downlink_data.qfi = pdr->qer->qfi; /* for 5GC */
 
-                ogs_assert(OGS_OK ==
-                    upf_pfcp_send_session_report_request(sess, &report));
+                ogs_expect(OGS_OK ==
+                    upf_pfcp_send_data_plane_report(sess, &report));
             }
+            upf_sess_unlock(sess);
 
         } else if (far->dst_if == OGS_PFCP_INTERFACE_CP_FUNCTION) {
 
@@ -704,8 +729,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 goto cleanup;
             }
 
+            upf_sess_lock(sess);
             ogs_assert(true == ogs_pfcp_up_handle_pdr(
                         pdr, gtp_h->type, pkbuf, &report));
+            upf_sess_unlock(sess);
 
             ogs_assert(report.type.downlink_data_report == 0);
 
@@ -722,12 +749,117 @@ cleanup:
     ogs_pkbuf_free(pkbuf);
 }
 
+static ogs_sock_t *worker_gtpu_sock(upf_gtp_worker_t *w, ogs_socket_t fd)
+{
+    ogs_socknode_t *node = NULL;
+
+    ogs_list_for_each(w->gtpu_list, node) {
+        if (node->sock && node->sock->fd == fd)
+            return node->sock;
+    }
+
+    return NULL;
+}
+
+static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+{
+    int i, n, batch;
+    upf_gtp_worker_t *w = NULL;
+    ogs_sock_t *sock = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_sockaddr_t from[OGS_MAX_MMSG];
+    ogs_time_t now;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    w = data;
+    ogs_assert(w);
+    sock = worker_gtpu_sock(w, fd);
+    ogs_assert(sock);
+
+    batch = ogs_gtp_self()->gtpu_batch;
+    ogs_assert(batch > 0 && batch <= OGS_MAX_MMSG);
+
+    /*
+     * Only the slots consumed by the previous wakeup need a new buffer.
+     * When the pool runs out, the batch shrinks to the slots filled so far.
+     */
+    for (i = 0; i < batch; i++) {
+        if (w->recv_pkbuf[i])
+            continue;
+
+        w->recv_pkbuf[i] = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
+        if (!w->recv_pkbuf[i])
+            break;
+        ogs_pkbuf_reserve(w->recv_pkbuf[i], OGS_TUN_MAX_HEADROOM);
+        ogs_pkbuf_put(w->recv_pkbuf[i], OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+    }
+
+    if (i == 0) {
+        uint8_t dropbuf[OGS_MAX_PKT_LEN];
+
+        /* Take the packet off the socket so that the poll does not spin */
+        ogs_error("[DROP] No packet buffer");
+        if (ogs_recv(fd, dropbuf, sizeof(dropbuf), 0) < 0)
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_recv() failed");
+        return;
+    }
+
+    n = ogs_recvmmsg(fd, w->recv_pkbuf, from, i, 0);
+    if (n <= 0) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                "ogs_recvmmsg() failed");
+        return;
+    }
+
+    /* QER token buckets and URR packet times use one clock per wakeup */
+    now = ogs_loop_monotonic_time();
+
+    upf_context_rdlock();
+
+    for (i = 0; i < n; i++) {
+        pkbuf = w->recv_pkbuf[i];
+        w->recv_pkbuf[i] = NULL;
+
+        _gtpv1_u_handle(sock, fd, pkbuf, &from[i], now);
+    }
+
+    upf_sess_urr_acc_sweep();
+
+    /* The peers stay valid while the context is read-locked */
+    ogs_gtp_flush_all();
+
+    upf_context_rdunlock();
+}
+
+static void upf_gtp_worker_main(void *data)
+{
+    upf_gtp_worker_t *w = data;
+    ogs_assert(w);
+
+    while (__atomic_load_n(&w->terminated, __ATOMIC_ACQUIRE) == false)
+        ogs_pollset_poll(w->pollset, OGS_INFINITE_TIME);
+}
+
 int upf_gtp_init(void)
 {
     ogs_pkbuf_config_t config;
     memset(&config, 0, sizeof config);
 
-    config.cluster_2048_pool = ogs_app()->pool.packet;
+    /*
+     * Packets in flight, per thread (the workers and upf_main): the
+     * receive batch, the pkbuf cache, and the G-PDUs waiting for
+     * sendmmsg() in the transmit batches of up to OGS_GTP_MAX_TX_BATCH
+     * peers. TUN reads, ARP/ND and ICMP replies share the same clusters,
+     * so twice that plus one packet per UE is kept as headroom.
+     * On exhaustion the packet is dropped. This only bounds the pool
+     * without talloc, downlink data buffering is bounded by its own
+     * byte count (see ogs_pfcp_far_buffer_add()).
+     */
+    config.cluster_2048_pool = 2 * (upf_self()->num_of_worker + 1) *
+            (OGS_MAX_MMSG * 2 +
+             OGS_GTP_MAX_TX_BATCH * ogs_gtp_self()->gtpu_batch) +
+        ogs_app()->max.ue;
 
 #if OGS_USE_TALLOC == 1
     /* allocate a talloc pool for GTP to ensure it doesn't have to go back
@@ -737,12 +869,14 @@ int upf_gtp_init(void)
 #else
     packet_pool = ogs_pkbuf_pool_create(&config);
 #endif
+    ogs_pfcp_self()->buffer.pool = packet_pool;
 
     return OGS_OK;
 }
 
 void upf_gtp_final(void)
 {
+    ogs_pfcp_self()->buffer.pool = NULL;
     ogs_pkbuf_pool_destroy(packet_pool);
 }
 
@@ -772,6 +906,148 @@ static void _get_dev_mac_addr(char *ifname, uint8_t *mac_addr)
 #endif
 }
 
+static void upf_gtp_worker_open(void)
+{
+    int i;
+
+    num_of_worker = ogs_max(upf_self()->num_of_worker, 1);
+    worker = ogs_calloc(num_of_worker, sizeof(*worker));
+    ogs_assert(worker);
+
+    for (i = 0; i < num_of_worker; i++) {
+        if (upf_self()->num_of_worker) {
+            worker[i].pollset = ogs_pollset_create(ogs_app()->pool.socket);
+            ogs_assert(worker[i].pollset);
+        } else {
+            worker[i].pollset = ogs_app()->pollset;
+        }
+
+        if (i == 0)
+            worker[i].gtpu_list = &ogs_gtp_self()->gtpu_list;
+        else
+            worker[i].gtpu_list = &worker[i].reuseport_list;
+    }
+
+    if (upf_self()->num_of_worker)
+        ogs_info("%d data-plane workers", num_of_worker);
+}
+
+static int upf_gtp_worker_open_gtpu(ogs_socknode_t *main_node)
+{
+    int i;
+    ogs_socknode_t *node = NULL;
+    ogs_sock_t *sock = NULL;
+
+    ogs_assert(main_node);
+
+    for (i = 1; i < num_of_worker; i++) {
+        node = ogs_socknode_add(&worker[i].reuseport_list,
+                AF_UNSPEC, main_node->addr, main_node->option);
+        ogs_assert(node);
+
+        sock = ogs_udp_server(node->addr, node->option);
+        if (!sock) return OGS_ERROR;
+        node->sock = sock;
+
+        node->poll = ogs_pollset_add(worker[i].pollset,
+                OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, &worker[i]);
+        ogs_assert(node->poll);
+    }
+
+    return OGS_OK;
+}
+
+static int upf_gtp_worker_open_tun(ogs_pfcp_dev_t *dev)
+{
+    int i;
+    ogs_socket_t fd[UPF_MAX_NUM_OF_WORKER];
+    ogs_poll_handler_f handler;
+
+    ogs_assert(dev);
+
+    if (ogs_tun_open_multi_queue(dev->ifname, OGS_MAX_IFNAME_LEN,
+                dev->is_tap, fd, num_of_worker) != OGS_OK)
+        return OGS_ERROR;
+
+    handler = dev->is_tap ? _gtpv1_tun_recv_eth_cb : _gtpv1_tun_recv_cb;
+
+    /* Queue 0 is kept in the device, the others belong to the workers */
+    dev->fd = fd[0];
+    dev->poll = ogs_pollset_add(worker[0].pollset,
+            OGS_POLLIN, dev->fd, handler, NULL);
+    ogs_assert(dev->poll);
+
+    for (i = 1; i < num_of_worker; i++) {
+        upf_gtp_worker_t *w = &worker[i];
+
+        ogs_assert(w->num_of_tun < OGS_MAX_NUM_OF_DEV);
+        w->tun_fd[w->num_of_tun] = fd[i];
+        w->tun_poll[w->num_of_tun] = ogs_pollset_add(w->pollset,
+                OGS_POLLIN, fd[i], handler, NULL);
+        ogs_assert(w->tun_poll[w->num_of_tun]);
+        w->num_of_tun++;
+    }
+
+    return OGS_OK;
+}
+
+static void upf_gtp_worker_start(void)
+{
+    int i;
+
+    if (!upf_self()->num_of_worker)
+        return;
+
+    for (i = 0; i < num_of_worker; i++) {
+        worker[i].thread = ogs_thread_create(upf_gtp_worker_main, &worker[i]);
+        ogs_assert(worker[i].thread);
+    }
+}
+
+static void upf_gtp_worker_stop(void)
+{
+    int i;
+
+    for (i = 0; i < num_of_worker; i++) {
+        if (!worker[i].thread)
+            continue;
+
+        __atomic_store_n(&worker[i].terminated, true, __ATOMIC_RELEASE);
+        ogs_pollset_notify(worker[i].pollset);
+
+        ogs_thread_destroy(worker[i].thread);
+        worker[i].thread = NULL;
+    }
+}
+
+static void upf_gtp_worker_close(void)
+{
+    int i, j;
+
+    for (i = 0; i < num_of_worker; i++) {
+        upf_gtp_worker_t *w = &worker[i];
+
+        ogs_socknode_remove_all(&w->reuseport_list);
+
+        for (j = 0; j < w->num_of_tun; j++) {
+            ogs_pollset_remove(w->tun_poll[j]);
+            ogs_closesocket(w->tun_fd[j]);
+        }
+
+        for (j = 0; j < OGS_MAX_MMSG; j++) {
+            if (w->recv_pkbuf[j])
+                ogs_pkbuf_free(w->recv_pkbuf[j]);
+        }
+
+        if (w->pollset != ogs_app()->pollset)
+            ogs_pollset_destroy(w->pollset);
+    }
+
+    ogs_free(worker);
+    worker = NULL;
+    num_of_worker = 0;
+}
+
 int upf_gtp_open(void)
 {
     ogs_pfcp_dev_t *dev = NULL;
@@ -780,7 +1056,19 @@ int upf_gtp_open(void)
     ogs_sock_t *sock = NULL;
     int rc;
 
+    upf_gtp_worker_open();
+
     ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
+        if (upf_self()->num_of_worker) {
+            /* Every worker binds its own socket to the same address */
+            if (!node->option) {
+                node->option = ogs_malloc(sizeof(*node->option));
+                ogs_assert(node->option);
+                ogs_sockopt_init(node->option);
+            }
+            node->option->so_reuseport = true;
+        }
+
         sock = ogs_gtp_server(node);
         if (!sock) return OGS_ERROR;
 
@@ -789,9 +1077,12 @@ int upf_gtp_open(void)
         else if (sock->family == AF_INET6)
             ogs_gtp_self()->gtpu_sock6 = sock;
 
-        node->poll = ogs_pollset_add(ogs_app()->pollset,
-                OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
+        node->poll = ogs_pollset_add(worker[0].pollset,
+                OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, &worker[0]);
         ogs_assert(node->poll);
+
+        rc = upf_gtp_worker_open_gtpu(node);
+        if (rc != OGS_OK) return rc;
     }
 
     OGS_SETUP_GTPU_SERVER;
@@ -800,6 +1091,10 @@ int upf_gtp_open(void)
      *
      * $ sudo ip tuntap add name ogstun mode tun
      *
+     * With upf.worker, the device needs the 'multi_queue' option.
+     *
+     * $ sudo ip tuntap add name ogstun mode tun multi_queue
+     *
      * Also, before running upf, assign the one IP from IP pool of UE
      * to ogstun. The IP should not be assigned to UE
      *
@@ -810,6 +1105,18 @@ int upf_gtp_open(void)
     /* Open Tun interface */
     ogs_list_for_each(&ogs_pfcp_self()->dev_list, dev) {
         dev->is_tap = strstr(dev->ifname, "tap");
+
+        if (upf_self()->num_of_worker) {
+            if (upf_gtp_worker_open_tun(dev) != OGS_OK) {
+                ogs_error("tun_open(dev:%s, queue:%d) failed",
+                        dev->ifname, num_of_worker);
+                return OGS_ERROR;
+            }
+            if (dev->is_tap)
+                _get_dev_mac_addr(dev->ifname, dev->mac_addr);
+            continue;
+        }
+
         dev->fd = ogs_tun_open(dev->ifname, OGS_MAX_IFNAME_LEN, dev->is_tap);
         if (dev->fd == INVALID_SOCKET) {
             ogs_error("tun_open(dev:%s) failed", dev->ifname);
@@ -850,6 +1157,8 @@ int upf_gtp_open(void)
         }
     }
 
+    upf_gtp_worker_start();
+
     return OGS_OK;
 }
 
@@ -857,6 +1166,8 @@ void upf_gtp_close(void)
 {
     ogs_pfcp_dev_t *dev = NULL;
 
+    upf_gtp_worker_stop();
+
     ogs_socknode_remove_all(&ogs_gtp_self()->gtpu_list);
 
     ogs_list_for_each(&ogs_pfcp_self()->dev_list, dev) {
@@ -864,6 +1175,8 @@ void upf_gtp_close(void)
             ogs_pollset_remove(dev->poll);
         ogs_closesocket(dev->fd);
     }
+
+    upf_gtp_worker_close();
 }
 
 static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
@@ -892,6 +1205,7 @@ static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
                     /* PDN IPv6 is avaiable */
                     ogs_pfcp_pdr_t *pdr = NULL;
 
+                    upf_sess_lock(sess);
                     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
                         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) {
                             ogs_assert(true ==
@@ -900,6 +1214,7 @@ static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
                             break;
                         }
                     }
+                    upf_sess_unlock(sess);
 
                     return;
                 }
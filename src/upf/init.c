@@ -38,7 +38,6 @@ int upf_initialize(void)
 
     upf_context_init();
     upf_event_init();
-    upf_gtp_init();
 
     rv = ogs_pfcp_xact_init();
     if (rv != OGS_OK) return rv;
@@ -55,6 +54,9 @@ int upf_initialize(void)
     rv = upf_context_parse_config();
     if (rv != OGS_OK) return rv;
 
+    rv = upf_gtp_init();
+    if (rv != OGS_OK) return rv;
+
     rv = ogs_log_config_domain(
             ogs_app()->logger.domain, ogs_app()->logger.level);
     if (rv != OGS_OK) return rv;
@@ -86,7 +88,11 @@ void upf_terminate(void)
 
     ogs_thread_destroy(thread);
 
+    /* Data-plane workers are still running until upf_gtp_close() */
+    upf_context_wrlock();
     upf_pfcp_close();
+    upf_context_wrunlock();
+
     upf_gtp_close();
 
     ogs_metrics_context_close(ogs_metrics_self());
@@ -112,6 +118,12 @@ static void upf_main(void *data)
     ogs_fsm_init(&upf_sm, upf_state_initial, upf_state_final, 0);
 
     for ( ;; ) {
+        /*
+         * Transmit the G-PDUs batched during the previous iteration
+         * before going to sleep in ogs_pollset_poll().
+         */
+        ogs_gtp_flush_all();
+
         ogs_pollset_poll(ogs_app()->pollset,
                 ogs_timer_mgr_next(ogs_app()->timer_mgr));
 
@@ -126,24 +138,36 @@ static void upf_main(void *data)
          * because 'if rv == OGS_DONE' statement is exiting and
          * not calling ogs_timer_mgr_expire().
          */
+
+        /* Data-plane workers must not see the sessions being modified */
+        upf_context_wrlock();
+
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            upf_event_t *e = NULL;
+            upf_event_t *e[OGS_QUEUE_POP_BATCH];
+            int i;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_n(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_POP_BATCH);
             ogs_assert(rv != OGS_ERROR);
 
-            if (rv == OGS_DONE)
+            if (rv == OGS_DONE) {
+                upf_context_wrunlock();
                 goto done;
+            }
 
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&upf_sm, e);
-            upf_event_free(e);
+            for (i = 0; i < rv; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&upf_sm, e[i]);
+                upf_event_free(e[i]);
+            }
         }
+
+        upf_context_wrunlock();
     }
 done:
 
@@ -76,6 +76,16 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "fivegs_upffunction_sm_n4sessionreportsucc",
     .description = "Number of successful N4 session reports",
 },
+[UPF_METR_GLOB_CTR_QER_MARKEDPKT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "fivegs_upffunction_upf_qermarkedpkt",
+    .description = "Number of data packets forwarded above the GBR of the QER",
+},
+[UPF_METR_GLOB_CTR_QER_DROPPEDPKT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "fivegs_upffunction_upf_qerdroppedpkt",
+    .description = "Number of data packets dropped by the MBR or the gate of the QER",
+},
 /* Global Gauges: */
 [UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR] = {
     .type = OGS_METRICS_METRIC_TYPE_GAUGE,
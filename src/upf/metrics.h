@@ -14,6 +14,8 @@ typedef enum upf_metric_type_global_s {
     UPF_METR_GLOB_CTR_SM_N4SESSIONESTABREQ,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORT,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORTSUCC,
+    UPF_METR_GLOB_CTR_QER_MARKEDPKT,
+    UPF_METR_GLOB_CTR_QER_DROPPEDPKT,
     UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR,
     _UPF_METR_GLOB_MAX,
 } upf_metric_type_global_t;
@@ -321,3 +321,72 @@ int upf_pfcp_send_session_report_request(
 
     return rv;
 }
+
+static int send_data_plane_report(
+        upf_sess_t *sess, ogs_pfcp_user_plane_report_t *report)
+{
+    int i, rv;
+
+    rv = upf_pfcp_send_session_report_request(sess, report);
+
+    /* Start new report period/iteration of the reported URRs */
+    for (i = 0; i < report->num_of_usage_report; i++) {
+        ogs_pfcp_urr_t *urr = ogs_pfcp_urr_find(
+                &sess->pfcp, report->usage_report[i].id);
+        if (urr)
+            upf_sess_urr_acc_timers_setup(sess, urr);
+    }
+
+    return rv;
+}
+
+/*
+ * Called from the G-PDU path. PFCP transactions and timers are owned
+ * by upf_main, so a data-plane worker hands the report over as an event.
+ */
+int upf_pfcp_send_data_plane_report(
+        upf_sess_t *sess, ogs_pfcp_user_plane_report_t *report)
+{
+    int rv;
+    upf_event_t *e = NULL;
+
+    ogs_assert(sess);
+    ogs_assert(report);
+
+    if (upf_self()->num_of_worker == 0)
+        return send_data_plane_report(sess, report);
+
+    e = upf_event_new(UPF_EVT_N4_DATA_PLANE_REPORT);
+    ogs_assert(e);
+    e->upf_n4_seid = sess->upf_n4_seid;
+    e->report = ogs_memdup(report, sizeof(*report));
+    ogs_assert(e->report);
+
+    rv = ogs_queue_push(ogs_app()->queue, e);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed:%d", (int)rv);
+        ogs_free(e->report);
+        upf_event_free(e);
+        return OGS_ERROR;
+    }
+    ogs_pollset_notify(ogs_app()->pollset);
+
+    return OGS_OK;
+}
+
+void upf_pfcp_handle_data_plane_report(upf_event_t *e)
+{
+    upf_sess_t *sess = NULL;
+
+    ogs_assert(e);
+    ogs_assert(e->report);
+
+    sess = upf_sess_find_by_upf_n4_seid(e->upf_n4_seid);
+    if (sess)
+        ogs_expect(OGS_OK == send_data_plane_report(sess, e->report));
+    else
+        ogs_warn("No Session [UPF-N4-SEID:0x%llx]",
+                (unsigned long long)e->upf_n4_seid);
+
+    ogs_free(e->report);
+}
@@ -41,6 +41,10 @@ int upf_pfcp_send_session_deletion_response(ogs_pfcp_xact_t *xact,
 int upf_pfcp_send_session_report_request(
         upf_sess_t *sess, ogs_pfcp_user_plane_report_t *report);
 
+int upf_pfcp_send_data_plane_report(
+        upf_sess_t *sess, ogs_pfcp_user_plane_report_t *report);
+void upf_pfcp_handle_data_plane_report(upf_event_t *e);
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,3 +65,48 @@ upf_sess_t *upf_sess_find_by_ue_ip_address(ogs_pkbuf_t *pkbuf)
 
     return sess;
 }
+
+void upf_sess_build_classifier(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pfcp_far_t *far = NULL;
+
+    ogs_assert(sess);
+
+    ogs_pfcp_classifier_clear(&sess->dl_classifier);
+    ogs_pfcp_classifier_clear(&sess->ul_classifier);
+    sess->dl_fallback_pdr = NULL;
+
+    /* PDR list is kept in precedence order */
+    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
+        far = pdr->far;
+        ogs_assert(far);
+
+        if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) {
+            /* Save the Fallback PDR : Lowest precedence downlink PDR */
+            sess->dl_fallback_pdr = pdr;
+
+            /* Check if FAR is Downlink */
+            if (far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
+                continue;
+
+            /* Check if Outer header creation */
+            if (far->outer_header_creation.ip4 == 0 &&
+                far->outer_header_creation.ip6 == 0 &&
+                far->outer_header_creation.udp4 == 0 &&
+                far->outer_header_creation.udp6 == 0 &&
+                far->outer_header_creation.gtpu4 == 0 &&
+                far->outer_header_creation.gtpu6 == 0)
+                continue;
+
+            ogs_pfcp_classifier_add(&sess->dl_classifier, pdr);
+
+        } else if (pdr->src_if == OGS_PFCP_INTERFACE_ACCESS ||
+                    pdr->src_if == OGS_PFCP_INTERFACE_CP_FUNCTION) {
+            ogs_pfcp_classifier_add(&sess->ul_classifier, pdr);
+        }
+    }
+
+    ogs_pfcp_classifier_build(&sess->dl_classifier);
+    ogs_pfcp_classifier_build(&sess->ul_classifier);
+}
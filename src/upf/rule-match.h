@@ -28,6 +28,8 @@ extern "C" {
 
 upf_sess_t *upf_sess_find_by_ue_ip_address(ogs_pkbuf_t *pkbuf);
 
+void upf_sess_build_classifier(upf_sess_t *sess);
+
 #ifdef __cplusplus
 }
 #endif
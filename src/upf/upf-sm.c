@@ -104,6 +104,9 @@ void upf_state_operational(ogs_fsm_t *s, upf_event_t *e)
 
         ogs_fsm_dispatch(&node->sm, e);
         break;
+    case UPF_EVT_N4_DATA_PLANE_REPORT:
+        upf_pfcp_handle_data_plane_report(e);
+        break;
     default:
         ogs_error("No handler for event %s", upf_event_get_name(e));
         break;
@@ -28,6 +28,7 @@ abts_suite *test_conv(abts_suite *suite);
 abts_suite *test_log(abts_suite *suite);
 abts_suite *test_pkbuf(abts_suite *suite);
 abts_suite *test_memory(abts_suite *suite);
+abts_suite *test_arena(abts_suite *suite);
 abts_suite *test_rbtree(abts_suite *suite);
 abts_suite *test_timer(abts_suite *suite);
 abts_suite *test_thread(abts_suite *suite);
@@ -37,6 +38,8 @@ abts_suite *test_poll(abts_suite *suite);
 abts_suite *test_tlv(abts_suite *suite);
 abts_suite *test_fsm(abts_suite *suite);
 abts_suite *test_hash(abts_suite *suite);
+abts_suite *test_lpm(abts_suite *suite);
+abts_suite *test_hmap(abts_suite *suite);
 abts_suite *test_uuid(abts_suite *suite);
 
 const struct testlist {
@@ -50,6 +53,7 @@ const struct testlist {
     {test_log},
     {test_pkbuf},
     {test_memory},
+    {test_arena},
     {test_rbtree},
     {test_timer},
     {test_thread},
@@ -59,6 +63,8 @@ const struct testlist {
     {test_tlv},
     {test_fsm},
     {test_hash},
+    {test_lpm},
+    {test_hmap},
     {test_uuid},
     {NULL},
 };
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+static void test1_func(abts_case *tc, void *data)
+{
+    char *p, *q, *r;
+    int i;
+
+    /* Outside of the scope : heap */
+    p = ogs_arena_malloc(32);
+    ABTS_PTR_NOTNULL(tc, p);
+    ABTS_TRUE(tc, !ogs_arena_owns(p));
+
+    ogs_arena_enter();
+
+    q = ogs_arena_malloc(32);
+    ABTS_PTR_NOTNULL(tc, q);
+    ABTS_TRUE(tc, ogs_arena_owns(q));
+    ABTS_INT_EQUAL(tc, 0, (int)((uintptr_t)q & 15));
+
+    r = ogs_arena_calloc(4, 8);
+    ABTS_PTR_NOTNULL(tc, r);
+    ABTS_TRUE(tc, ogs_arena_owns(r));
+    for (i = 0; i < 32; i++)
+        ABTS_INT_EQUAL(tc, 0, r[i]);
+
+    ogs_arena_leave();
+
+    /* Both kinds are freed in the same way */
+    ogs_arena_free(p);
+    ogs_arena_free(r);
+    ogs_arena_free(q);
+    ogs_arena_free(NULL);
+
+    /* The chunk is rewound once every allocation is freed */
+    ogs_arena_enter();
+    p = ogs_arena_malloc(100);
+    ogs_arena_leave();
+    ABTS_PTR_EQUAL(tc, q, p);
+    ogs_arena_free(p);
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    char *p, *q, *r;
+
+    ogs_arena_enter();
+
+    /* The last allocation grows in place */
+    p = ogs_arena_malloc(10);
+    memset(p, 1, 10);
+    q = ogs_arena_realloc(p, 100);
+    ABTS_PTR_EQUAL(tc, p, q);
+
+    /* Otherwise it is moved */
+    r = ogs_arena_malloc(10);
+    p = ogs_arena_realloc(q, 200);
+    ABTS_TRUE(tc, p != q);
+    ABTS_TRUE(tc, ogs_arena_owns(p));
+    ABTS_INT_EQUAL(tc, 1, p[9]);
+
+    ogs_arena_leave();
+
+    /* Out of the scope, it goes to the heap */
+    q = ogs_arena_realloc(p, 300);
+    ABTS_TRUE(tc, !ogs_arena_owns(q));
+    ABTS_INT_EQUAL(tc, 1, q[0]);
+    ABTS_INT_EQUAL(tc, 1, q[9]);
+
+    /* A heap pointer stays on the heap */
+    p = ogs_arena_realloc(q, 400);
+    ABTS_TRUE(tc, !ogs_arena_owns(p));
+    ogs_arena_free(p);
+
+    ogs_arena_free(r);
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    char *big, *p, *q;
+    char *ptr[64];
+    int i;
+
+    ogs_arena_enter();
+
+    /* Larger than a chunk */
+    big = ogs_arena_malloc(OGS_ARENA_CHUNK_SIZE * 4);
+    ABTS_PTR_NOTNULL(tc, big);
+    ABTS_TRUE(tc, ogs_arena_owns(big));
+    memset(big, 0xff, OGS_ARENA_CHUNK_SIZE * 4);
+
+    /* Kept alive while the other chunks come and go */
+    p = ogs_arena_malloc(16);
+    for (i = 0; i < 64; i++) {
+        ptr[i] = ogs_arena_malloc(OGS_ARENA_CHUNK_SIZE / 8);
+        ogs_assert(ptr[i]);
+        ogs_assert(ogs_arena_owns(ptr[i]));
+    }
+    for (i = 0; i < 64; i++)
+        ogs_arena_free(ptr[i]);
+
+    ogs_arena_leave();
+
+    ABTS_TRUE(tc, ogs_arena_owns(big));
+    ABTS_TRUE(tc, ogs_arena_owns(p));
+    ABTS_INT_EQUAL(tc, 0xff, (uint8_t)big[OGS_ARENA_CHUNK_SIZE * 4 - 1]);
+
+    ogs_arena_free(big);
+    ogs_arena_free(p);
+
+    ogs_arena_enter();
+    q = ogs_arena_malloc(16);
+    ogs_arena_leave();
+    ABTS_TRUE(tc, ogs_arena_owns(q));
+    ogs_arena_free(q);
+}
+
+static void free_func(void *data)
+{
+    char **ptr = data;
+
+    /* Another thread's arena memory is recognized, not given to ogs_free() */
+    ogs_assert(ogs_arena_owns(ptr[0]));
+    ogs_arena_free(ptr[0]);
+    ogs_arena_free(ptr[1]);
+}
+
+static void alloc_func(void *data)
+{
+    char **ptr = data;
+
+    ogs_arena_enter();
+    ptr[0] = ogs_arena_malloc(64);
+    ogs_assert(ptr[0]);
+    ptr[1] = ogs_arena_malloc(64);
+    ogs_assert(ptr[1]);
+    ogs_arena_leave();
+
+    memset(ptr[0], 0xff, 64);
+    memset(ptr[1], 0xff, 64);
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread;
+    char *ptr[2], *p;
+
+    /* Allocated here, freed by another thread */
+    ogs_arena_enter();
+    ptr[0] = ogs_arena_malloc(64);
+    ptr[1] = ogs_arena_calloc(1, 64);
+    ogs_arena_leave();
+    ABTS_TRUE(tc, ogs_arena_owns(ptr[0]));
+
+    thread = ogs_thread_create(free_func, ptr);
+    ABTS_PTR_NOTNULL(tc, thread);
+    ogs_thread_destroy(thread);
+
+    ABTS_TRUE(tc, !ogs_arena_owns(ptr[0]));
+    ABTS_TRUE(tc, !ogs_arena_owns(ptr[1]));
+
+    /* The emptied chunk is reused by its owner */
+    ogs_arena_enter();
+    p = ogs_arena_malloc(64);
+    ogs_arena_leave();
+    ABTS_PTR_EQUAL(tc, ptr[0], p);
+    ogs_arena_free(p);
+
+    /* Allocated by a thread which has exited, freed here */
+    thread = ogs_thread_create(alloc_func, ptr);
+    ABTS_PTR_NOTNULL(tc, thread);
+    ogs_thread_destroy(thread);
+
+    ABTS_TRUE(tc, ogs_arena_owns(ptr[0]));
+    ABTS_INT_EQUAL(tc, 0xff, (uint8_t)ptr[1][63]);
+    ogs_arena_free(ptr[0]);
+    ogs_arena_free(ptr[1]);
+}
+
+#define NUM_OF_ROUND 100000
+
+/*
+ * Decode-like pattern, many small allocations freed at the end.
+ * Timing is printed at info level:
+ *
+ * $ ./tests/core/core -e info arena-test
+ */
+static void test5_func(abts_case *tc, void *data)
+{
+    char *ptr[64];
+    ogs_time_t start, arena_time, heap_time;
+    int i, j;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_ROUND; i++) {
+        ogs_arena_enter();
+        for (j = 0; j < 64; j++)
+            ptr[j] = ogs_arena_calloc(1, 8 + j * 4);
+        ogs_arena_leave();
+        for (j = 0; j < 64; j++)
+            ogs_arena_free(ptr[j]);
+    }
+    arena_time = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_ROUND; i++) {
+        for (j = 0; j < 64; j++)
+            ptr[j] = ogs_calloc(1, 8 + j * 4);
+        for (j = 0; j < 64; j++)
+            ogs_free(ptr[j]);
+    }
+    heap_time = ogs_get_monotonic_time() - start;
+
+    ogs_info("%d x 64 allocations : arena %lld usec, heap %lld usec",
+            NUM_OF_ROUND, (long long)arena_time, (long long)heap_time);
+}
+
+abts_suite *test_arena(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
+
+    return suite;
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+static int data[16];
+
+static void hmap_test1(abts_case *tc, void *data_)
+{
+    ogs_hmap_t *map = NULL;
+    uint8_t imsi[8] = { 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0xf1 };
+    char supi[] = "imsi-001010000000001";
+    char key[] = "imsi-001010000000001";
+
+    map = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, map);
+
+    /* Fixed-width integer keys */
+    ogs_hmap_set_u32(map, 0x12345678, &data[0]);
+    ogs_hmap_set_u64(map, 0x12345678, &data[1]);
+    ABTS_PTR_EQUAL(tc, &data[0], ogs_hmap_get_u32(map, 0x12345678));
+    ABTS_PTR_EQUAL(tc, &data[1], ogs_hmap_get_u64(map, 0x12345678));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hmap_get_u32(map, 0x87654321));
+
+    /* Inline byte key and referenced string key */
+    ogs_hmap_set(map, imsi, sizeof(imsi), &data[2]);
+    ogs_hmap_set(map, supi, OGS_HASH_KEY_STRING, &data[3]);
+    ABTS_INT_EQUAL(tc, 4, ogs_hmap_count(map));
+
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_hmap_get(map, imsi, sizeof(imsi)));
+    ABTS_PTR_EQUAL(tc, &data[3], ogs_hmap_get(map, key, strlen(key)));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hmap_get(map, key, strlen(key) - 1));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hmap_get(map, imsi, sizeof(imsi) - 1));
+
+    /* Replace and remove */
+    ogs_hmap_set(map, key, OGS_HASH_KEY_STRING, &data[4]);
+    ABTS_INT_EQUAL(tc, 4, ogs_hmap_count(map));
+    ABTS_PTR_EQUAL(tc, &data[4], ogs_hmap_get(map, supi, strlen(supi)));
+
+    ogs_hmap_set_u32(map, 0x12345678, NULL);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hmap_get_u32(map, 0x12345678));
+    ABTS_PTR_EQUAL(tc, &data[1], ogs_hmap_get_u64(map, 0x12345678));
+    ABTS_INT_EQUAL(tc, 3, ogs_hmap_count(map));
+
+    /* Removing a missing key does nothing */
+    ogs_hmap_set_u32(map, 0x12345678, NULL);
+    ABTS_INT_EQUAL(tc, 3, ogs_hmap_count(map));
+
+    ogs_hmap_set_u64(map, 0x12345678, NULL);
+    ogs_hmap_set(map, imsi, sizeof(imsi), NULL);
+    ogs_hmap_set(map, key, OGS_HASH_KEY_STRING, NULL);
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(map));
+
+    ogs_hmap_destroy(map);
+}
+
+#define NUM_OF_KEY 100000
+
+/* Keys stay reachable while the table grows and entries are moved */
+static void hmap_test2(abts_case *tc, void *data_)
+{
+    ogs_hmap_t *map = NULL;
+    int i, mismatch = 0;
+
+    map = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, map);
+
+    for (i = 0; i < NUM_OF_KEY; i++) {
+        ogs_hmap_set_u32(map, i, &data[i % 16]);
+
+        /* Every key inserted so far is found, old or new table */
+        if (ogs_hmap_get_u32(map, i / 2) !=
+                ((i / 2) % 3 == 0 && i > 0 ? NULL : &data[(i / 2) % 16]))
+            mismatch++;
+        if (ogs_hmap_get_u32(map, i + 1) != NULL)
+            mismatch++;
+
+        /* Remove one of every three keys right away */
+        if (i % 3 == 0)
+            ogs_hmap_set_u32(map, i, NULL);
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY - (NUM_OF_KEY + 2) / 3, ogs_hmap_count(map));
+
+    for (i = 0; i < NUM_OF_KEY; i++) {
+        void *expected = (i % 3 == 0) ? NULL : &data[i % 16];
+        if (ogs_hmap_get_u32(map, i) != expected)
+            mismatch++;
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    /* Churn : tombstones must not fill the table up */
+    for (i = 0; i < NUM_OF_KEY * 4; i++) {
+        ogs_hmap_set_u64(map, (uint64_t)NUM_OF_KEY + i, &data[0]);
+        ogs_hmap_set_u64(map, (uint64_t)NUM_OF_KEY + i, NULL);
+    }
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY - (NUM_OF_KEY + 2) / 3, ogs_hmap_count(map));
+
+    for (i = 0; i < NUM_OF_KEY; i++)
+        ogs_hmap_set_u32(map, i, NULL);
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(map));
+
+    ogs_hmap_destroy(map);
+}
+
+/*
+ * 770 keys make a 1024-slot table grow, so everything below
+ * runs while the entries are being moved into the new table
+ */
+#define NUM_OF_MIGRATE_KEY 770
+
+static void hmap_test4(abts_case *tc, void *data_)
+{
+    ogs_hmap_t *map = NULL;
+    int i, mismatch = 0;
+
+    map = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, map);
+
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i++)
+        ogs_hmap_set_u32(map, i, &data[0]);
+    ABTS_INT_EQUAL(tc, NUM_OF_MIGRATE_KEY, ogs_hmap_count(map));
+
+    /* Remove even keys twice, replace odd keys */
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i++) {
+        if (i % 2 == 0) {
+            ogs_hmap_set_u32(map, i, NULL);
+            ogs_hmap_set_u32(map, i, NULL);
+            if (ogs_hmap_get_u32(map, i) != NULL)
+                mismatch++;
+        } else {
+            ogs_hmap_set_u32(map, i, &data[1]);
+            if (ogs_hmap_get_u32(map, i) != &data[1])
+                mismatch++;
+        }
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+    ABTS_INT_EQUAL(tc, NUM_OF_MIGRATE_KEY / 2, ogs_hmap_count(map));
+
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i++) {
+        if (ogs_hmap_get_u32(map, i) != (i % 2 == 0 ? NULL : &data[1]))
+            mismatch++;
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    /* Re-insert the removed keys */
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i += 2)
+        ogs_hmap_set_u32(map, i, &data[2]);
+    ABTS_INT_EQUAL(tc, NUM_OF_MIGRATE_KEY, ogs_hmap_count(map));
+
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i++) {
+        if (ogs_hmap_get_u32(map, i) != (i % 2 == 0 ? &data[2] : &data[1]))
+            mismatch++;
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    for (i = 0; i < NUM_OF_MIGRATE_KEY; i++)
+        ogs_hmap_set_u32(map, i, NULL);
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(map));
+
+    ogs_hmap_destroy(map);
+}
+
+/*
+ * Lookup benchmark against ogs_hash with 1M SEIDs and 1M SUPIs.
+ * It takes a few seconds, so it only runs at info level:
+ *
+ * $ ./tests/core/core -e info hmap-test
+ */
+#define NUM_OF_ENTRY 1000000
+#define NUM_OF_LOOKUP 4000000
+
+static void hmap_test3(abts_case *tc, void *data_)
+{
+    ogs_hmap_t *map = NULL;
+    ogs_hash_t *hash = NULL;
+    uint64_t *seid = NULL;
+    char (*supi)[32] = NULL;
+    uint32_t *index = NULL;
+    ogs_time_t start, hmap_time[2], hash_time[2];
+    int i, mismatch = 0;
+
+    if (ogs_log_get_domain_level(OGS_LOG_DOMAIN) < OGS_LOG_INFO)
+        return;
+
+    seid = ogs_calloc(NUM_OF_ENTRY, sizeof(*seid));
+    ABTS_PTR_NOTNULL(tc, seid);
+    supi = ogs_calloc(NUM_OF_ENTRY, sizeof(*supi));
+    ABTS_PTR_NOTNULL(tc, supi);
+    index = ogs_calloc(NUM_OF_LOOKUP, sizeof(*index));
+    ABTS_PTR_NOTNULL(tc, index);
+
+    for (i = 0; i < NUM_OF_ENTRY; i++) {
+        seid[i] = ((uint64_t)ogs_random32() << 32) | i;
+        ogs_snprintf(supi[i], sizeof(supi[i]), "imsi-9997%011d", i);
+    }
+    for (i = 0; i < NUM_OF_LOOKUP; i++)
+        index[i] = ogs_random32() % NUM_OF_ENTRY;
+
+    /* Integer key */
+    map = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, map);
+    hash = ogs_hash_make();
+    ABTS_PTR_NOTNULL(tc, hash);
+
+    for (i = 0; i < NUM_OF_ENTRY; i++) {
+        ogs_hmap_set_u64(map, seid[i], &seid[i]);
+        ogs_hash_set(hash, &seid[i], sizeof(seid[i]), &seid[i]);
+    }
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        if (ogs_hmap_get_u64(map, seid[index[i]]) != &seid[index[i]])
+            mismatch++;
+    }
+    hmap_time[0] = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        if (ogs_hash_get(hash, &seid[index[i]], sizeof(seid[0])) !=
+                &seid[index[i]])
+            mismatch++;
+    }
+    hash_time[0] = ogs_get_monotonic_time() - start;
+
+    ogs_hash_destroy(hash);
+    ogs_hmap_destroy(map);
+
+    /* String key */
+    map = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, map);
+    hash = ogs_hash_make();
+    ABTS_PTR_NOTNULL(tc, hash);
+
+    for (i = 0; i < NUM_OF_ENTRY; i++) {
+        ogs_hmap_set(map, supi[i], OGS_HASH_KEY_STRING, supi[i]);
+        ogs_hash_set(hash, supi[i], OGS_HASH_KEY_STRING, supi[i]);
+    }
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        char *s = supi[index[i]];
+        if (ogs_hmap_get(map, s, strlen(s)) != s)
+            mismatch++;
+    }
+    hmap_time[1] = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        char *s = supi[index[i]];
+        if (ogs_hash_get(hash, s, strlen(s)) != s)
+            mismatch++;
+    }
+    hash_time[1] = ogs_get_monotonic_time() - start;
+
+    ogs_hash_destroy(hash);
+    ogs_hmap_destroy(map);
+
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    ogs_info("%d entries, %d lookups : SEID hmap %lld usec, hash %lld usec",
+            NUM_OF_ENTRY, NUM_OF_LOOKUP,
+            (long long)hmap_time[0], (long long)hash_time[0]);
+    ogs_info("%d entries, %d lookups : SUPI hmap %lld usec, hash %lld usec",
+            NUM_OF_ENTRY, NUM_OF_LOOKUP,
+            (long long)hmap_time[1], (long long)hash_time[1]);
+
+    ogs_free(index);
+    ogs_free(supi);
+    ogs_free(seid);
+}
+
+abts_suite *test_hmap(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, hmap_test1, NULL);
+    abts_run_test(suite, hmap_test2, NULL);
+    abts_run_test(suite, hmap_test4, NULL);
+    abts_run_test(suite, hmap_test3, NULL);
+
+    return suite;
+}
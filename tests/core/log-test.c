@@ -20,6 +20,10 @@
 #include "ogs-core.h"
 #include "core/abts.h"
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
 static void test_basic(abts_case *tc, void *data)
 {
     int domain_id = -1;
@@ -103,11 +107,202 @@ static void test_basic(abts_case *tc, void *data)
 #endif
 }
 
+#if !defined(_WIN32)
+#define ASYNC_FILE          "log-test.log"
+#define ASYNC_THREAD_NUM    2
+#define ASYNC_MESSAGE_NUM   20000
+
+static void async_thread_func(void *data)
+{
+    int i;
+
+    for (i = 0; i < ASYNC_MESSAGE_NUM; i++)
+        ogs_log_print(OGS_LOG_ERROR, "async-test %d\n", i);
+}
+
+static void test_async(abts_case *tc, void *data)
+{
+    ogs_log_t *log = NULL;
+    ogs_thread_t *thread[ASYNC_THREAD_NUM];
+    FILE *file = NULL;
+    char line[OGS_HUGE_LEN];
+    unsigned long long dropped = 0, reported = 0, n;
+    int i, count = 0, saved_stderr, null_fd;
+
+    /* Keep the console quiet */
+    saved_stderr = dup(STDERR_FILENO);
+    ogs_assert(saved_stderr >= 0);
+    null_fd = open("/dev/null", O_WRONLY);
+    ogs_assert(null_fd >= 0);
+    dup2(null_fd, STDERR_FILENO);
+
+    unlink(ASYNC_FILE);
+    log = ogs_log_add_file(ASYNC_FILE);
+    ABTS_PTR_NOTNULL(tc, log);
+
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start());
+
+    for (i = 0; i < ASYNC_THREAD_NUM; i++) {
+        thread[i] = ogs_thread_create(async_thread_func, NULL);
+        ogs_assert(thread[i]);
+    }
+    for (i = 0; i < ASYNC_THREAD_NUM; i++)
+        ogs_thread_destroy(thread[i]);
+
+    /* Cycling the file while the writer thread is running */
+    ogs_log_cycle();
+
+    dropped = ogs_log_async_dropped(log);
+    ogs_log_async_stop();
+    ogs_log_remove(log);
+
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+    close(null_fd);
+
+    /* Every message is either written or counted as dropped */
+    file = fopen(ASYNC_FILE, "r");
+    ABTS_PTR_NOTNULL(tc, file);
+    while (fgets(line, sizeof(line), file)) {
+        if (!strncmp(line, "async-test ", 11))
+            count++;
+        else if (sscanf(line, "%llu log messages dropped", &n) == 1)
+            reported += n;
+    }
+    fclose(file);
+    unlink(ASYNC_FILE);
+
+    ABTS_INT_EQUAL(tc, ASYNC_THREAD_NUM * ASYNC_MESSAGE_NUM, count + dropped);
+    ABTS_INT_EQUAL(tc, dropped, reported);
+}
+
+static int restart_state;
+
+static void restart_thread_func(void *data)
+{
+    ogs_log_print(OGS_LOG_ERROR, "async-test\n");
+    __atomic_store_n(&restart_state, 1, __ATOMIC_RELEASE);
+
+    /* Exits only after the writer was stopped and started again */
+    while (__atomic_load_n(&restart_state, __ATOMIC_ACQUIRE) != 2)
+        ogs_msleep(1);
+
+    ogs_log_print(OGS_LOG_ERROR, "async-test\n");
+}
+
+static void test_async_restart(abts_case *tc, void *data)
+{
+    ogs_log_t *log = NULL;
+    ogs_thread_t *thread = NULL;
+    FILE *file = NULL;
+    char line[OGS_HUGE_LEN];
+    int i, count = 0, saved_stderr, null_fd;
+
+    saved_stderr = dup(STDERR_FILENO);
+    ogs_assert(saved_stderr >= 0);
+    null_fd = open("/dev/null", O_WRONLY);
+    ogs_assert(null_fd >= 0);
+    dup2(null_fd, STDERR_FILENO);
+
+    unlink(ASYNC_FILE);
+    log = ogs_log_add_file(ASYNC_FILE);
+    ABTS_PTR_NOTNULL(tc, log);
+
+    restart_state = 0;
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start());
+
+    thread = ogs_thread_create(restart_thread_func, NULL);
+    ogs_assert(thread);
+    while (__atomic_load_n(&restart_state, __ATOMIC_ACQUIRE) != 1)
+        ogs_msleep(1);
+
+    /* Each thread still caches the ring freed by the stop */
+    for (i = 0; i < 2; i++) {
+        ogs_log_print(OGS_LOG_ERROR, "async-test\n");
+        ogs_log_async_stop();
+        ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start());
+    }
+
+    __atomic_store_n(&restart_state, 2, __ATOMIC_RELEASE);
+    ogs_thread_destroy(thread);
+
+    ogs_log_print(OGS_LOG_ERROR, "async-test\n");
+    ogs_log_async_stop();
+    ogs_log_remove(log);
+
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+    close(null_fd);
+
+    file = fopen(ASYNC_FILE, "r");
+    ABTS_PTR_NOTNULL(tc, file);
+    while (fgets(line, sizeof(line), file)) {
+        if (!strncmp(line, "async-test", 10))
+            count++;
+    }
+    fclose(file);
+    unlink(ASYNC_FILE);
+
+    ABTS_INT_EQUAL(tc, 5, count);
+}
+
+static void test_async_fatal(abts_case *tc, void *data)
+{
+    ogs_log_t *log = NULL;
+    FILE *file = NULL;
+    char line[OGS_HUGE_LEN];
+    int i, count = 0, saved_stderr, null_fd;
+
+    saved_stderr = dup(STDERR_FILENO);
+    ogs_assert(saved_stderr >= 0);
+    null_fd = open("/dev/null", O_WRONLY);
+    ogs_assert(null_fd >= 0);
+    dup2(null_fd, STDERR_FILENO);
+
+    unlink(ASYNC_FILE);
+    log = ogs_log_add_file(ASYNC_FILE);
+    ABTS_PTR_NOTNULL(tc, log);
+
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start());
+
+    for (i = 0; i < 100; i++)
+        ogs_log_print(OGS_LOG_ERROR, "async-test\n");
+
+    /* The pending records are written before the fatal one */
+    ogs_log_print(OGS_LOG_FATAL, "async-fatal\n");
+
+    file = fopen(ASYNC_FILE, "r");
+    ABTS_PTR_NOTNULL(tc, file);
+    while (fgets(line, sizeof(line), file)) {
+        if (!strncmp(line, "async-test", 10))
+            count++;
+        else if (!strncmp(line, "async-fatal", 11))
+            break;
+    }
+    fclose(file);
+
+    ogs_log_async_stop();
+    ogs_log_remove(log);
+    unlink(ASYNC_FILE);
+
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+    close(null_fd);
+
+    ABTS_INT_EQUAL(tc, 100, count);
+}
+#endif
+
 abts_suite *test_log(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test_basic, NULL);
+#if !defined(_WIN32)
+    abts_run_test(suite, test_async, NULL);
+    abts_run_test(suite, test_async_restart, NULL);
+    abts_run_test(suite, test_async_fatal, NULL);
+#endif
 
     return suite;
 }
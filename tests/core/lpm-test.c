@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+static int data[16];
+
+static void lpm_test1(abts_case *tc, void *data_)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint8_t key[4];
+    int rv;
+
+    lpm = ogs_lpm_create(4);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    /* 10.0.0.0/8, 10.1.0.0/16, 10.1.2.0/24, 10.1.2.3/32 */
+    key[0] = 10; key[1] = 0; key[2] = 0; key[3] = 0;
+    rv = ogs_lpm_add(lpm, key, 8, &data[8]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[1] = 1;
+    rv = ogs_lpm_add(lpm, key, 16, &data[0]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[2] = 2;
+    rv = ogs_lpm_add(lpm, key, 24, &data[1]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[3] = 3;
+    rv = ogs_lpm_add(lpm, key, 32, &data[2]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 4, ogs_lpm_count(lpm));
+
+    key[0] = 10; key[1] = 1; key[2] = 2; key[3] = 3;
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_lpm_find(lpm, key));
+    key[3] = 4;
+    ABTS_PTR_EQUAL(tc, &data[1], ogs_lpm_find(lpm, key));
+    key[2] = 3;
+    ABTS_PTR_EQUAL(tc, &data[0], ogs_lpm_find(lpm, key));
+    key[1] = 2;
+    ABTS_PTR_EQUAL(tc, &data[8], ogs_lpm_find(lpm, key));
+    key[0] = 11;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, key));
+
+    /* Host bits of the prefix are ignored */
+    key[0] = 10; key[1] = 1; key[2] = 2; key[3] = 77;
+    ABTS_PTR_EQUAL(tc, &data[1], ogs_lpm_find_exact(lpm, key, 24));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find_exact(lpm, key, 25));
+
+    /* Deleting 10.1.2.0/24 falls back to 10.1.0.0/16 */
+    rv = ogs_lpm_delete(lpm, key, 24);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_PTR_EQUAL(tc, &data[0], ogs_lpm_find(lpm, key));
+    key[3] = 3;
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_lpm_find(lpm, key));
+
+    /* Deleting 10.1.0.0/16 falls back to 10.0.0.0/8 */
+    rv = ogs_lpm_delete(lpm, key, 16);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[3] = 4;
+    ABTS_PTR_EQUAL(tc, &data[8], ogs_lpm_find(lpm, key));
+
+    rv = ogs_lpm_delete(lpm, key, 16);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+
+    /* Default route */
+    key[0] = 0; key[1] = 0; key[2] = 0; key[3] = 0;
+    rv = ogs_lpm_add(lpm, key, 0, &data[3]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[0] = 192; key[1] = 168;
+    ABTS_PTR_EQUAL(tc, &data[3], ogs_lpm_find(lpm, key));
+    key[0] = 10; key[1] = 1; key[2] = 2; key[3] = 3;
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_lpm_find(lpm, key));
+    rv = ogs_lpm_delete(lpm, key, 32);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_PTR_EQUAL(tc, &data[8], ogs_lpm_find(lpm, key));
+    rv = ogs_lpm_delete(lpm, key, 8);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_PTR_EQUAL(tc, &data[3], ogs_lpm_find(lpm, key));
+    rv = ogs_lpm_delete(lpm, key, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, key));
+
+    ABTS_INT_EQUAL(tc, 0, ogs_lpm_count(lpm));
+
+    ogs_lpm_destroy(lpm);
+}
+
+static void lpm_test2(abts_case *tc, void *data_)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint8_t key[16];
+    int rv;
+
+    lpm = ogs_lpm_create(16);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    /* 2001:db8:cafe::/48, 2001:db8:cafe:1::/64, 2001:db8:cafe:1::1/128 */
+    memset(key, 0, sizeof(key));
+    key[0] = 0x20; key[1] = 0x01; key[2] = 0x0d; key[3] = 0xb8;
+    key[4] = 0xca; key[5] = 0xfe;
+    rv = ogs_lpm_add(lpm, key, 48, &data[0]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[7] = 1;
+    rv = ogs_lpm_add(lpm, key, 64, &data[1]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    key[15] = 1;
+    rv = ogs_lpm_add(lpm, key, 128, &data[2]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_lpm_find(lpm, key));
+    key[15] = 2;
+    ABTS_PTR_EQUAL(tc, &data[1], ogs_lpm_find(lpm, key));
+    key[7] = 2;
+    ABTS_PTR_EQUAL(tc, &data[0], ogs_lpm_find(lpm, key));
+    key[5] = 0xff;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, key));
+
+    key[5] = 0xfe; key[7] = 1; key[15] = 1;
+    rv = ogs_lpm_delete(lpm, key, 64);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_PTR_EQUAL(tc, &data[2], ogs_lpm_find(lpm, key));
+    key[15] = 2;
+    ABTS_PTR_EQUAL(tc, &data[0], ogs_lpm_find(lpm, key));
+
+    ogs_lpm_destroy(lpm);
+}
+
+#define NUM_OF_ROUTE 512
+
+typedef struct route_s {
+    uint32_t addr;      /* host byte order */
+    int len;
+    bool used;
+} route_t;
+
+static void *brute_force_find(route_t *route, uint32_t addr)
+{
+    int i, best = -1;
+
+    for (i = 0; i < NUM_OF_ROUTE; i++) {
+        uint32_t mask;
+
+        if (!route[i].used)
+            continue;
+        mask = route[i].len ? 0xffffffff << (32 - route[i].len) : 0;
+        if ((addr & mask) != route[i].addr)
+            continue;
+        if (best < 0 || route[i].len > route[best].len)
+            best = i;
+    }
+
+    return best < 0 ? NULL : &route[best];
+}
+
+static void lpm_test3(abts_case *tc, void *data_)
+{
+    ogs_lpm_t *lpm = NULL;
+    route_t *route = NULL;
+    uint32_t addr, be;
+    int i, j, rv, mismatch;
+
+    lpm = ogs_lpm_create(4);
+    ABTS_PTR_NOTNULL(tc, lpm);
+    route = ogs_calloc(NUM_OF_ROUTE, sizeof(*route));
+    ABTS_PTR_NOTNULL(tc, route);
+
+    /* Overlapping prefixes under 10.0.0.0/8 */
+    for (i = 0; i < NUM_OF_ROUTE; i++) {
+        route[i].len = 8 + ogs_random32() % 25;
+        route[i].addr = (0x0a000000 | (ogs_random32() & 0x00ffffff)) &
+            (0xffffffff << (32 - route[i].len));
+        for (j = 0; j < i; j++) {
+            if (route[j].used && route[j].len == route[i].len &&
+                route[j].addr == route[i].addr)
+                break;
+        }
+        if (j != i)
+            continue;
+
+        be = htobe32(route[i].addr);
+        rv = ogs_lpm_add(lpm, &be, route[i].len, &route[i]);
+        ogs_assert(rv == OGS_OK);
+        route[i].used = true;
+    }
+
+    for (j = 0; j < 4; j++) {
+        mismatch = 0;
+        for (i = 0; i < 10000; i++) {
+            addr = 0x0a000000 | (ogs_random32() & 0x00ffffff);
+            be = htobe32(addr);
+            if (brute_force_find(route, addr) != ogs_lpm_find(lpm, &be))
+                mismatch++;
+        }
+        ABTS_INT_EQUAL(tc, 0, mismatch);
+
+        /* Remove about half of the routes and check again */
+        for (i = 0; i < NUM_OF_ROUTE; i++) {
+            if (!route[i].used || ogs_random32() % 2)
+                continue;
+            be = htobe32(route[i].addr);
+            rv = ogs_lpm_delete(lpm, &be, route[i].len);
+            ogs_assert(rv == OGS_OK);
+            route[i].used = false;
+        }
+    }
+
+    ogs_free(route);
+    ogs_lpm_destroy(lpm);
+}
+
+/*
+ * Microbenchmark against a bit-by-bit trie, the structure the UPF used
+ * for framed routes. Timing is printed at info level:
+ *
+ * $ ./tests/core/core -e info lpm-test
+ */
+typedef struct bit_trie_s {
+    struct bit_trie_s *child[2];
+    void *data;
+} bit_trie_t;
+
+static void bit_trie_add(bit_trie_t **trie, uint32_t addr, int len, void *data)
+{
+    int i;
+
+    for (i = 0; i <= len; i++) {
+        if (!*trie) {
+            *trie = ogs_calloc(1, sizeof(**trie));
+            ogs_assert(*trie);
+        }
+        if (i == len) {
+            (*trie)->data = data;
+            break;
+        }
+        trie = &(*trie)->child[(addr >> (31 - i)) & 1];
+    }
+}
+
+static void *bit_trie_find(bit_trie_t *trie, uint32_t addr)
+{
+    void *ret = NULL;
+    int i;
+
+    for (i = 0; i <= 32 && trie; i++) {
+        if (trie->data)
+            ret = trie->data;
+        if (i == 32)
+            break;
+        trie = trie->child[(addr >> (31 - i)) & 1];
+    }
+
+    return ret;
+}
+
+static void bit_trie_free(bit_trie_t *trie)
+{
+    if (!trie)
+        return;
+    bit_trie_free(trie->child[0]);
+    bit_trie_free(trie->child[1]);
+    ogs_free(trie);
+}
+
+#define NUM_OF_LOOKUP 1000000
+
+static void lpm_test4(abts_case *tc, void *data_)
+{
+    ogs_lpm_t *lpm = NULL;
+    bit_trie_t *trie = NULL;
+    uint32_t *addr = NULL, be;
+    void *result = NULL;
+    ogs_time_t start, lpm_time, trie_time;
+    int i, mismatch = 0;
+
+    lpm = ogs_lpm_create(4);
+    ABTS_PTR_NOTNULL(tc, lpm);
+    addr = ogs_calloc(NUM_OF_LOOKUP, sizeof(*addr));
+    ABTS_PTR_NOTNULL(tc, addr);
+
+    /* 4096 UEs (/32) in 10.45.0.0/16 and 256 framed routes (/24) */
+    for (i = 0; i < 4096; i++) {
+        uint32_t ue = 0x0a2d0000 | i;
+        be = htobe32(ue);
+        ogs_lpm_add(lpm, &be, 32, &data[i % 16]);
+        bit_trie_add(&trie, ue, 32, &data[i % 16]);
+    }
+    for (i = 0; i < 256; i++) {
+        uint32_t net = 0xac100000 | (i << 8);
+        be = htobe32(net);
+        ogs_lpm_add(lpm, &be, 24, &data[i % 16]);
+        bit_trie_add(&trie, net, 24, &data[i % 16]);
+    }
+
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        if (i % 2)
+            addr[i] = 0x0a2d0000 | (ogs_random32() % 4096);
+        else
+            addr[i] = 0xac100000 | (ogs_random32() & 0xffff);
+    }
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        be = htobe32(addr[i]);
+        result = ogs_lpm_find(lpm, &be);
+        if (!result) mismatch++;
+    }
+    lpm_time = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++) {
+        result = bit_trie_find(trie, addr[i]);
+        if (!result) mismatch++;
+    }
+    trie_time = ogs_get_monotonic_time() - start;
+
+    for (i = 0; i < NUM_OF_LOOKUP; i += 97) {
+        be = htobe32(addr[i]);
+        if (ogs_lpm_find(lpm, &be) != bit_trie_find(trie, addr[i]))
+            mismatch++;
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    ogs_info("%d lookups : LPM %lld usec, bit trie %lld usec",
+            NUM_OF_LOOKUP, (long long)lpm_time, (long long)trie_time);
+
+    bit_trie_free(trie);
+    ogs_free(addr);
+    ogs_lpm_destroy(lpm);
+}
+
+abts_suite *test_lpm(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, lpm_test1, NULL);
+    abts_run_test(suite, lpm_test2, NULL);
+    abts_run_test(suite, lpm_test3, NULL);
+    abts_run_test(suite, lpm_test4, NULL);
+
+    return suite;
+}
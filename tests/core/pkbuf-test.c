@@ -70,12 +70,151 @@ static void test2_func(abts_case *tc, void *data)
     ogs_pkbuf_free(p3);
 }
 
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf[100];
+    ogs_pkbuf_cache_stat_t before, after;
+    int i;
+
+    ogs_pkbuf_cache_flush();
+    ogs_pkbuf_cache_stat(&before);
+
+    for (i = 0; i < 100; i++) {
+        pkbuf[i] = ogs_pkbuf_alloc(NULL, 1500);
+        ABTS_PTR_NOTNULL(tc, pkbuf[i]);
+        ABTS_INT_EQUAL(tc, 0, pkbuf[i]->len);
+        ABTS_INT_EQUAL(tc, 1500, ogs_pkbuf_tailroom(pkbuf[i]));
+        ogs_pkbuf_put(pkbuf[i], 1500);
+    }
+    for (i = 0; i < 100; i++)
+        ogs_pkbuf_free(pkbuf[i]);
+
+    ogs_pkbuf_cache_stat(&after);
+    ABTS_TRUE(tc, after.refill > before.refill);
+    ABTS_TRUE(tc, after.spill > before.spill);
+
+    /* The buffers freed above are reused */
+    ogs_pkbuf_cache_stat(&before);
+    for (i = 0; i < 10; i++) {
+        pkbuf[i] = ogs_pkbuf_alloc(NULL, 100);
+        ABTS_PTR_NOTNULL(tc, pkbuf[i]);
+        ABTS_INT_EQUAL(tc, 0, pkbuf[i]->len);
+        ABTS_INT_EQUAL(tc, 100, ogs_pkbuf_tailroom(pkbuf[i]));
+        ABTS_INT_EQUAL(tc, 0, ogs_pkbuf_headroom(pkbuf[i]));
+    }
+    for (i = 0; i < 10; i++) {
+        pkbuf[10+i] = ogs_pkbuf_alloc(NULL, 2000);
+        ABTS_PTR_NOTNULL(tc, pkbuf[10+i]);
+    }
+    ogs_pkbuf_cache_stat(&after);
+    ABTS_TRUE(tc, after.hit - before.hit >= 10);
+
+    for (i = 0; i < 20; i++)
+        ogs_pkbuf_free(pkbuf[i]);
+
+    ogs_pkbuf_cache_flush();
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pkbuf_cache_stat_t before, after;
+#if OGS_USE_TALLOC == 1
+    int i;
+#endif
+
+    ogs_pkbuf_cache_flush();
+
+    pkbuf = ogs_pkbuf_alloc(NULL, 100);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    memset(ogs_pkbuf_put(pkbuf, 100), 0xff, 100);
+    ogs_pkbuf_free(pkbuf);
+
+    /* A buffer taken from the cache is cleared like a new one */
+    ogs_pkbuf_cache_stat(&before);
+    pkbuf = ogs_pkbuf_alloc(NULL, 100);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ogs_pkbuf_cache_stat(&after);
+    ABTS_INT_EQUAL(tc, 1, (int)(after.hit - before.hit));
+#if OGS_USE_TALLOC == 1
+    for (i = 0; i < 100; i++)
+        if (pkbuf->data[i] != 0)
+            break;
+    ABTS_INT_EQUAL(tc, 100, i);
+#endif
+    ogs_pkbuf_free(pkbuf);
+
+    ogs_pkbuf_cache_flush();
+}
+
+#if OGS_USE_TALLOC == 0
+static void destroy_func(void *data)
+{
+    ogs_pkbuf_pool_destroy(data);
+}
+
+static void test5_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_config_t config;
+    ogs_pkbuf_pool_t *pool = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pkbuf_cache_stat_t before, after;
+    ogs_thread_t *thread = NULL;
+    ogs_log_level_e level;
+    int id;
+
+    memset(&config, 0, sizeof config);
+    config.cluster_2048_pool = 64;
+
+    ogs_pkbuf_cache_flush();
+
+    /* The cache of this thread keeps buffers of the pool */
+    pool = ogs_pkbuf_pool_create(&config);
+    ABTS_PTR_NOTNULL(tc, pool);
+    pkbuf = ogs_pkbuf_alloc(pool, 1500);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ogs_pkbuf_free(pkbuf);
+
+    /* Another thread destroys it, reporting the cached buffers */
+    id = ogs_log_get_domain_id("mem");
+    level = ogs_log_get_domain_level(id);
+    ogs_log_set_domain_level(id, OGS_LOG_FATAL);
+
+    thread = ogs_thread_create(destroy_func, pool);
+    ABTS_PTR_NOTNULL(tc, thread);
+    ogs_thread_destroy(thread);
+
+    ogs_log_set_domain_level(id, level);
+
+    /* The stale buffers are dropped, not handed out or returned */
+    pool = ogs_pkbuf_pool_create(&config);
+    ABTS_PTR_NOTNULL(tc, pool);
+
+    ogs_pkbuf_cache_stat(&before);
+    pkbuf = ogs_pkbuf_alloc(pool, 1500);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ABTS_PTR_EQUAL(tc, pool, pkbuf->pool);
+    ogs_pkbuf_cache_stat(&after);
+    ABTS_INT_EQUAL(tc, 1, (int)(after.refill - before.refill));
+
+    ogs_pkbuf_free(pkbuf);
+    ogs_pkbuf_cache_flush();
+
+    ogs_pkbuf_pool_destroy(pool);
+}
+#endif
+
 abts_suite *test_pkbuf(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+#if OGS_USE_TALLOC == 0
+    abts_run_test(suite, test5_func, NULL);
+#endif
 
     return suite;
 }
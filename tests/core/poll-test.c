@@ -657,6 +657,40 @@ static void test8_func(abts_case *tc, void *data)
     ogs_pollset_destroy(pollset);
 }
 
+static void test9_func(abts_case *tc, void *data)
+{
+    ogs_pollset_t *pollset;
+    ogs_time_t start, cached, elapsed, timeout;
+    int i, rv;
+
+    pollset = ogs_pollset_create(512);
+    ABTS_PTR_NOTNULL(tc, pollset);
+
+    /* The loop clock is refreshed when the poll returns */
+    rv = ogs_pollset_poll(pollset, OGS_NO_WAIT_TIME);
+    ABTS_INT_EQUAL(tc, OGS_TIMEUP, rv);
+    cached = ogs_loop_monotonic_time();
+    ogs_usleep(2000);
+    ABTS_TRUE(tc, ogs_loop_monotonic_time() == cached);
+
+    rv = ogs_pollset_poll(pollset, OGS_NO_WAIT_TIME);
+    ABTS_INT_EQUAL(tc, OGS_TIMEUP, rv);
+    ABTS_TRUE(tc, ogs_loop_monotonic_time() - cached >= 2000);
+
+    /* Sub-millisecond timeouts never return early */
+    for (i = 0; i < 10; i++) {
+        timeout = 300 + i * 150;
+        start = ogs_get_monotonic_time();
+        rv = ogs_pollset_poll(pollset, timeout);
+        elapsed = ogs_loop_monotonic_time() - start;
+
+        ABTS_INT_EQUAL(tc, OGS_TIMEUP, rv);
+        ABTS_TRUE(tc, elapsed >= timeout);
+    }
+
+    ogs_pollset_destroy(pollset);
+}
+
 abts_suite *test_poll(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -672,6 +706,7 @@ abts_suite *test_poll(abts_suite *suite)
     abts_run_test(suite, test6_func, NULL);
     abts_run_test(suite, test7_func, NULL);
     abts_run_test(suite, test8_func, NULL);
+    abts_run_test(suite, test9_func, NULL);
 
     return suite;
 }
@@ -228,6 +228,65 @@ static void test3_func(abts_case *tc, void *data)
     ogs_pool_final(&testpool);
 }
 
+#define SIZE_OF_TESTPOOL2   100000
+#define NUM_OF_INUSE        10
+
+static OGS_POOL(testpool2, int);
+static int freed_at[SIZE_OF_TESTPOOL2];
+
+static void test4_func(abts_case *tc, void *data)
+{
+    int *node[NUM_OF_INUSE] = { NULL, }, *found = NULL;
+    int last[NUM_OF_INUSE];
+    int i, index, reused = 0, gap = SIZE_OF_TESTPOOL2;
+
+    ogs_pool_init(&testpool2, SIZE_OF_TESTPOOL2);
+    ABTS_INT_EQUAL(tc, 0, testpool2.used);
+    ABTS_INT_EQUAL(tc, SIZE_OF_TESTPOOL2 / 4, testpool2.delay);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find(&testpool2, 1));
+
+    /* Churn with only a few nodes in use at a time */
+    for (i = 0; i < SIZE_OF_TESTPOOL2 * 2; i++) {
+        int n = i % NUM_OF_INUSE;
+
+        if (node[n]) {
+            last[n] = ogs_pool_index(&testpool2, node[n]);
+            freed_at[last[n]-1] = i;
+            ogs_pool_free(&testpool2, node[n]);
+            found = ogs_pool_find(&testpool2, last[n]);
+            ogs_assert(found == NULL);
+        }
+
+        ogs_pool_alloc(&testpool2, &node[n]);
+        ogs_assert(node[n]);
+
+        index = ogs_pool_index(&testpool2, node[n]);
+        found = ogs_pool_find(&testpool2, index);
+        ogs_assert(found == node[n]);
+        if (i >= NUM_OF_INUSE && index == last[n])
+            reused++;
+        if (freed_at[index-1])
+            gap = ogs_min(gap, i - freed_at[index-1]);
+    }
+
+    /*
+     * Memory follows the load, and 'delay - 1' other nodes are
+     * handed out before a freed node comes back
+     */
+    ABTS_INT_EQUAL(tc, NUM_OF_INUSE, ogs_pool_hwm(&testpool2));
+    ABTS_INT_EQUAL(tc,
+            NUM_OF_INUSE - 1 + testpool2.delay, testpool2.used);
+    ABTS_INT_EQUAL(tc, 0, reused);
+    ABTS_TRUE(tc, gap >= testpool2.delay - 1);
+    ABTS_INT_EQUAL(tc,
+            SIZE_OF_TESTPOOL2 - NUM_OF_INUSE, ogs_pool_avail(&testpool2));
+
+    for (i = 0; i < NUM_OF_INUSE; i++)
+        ogs_pool_free(&testpool2, node[i]);
+
+    ogs_pool_final(&testpool2);
+}
+
 abts_suite *test_pool(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -235,6 +294,7 @@ abts_suite *test_pool(abts_suite *suite)
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
 
     return suite;
 }
@@ -166,12 +166,86 @@ static void test_queue_timeout(abts_case *tc, void *data)
     ogs_queue_destroy(q);
 }
 
+#define MPSC_PRODUCERS      4
+#define MPSC_ITEMS          100000
+
+static void mpsc_producer(void *data)
+{
+    long i, base = (long)data * MPSC_ITEMS;
+    int rv;
+
+    for (i = 0; i < MPSC_ITEMS; i++) {
+        /* Another producer may take the slot we were woken up for */
+        do {
+            rv = ogs_queue_push(queue, (void *)(base + i + 1));
+        } while (rv == OGS_ERROR);
+        ogs_assert(rv == OGS_OK);
+    }
+}
+
+static void test_queue_mpsc(abts_case *tc, void *data)
+{
+    ogs_thread_t *producer_thread[MPSC_PRODUCERS];
+    long next[MPSC_PRODUCERS];
+    void *v[OGS_QUEUE_POP_BATCH];
+    long i, total = 0;
+    int rv, n, order = 1;
+
+    queue = ogs_queue_create(QUEUE_SIZE);
+    ABTS_PTR_NOTNULL(tc, queue);
+
+    rv = ogs_queue_trypop_n(queue, v, OGS_QUEUE_POP_BATCH);
+    ABTS_INT_EQUAL(tc, OGS_RETRY, rv);
+
+    for (i = 0; i < MPSC_PRODUCERS; i++) {
+        next[i] = i * MPSC_ITEMS + 1;
+        producer_thread[i] = ogs_thread_create(mpsc_producer, (void *)i);
+        ABTS_PTR_NOTNULL(tc, producer_thread[i]);
+    }
+
+    /* Each producer's items arrive exactly once and in order */
+    while (total < MPSC_PRODUCERS * MPSC_ITEMS) {
+        n = ogs_queue_trypop_n(queue, v, OGS_QUEUE_POP_BATCH);
+        if (n == OGS_RETRY) {
+            rv = ogs_queue_timedpop(queue, &v[0], ogs_time_from_sec(1));
+            ogs_assert(rv == OGS_OK);
+            n = 1;
+        }
+        ogs_assert(n > 0 && n <= OGS_QUEUE_POP_BATCH);
+
+        for (i = 0; i < n; i++) {
+            long value = (long)v[i] - 1;
+            long p = value / MPSC_ITEMS;
+
+            if (p >= MPSC_PRODUCERS || next[p] != value + 1)
+                order = 0;
+            else
+                next[p]++;
+        }
+        total += n;
+    }
+    ABTS_INT_EQUAL(tc, 1, order);
+    ABTS_INT_EQUAL(tc, 0, ogs_queue_size(queue));
+
+    for (i = 0; i < MPSC_PRODUCERS; i++)
+        ogs_thread_destroy(producer_thread[i]);
+
+    rv = ogs_queue_term(queue);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    rv = ogs_queue_trypop_n(queue, v, OGS_QUEUE_POP_BATCH);
+    ABTS_INT_EQUAL(tc, OGS_DONE, rv);
+
+    ogs_queue_destroy(queue);
+}
+
 abts_suite *test_queue(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test_queue_producer_consumer, NULL);
     abts_run_test(suite, test_queue_timeout, NULL);
+    abts_run_test(suite, test_queue_mpsc, NULL);
 
     return suite;
 }
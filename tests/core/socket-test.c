@@ -424,6 +424,81 @@ static void test8_func(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, OGS_OK, rv);
 }
 
+static void test9_func(abts_case *tc, void *data)
+{
+    int rv, i;
+    ogs_sock_t *udp, *client;
+    ogs_sockaddr_t *addr;
+    ogs_sockaddr_t from[3];
+    ogs_pkbuf_t *pkbuf[3];
+    char buf[OGS_ADDRSTRLEN];
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, NULL, PORT, AI_PASSIVE);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    udp = ogs_udp_server(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, udp);
+
+    client = ogs_sock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ABTS_PTR_NOTNULL(tc, client);
+
+    for (i = 0; i < 3; i++) {
+        pkbuf[i] = ogs_pkbuf_alloc(NULL, STRLEN);
+        ABTS_PTR_NOTNULL(tc, pkbuf[i]);
+        ogs_pkbuf_put_data(pkbuf[i], DATASTR, strlen(DATASTR) - i);
+    }
+
+    rv = ogs_sendmmsg(client->fd, pkbuf, 3, 0, addr);
+    ABTS_INT_EQUAL(tc, 3, rv);
+
+    for (i = 0; i < 3; i++) {
+        ogs_pkbuf_trim(pkbuf[i], 0);
+        ogs_pkbuf_put(pkbuf[i], STRLEN);
+    }
+
+    rv = ogs_recvmmsg(udp->fd, pkbuf, from, 3, 0);
+    ABTS_INT_EQUAL(tc, 3, rv);
+
+    for (i = 0; i < 3; i++) {
+        ABTS_INT_EQUAL(tc, strlen(DATASTR) - i, pkbuf[i]->len);
+        ABTS_TRUE(tc, memcmp(pkbuf[i]->data, DATASTR, pkbuf[i]->len) == 0);
+        ABTS_STR_EQUAL(tc, "127.0.0.1", OGS_ADDR(&from[i], buf));
+        ogs_pkbuf_free(pkbuf[i]);
+    }
+
+    ogs_sock_destroy(client);
+    ogs_sock_destroy(udp);
+
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+}
+
+#if defined(SO_REUSEPORT)
+static void test10_func(abts_case *tc, void *data)
+{
+    int rv;
+    ogs_sock_t *udp1, *udp2;
+    ogs_sockaddr_t *addr;
+    ogs_sockopt_t option;
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, NULL, PORT, AI_PASSIVE);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    ogs_sockopt_init(&option);
+    option.so_reuseport = true;
+
+    udp1 = ogs_udp_server(addr, &option);
+    ABTS_PTR_NOTNULL(tc, udp1);
+    udp2 = ogs_udp_server(addr, &option);
+    ABTS_PTR_NOTNULL(tc, udp2);
+
+    ogs_sock_destroy(udp2);
+    ogs_sock_destroy(udp1);
+
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+}
+#endif
+
 abts_suite *test_socket(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -436,6 +511,10 @@ abts_suite *test_socket(abts_suite *suite)
     abts_run_test(suite, test6_func, NULL);
     abts_run_test(suite, test7_func, NULL);
     abts_run_test(suite, test8_func, NULL);
+    abts_run_test(suite, test9_func, NULL);
+#if defined(SO_REUSEPORT)
+    abts_run_test(suite, test10_func, NULL);
+#endif
 
     return suite;
 }
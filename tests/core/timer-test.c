@@ -114,6 +114,14 @@ static void test1_func(abts_case *tc, void *data)
     ogs_pollset_destroy(pollset);
 }
 
+static ogs_timer_mgr_t *test_timer_mgr_create(void *data, int capacity)
+{
+    if (data)
+        return ogs_timer_mgr_create_wheel(capacity);
+
+    return ogs_timer_mgr_create(capacity);
+}
+
 static void test2_func(abts_case *tc, void *data)
 {
     int n = 0;
@@ -126,7 +134,7 @@ static void test2_func(abts_case *tc, void *data)
     memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
     memset(tm_num, 0, sizeof(int)*(TEST_DURATION/TEST_TIMER_PRECISION));
 
-    timer = ogs_timer_mgr_create(512);
+    timer = test_timer_mgr_create(data, 512);
     ogs_assert(timer);
 
     for(n = 0; n < TEST_TIMER_NUM; n++) {
@@ -168,7 +176,7 @@ static void test3_func(abts_case *tc, void *data)
     memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
     memset(tm_num, 0, sizeof(int)*(TEST_DURATION/TEST_TIMER_PRECISION));
 
-    timer = ogs_timer_mgr_create(512);
+    timer = test_timer_mgr_create(data, 512);
     ogs_assert(timer);
 
     for(n = 0; n < TEST_TIMER_NUM; n++) {
@@ -208,6 +216,215 @@ static void test3_func(abts_case *tc, void *data)
     ogs_timer_mgr_destroy(timer);
 }
 
+/*
+ * Timing wheel : every timer fires in order, never before its timeout,
+ * even when it has to be cascaded down from a higher level
+ */
+#define TEST4_TIMER_NUM         6
+
+static ogs_time_t test4_timeout[TEST4_TIMER_NUM];
+static ogs_time_t test4_fired[TEST4_TIMER_NUM];
+static int test4_order[TEST4_TIMER_NUM];
+static int test4_count;
+
+static void test4_expire_func(void *data)
+{
+    int index = (uintptr_t)data;
+
+    test4_fired[index] = ogs_get_monotonic_time();
+    test4_order[test4_count++] = index;
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_pollset_t *pollset = NULL;
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t *timer_array[TEST4_TIMER_NUM];
+    ogs_time_t duration[TEST4_TIMER_NUM] =
+        { 3000, 70000, 130000, 250000, 4200000, 4300000 };
+    int n;
+
+    memset(test4_fired, 0, sizeof(test4_fired));
+    test4_count = 0;
+
+    timer = ogs_timer_mgr_create_wheel(512);
+    ogs_assert(timer);
+    pollset = ogs_pollset_create(512);
+    ogs_assert(pollset);
+
+    for (n = 0; n < TEST4_TIMER_NUM; n++) {
+        timer_array[n] = ogs_timer_add(
+                timer, test4_expire_func, (void*)(uintptr_t)n);
+        ogs_assert(timer_array[n]);
+    }
+
+    /* Started in reverse order, and the 250ms timer is restarted */
+    for (n = TEST4_TIMER_NUM - 1; n >= 0; n--) {
+        ogs_timer_start(timer_array[n], duration[n] / 2);
+        ogs_timer_start(timer_array[n], duration[n]);
+        test4_timeout[n] = ogs_get_monotonic_time() + duration[n];
+    }
+
+    /* The 4.3s timer is stopped before it fires */
+    ogs_timer_stop(timer_array[5]);
+
+    while (ogs_timer_mgr_next(timer) != OGS_INFINITE_TIME) {
+        ogs_pollset_poll(pollset, ogs_timer_mgr_next(timer));
+        ogs_timer_mgr_expire(timer);
+    }
+
+    ABTS_INT_EQUAL(tc, TEST4_TIMER_NUM - 1, test4_count);
+    for (n = 0; n < TEST4_TIMER_NUM - 1; n++) {
+        ABTS_INT_EQUAL(tc, n, test4_order[n]);
+        ABTS_TRUE(tc, test4_fired[n] >= test4_timeout[n] - duration[n] / 2);
+        ABTS_TRUE(tc, test4_fired[n] + OGS_TIMER_WHEEL_RESOLUTION >=
+                test4_timeout[n]);
+    }
+    ABTS_INT_EQUAL(tc, 0, test4_fired[5]);
+
+    for (n = 0; n < TEST4_TIMER_NUM; n++)
+        ogs_timer_delete(timer_array[n]);
+
+    ogs_timer_mgr_destroy(timer);
+    ogs_pollset_destroy(pollset);
+}
+
+/*
+ * Timing wheel : a timer that is already due when it is started,
+ * e.g. from a stale loop time, fires on the next tick and not
+ * a full turn of level 0 later
+ */
+static int test6_count;
+
+static void test6_expire_func(void *data)
+{
+    test6_count++;
+}
+
+static void test6_func(abts_case *tc, void *data)
+{
+    ogs_pollset_t *pollset = NULL;
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t *timer_due = NULL;
+    ogs_time_t start;
+
+    test6_count = 0;
+
+    pollset = ogs_pollset_create(512);
+    ogs_assert(pollset);
+
+    /* The loop time falls behind the tick of the new wheel */
+    ogs_loop_time_update();
+    ogs_msleep(10);
+
+    timer = ogs_timer_mgr_create_wheel(512);
+    ogs_assert(timer);
+    timer_due = ogs_timer_add(timer, test6_expire_func, NULL);
+    ogs_assert(timer_due);
+
+    start = ogs_get_monotonic_time();
+    ogs_timer_start(timer_due, OGS_TIMER_WHEEL_RESOLUTION);
+
+    while (ogs_timer_mgr_next(timer) != OGS_INFINITE_TIME) {
+        ogs_pollset_poll(pollset, ogs_timer_mgr_next(timer));
+        ogs_timer_mgr_expire(timer);
+    }
+
+    ABTS_INT_EQUAL(tc, 1, test6_count);
+    ABTS_TRUE(tc, ogs_get_monotonic_time() - start <
+            32 * OGS_TIMER_WHEEL_RESOLUTION);
+
+    ogs_timer_delete(timer_due);
+
+    ogs_timer_mgr_destroy(timer);
+    ogs_pollset_destroy(pollset);
+}
+
+/*
+ * Microbenchmark of a restart-heavy workload : every timer is restarted
+ * long before it expires, like T3512/T3513/PFCP/SBI timers are.
+ * It takes a few seconds, so it only runs at info level:
+ *
+ * $ ./tests/core/core -e info timer-test
+ */
+#define BENCH_TIMER_NUM         100000
+#define BENCH_RESTART_NUM       1000000
+
+static ogs_time_t bench_timer(abts_case *tc, ogs_timer_mgr_t *timer)
+{
+    ogs_timer_t **timer_array = NULL;
+    int *restart = NULL;
+    ogs_time_t start, elapsed;
+    ogs_time_t duration[] = {
+        ogs_time_from_sec(3240),    /* T3512 */
+        ogs_time_from_sec(2),       /* T3513 */
+        ogs_time_from_sec(3),       /* PFCP T1 */
+        ogs_time_from_sec(10),      /* SBI client wait */
+    };
+    int n;
+
+    timer_array = ogs_calloc(BENCH_TIMER_NUM, sizeof(*timer_array));
+    ogs_assert(timer_array);
+
+    for (n = 0; n < BENCH_TIMER_NUM; n++) {
+        timer_array[n] = ogs_timer_add(timer, NULL, NULL);
+        ogs_assert(timer_array[n]);
+    }
+
+    restart = ogs_calloc(BENCH_RESTART_NUM, sizeof(*restart));
+    ogs_assert(restart);
+    for (n = 0; n < BENCH_RESTART_NUM; n++)
+        restart[n] = ogs_random32() % BENCH_TIMER_NUM;
+
+    start = ogs_get_monotonic_time();
+
+    for (n = 0; n < BENCH_TIMER_NUM; n++)
+        ogs_timer_start(timer_array[n], duration[n % 4]);
+    for (n = 0; n < BENCH_RESTART_NUM; n++) {
+        ogs_timer_start(timer_array[restart[n]], duration[n % 4] + n % 1000);
+        if (n % 1000 == 0) {
+            ogs_timer_mgr_next(timer);
+            ogs_timer_mgr_expire(timer);
+        }
+    }
+    for (n = 0; n < BENCH_TIMER_NUM; n++)
+        ogs_timer_stop(timer_array[n]);
+
+    elapsed = ogs_get_monotonic_time() - start;
+
+    ABTS_INT_EQUAL(tc, OGS_INFINITE_TIME, ogs_timer_mgr_next(timer));
+
+    for (n = 0; n < BENCH_TIMER_NUM; n++)
+        ogs_timer_delete(timer_array[n]);
+    ogs_free(timer_array);
+    ogs_free(restart);
+
+    return elapsed;
+}
+
+static void test5_func(abts_case *tc, void *data)
+{
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_time_t rbtree_time, wheel_time;
+
+    if (ogs_log_get_domain_level(OGS_LOG_DOMAIN) < OGS_LOG_INFO)
+        return;
+
+    timer = ogs_timer_mgr_create(BENCH_TIMER_NUM);
+    ogs_assert(timer);
+    rbtree_time = bench_timer(tc, timer);
+    ogs_timer_mgr_destroy(timer);
+
+    timer = ogs_timer_mgr_create_wheel(BENCH_TIMER_NUM);
+    ogs_assert(timer);
+    wheel_time = bench_timer(tc, timer);
+    ogs_timer_mgr_destroy(timer);
+
+    ogs_info("%d timers, %d restarts : rbtree %lld usec, wheel %lld usec",
+            BENCH_TIMER_NUM, BENCH_RESTART_NUM,
+            (long long)rbtree_time, (long long)wheel_time);
+}
+
 abts_suite *test_timer(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -215,6 +432,11 @@ abts_suite *test_timer(abts_suite *suite)
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test2_func, (void *)1);
+    abts_run_test(suite, test3_func, (void *)1);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test6_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
 
     return suite;
 }
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "amf/context.h"
+#include "core/abts.h"
+
+#define NUM_OF_GNB          1024
+#define NUM_OF_TAC          256
+#define NUM_OF_PAGING       100000
+#define PAGING_PDU_SIZE     64
+
+static void gnb_add_ta(amf_gnb_t *gnb,
+        uint32_t tac, int num_of_plmn_id, ogs_plmn_id_t *plmn_id)
+{
+    int i, j;
+
+    i = gnb->num_of_supported_ta_list++;
+    ogs_assert(i < OGS_MAX_NUM_OF_TAI);
+
+    gnb->supported_ta_list[i].tac.v = tac;
+    gnb->supported_ta_list[i].num_of_bplmn_list = num_of_plmn_id;
+    for (j = 0; j < num_of_plmn_id; j++)
+        memcpy(&gnb->supported_ta_list[i].bplmn_list[j].plmn_id,
+                &plmn_id[j], OGS_PLMN_ID_LEN);
+}
+
+static amf_tai_gnb_t *tai_gnb_find(ogs_plmn_id_t *plmn_id, uint32_t tac)
+{
+    ogs_5gs_tai_t tai;
+
+    memset(&tai, 0, sizeof(tai));
+    memcpy(&tai.plmn_id, plmn_id, OGS_PLMN_ID_LEN);
+    tai.tac.v = tac;
+
+    return amf_tai_gnb_find(&tai);
+}
+
+static bool tai_gnb_has(amf_tai_gnb_t *tai_gnb, amf_gnb_t *gnb)
+{
+    int i;
+
+    for (i = 0; i < tai_gnb->num_of_gnb; i++)
+        if (tai_gnb->gnb[i] == gnb)
+            return true;
+
+    return false;
+}
+
+static void amf_paging_test1(abts_case *tc, void *data)
+{
+    amf_gnb_t *gnb1 = NULL, *gnb2 = NULL;
+    amf_tai_gnb_t *tai_gnb = NULL;
+    ogs_plmn_id_t plmn_id[2];
+
+    ogs_plmn_id_build(&plmn_id[0], 999, 70, 2);
+    ogs_plmn_id_build(&plmn_id[1], 1, 1, 2);
+
+    amf_self()->tai_gnb_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, amf_self()->tai_gnb_hash);
+
+    gnb1 = ogs_calloc(1, sizeof(*gnb1));
+    ABTS_PTR_NOTNULL(tc, gnb1);
+    gnb2 = ogs_calloc(1, sizeof(*gnb2));
+    ABTS_PTR_NOTNULL(tc, gnb2);
+
+    /* NGSetup : gNB1 TAC 1 (PLMN 0, 1), TAC 2 (PLMN 0) */
+    gnb_add_ta(gnb1, 1, 2, plmn_id);
+    gnb_add_ta(gnb1, 2, 1, plmn_id);
+    amf_gnb_tai_hash_set(gnb1);
+    ABTS_INT_EQUAL(tc, 3, gnb1->num_of_paging_tai);
+
+    /* NGSetup : gNB2 lists TAC 2 (PLMN 0) twice */
+    gnb_add_ta(gnb2, 2, 1, plmn_id);
+    gnb_add_ta(gnb2, 2, 1, plmn_id);
+    amf_gnb_tai_hash_set(gnb2);
+
+    ABTS_INT_EQUAL(tc, 3, ogs_hmap_count(amf_self()->tai_gnb_hash));
+
+    tai_gnb = tai_gnb_find(&plmn_id[0], 1);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_INT_EQUAL(tc, 1, tai_gnb->num_of_gnb);
+    ABTS_PTR_EQUAL(tc, gnb1, tai_gnb->gnb[0]);
+
+    tai_gnb = tai_gnb_find(&plmn_id[1], 1);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_INT_EQUAL(tc, 1, tai_gnb->num_of_gnb);
+    ABTS_PTR_EQUAL(tc, gnb1, tai_gnb->gnb[0]);
+
+    /* gNB2 is paged once for TAC 2 */
+    tai_gnb = tai_gnb_find(&plmn_id[0], 2);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_INT_EQUAL(tc, 2, tai_gnb->num_of_gnb);
+    ABTS_TRUE(tc, tai_gnb_has(tai_gnb, gnb1));
+    ABTS_TRUE(tc, tai_gnb_has(tai_gnb, gnb2));
+
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[1], 2));
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[0], 3));
+
+    /* RANConfigurationUpdate : gNB1 now supports TAC 3 (PLMN 0) only */
+    gnb1->num_of_supported_ta_list = 0;
+    gnb_add_ta(gnb1, 3, 1, plmn_id);
+    amf_gnb_tai_hash_set(gnb1);
+    ABTS_INT_EQUAL(tc, 1, gnb1->num_of_paging_tai);
+
+    ABTS_INT_EQUAL(tc, 2, ogs_hmap_count(amf_self()->tai_gnb_hash));
+
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[0], 1));
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[1], 1));
+
+    tai_gnb = tai_gnb_find(&plmn_id[0], 2);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_INT_EQUAL(tc, 1, tai_gnb->num_of_gnb);
+    ABTS_PTR_EQUAL(tc, gnb2, tai_gnb->gnb[0]);
+
+    tai_gnb = tai_gnb_find(&plmn_id[0], 3);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_INT_EQUAL(tc, 1, tai_gnb->num_of_gnb);
+    ABTS_PTR_EQUAL(tc, gnb1, tai_gnb->gnb[0]);
+
+    /* gNB2 is removed */
+    amf_gnb_tai_hash_clear(gnb2);
+    ABTS_INT_EQUAL(tc, 0, gnb2->num_of_paging_tai);
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[0], 2));
+
+    tai_gnb = tai_gnb_find(&plmn_id[0], 3);
+    ABTS_PTR_NOTNULL(tc, tai_gnb);
+    ABTS_PTR_EQUAL(tc, gnb1, tai_gnb->gnb[0]);
+
+    /* gNB1 is removed */
+    amf_gnb_tai_hash_clear(gnb1);
+    ABTS_PTR_EQUAL(tc, NULL, tai_gnb_find(&plmn_id[0], 3));
+
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(amf_self()->tai_gnb_hash));
+
+    ogs_free(gnb2);
+    ogs_free(gnb1);
+
+    ogs_hmap_destroy(amf_self()->tai_gnb_hash);
+    amf_self()->tai_gnb_hash = NULL;
+}
+
+static void amf_paging_test2(abts_case *tc, void *data)
+{
+    amf_gnb_t **gnb = NULL;
+    amf_tai_gnb_t *tai_gnb = NULL;
+    ogs_plmn_id_t plmn_id;
+    int i, j;
+
+    ogs_plmn_id_build(&plmn_id, 999, 70, 2);
+
+    amf_self()->tai_gnb_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, amf_self()->tai_gnb_hash);
+
+    gnb = ogs_calloc(NUM_OF_GNB, sizeof(*gnb));
+    ABTS_PTR_NOTNULL(tc, gnb);
+
+    /* Each TAC is served by NUM_OF_GNB/NUM_OF_TAC gNBs */
+    for (i = 0; i < NUM_OF_GNB; i++) {
+        gnb[i] = ogs_calloc(1, sizeof(*gnb[i]));
+        ABTS_PTR_NOTNULL(tc, gnb[i]);
+        gnb_add_ta(gnb[i], i % NUM_OF_TAC, 1, &plmn_id);
+        amf_gnb_tai_hash_set(gnb[i]);
+    }
+
+    ABTS_INT_EQUAL(tc, NUM_OF_TAC, ogs_hmap_count(amf_self()->tai_gnb_hash));
+
+    for (i = 0; i < NUM_OF_TAC; i++) {
+        tai_gnb = tai_gnb_find(&plmn_id, i);
+        ABTS_PTR_NOTNULL(tc, tai_gnb);
+        ABTS_INT_EQUAL(tc, NUM_OF_GNB/NUM_OF_TAC, tai_gnb->num_of_gnb);
+        for (j = i; j < NUM_OF_GNB; j += NUM_OF_TAC)
+            ABTS_TRUE(tc, tai_gnb_has(tai_gnb, gnb[j]));
+    }
+
+    /* Removing every other gNB keeps the rest indexed */
+    for (i = 0; i < NUM_OF_GNB; i += 2)
+        amf_gnb_tai_hash_clear(gnb[i]);
+
+    for (i = 0; i < NUM_OF_TAC; i++) {
+        tai_gnb = tai_gnb_find(&plmn_id, i);
+        if (i % 2 == 0) {
+            ABTS_PTR_EQUAL(tc, NULL, tai_gnb);
+            continue;
+        }
+        ABTS_PTR_NOTNULL(tc, tai_gnb);
+        ABTS_INT_EQUAL(tc, NUM_OF_GNB/NUM_OF_TAC, tai_gnb->num_of_gnb);
+    }
+
+    for (i = 1; i < NUM_OF_GNB; i += 2)
+        amf_gnb_tai_hash_clear(gnb[i]);
+
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(amf_self()->tai_gnb_hash));
+
+    for (i = 0; i < NUM_OF_GNB; i++)
+        ogs_free(gnb[i]);
+    ogs_free(gnb);
+
+    ogs_hmap_destroy(amf_self()->tai_gnb_hash);
+    amf_self()->tai_gnb_hash = NULL;
+}
+
+/*
+ * Paging throughput : the TAI index against the scan of all gNBs
+ * with a PDU built for each gNB that it replaced
+ */
+static void amf_paging_test3(abts_case *tc, void *data)
+{
+    amf_gnb_t **gnb = NULL;
+    amf_tai_gnb_t *tai_gnb = NULL;
+    ogs_pkbuf_t *pdu = NULL, *pkbuf = NULL;
+    ogs_plmn_id_t plmn_id;
+    ogs_5gs_tai_t tai;
+    uint32_t *tac = NULL;
+    uint8_t buf[PAGING_PDU_SIZE];
+    ogs_time_t start, index_time, scan_time;
+    int i, j, k, l;
+    uint64_t index_sent = 0, scan_sent = 0;
+
+    if (ogs_log_get_domain_level(OGS_LOG_DOMAIN) < OGS_LOG_INFO)
+        return;
+
+    ogs_plmn_id_build(&plmn_id, 999, 70, 2);
+    memset(buf, 0xa5, sizeof(buf));
+
+    amf_self()->tai_gnb_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, amf_self()->tai_gnb_hash);
+
+    gnb = ogs_calloc(NUM_OF_GNB, sizeof(*gnb));
+    ABTS_PTR_NOTNULL(tc, gnb);
+    for (i = 0; i < NUM_OF_GNB; i++) {
+        gnb[i] = ogs_calloc(1, sizeof(*gnb[i]));
+        ABTS_PTR_NOTNULL(tc, gnb[i]);
+        gnb_add_ta(gnb[i], i % NUM_OF_TAC, 1, &plmn_id);
+        amf_gnb_tai_hash_set(gnb[i]);
+    }
+
+    tac = ogs_calloc(NUM_OF_PAGING, sizeof(*tac));
+    ABTS_PTR_NOTNULL(tc, tac);
+    for (i = 0; i < NUM_OF_PAGING; i++)
+        tac[i] = ogs_random32() % NUM_OF_TAC;
+
+    memset(&tai, 0, sizeof(tai));
+    memcpy(&tai.plmn_id, &plmn_id, OGS_PLMN_ID_LEN);
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_PAGING; i++) {
+        tai.tac.v = tac[i];
+        tai_gnb = amf_tai_gnb_find(&tai);
+        if (!tai_gnb)
+            continue;
+
+        pdu = ogs_pkbuf_alloc(NULL, PAGING_PDU_SIZE);
+        ogs_assert(pdu);
+        ogs_pkbuf_put_data(pdu, buf, sizeof(buf));
+
+        for (j = 0; j < tai_gnb->num_of_gnb; j++) {
+            pkbuf = ogs_pkbuf_copy(pdu);
+            ogs_assert(pkbuf);
+            ogs_pkbuf_free(pkbuf);
+            index_sent++;
+        }
+
+        ogs_pkbuf_free(pdu);
+    }
+    index_time = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_PAGING; i++) {
+        for (j = 0; j < NUM_OF_GNB; j++) {
+            for (k = 0; k < gnb[j]->num_of_supported_ta_list; k++) {
+                for (l = 0;
+                    l < gnb[j]->supported_ta_list[k].num_of_bplmn_list; l++) {
+                    if (memcmp(
+                            &gnb[j]->supported_ta_list[k].bplmn_list[l].plmn_id,
+                            &plmn_id, OGS_PLMN_ID_LEN) == 0 &&
+                        gnb[j]->supported_ta_list[k].tac.v == tac[i]) {
+                        pkbuf = ogs_pkbuf_alloc(NULL, PAGING_PDU_SIZE);
+                        ogs_assert(pkbuf);
+                        ogs_pkbuf_put_data(pkbuf, buf, sizeof(buf));
+                        ogs_pkbuf_free(pkbuf);
+                        scan_sent++;
+                    }
+                }
+            }
+        }
+    }
+    scan_time = ogs_get_monotonic_time() - start;
+
+    ABTS_TRUE(tc, index_sent == scan_sent);
+
+    ogs_info("%d gNBs, %d TAIs, %d paging : index %lld usec, scan %lld usec",
+            NUM_OF_GNB, NUM_OF_TAC, NUM_OF_PAGING,
+            (long long)index_time, (long long)scan_time);
+
+    for (i = 0; i < NUM_OF_GNB; i++) {
+        amf_gnb_tai_hash_clear(gnb[i]);
+        ogs_free(gnb[i]);
+    }
+    ogs_free(gnb);
+    ogs_free(tac);
+
+    ogs_hmap_destroy(amf_self()->tai_gnb_hash);
+    amf_self()->tai_gnb_hash = NULL;
+}
+
+abts_suite *test_amf_paging(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, amf_paging_test1, NULL);
+    abts_run_test(suite, amf_paging_test2, NULL);
+    abts_run_test(suite, amf_paging_test3, NULL);
+
+    return suite;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "amf/context.h"
+#include "core/abts.h"
+
+#define NUM_OF_RAN_UE   3
+
+static void amf_ran_ue_test1(abts_case *tc, void *data)
+{
+    amf_gnb_t *gnb = NULL;
+    ran_ue_t *ran_ue[NUM_OF_RAN_UE];
+    int i;
+
+    gnb = ogs_calloc(1, sizeof(*gnb));
+    ABTS_PTR_NOTNULL(tc, gnb);
+    ogs_list_init(&gnb->ran_ue_list);
+    gnb->ran_ue_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, gnb->ran_ue_hash);
+
+    for (i = 0; i < NUM_OF_RAN_UE; i++) {
+        ran_ue[i] = ogs_calloc(1, sizeof(*ran_ue[i]));
+        ABTS_PTR_NOTNULL(tc, ran_ue[i]);
+        ran_ue[i]->ran_ue_ngap_id = INVALID_UE_NGAP_ID;
+        ran_ue[i]->gnb = gnb;
+        ogs_list_add(&gnb->ran_ue_list, ran_ue[i]);
+    }
+
+    /* The newer UE does not overwrite the older one */
+    ran_ue_set_ran_ue_ngap_id(ran_ue[0], 1);
+    ran_ue_set_ran_ue_ngap_id(ran_ue[1], 1);
+    ran_ue_set_ran_ue_ngap_id(ran_ue[2], 2);
+    ABTS_PTR_EQUAL(tc, ran_ue[0], ran_ue_find_by_ran_ue_ngap_id(gnb, 1));
+    ABTS_PTR_EQUAL(tc, ran_ue[2], ran_ue_find_by_ran_ue_ngap_id(gnb, 2));
+
+    ran_ue_set_ran_ue_ngap_id(ran_ue[2], 1);
+    ABTS_PTR_EQUAL(tc, ran_ue[0], ran_ue_find_by_ran_ue_ngap_id(gnb, 1));
+    ABTS_PTR_EQUAL(tc, NULL, ran_ue_find_by_ran_ue_ngap_id(gnb, 2));
+
+    /* The oldest UE left takes over the ID, as in ran_ue_remove() */
+    ogs_list_remove(&gnb->ran_ue_list, ran_ue[0]);
+    ran_ue_set_ran_ue_ngap_id(ran_ue[0], INVALID_UE_NGAP_ID);
+    ABTS_PTR_EQUAL(tc, ran_ue[1], ran_ue_find_by_ran_ue_ngap_id(gnb, 1));
+
+    /* A UE that waits for the ID can leave it */
+    ran_ue_set_ran_ue_ngap_id(ran_ue[2], 3);
+    ABTS_PTR_EQUAL(tc, ran_ue[2], ran_ue_find_by_ran_ue_ngap_id(gnb, 3));
+    ABTS_PTR_EQUAL(tc, ran_ue[1], ran_ue_find_by_ran_ue_ngap_id(gnb, 1));
+
+    ogs_list_remove(&gnb->ran_ue_list, ran_ue[1]);
+    ran_ue_set_ran_ue_ngap_id(ran_ue[1], INVALID_UE_NGAP_ID);
+    ABTS_PTR_EQUAL(tc, NULL, ran_ue_find_by_ran_ue_ngap_id(gnb, 1));
+
+    ogs_list_remove(&gnb->ran_ue_list, ran_ue[2]);
+    ran_ue_set_ran_ue_ngap_id(ran_ue[2], INVALID_UE_NGAP_ID);
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(gnb->ran_ue_hash));
+
+    for (i = 0; i < NUM_OF_RAN_UE; i++) {
+        ABTS_INT_EQUAL(tc, 0, ran_ue[i]->num_of_shadowed);
+        ABTS_TRUE(tc, ran_ue[i]->ran_ue_ngap_id_shadowed == false);
+        ogs_free(ran_ue[i]);
+    }
+
+    ogs_hmap_destroy(gnb->ran_ue_hash);
+    ogs_free(gnb);
+}
+
+abts_suite *test_amf_ran_ue(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, amf_ran_ue_test1, NULL);
+
+    return suite;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mme/mme-context.h"
+#include "core/abts.h"
+
+#define NUM_OF_ENB_UE   3
+
+static void mme_enb_ue_test1(abts_case *tc, void *data)
+{
+    mme_enb_t *enb = NULL;
+    enb_ue_t *enb_ue[NUM_OF_ENB_UE];
+    int i;
+
+    enb = ogs_calloc(1, sizeof(*enb));
+    ABTS_PTR_NOTNULL(tc, enb);
+    ogs_list_init(&enb->enb_ue_list);
+    enb->enb_ue_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, enb->enb_ue_hash);
+
+    for (i = 0; i < NUM_OF_ENB_UE; i++) {
+        enb_ue[i] = ogs_calloc(1, sizeof(*enb_ue[i]));
+        ABTS_PTR_NOTNULL(tc, enb_ue[i]);
+        enb_ue[i]->enb_ue_s1ap_id = INVALID_UE_S1AP_ID;
+        enb_ue[i]->enb = enb;
+        ogs_list_add(&enb->enb_ue_list, enb_ue[i]);
+    }
+
+    /* The newer UE does not overwrite the older one */
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[0], 1);
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[1], 1);
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[2], 2);
+    ABTS_PTR_EQUAL(tc, enb_ue[0], enb_ue_find_by_enb_ue_s1ap_id(enb, 1));
+    ABTS_PTR_EQUAL(tc, enb_ue[2], enb_ue_find_by_enb_ue_s1ap_id(enb, 2));
+
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[2], 1);
+    ABTS_PTR_EQUAL(tc, enb_ue[0], enb_ue_find_by_enb_ue_s1ap_id(enb, 1));
+    ABTS_PTR_EQUAL(tc, NULL, enb_ue_find_by_enb_ue_s1ap_id(enb, 2));
+
+    /* The oldest UE left takes over the ID, as in enb_ue_remove() */
+    ogs_list_remove(&enb->enb_ue_list, enb_ue[0]);
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[0], INVALID_UE_S1AP_ID);
+    ABTS_PTR_EQUAL(tc, enb_ue[1], enb_ue_find_by_enb_ue_s1ap_id(enb, 1));
+
+    /* A UE that waits for the ID can leave it */
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[2], 3);
+    ABTS_PTR_EQUAL(tc, enb_ue[2], enb_ue_find_by_enb_ue_s1ap_id(enb, 3));
+    ABTS_PTR_EQUAL(tc, enb_ue[1], enb_ue_find_by_enb_ue_s1ap_id(enb, 1));
+
+    ogs_list_remove(&enb->enb_ue_list, enb_ue[1]);
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[1], INVALID_UE_S1AP_ID);
+    ABTS_PTR_EQUAL(tc, NULL, enb_ue_find_by_enb_ue_s1ap_id(enb, 1));
+
+    ogs_list_remove(&enb->enb_ue_list, enb_ue[2]);
+    enb_ue_set_enb_ue_s1ap_id(enb_ue[2], INVALID_UE_S1AP_ID);
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(enb->enb_ue_hash));
+
+    for (i = 0; i < NUM_OF_ENB_UE; i++) {
+        ABTS_INT_EQUAL(tc, 0, enb_ue[i]->num_of_shadowed);
+        ABTS_TRUE(tc, enb_ue[i]->enb_ue_s1ap_id_shadowed == false);
+        ogs_free(enb_ue[i]);
+    }
+
+    ogs_hmap_destroy(enb->enb_ue_hash);
+    ogs_free(enb);
+}
+
+abts_suite *test_mme_enb_ue(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, mme_enb_ue_test1, NULL);
+
+    return suite;
+}
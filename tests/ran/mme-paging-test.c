@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mme/mme-context.h"
+#include "core/abts.h"
+
+static void enb_add_ta(mme_enb_t *enb, ogs_plmn_id_t *plmn_id, uint16_t tac)
+{
+    int i;
+
+    i = enb->num_of_supported_ta_list++;
+    ogs_assert(i < OGS_MAX_NUM_OF_TAI*OGS_MAX_NUM_OF_BPLMN);
+
+    memcpy(&enb->supported_ta_list[i].plmn_id, plmn_id, OGS_PLMN_ID_LEN);
+    enb->supported_ta_list[i].tac = tac;
+}
+
+static mme_tai_enb_t *tai_enb_find(ogs_plmn_id_t *plmn_id, uint16_t tac)
+{
+    ogs_eps_tai_t tai;
+
+    memcpy(&tai.plmn_id, plmn_id, OGS_PLMN_ID_LEN);
+    tai.tac = tac;
+
+    return mme_tai_enb_find(&tai);
+}
+
+static void mme_paging_test1(abts_case *tc, void *data)
+{
+    mme_enb_t *enb1 = NULL, *enb2 = NULL;
+    mme_tai_enb_t *tai_enb = NULL;
+    ogs_plmn_id_t plmn_id[2];
+
+    ogs_plmn_id_build(&plmn_id[0], 1, 1, 2);
+    ogs_plmn_id_build(&plmn_id[1], 999, 70, 2);
+
+    mme_self()->tai_enb_hash = ogs_hmap_create();
+    ABTS_PTR_NOTNULL(tc, mme_self()->tai_enb_hash);
+
+    enb1 = ogs_calloc(1, sizeof(*enb1));
+    ABTS_PTR_NOTNULL(tc, enb1);
+    enb2 = ogs_calloc(1, sizeof(*enb2));
+    ABTS_PTR_NOTNULL(tc, enb2);
+
+    /* S1Setup : eNB1 TAC 1 (PLMN 0, 1), eNB2 TAC 1 (PLMN 0) twice */
+    enb_add_ta(enb1, &plmn_id[0], 1);
+    enb_add_ta(enb1, &plmn_id[1], 1);
+    mme_enb_tai_hash_set(enb1);
+    ABTS_INT_EQUAL(tc, 2, enb1->num_of_paging_tai);
+
+    enb_add_ta(enb2, &plmn_id[0], 1);
+    enb_add_ta(enb2, &plmn_id[0], 1);
+    mme_enb_tai_hash_set(enb2);
+
+    ABTS_INT_EQUAL(tc, 2, ogs_hmap_count(mme_self()->tai_enb_hash));
+
+    tai_enb = tai_enb_find(&plmn_id[0], 1);
+    ABTS_PTR_NOTNULL(tc, tai_enb);
+    ABTS_INT_EQUAL(tc, 2, tai_enb->num_of_enb);
+
+    tai_enb = tai_enb_find(&plmn_id[1], 1);
+    ABTS_PTR_NOTNULL(tc, tai_enb);
+    ABTS_INT_EQUAL(tc, 1, tai_enb->num_of_enb);
+    ABTS_PTR_EQUAL(tc, enb1, tai_enb->enb[0]);
+
+    ABTS_PTR_EQUAL(tc, NULL, tai_enb_find(&plmn_id[0], 2));
+
+    /* S1Setup again : eNB1 now supports TAC 2 (PLMN 0) only */
+    enb1->num_of_supported_ta_list = 0;
+    enb_add_ta(enb1, &plmn_id[0], 2);
+    mme_enb_tai_hash_set(enb1);
+
+    ABTS_PTR_EQUAL(tc, NULL, tai_enb_find(&plmn_id[1], 1));
+
+    tai_enb = tai_enb_find(&plmn_id[0], 1);
+    ABTS_PTR_NOTNULL(tc, tai_enb);
+    ABTS_INT_EQUAL(tc, 1, tai_enb->num_of_enb);
+    ABTS_PTR_EQUAL(tc, enb2, tai_enb->enb[0]);
+
+    tai_enb = tai_enb_find(&plmn_id[0], 2);
+    ABTS_PTR_NOTNULL(tc, tai_enb);
+    ABTS_INT_EQUAL(tc, 1, tai_enb->num_of_enb);
+    ABTS_PTR_EQUAL(tc, enb1, tai_enb->enb[0]);
+
+    /* eNB2 and eNB1 are removed */
+    mme_enb_tai_hash_clear(enb2);
+    ABTS_PTR_EQUAL(tc, NULL, tai_enb_find(&plmn_id[0], 1));
+    ABTS_PTR_NOTNULL(tc, tai_enb_find(&plmn_id[0], 2));
+
+    mme_enb_tai_hash_clear(enb1);
+    ABTS_PTR_EQUAL(tc, NULL, tai_enb_find(&plmn_id[0], 2));
+
+    ABTS_INT_EQUAL(tc, 0, ogs_hmap_count(mme_self()->tai_enb_hash));
+
+    ogs_free(enb2);
+    ogs_free(enb1);
+
+    ogs_hmap_destroy(mme_self()->tai_enb_hash);
+    mme_self()->tai_enb_hash = NULL;
+}
+
+abts_suite *test_mme_paging(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, mme_paging_test1, NULL);
+
+    return suite;
+}
@@ -36,6 +36,8 @@ abts_suite *test_ngap_message(abts_suite *suite);
 abts_suite *test_sbi_message(abts_suite *suite);
 abts_suite *test_security(abts_suite *suite);
 abts_suite *test_crash(abts_suite *suite);
+abts_suite *test_pfcp_qer(abts_suite *suite);
+abts_suite *test_pfcp_rule(abts_suite *suite);
 
 const struct testlist {
     abts_suite *(*func)(abts_suite *suite);
@@ -47,6 +49,8 @@ const struct testlist {
     {test_sbi_message},
     {test_security},
     {test_crash},
+    {test_pfcp_qer},
+    {test_pfcp_rule},
     {NULL},
 };
 
@@ -104,6 +108,7 @@ int main(int argc, const char *const argv[])
     ogs_log_install_domain(&__ogs_ngap_domain, "ngap", OGS_LOG_ERROR);
     ogs_log_install_domain(&__ogs_nas_domain, "nas", OGS_LOG_ERROR);
     ogs_log_install_domain(&__ogs_gtp_domain, "gtp", OGS_LOG_ERROR);
+    ogs_log_install_domain(&__ogs_pfcp_domain, "pfcp", OGS_LOG_ERROR);
     ogs_log_install_domain(&__ogs_sbi_domain, "sbi", OGS_LOG_ERROR);
 
     atexit(terminate);
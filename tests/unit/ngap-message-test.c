@@ -68,6 +68,8 @@ static void ngap_message_test1(abts_case *tc, void *data)
 
     pkbuf = ogs_ngap_encode(&pdu);
     ogs_assert(pkbuf);
+    ABTS_INT_EQUAL(tc, 16, pkbuf->len);
+    ABTS_TRUE(tc, ogs_pkbuf_tailroom(pkbuf) < 128);
 
     struct_ptr = &message;
     struct_size = sizeof(ogs_ngap_message_t);
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+static void qer_setup(ogs_pfcp_qer_t *qer, uint64_t mbr, uint64_t gbr)
+{
+    memset(qer, 0, sizeof *qer);
+
+    qer->gate_status.uplink = OGS_PFCP_GATE_OPEN;
+    qer->gate_status.downlink = OGS_PFCP_GATE_OPEN;
+    qer->mbr.uplink = mbr;
+    qer->gbr.uplink = gbr;
+
+    ogs_pfcp_qer_meter_setup(qer);
+}
+
+/* 8Mbps is 1000 octets per msec, and a burst of 100,000 octets */
+#define RATE_8MBPS      (8 * 1000 * 1000)
+
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_qer_t qer;
+    ogs_time_t now = ogs_time_from_sec(1);
+    int i;
+
+    qer_setup(&qer, RATE_8MBPS, 0);
+
+    /* The bucket starts full */
+    for (i = 0; i < 100; i++)
+        ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+                ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+
+    /* Refilled at the MBR */
+    now += ogs_time_from_msec(2);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+
+    /* An idle period refills no more than the burst */
+    now += ogs_time_from_sec(10);
+    for (i = 0; i < 100; i++)
+        ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+                ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+
+    /* No MBR in the downlink */
+    for (i = 0; i < 200; i++)
+        ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+                ogs_pfcp_qer_meter(&qer, false, 1000, now));
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_qer_t qer;
+    ogs_time_t now = ogs_time_from_sec(1);
+    int i;
+
+    qer_setup(&qer, 2 * RATE_8MBPS, RATE_8MBPS);
+
+    /* Above the GBR, but still within the MBR */
+    for (i = 0; i < 100; i++)
+        ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+                ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    for (i = 0; i < 100; i++)
+        ABTS_INT_EQUAL(tc, OGS_PFCP_QER_YELLOW,
+                ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_qer_t qer;
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    qer_setup(&qer, 0, 0);
+
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+            ogs_pfcp_qer_meter(&qer, false, 1000, now));
+
+    /* A closed gate drops everything, whatever the bitrate */
+    qer.gate_status.downlink = OGS_PFCP_GATE_CLOSE;
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_GREEN,
+            ogs_pfcp_qer_meter(&qer, true, 1000, now));
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, false, 1000, now));
+
+    qer.gate_status.uplink = OGS_PFCP_GATE_CLOSE;
+    ABTS_INT_EQUAL(tc, OGS_PFCP_QER_RED,
+            ogs_pfcp_qer_meter(&qer, true, 1, now));
+}
+
+/* 64kbps is 8 octets per msec, less than one octet per wakeup of 5usec */
+#define RATE_64KBPS     (64 * 1000)
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_qer_t qer;
+    ogs_time_t now = ogs_time_from_sec(1), end;
+    uint64_t sent = 0;
+
+    qer_setup(&qer, RATE_64KBPS, 0);
+
+    /* Empty the burst first */
+    while (ogs_pfcp_qer_meter(&qer, true, 100, now) == OGS_PFCP_QER_GREEN)
+        ;
+
+    /* 10 seconds of wakeups every 5usec carry 80,000 octets */
+    end = now + ogs_time_from_sec(10);
+    while (now < end) {
+        now += 5;
+        if (ogs_pfcp_qer_meter(&qer, true, 100, now) == OGS_PFCP_QER_GREEN)
+            sent += 100;
+    }
+
+    ABTS_TRUE(tc, sent >= 79900 && sent <= 80000);
+}
+
+abts_suite *test_pfcp_qer(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+
+    return suite;
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+#if HAVE_NETINET_IP_H
+#include <netinet/ip.h>
+#endif
+
+#if HAVE_NETINET_IP6_H
+#include <netinet/ip6.h>
+#endif
+
+#define MAX_NUM_OF_TEST_PDR     80
+
+static const char *flow_description[] = {
+    /* Port ranges */
+    "permit out 6 from 10.45.0.0/16 80-8080 to 10.45.0.2 1000-2000",
+    "permit out 17 from 172.20.166.84 to 10.45.0.2 20001",
+    /* Any protocol */
+    "permit out ip from 192.168.1.0/24 to any",
+    "permit out 17 from 2001:db8::/32 to 2001:db8:cafe::1 5000-6000",
+    "permit out ip from 2001:db8:1::/48 to any",
+    "permit out icmp from any to any",
+};
+
+static const char *ipv4_addr[] = {
+    "10.45.0.2", "10.45.1.1", "172.20.166.84", "192.168.1.7", "8.8.8.8",
+};
+
+static const char *ipv6_addr[] = {
+    "2001:db8:cafe::1", "2001:db8:1::7", "2001:db8:2::7", "fe80::1",
+};
+
+static uint8_t proto_list[] = { IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ICMP, 47 };
+static uint16_t port_list[] = { 0, 79, 80, 1000, 2000, 2001, 5500, 20001 };
+
+static ogs_pfcp_pdr_t pdr[MAX_NUM_OF_TEST_PDR];
+static ogs_pfcp_rule_t rule[MAX_NUM_OF_TEST_PDR];
+static int num_of_pdr;
+
+static void pdr_add(abts_case *tc, const char *description,
+        uint32_t teid, uint8_t qfi)
+{
+    ogs_pfcp_pdr_t *p = &pdr[num_of_pdr];
+    ogs_pfcp_rule_t *r = &rule[num_of_pdr];
+    char *fd = NULL;
+
+    ogs_assert(num_of_pdr < MAX_NUM_OF_TEST_PDR);
+    num_of_pdr++;
+
+    memset(p, 0, sizeof *p);
+    memset(r, 0, sizeof *r);
+
+    p->f_teid.teid = teid;
+    p->qfi = qfi;
+    ogs_list_init(&p->rule_list);
+
+    if (!description)
+        return;
+
+    fd = ogs_strdup(description);
+    ogs_assert(fd);
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_ipfw_compile_rule(&r->ipfw, fd));
+    ogs_free(fd);
+
+    r->pdr = p;
+    ogs_list_add(&p->rule_list, r);
+}
+
+/* PDR lookup as done by the UPF before the classifier */
+static ogs_pfcp_pdr_t *pdr_find(ogs_pkbuf_t *pkbuf,
+        bool by_teid, uint32_t teid, uint8_t qfi)
+{
+    int i;
+
+    for (i = 0; i < num_of_pdr; i++) {
+        if (by_teid) {
+            if (teid != pdr[i].f_teid.teid)
+                continue;
+            if (qfi && pdr[i].qfi != qfi)
+                continue;
+        }
+
+        if (ogs_list_first(&pdr[i].rule_list) &&
+            ogs_pfcp_pdr_rule_find_by_packet(&pdr[i], pkbuf) == NULL)
+            continue;
+
+        return &pdr[i];
+    }
+
+    return NULL;
+}
+
+static ogs_pkbuf_t *packet_build(int family, const char *src, const char *dst,
+        uint8_t proto, uint16_t src_port, uint16_t dst_port)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+    uint16_t port[2];
+    int hlen;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+
+    hlen = family == AF_INET ? sizeof(struct ip) : sizeof(struct ip6_hdr);
+    ogs_pkbuf_put(pkbuf, hlen + sizeof(port));
+    memset(pkbuf->data, 0, pkbuf->len);
+
+    if (family == AF_INET) {
+        struct ip *ip_h = (struct ip *)pkbuf->data;
+
+        ip_h->ip_v = 4;
+        ip_h->ip_hl = 5;
+        ip_h->ip_p = proto;
+        ip_h->ip_len = htobe16(pkbuf->len);
+        ogs_assert(inet_pton(AF_INET, src, &ip_h->ip_src) == 1);
+        ogs_assert(inet_pton(AF_INET, dst, &ip_h->ip_dst) == 1);
+    } else {
+        struct ip6_hdr *ip6_h = (struct ip6_hdr *)pkbuf->data;
+
+        ip6_h->ip6_vfc = 0x60;
+        ip6_h->ip6_nxt = proto;
+        ip6_h->ip6_plen = htobe16(sizeof(port));
+        ogs_assert(inet_pton(AF_INET6, src, &ip6_h->ip6_src) == 1);
+        ogs_assert(inet_pton(AF_INET6, dst, &ip6_h->ip6_dst) == 1);
+    }
+
+    port[0] = htobe16(src_port);
+    port[1] = htobe16(dst_port);
+    memcpy((char *)pkbuf->data + hlen, port, sizeof(port));
+
+    return pkbuf;
+}
+
+/*
+ * Looks up every combination of the addresses, protocols and ports
+ * in the classifier and in the PDRs. Returns the number of packets
+ * matching a PDR, or -1 if the classifier found another PDR.
+ */
+static int classifier_compare(ogs_pfcp_classifier_t *classifier,
+        int family, bool by_teid, uint32_t teid, uint8_t qfi)
+{
+    const char **addr = family == AF_INET ? ipv4_addr : ipv6_addr;
+    int num_of_addr = family == AF_INET ?
+        OGS_ARRAY_SIZE(ipv4_addr) : OGS_ARRAY_SIZE(ipv6_addr);
+    int s, d, p, sp, dp, matched = 0;
+
+    for (s = 0; s < num_of_addr; s++)
+    for (d = 0; d < num_of_addr; d++)
+    for (p = 0; p < OGS_ARRAY_SIZE(proto_list); p++)
+    for (sp = 0; sp < OGS_ARRAY_SIZE(port_list); sp++)
+    for (dp = 0; dp < OGS_ARRAY_SIZE(port_list); dp++) {
+        ogs_pkbuf_t *pkbuf = NULL;
+        ogs_pfcp_flow_key_t key;
+        ogs_pfcp_pdr_t *expected = NULL, *found = NULL;
+
+        pkbuf = packet_build(family, addr[s], addr[d],
+                proto_list[p], port_list[sp], port_list[dp]);
+
+        ogs_assert(ogs_pfcp_flow_key_parse(&key, pkbuf) == OGS_OK);
+        if (by_teid)
+            found = ogs_pfcp_classifier_find_by_teid(
+                    classifier, &key, teid, qfi);
+        else
+            found = ogs_pfcp_classifier_find(classifier, &key);
+
+        expected = pdr_find(pkbuf, by_teid, teid, qfi);
+
+        ogs_pkbuf_free(pkbuf);
+
+        if (found != expected) {
+            ogs_error("%s -> %s PROTO:%d PORT:%d -> %d",
+                    addr[s], addr[d], proto_list[p],
+                    port_list[sp], port_list[dp]);
+            return -1;
+        }
+        if (expected)
+            matched++;
+    }
+
+    return matched;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_classifier_t classifier;
+    ogs_pfcp_flow_key_t key;
+    ogs_pkbuf_t *pkbuf = NULL;
+    int i;
+
+    num_of_pdr = 0;
+    for (i = 0; i < OGS_ARRAY_SIZE(flow_description); i++)
+        pdr_add(tc, flow_description[i], 0, 0);
+
+    memset(&classifier, 0, sizeof(classifier));
+    for (i = 0; i < num_of_pdr; i++)
+        ogs_pfcp_classifier_add(&classifier, &pdr[i]);
+    ogs_pfcp_classifier_build(&classifier);
+
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET, false, 0, 0) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET6, false, 0, 0) > 0);
+
+    /* Inside both port ranges */
+    pkbuf = packet_build(AF_INET,
+            "10.45.1.1", "10.45.0.2", IPPROTO_TCP, 8080, 1000);
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_pfcp_flow_key_parse(&key, pkbuf));
+    ABTS_PTR_EQUAL(tc, &pdr[0], ogs_pfcp_classifier_find(&classifier, &key));
+    ogs_pkbuf_free(pkbuf);
+
+    /* Outside the source port range */
+    pkbuf = packet_build(AF_INET,
+            "10.45.1.1", "10.45.0.2", IPPROTO_TCP, 8081, 1000);
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_pfcp_flow_key_parse(&key, pkbuf));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_classifier_find(&classifier, &key));
+    ogs_pkbuf_free(pkbuf);
+
+    /* Any protocol, ports are ignored */
+    pkbuf = packet_build(AF_INET6,
+            "2001:db8:1::7", "fe80::1", 47, 1, 2);
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_pfcp_flow_key_parse(&key, pkbuf));
+    ABTS_PTR_EQUAL(tc, &pdr[4], ogs_pfcp_classifier_find(&classifier, &key));
+    ogs_pkbuf_free(pkbuf);
+
+    /* A non-IP packet only matches a PDR without SDF Filter */
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put(pkbuf, 64);
+    memset(pkbuf->data, 0, pkbuf->len);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, ogs_pfcp_flow_key_parse(&key, pkbuf));
+    ABTS_INT_EQUAL(tc, 0, key.addr_len);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_classifier_find(&classifier, &key));
+
+    /* Rebuilt from scratch, as on a session modification */
+    pdr_add(tc, NULL, 0, 0);
+    ogs_pfcp_classifier_clear(&classifier);
+    for (i = 0; i < num_of_pdr; i++)
+        ogs_pfcp_classifier_add(&classifier, &pdr[i]);
+    ogs_pfcp_classifier_build(&classifier);
+    ABTS_PTR_EQUAL(tc, &pdr[num_of_pdr-1],
+            ogs_pfcp_classifier_find(&classifier, &key));
+    ogs_pkbuf_free(pkbuf);
+
+    ogs_pfcp_classifier_clear(&classifier);
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_classifier_t classifier;
+    int i;
+
+    num_of_pdr = 0;
+    for (i = 0; i < OGS_ARRAY_SIZE(flow_description); i++)
+        pdr_add(tc, flow_description[i], 1 + (i % 2), i % 3 ? 5 : 9);
+    /* Default PDR of the first tunnel */
+    pdr_add(tc, NULL, 1, 5);
+
+    memset(&classifier, 0, sizeof(classifier));
+    for (i = 0; i < num_of_pdr; i++)
+        ogs_pfcp_classifier_add(&classifier, &pdr[i]);
+    ogs_pfcp_classifier_build(&classifier);
+
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET, true, 1, 0) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET, true, 1, 5) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET, true, 2, 0) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET6, true, 1, 5) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET6, true, 2, 9) > 0);
+    ABTS_INT_EQUAL(tc, 0,
+            classifier_compare(&classifier, AF_INET, true, 3, 0));
+
+    ogs_pfcp_classifier_clear(&classifier);
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_classifier_t classifier;
+    char description[OGS_HUGE_LEN];
+    int i;
+
+    /* More than 64 TCP entries, the bitmaps take several words */
+    num_of_pdr = 0;
+    for (i = 0; i < 70; i++) {
+        ogs_snprintf(description, sizeof(description),
+                "permit out 6 from 10.45.%d.0/24 %d to 10.45.0.2 %d-%d", i % 3,
+                port_list[(i / 3) % 8] + i % 2,
+                port_list[i % 8], port_list[i % 8] + i);
+        pdr_add(tc, description, 0, 0);
+    }
+    for (i = 0; i < OGS_ARRAY_SIZE(flow_description); i++)
+        pdr_add(tc, flow_description[i], 0, 0);
+
+    memset(&classifier, 0, sizeof(classifier));
+    for (i = 0; i < num_of_pdr; i++)
+        ogs_pfcp_classifier_add(&classifier, &pdr[i]);
+    ogs_pfcp_classifier_build(&classifier);
+
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET, false, 0, 0) > 0);
+    ABTS_TRUE(tc, classifier_compare(
+            &classifier, AF_INET6, false, 0, 0) > 0);
+
+    ogs_pfcp_classifier_clear(&classifier);
+}
+
+abts_suite *test_pfcp_rule(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+
+    return suite;
+}